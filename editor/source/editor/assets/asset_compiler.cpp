@@ -1,4 +1,5 @@
 #include "asset_compiler.h"
+#include "asset_compiler_cache.h"
 #include "core/common/string.h"
 #include "core/logging/logging.h"
 #include "runtime/system/filesystem.h"
@@ -6,7 +7,12 @@
 #include "texturec/texturec.h"
 #include <fstream>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include "graphics/graphics.h"
+#include "core/subsystem/subsystem.h"
+#include "runtime/system/task.h"
 
 #include "runtime/assets/asset_extensions.h"
 #include "core/serialization/serialization.h"
@@ -16,30 +22,24 @@
 
 #include "mesh_importer.h"
 #include "runtime/meta/rendering/mesh.hpp"
+#include "runtime/ecs/utils.h"
+#include <algorithm>
+#include <cctype>
 
-void ShaderCompiler::compile(const fs::path& absolute_key)
+namespace
 {
-	std::string str_input = absolute_key.string();
-	std::string file = absolute_key.stem().string();
-	fs::path dir = absolute_key.parent_path();
-	fs::path output = dir / fs::path(file + extensions::shader);
-
-	std::array<gfx::RendererType::Enum, 3> supported =
+	bool compile_shader_for_platform(const fs::path& absolute_key, const fs::path& include_dir, gfx::RendererType::Enum platform, fs::byte_array_t& binary)
 	{
-		gfx::RendererType::Direct3D11,
-		gfx::RendererType::OpenGL,
-		gfx::RendererType::Metal
-	};
+		std::string str_input = absolute_key.string();
+		std::string file = absolute_key.stem().string();
+		fs::path dir = absolute_key.parent_path();
+		fs::path output = dir / fs::path(file + extensions::shader);
 
-	bool vs = string_utils::begins_with(file, "vs_");
-	bool fs = string_utils::begins_with(file, "fs_");
-	bool cs = string_utils::begins_with(file, "cs_");
+		bool vs = string_utils::begins_with(file, "vs_");
+		bool fs = string_utils::begins_with(file, "fs_");
+		bool cs = string_utils::begins_with(file, "cs_");
 
-	std::unordered_map<gfx::RendererType::Enum, fs::byte_array_t> binaries;
-	binaries.reserve(4);
-	std::string str_output = output.string();
-	for (auto& platform : supported)
-	{
+		std::string str_output = output.string();
 		static const int arg_count = 16;
 		const char* args_array[arg_count];
 		args_array[0] = "-f";
@@ -47,8 +47,7 @@ void ShaderCompiler::compile(const fs::path& absolute_key)
 		args_array[2] = "-o";
 		args_array[3] = str_output.c_str();
 		args_array[4] = "-i";
-		fs::path include = fs::resolve_protocol("engine_data:/shaders");
-		std::string str_include = include.string();
+		std::string str_include = include_dir.string();
 		args_array[5] = str_include.c_str();
 		args_array[6] = "--varyingdef";
 		fs::path varying = dir / (file + ".io");
@@ -99,34 +98,172 @@ void ShaderCompiler::compile(const fs::path& absolute_key)
 		bx::MemoryBlock mem_block(&allocator);
 		int64_t sz;
 		std::string err;
-		int result = 0;
-		if (platform != gfx::RendererType::Direct3D11)
-		{
-			//glsl shader compilation is not thread safe-
-			static std::mutex mtx;
-			std::lock_guard<std::mutex> lock(mtx);
-			result = compile_shader(arg_count, args_array, mem_block, sz, err);
-		}
-		else
-		{
-			result = compile_shader(arg_count, args_array, mem_block, sz, err);
-		}
+		int result = compile_shader(arg_count, args_array, mem_block, sz, err);
 
 		if (result != 0)
 		{
 			APPLOG_ERROR("Failed compilation of {0} for {1} with error \n{2}", str_input, gfx::getRendererName(platform), err);
-			continue;
+			return false;
 		}
 
 		if (sz > 0)
 		{
 			auto buf = (char*)mem_block.more();
-			auto length = sz;
-			fs::byte_array_t vec;
-			std::copy(buf, buf + length, std::back_inserter(vec));
-			binaries[platform] = vec;
+			binary.assign(buf, buf + sz);
+		}
+		return true;
+	}
+
+	std::mutex mesh_settings_mutex;
+	MeshCompiler::LodSettings lod_settings;
+	MeshCompiler::VertexSettings vertex_settings;
+	MeshCompiler::VertexStats vertex_stats;
+
+	void save_mesh(const fs::path& output, const fs::path& entry, const Mesh::LoadData& data)
+	{
+		{
+			std::ofstream soutput(entry, std::ios::out | std::ios::binary);
+			cereal::oarchive_binary_t ar(soutput);
+			try_save(ar, cereal::make_nvp("mesh", data));
 		}
-		
+		fs::copy(entry, output, fs::copy_options::overwrite_existing, std::error_code{});
+		fs::remove(entry, std::error_code{});
+	}
+
+	// Lists the levels of detail of a mesh next to it for
+	// ecs::utils::create_model, and removes the ones left over from earlier
+	// settings or failed generations.
+	void update_mesh_lods(const fs::path& dir, const std::string& file, const std::vector<std::string>& lods)
+	{
+		const std::string prefix = file + "_lod";
+		std::vector<fs::path> stale;
+		std::error_code err;
+		fs::directory_iterator end;
+		for (fs::directory_iterator it(dir, err); !err && it != end; it.increment(err))
+		{
+			const auto& path = it->path();
+			const std::string name = path.stem().string();
+			if (path.extension().string() != extensions::mesh || name.size() <= prefix.size() ||
+				!string_utils::begins_with(name, prefix))
+				continue;
+
+			const bool numbered = std::all_of(name.begin() + prefix.size(), name.end(), [](char c)
+			{
+				return std::isdigit(static_cast<unsigned char>(c)) != 0;
+			});
+			if (numbered && std::find(lods.begin(), lods.end(), name) == lods.end())
+				stale.push_back(path);
+		}
+
+		for (const auto& path : stale)
+			fs::remove(path, std::error_code{});
+
+		const fs::path manifest = dir / fs::path(file + extensions::mesh_lods);
+		if (lods.empty())
+		{
+			fs::remove(manifest, std::error_code{});
+			return;
+		}
+
+		std::vector<std::string> listed;
+		if (!ecs::utils::load_mesh_lods(manifest, listed) || listed != lods)
+			ecs::utils::save_mesh_lods(manifest, lods);
+	}
+
+	void compress_mesh(const std::string& name, const MeshCompiler::VertexSettings& settings, Mesh::LoadData& data)
+	{
+		Mesh::CompressionReport report;
+		report.source_bytes = report.compressed_bytes = data.vertex_data.size();
+		report.source_stride = report.compressed_stride = data.vertex_format.getStride();
+		if (settings.compress)
+			Mesh::compress_load_data(data, settings.quantize_positions, report);
+
+		MeshCompiler::VertexStats stats;
+		{
+			std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+			vertex_stats.meshes++;
+			vertex_stats.source_bytes += report.source_bytes;
+			vertex_stats.compiled_bytes += report.compressed_bytes;
+			stats = vertex_stats;
+		}
+
+		APPLOG_INFO("{0}: vertex data {1} -> {2} bytes ({3} -> {4} bytes per vertex), {5} bytes saved over {6} compiled meshes",
+			name, report.source_bytes, report.compressed_bytes, report.source_stride, report.compressed_stride,
+			stats.source_bytes - stats.compiled_bytes, stats.meshes);
+	}
+}
+
+bool ShaderCompiler::compile(const fs::path& absolute_key)
+{
+	std::string file = absolute_key.stem().string();
+	fs::path dir = absolute_key.parent_path();
+	fs::path output = dir / fs::path(file + extensions::shader);
+
+	static const std::size_t platform_count = 3;
+	static const std::array<gfx::RendererType::Enum, platform_count> supported =
+	{
+		gfx::RendererType::Direct3D11,
+		gfx::RendererType::OpenGL,
+		gfx::RendererType::Metal
+	};
+
+	// bump when the compile arguments change
+	static const std::string compiler_version = "shaderc-1-" + std::to_string(BGFX_API_VERSION);
+
+	const fs::path include_dir = fs::resolve_protocol("engine_data:/shaders");
+	std::vector<fs::path> includes;
+	AssetCompilerCache::collect_shader_includes(absolute_key, { include_dir }, includes);
+
+	AssetCompilerCache::KeyBuilder key;
+	key.add(compiler_version);
+	key.add(file.substr(0, 3));
+	for (auto& platform : supported)
+		key.add(std::to_string(platform));
+	key.add_file(absolute_key);
+	key.add_file(dir / (file + ".io"));
+	for (const auto& include : includes)
+		key.add_file(include);
+
+	if (AssetCompilerCache::try_reuse(key.get(), output))
+		return true;
+
+	const auto compile_start = std::chrono::high_resolution_clock::now();
+
+	// Every platform is compiled as its own task. shaderc keeps its state per
+	// invocation, so the variants of this and other shaders run concurrently.
+	std::array<fs::byte_array_t, platform_count> platform_binaries;
+	std::array<bool, platform_count> platform_results = {};
+
+	auto ts = core::get_subsystem<runtime::TaskSystem>();
+	auto master = ts->create("Compile Shader");
+	for (std::size_t i = 0; i < platform_count; ++i)
+	{
+		auto task = ts->create_as_child(master, "Compile Shader Platform", [&, i]()
+		{
+			platform_results[i] = compile_shader_for_platform(absolute_key, include_dir, supported[i], platform_binaries[i]);
+		});
+		ts->run(task);
+	}
+	ts->run(master);
+	ts->wait(master);
+
+	// A shader missing a platform would load everywhere but fail on that one,
+	// keep the previous output and leave nothing in the cache instead.
+	for (std::size_t i = 0; i < platform_count; ++i)
+	{
+		if (!platform_results[i])
+		{
+			APPLOG_ERROR("Failed compilation of {0}, output not written", absolute_key.string());
+			return false;
+		}
+	}
+
+	std::unordered_map<gfx::RendererType::Enum, fs::byte_array_t> binaries;
+	binaries.reserve(4);
+	for (std::size_t i = 0; i < platform_count; ++i)
+	{
+		if (!platform_binaries[i].empty())
+			binaries[supported[i]] = std::move(platform_binaries[i]);
 	}
 
 	fs::path entry = dir / fs::path(file + ".buildtemp");
@@ -137,6 +274,43 @@ void ShaderCompiler::compile(const fs::path& absolute_key)
 	}
 	fs::copy(entry, output, fs::copy_options::overwrite_existing, std::error_code{});
 	fs::remove(entry, std::error_code{});
+
+	AssetCompilerCache::store(key.get(), output, std::chrono::high_resolution_clock::now() - compile_start);
+	return true;
+}
+
+bool ShaderCompiler::compile(const std::vector<fs::path>& absolute_keys)
+{
+	const auto batch_start = std::chrono::high_resolution_clock::now();
+	std::atomic<std::int64_t> compile_time{ 0 };
+	std::atomic<std::uint32_t> failed{ 0 };
+
+	auto ts = core::get_subsystem<runtime::TaskSystem>();
+	auto master = ts->create("Compile Shaders");
+	for (const auto& absolute_key : absolute_keys)
+	{
+		auto task = ts->create_as_child(master, "Compile Shader", [absolute_key, &compile_time, &failed]()
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			if (!ShaderCompiler::compile(absolute_key))
+				failed++;
+			compile_time += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		});
+		ts->run(task);
+	}
+	ts->run(master);
+	ts->wait(master);
+
+	// the sum of the single compilations is what compiling them one after
+	// the other would take, compared to the time of the whole batch
+	const float batch_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - batch_start).count();
+	const float compile_ms = float(compile_time.load()) / 1000.0f;
+	APPLOG_INFO("Compiled {0} shaders in {1:.1f} ms, {2:.1f} ms of single compilations ({3:.1f}x)",
+		absolute_keys.size(), batch_ms, compile_ms, batch_ms > 0.0f ? compile_ms / batch_ms : 1.0f);
+	if (failed > 0)
+		APPLOG_ERROR("{0} of {1} shaders failed to compile", failed.load(), absolute_keys.size());
+
+	return failed == 0;
 }
 
 
@@ -150,6 +324,18 @@ void TextureCompiler::compile(const fs::path& absolute_key)
 
 	std::string str_output = output.string();
 
+	// bump when the compile arguments below change
+	static const std::string compiler_version = "texturec-1";
+
+	AssetCompilerCache::KeyBuilder key;
+	key.add(compiler_version);
+	key.add_file(absolute_key);
+
+	if (AssetCompilerCache::try_reuse(key.get(), output))
+		return;
+
+	const auto compile_start = std::chrono::high_resolution_clock::now();
+
 	if (raw_ext == ".dds" || raw_ext == ".pvr" || raw_ext == ".ktx")
 	{
 		if (!fs::copy_file(str_input, str_output, fs::copy_options::overwrite_existing, std::error_code{}))
@@ -159,6 +345,7 @@ void TextureCompiler::compile(const fs::path& absolute_key)
 		else
 		{
 			fs::last_write_time(str_output, fs::file_time_type::clock::now(), std::error_code{});
+			AssetCompilerCache::store(key.get(), output, std::chrono::high_resolution_clock::now() - compile_start);
 		}
 		return;
 	}
@@ -175,7 +362,40 @@ void TextureCompiler::compile(const fs::path& absolute_key)
 	if (compile_texture(arg_count, args_array) != 0)
 	{
 		APPLOG_ERROR("Failed compilation of {0}", str_input);
+		return;
 	}
+
+	AssetCompilerCache::store(key.get(), output, std::chrono::high_resolution_clock::now() - compile_start);
+}
+
+void MeshCompiler::set_vertex_settings(const VertexSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+	vertex_settings = settings;
+}
+
+MeshCompiler::VertexSettings MeshCompiler::get_vertex_settings()
+{
+	std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+	return vertex_settings;
+}
+
+MeshCompiler::VertexStats MeshCompiler::get_vertex_stats()
+{
+	std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+	return vertex_stats;
+}
+
+void MeshCompiler::set_lod_settings(const LodSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+	lod_settings = settings;
+}
+
+MeshCompiler::LodSettings MeshCompiler::get_lod_settings()
+{
+	std::lock_guard<std::mutex> lock(mesh_settings_mutex);
+	return lod_settings;
 }
 
 void MeshCompiler::compile(const fs::path& absolute_key)
@@ -185,6 +405,44 @@ void MeshCompiler::compile(const fs::path& absolute_key)
 	fs::path dir = absolute_key.parent_path();
 	fs::path output = dir / fs::path(file + extensions::mesh);
 
+	// bump when the importer or the mesh format changes
+	static const std::string compiler_version = "meshc-5";
+
+	const LodSettings settings = get_lod_settings();
+	const VertexSettings vertex_format = get_vertex_settings();
+
+	AssetCompilerCache::KeyBuilder key;
+	key.add(compiler_version);
+	key.add(vertex_format.compress ? "compress" : "float");
+	key.add(vertex_format.quantize_positions ? "quantize" : "");
+	key.add_file(absolute_key);
+
+	// Every level of detail is cached under its own key.
+	std::vector<fs::path> lod_outputs;
+	std::vector<std::string> lod_names;
+	std::vector<std::uint64_t> lod_keys;
+	for (std::size_t i = 0; i < settings.triangle_ratios.size(); ++i)
+	{
+		AssetCompilerCache::KeyBuilder lod_key = key;
+		lod_key.add("lod");
+		lod_key.add(std::to_string(settings.triangle_ratios[i]));
+		lod_key.add(std::to_string(settings.max_error));
+		lod_keys.push_back(lod_key.get());
+		lod_names.push_back(file + "_lod" + std::to_string(i + 1));
+		lod_outputs.push_back(dir / fs::path(lod_names.back() + extensions::mesh));
+	}
+
+	bool reused = AssetCompilerCache::try_reuse(key.get(), output);
+	for (std::size_t i = 0; i < lod_outputs.size(); ++i)
+		reused &= AssetCompilerCache::try_reuse(lod_keys[i], lod_outputs[i]);
+	if (reused)
+	{
+		update_mesh_lods(dir, file, lod_names);
+		return;
+	}
+
+	const auto compile_start = std::chrono::high_resolution_clock::now();
+
 	Mesh::LoadData data;
 	if (!importer::load_mesh_data_from_file(str_input, data))
 	{
@@ -192,13 +450,41 @@ void MeshCompiler::compile(const fs::path& absolute_key)
 		return;
 	}
 
-	fs::path entry = dir / fs::path(file + ".buildtemp");
+	// Levels of detail are simplified from the imported data and optimized
+	// the same way as the mesh itself. The ones that fail are left out of the
+	// list, and their outputs of earlier compilations are removed.
+	std::vector<std::string> generated_lods;
+	for (std::size_t i = 0; i < lod_outputs.size(); ++i)
 	{
-		std::ofstream soutput(entry, std::ios::out | std::ios::binary);
-		cereal::oarchive_binary_t ar(soutput);
-		try_save(ar, cereal::make_nvp("mesh", data));
+		const auto lod_start = std::chrono::high_resolution_clock::now();
+
+		Mesh::LoadData lod;
+		Mesh::LodReport report;
+		if (!Mesh::generate_lod(data, settings.triangle_ratios[i], settings.max_error, lod, report))
+		{
+			APPLOG_ERROR("Failed to generate lod {0} of {1}", i + 1, str_input);
+			continue;
+		}
+		Mesh::optimize_load_data(lod);
+		compress_mesh(lod_outputs[i].string(), vertex_format, lod);
+
+		const float ratio = report.source_triangles > 0 ? float(report.triangles) / float(report.source_triangles) : 0.0f;
+		APPLOG_INFO("{0} lod {1}: {2} of {3} triangles ({4:.1f}%, target {5:.1f}%), {6} of {7} vertices, error {8:.4f}",
+			str_input, i + 1, report.triangles, report.source_triangles, ratio * 100.0f, settings.triangle_ratios[i] * 100.0f,
+			report.vertices, report.source_vertices, report.error);
+
+		save_mesh(lod_outputs[i], dir / fs::path(lod_names[i] + ".buildtemp"), lod);
+		AssetCompilerCache::store(lod_keys[i], lod_outputs[i], std::chrono::high_resolution_clock::now() - lod_start);
+		generated_lods.push_back(lod_names[i]);
 	}
-	fs::copy(entry, output, fs::copy_options::overwrite_existing, std::error_code{});
-	fs::remove(entry, std::error_code{});
+	update_mesh_lods(dir, file, generated_lods);
+
+	// Meshes are loaded without optimization, so the triangle and vertex
+	// order is optimized here once.
+	Mesh::optimize_load_data(data);
+	compress_mesh(str_input, vertex_format, data);
+
+	save_mesh(output, dir / fs::path(file + ".buildtemp"), data);
 
+	AssetCompilerCache::store(key.get(), output, std::chrono::high_resolution_clock::now() - compile_start);
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <vector>
 #include "runtime/system/filesystem.h"
 
 struct Shader;
@@ -7,7 +9,24 @@ class Mesh;
 
 struct ShaderCompiler
 {
-	static void compile(const fs::path& absoluteKey);
+	//-----------------------------------------------------------------------------
+	//  Name : compile ()
+	/// <summary>
+	/// Compiles a shader for every supported platform. Returns false if any of
+	/// them failed, in which case the previous output is kept.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool compile(const fs::path& absoluteKey);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compile ()
+	/// <summary>
+	/// Compiles many shaders at once. Every shader and each of its platform
+	/// variants is a separate task, the call returns when all of them are done.
+	/// Returns false if any of them failed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool compile(const std::vector<fs::path>& absoluteKeys);
 };
 
 struct TextureCompiler
@@ -17,7 +36,95 @@ struct TextureCompiler
 
 struct MeshCompiler
 {
+	//-----------------------------------------------------------------------------
+	//  Name : LodSettings (Struct)
+	/// <summary>
+	/// Levels of detail generated next to every compiled mesh. The first one is
+	/// written to <name>_lod1.msc, the second to <name>_lod2.msc and so on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct LodSettings
+	{
+		/// Fraction of the source triangles to keep for each level of detail.
+		/// Empty by default, meaning that no levels of detail are generated.
+		std::vector<float> triangle_ratios;
+		/// Largest deviation allowed, relative to the extent of the mesh. A
+		/// level of detail that reaches it keeps more triangles than asked for.
+		float max_error = 0.05f;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : VertexSettings (Struct)
+	/// <summary>
+	/// Vertex format of compiled meshes, see Mesh::get_compressed_format.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct VertexSettings
+	{
+		/// Store half float texture coordinates and drop the bitangent.
+		bool compress = true;
+		/// Also quantize positions to 16 bits relative to the mesh bounds.
+		bool quantize_positions = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : VertexStats (Struct)
+	/// <summary>
+	/// Vertex data written by the mesh compiler since the editor started,
+	/// levels of detail included. Meshes restored from the cache are not counted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct VertexStats
+	{
+		/// Number of meshes written.
+		std::uint32_t meshes = 0;
+		/// Size of their vertex data as imported.
+		std::uint64_t source_bytes = 0;
+		/// Size of their vertex data as written.
+		std::uint64_t compiled_bytes = 0;
+	};
+
 	static void compile(const fs::path& absoluteKey);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_vertex_settings ()
+	/// <summary>
+	/// Sets the vertex format used for the meshes compiled from now on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_vertex_settings(const VertexSettings& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_vertex_settings ()
+	/// <summary>
+	/// Retrieves the vertex format used for compiled meshes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static VertexSettings get_vertex_settings();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_vertex_stats ()
+	/// <summary>
+	/// Retrieves the amount of vertex data written and saved so far.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static VertexStats get_vertex_stats();
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_lod_settings ()
+	/// <summary>
+	/// Sets the levels of detail generated for the meshes compiled from now on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_lod_settings(const LodSettings& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_lod_settings ()
+	/// <summary>
+	/// Retrieves the levels of detail generated for compiled meshes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static LodSettings get_lod_settings();
 };
 
 template<typename T>
@@ -0,0 +1,245 @@
+#include "asset_compiler_cache.h"
+#include "core/logging/logging.h"
+#include "core/serialization/serialization.h"
+#include "core/serialization/archives.h"
+#include "core/serialization/cereal/types/string.hpp"
+#include "core/serialization/cereal/types/unordered_map.hpp"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	struct CacheState
+	{
+		std::mutex mutex;
+		/// Directory where outputs are stored by key.
+		fs::path directory;
+		/// Output path -> key of the inputs it was produced from.
+		std::unordered_map<std::string, std::uint64_t> manifest;
+		/// Statistics since open.
+		AssetCompilerCache::Stats stats;
+		/// Compilations queued and not yet done.
+		std::atomic<std::uint32_t> pending{ 0 };
+		/// Statistics at the start of the current batch.
+		AssetCompilerCache::Stats batch_start;
+	};
+
+	CacheState& get_state()
+	{
+		static CacheState state;
+		return state;
+	}
+
+	fs::path get_manifest_path(const fs::path& directory)
+	{
+		return directory / "manifest.bin";
+	}
+
+	fs::path get_cached_path(const fs::path& directory, std::uint64_t key)
+	{
+		std::ostringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << key;
+		return directory / name.str();
+	}
+
+	void save_manifest(const fs::path& directory, const std::unordered_map<std::string, std::uint64_t>& manifest)
+	{
+		if (directory.empty())
+			return;
+
+		std::ofstream stream(get_manifest_path(directory), std::ios::out | std::ios::binary | std::ios::trunc);
+		cereal::oarchive_binary_t ar(stream);
+		try_save(ar, cereal::make_nvp("manifest", manifest));
+	}
+}
+
+AssetCompilerCache::KeyBuilder& AssetCompilerCache::KeyBuilder::add(const void* data, std::size_t size)
+{
+	static const std::uint64_t prime = 1099511628211ULL;
+
+	auto bytes = static_cast<const std::uint8_t*>(data);
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		_hash ^= bytes[i];
+		_hash *= prime;
+	}
+	return *this;
+}
+
+AssetCompilerCache::KeyBuilder& AssetCompilerCache::KeyBuilder::add(const std::string& str)
+{
+	// include the size so that ("ab", "c") and ("a", "bc") differ
+	const std::uint64_t size = str.size();
+	add(&size, sizeof(size));
+	return add(str.data(), str.size());
+}
+
+bool AssetCompilerCache::KeyBuilder::add_file(const fs::path& path)
+{
+	// only the file name, so that moving a project around keeps its cache valid
+	add(path.filename().generic_string());
+
+	std::ifstream stream{ path, std::ios::in | std::ios::binary };
+	if (!stream)
+		return false;
+
+	auto contents = fs::read_stream(stream);
+	add(contents.data(), contents.size());
+	return true;
+}
+
+void AssetCompilerCache::open(const fs::path& directory)
+{
+	auto& state = get_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	save_manifest(state.directory, state.manifest);
+
+	state.directory = directory;
+	state.manifest.clear();
+	state.stats = {};
+	state.batch_start = {};
+
+	fs::create_directories(directory, std::error_code{});
+
+	std::ifstream stream(get_manifest_path(directory), std::ios::in | std::ios::binary);
+	if (stream)
+	{
+		cereal::iarchive_binary_t ar(stream);
+		try_load(ar, cereal::make_nvp("manifest", state.manifest));
+	}
+}
+
+void AssetCompilerCache::close()
+{
+	auto& state = get_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	save_manifest(state.directory, state.manifest);
+	state.directory.clear();
+	state.manifest.clear();
+}
+
+bool AssetCompilerCache::try_reuse(std::uint64_t key, const fs::path& output)
+{
+	auto& state = get_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	if (state.directory.empty())
+		return false;
+
+	const auto output_key = output.generic_string();
+	auto it = state.manifest.find(output_key);
+	const bool up_to_date = it != state.manifest.end() && it->second == key && fs::exists(output, std::error_code{});
+	if (!up_to_date)
+	{
+		const auto cached = get_cached_path(state.directory, key);
+		if (!fs::exists(cached, std::error_code{}))
+			return false;
+
+		std::error_code err;
+		fs::copy_file(cached, output, fs::copy_options::overwrite_existing, err);
+		if (err)
+			return false;
+
+		state.manifest[output_key] = key;
+
+		// Touch the restored output so that watchers pick it up exactly as if it
+		// was compiled. An output that is already up to date is left alone.
+		fs::last_write_time(output, fs::file_time_type::clock::now(), std::error_code{});
+	}
+
+	state.stats.hits++;
+	return true;
+}
+
+void AssetCompilerCache::store(std::uint64_t key, const fs::path& output, duration compile_time)
+{
+	auto& state = get_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+
+	state.stats.misses++;
+	state.stats.compile_time += compile_time;
+
+	if (state.directory.empty() || !fs::exists(output, std::error_code{}))
+		return;
+
+	std::error_code err;
+	fs::copy_file(output, get_cached_path(state.directory, key), fs::copy_options::overwrite_existing, err);
+	if (!err)
+		state.manifest[output.generic_string()] = key;
+}
+
+void AssetCompilerCache::begin_compile()
+{
+	get_state().pending++;
+}
+
+void AssetCompilerCache::end_compile()
+{
+	auto& state = get_state();
+	if (--state.pending != 0)
+		return;
+
+	std::lock_guard<std::mutex> lock(state.mutex);
+	const auto hits = state.stats.hits - state.batch_start.hits;
+	const auto misses = state.stats.misses - state.batch_start.misses;
+	const auto compile_time = state.stats.compile_time - state.batch_start.compile_time;
+	state.batch_start = state.stats;
+
+	if (hits + misses > 0)
+	{
+		APPLOG_INFO("Asset compilation finished: {0} cache hits, {1} misses, {2} ms compiling", hits, misses, compile_time.count());
+	}
+
+	save_manifest(state.directory, state.manifest);
+}
+
+AssetCompilerCache::Stats AssetCompilerCache::get_stats()
+{
+	auto& state = get_state();
+	std::lock_guard<std::mutex> lock(state.mutex);
+	return state.stats;
+}
+
+void AssetCompilerCache::collect_shader_includes(const fs::path& source, const std::vector<fs::path>& include_dirs, std::vector<fs::path>& out_includes)
+{
+	static const std::regex include_regex("^\\s*#\\s*include\\s*[<\"]([^>\"]+)[>\"]");
+
+	std::unordered_set<std::string> visited;
+	std::vector<fs::path> stack = { source };
+	while (!stack.empty())
+	{
+		const auto file = stack.back();
+		stack.pop_back();
+
+		std::ifstream stream{ file, std::ios::in };
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			std::smatch match;
+			if (!std::regex_search(line, match, include_regex))
+				continue;
+
+			const fs::path include = match[1].str();
+			fs::path resolved = file.parent_path() / include;
+			for (auto it = include_dirs.begin(); !fs::exists(resolved, std::error_code{}) && it != include_dirs.end(); ++it)
+				resolved = *it / include;
+
+			if (!fs::exists(resolved, std::error_code{}))
+				continue;
+
+			resolved = fs::canonical(resolved, std::error_code{});
+			if (visited.insert(resolved.generic_string()).second)
+			{
+				out_includes.push_back(resolved);
+				stack.push_back(resolved);
+			}
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "runtime/system/filesystem.h"
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : AssetCompilerCache (Struct)
+/// <summary>
+/// Content addressed cache for compiled assets. The key of a compiled asset
+/// is a hash of everything that affects its output - source bytes, included
+/// files, compiler version and options. Outputs are stored in the cache
+/// directory under their key, so an unchanged asset is skipped, and an asset
+/// whose output is missing or stale is restored without compiling it again.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct AssetCompilerCache
+{
+	using duration = std::chrono::duration<float, std::milli>;
+
+	struct Stats
+	{
+		/// Assets that were skipped or restored from the cache.
+		std::uint32_t hits = 0;
+		/// Assets that had to be compiled.
+		std::uint32_t misses = 0;
+		/// Time spent compiling the misses.
+		duration compile_time = duration::zero();
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : KeyBuilder (Class)
+	/// <summary>
+	/// Accumulates the inputs of a compilation into a 64 bit key (FNV-1a).
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class KeyBuilder
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : add ()
+		/// <summary>
+		/// Adds raw bytes to the key.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		KeyBuilder& add(const void* data, std::size_t size);
+
+		//-----------------------------------------------------------------------------
+		//  Name : add ()
+		/// <summary>
+		/// Adds a string (an option, a version tag...) to the key.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		KeyBuilder& add(const std::string& str);
+
+		//-----------------------------------------------------------------------------
+		//  Name : add_file ()
+		/// <summary>
+		/// Adds the name and contents of a file to the key. Returns false if the
+		/// file could not be read, in which case only its name is added.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool add_file(const fs::path& path);
+
+		//-----------------------------------------------------------------------------
+		//  Name : get ()
+		/// <summary>
+		/// Returns the resulting key.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::uint64_t get() const { return _hash; }
+
+	private:
+		/// FNV-1a offset basis
+		std::uint64_t _hash = 14695981039346656037ULL;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Sets the cache directory and loads its manifest. Resets the statistics.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void open(const fs::path& directory);
+
+	//-----------------------------------------------------------------------------
+	//  Name : close ()
+	/// <summary>
+	/// Saves the manifest of the currently opened cache directory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void close();
+
+	//-----------------------------------------------------------------------------
+	//  Name : try_reuse ()
+	/// <summary>
+	/// Checks whether output is already the result of compiling key. If it is
+	/// not, tries to restore it from the cache directory. Returns true on a
+	/// cache hit, in which case the compilation can be skipped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool try_reuse(std::uint64_t key, const fs::path& output);
+
+	//-----------------------------------------------------------------------------
+	//  Name : store ()
+	/// <summary>
+	/// Records a freshly compiled output under key.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void store(std::uint64_t key, const fs::path& output, duration compile_time);
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_compile ()
+	/// <summary>
+	/// Marks a compilation as queued. When the last queued compilation ends,
+	/// the statistics of the batch are logged and the manifest is saved.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void begin_compile();
+
+	//-----------------------------------------------------------------------------
+	//  Name : end_compile ()
+	/// <summary>
+	/// Marks a queued compilation as done.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void end_compile();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_stats ()
+	/// <summary>
+	/// Returns the statistics since the cache was opened.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static Stats get_stats();
+
+	//-----------------------------------------------------------------------------
+	//  Name : collect_shader_includes ()
+	/// <summary>
+	/// Recursively collects the files included by a shader source. Includes are
+	/// resolved relative to the including file and then to the include dirs.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void collect_shader_includes(const fs::path& source, const std::vector<fs::path>& include_dirs, std::vector<fs::path>& out_includes);
+};
@@ -79,9 +79,6 @@ void process_vertices(aiMesh* mesh, Mesh::LoadData& load_data)
 		{
 			std::memcpy(math::value_ptr(tangent), &mesh->mTangents[i], sizeof(math::vec3));
 			tangent.w = 1.0f;
-			if (has_tangent)
-				gfx::vertexPack(math::value_ptr(tangent), true, gfx::Attrib::Tangent, load_data.vertex_format, current_vertex_ptr);
-
 		}
 
 		//binormals
@@ -90,13 +87,17 @@ void process_vertices(aiMesh* mesh, Mesh::LoadData& load_data)
 		{
 			std::memcpy(math::value_ptr(bitangent), &mesh->mBitangents[i], sizeof(math::vec3));
 			float handedness = math::dot(math::vec3(bitangent), math::normalize(math::cross(math::vec3(normal), math::vec3(tangent))));
-			tangent.w = handedness;
+			tangent.w = handedness < 0.0f ? -1.0f : 1.0f;
 
 			if (has_bitangent)
 				gfx::vertexPack(math::value_ptr(bitangent), true, gfx::Attrib::Bitangent, load_data.vertex_format, current_vertex_ptr);
 
 		}
 
+		// the tangent is stored last so that it carries the handedness
+		if (mesh->mTangents && has_tangent)
+			gfx::vertexPack(math::value_ptr(tangent), true, gfx::Attrib::Tangent, load_data.vertex_format, current_vertex_ptr);
+
 	}
 }
 
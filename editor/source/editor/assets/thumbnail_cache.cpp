@@ -0,0 +1,327 @@
+#include "thumbnail_cache.h"
+#include "asset_compiler_cache.h"
+#include "core/logging/logging.h"
+#include "runtime/rendering/texture.h"
+#include "runtime/system/engine.h"
+#include "runtime/system/task.h"
+#include "graphics/src/bgfx_p.h"
+#include "graphics/src/image.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace editor
+{
+	namespace
+	{
+		/// Written in front of the pixels of a persisted thumbnail.
+		struct ThumbnailHeader
+		{
+			static const std::uint32_t MAGIC = 0x424d4854; // 'THMB'
+			static const std::uint32_t VERSION = 1;
+
+			std::uint32_t magic = MAGIC;
+			std::uint32_t version = VERSION;
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+		};
+
+		fs::path get_thumbnail_path(const fs::path& directory, std::uint64_t key)
+		{
+			std::ostringstream name;
+			name << std::hex << std::setw(16) << std::setfill('0') << key;
+			return directory / name.str();
+		}
+
+		bool read_thumbnail(const fs::path& path, std::vector<std::uint8_t>& pixels, std::uint32_t& width, std::uint32_t& height)
+		{
+			std::ifstream stream(path, std::ios::in | std::ios::binary);
+			if (!stream)
+				return false;
+
+			ThumbnailHeader header;
+			stream.read(reinterpret_cast<char*>(&header), sizeof(ThumbnailHeader));
+			if (!stream || header.magic != ThumbnailHeader::MAGIC || header.version != ThumbnailHeader::VERSION)
+				return false;
+
+			if (header.width == 0 || header.height == 0 || header.width > ThumbnailCache::thumbnail_size || header.height > ThumbnailCache::thumbnail_size)
+				return false;
+
+			pixels.resize(header.width * header.height * 4);
+			stream.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+			if (!stream)
+				return false;
+
+			width = header.width;
+			height = header.height;
+			return true;
+		}
+
+		void write_thumbnail(const fs::path& path, const std::vector<std::uint8_t>& pixels, std::uint32_t width, std::uint32_t height)
+		{
+			std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!stream)
+				return;
+
+			ThumbnailHeader header;
+			header.width = width;
+			header.height = height;
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(ThumbnailHeader));
+			stream.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : downsample ()
+		/// <summary>
+		/// Box filters an rgba8 image to the given size, every destination pixel is
+		/// the average of the source pixels it covers.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void downsample(const std::uint8_t* src, std::uint32_t src_width, std::uint32_t src_height, std::uint8_t* dst, std::uint32_t dst_width, std::uint32_t dst_height)
+		{
+			for (std::uint32_t y = 0; y < dst_height; ++y)
+			{
+				const std::uint32_t y0 = y * src_height / dst_height;
+				const std::uint32_t y1 = std::max(y0 + 1, (y + 1) * src_height / dst_height);
+				for (std::uint32_t x = 0; x < dst_width; ++x)
+				{
+					const std::uint32_t x0 = x * src_width / dst_width;
+					const std::uint32_t x1 = std::max(x0 + 1, (x + 1) * src_width / dst_width);
+
+					std::uint32_t sum[4] = { 0, 0, 0, 0 };
+					for (std::uint32_t sy = y0; sy < y1; ++sy)
+					{
+						const std::uint8_t* row = src + (sy * src_width + x0) * 4;
+						for (std::uint32_t sx = x0; sx < x1; ++sx, row += 4)
+						{
+							sum[0] += row[0];
+							sum[1] += row[1];
+							sum[2] += row[2];
+							sum[3] += row[3];
+						}
+					}
+
+					const std::uint32_t count = (y1 - y0) * (x1 - x0);
+					std::uint8_t* pixel = dst + (y * dst_width + x) * 4;
+					for (int c = 0; c < 4; ++c)
+						pixel[c] = static_cast<std::uint8_t>(sum[c] / count);
+				}
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : decode_thumbnail ()
+		/// <summary>
+		/// Decodes the smallest mip of a compiled texture that is still at least
+		/// thumbnail_size big and downsamples it to fit thumbnail_size.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool decode_thumbnail(const fs::byte_array_t& contents, std::vector<std::uint8_t>& pixels, std::uint32_t& width, std::uint32_t& height)
+		{
+			const auto size = static_cast<std::uint32_t>(contents.size());
+
+			bgfx::ImageContainer container;
+			if (!bgfx::imageParse(container, contents.data(), size) || container.m_width == 0 || container.m_height == 0)
+				return false;
+
+			std::uint8_t lod = 0;
+			while (lod + 1 < container.m_numMips &&
+				std::max(container.m_width >> (lod + 1), container.m_height >> (lod + 1)) >= ThumbnailCache::thumbnail_size)
+			{
+				++lod;
+			}
+
+			bgfx::ImageMip mip;
+			if (!bgfx::imageGetRawData(container, 0, lod, contents.data(), size, mip))
+				return false;
+
+			std::vector<std::uint8_t> decoded(mip.m_width * mip.m_height * 4);
+			bgfx::imageDecodeToRgba8(decoded.data(), mip.m_data, mip.m_width, mip.m_height, mip.m_width * 4, mip.m_format);
+
+			const std::uint32_t largest = std::max(mip.m_width, mip.m_height);
+			if (largest <= ThumbnailCache::thumbnail_size)
+			{
+				pixels = std::move(decoded);
+				width = mip.m_width;
+				height = mip.m_height;
+				return true;
+			}
+
+			width = std::max(1u, mip.m_width * ThumbnailCache::thumbnail_size / largest);
+			height = std::max(1u, mip.m_height * ThumbnailCache::thumbnail_size / largest);
+			pixels.resize(width * height * 4);
+			downsample(decoded.data(), mip.m_width, mip.m_height, pixels.data(), width, height);
+			return true;
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : generate_thumbnail ()
+		/// <summary>
+		/// Runs on a worker. Reads the thumbnail from the cache directory or
+		/// decodes the compiled texture and stores the result there.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void generate_thumbnail(const fs::path& absolute, const fs::path& directory, std::vector<std::uint8_t>& pixels, std::uint32_t& width, std::uint32_t& height)
+		{
+			// Keyed on what the file system says about the file, so that a
+			// thumbnail found in the cache costs no read of the texture. The
+			// compiler stamps every output it writes, a rewritten file of the
+			// same size still gets a new key.
+			std::error_code err;
+			const std::uint64_t size = fs::file_size(absolute, err);
+			if (err)
+				return;
+			const std::int64_t write_time = fs::last_write_time(absolute, err).time_since_epoch().count();
+			if (err)
+				return;
+
+			AssetCompilerCache::KeyBuilder key;
+			key.add("thumbnail");
+			key.add(&ThumbnailCache::thumbnail_size, sizeof(ThumbnailCache::thumbnail_size));
+			key.add(absolute.generic_string());
+			key.add(&size, sizeof(size));
+			key.add(&write_time, sizeof(write_time));
+
+			const auto cached = directory.empty() ? fs::path() : get_thumbnail_path(directory, key.get());
+			if (!cached.empty() && read_thumbnail(cached, pixels, width, height))
+				return;
+
+			std::ifstream stream{ absolute, std::ios::in | std::ios::binary };
+			if (!stream)
+				return;
+
+			const auto contents = fs::read_stream(stream);
+
+			if (!decode_thumbnail(contents, pixels, width, height))
+			{
+				APPLOG_WARNING("Failed to generate a thumbnail for {0}", absolute.string());
+
+				width = height = 16;
+				pixels.resize(width * height * 4);
+				bgfx::imageCheckerboard(width, height, 4, UINT32_C(0xff404040), UINT32_C(0xff808080), pixels.data());
+			}
+
+			if (!cached.empty())
+				write_thumbnail(cached, pixels, width, height);
+		}
+	}
+
+	bool ThumbnailCache::initialize()
+	{
+		runtime::on_frame_end.connect(this, &ThumbnailCache::frame_end);
+
+		return true;
+	}
+
+	void ThumbnailCache::dispose()
+	{
+		runtime::on_frame_end.disconnect(this, &ThumbnailCache::frame_end);
+
+		_entries.clear();
+	}
+
+	void ThumbnailCache::open(const fs::path& directory)
+	{
+		// Jobs still in flight keep their own state alive and are just ignored.
+		_entries.clear();
+		_pending = 0;
+		_directory = directory;
+
+		fs::create_directories(directory, std::error_code{});
+	}
+
+	AssetHandle<Texture> ThumbnailCache::get_thumbnail(const fs::path& absolute)
+	{
+		auto& entry = _entries[absolute.generic_string()];
+		entry.last_used = _frame;
+
+		if (!entry.job && (entry.checked == 0 || _frame - entry.checked >= check_interval))
+		{
+			entry.checked = _frame;
+
+			std::error_code err;
+			const auto write_time = fs::last_write_time(absolute, err);
+			if (!err && write_time != entry.write_time)
+			{
+				entry.write_time = write_time;
+				entry.outdated = true;
+			}
+		}
+
+		if (entry.outdated && !entry.job && _pending < max_pending)
+		{
+			entry.outdated = false;
+			entry.job = std::make_shared<Job>();
+			++_pending;
+
+			auto ts = core::get_subsystem<runtime::TaskSystem>();
+			auto job = entry.job;
+			auto directory = _directory;
+			auto task = ts->create("Generate Thumbnail", [job, absolute, directory]()
+			{
+				generate_thumbnail(absolute, directory, job->pixels, job->width, job->height);
+				job->done = true;
+			});
+			ts->run(task);
+		}
+
+		// Until a new thumbnail is ready the outdated one is still shown.
+		return entry.texture;
+	}
+
+	void ThumbnailCache::frame_end(std::chrono::duration<float>)
+	{
+		std::size_t textures = 0;
+		for (auto& pair : _entries)
+		{
+			auto& entry = pair.second;
+			if (entry.job && entry.job->done)
+			{
+				auto& job = *entry.job;
+				if (!job.pixels.empty())
+				{
+					AssetHandle<Texture> texture;
+					texture.link->id = pair.first;
+					texture.link->asset = std::make_shared<Texture>(
+						static_cast<std::uint16_t>(job.width)
+						, static_cast<std::uint16_t>(job.height)
+						, false
+						, 1
+						, gfx::TextureFormat::RGBA8
+						, BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP
+						, gfx::copy(job.pixels.data(), static_cast<std::uint32_t>(job.pixels.size()))
+						);
+					entry.texture = texture;
+				}
+				entry.job.reset();
+				--_pending;
+			}
+
+			if (entry.texture)
+				++textures;
+		}
+
+		_frame++;
+
+		if (textures <= max_textures)
+			return;
+
+		// Release the least recently shown thumbnails. They are read back from
+		// the cache directory when shown again.
+		std::vector<std::pair<std::uint64_t, std::string>> candidates;
+		candidates.reserve(textures);
+		for (const auto& pair : _entries)
+		{
+			if (pair.second.texture && !pair.second.job)
+				candidates.emplace_back(pair.second.last_used, pair.first);
+		}
+
+		const std::size_t count = std::min(textures - max_textures, candidates.size());
+		std::partial_sort(std::begin(candidates), std::begin(candidates) + count, std::end(candidates));
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			_entries.erase(candidates[i].second);
+		}
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "core/subsystem/subsystem.h"
+#include "runtime/assets/asset_handle.h"
+#include "runtime/system/filesystem.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Texture;
+
+namespace editor
+{
+	//-----------------------------------------------------------------------------
+	// Main Class Declarations
+	//-----------------------------------------------------------------------------
+	//-----------------------------------------------------------------------------
+	//  Name : ThumbnailCache (Class)
+	/// <summary>
+	/// Small previews of compiled textures for the asset browser. Thumbnails are
+	/// decoded and downsampled on the task workers and persisted in the cache
+	/// directory keyed by the path, size and write time of the compiled file,
+	/// so a texture is only decoded again once it is recompiled. At most max_textures thumbnails live on the gpu,
+	/// the least recently shown ones are released first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class ThumbnailCache : public core::Subsystem
+	{
+	public:
+		/// Largest side of a thumbnail in pixels.
+		static const std::uint32_t thumbnail_size = 128;
+		/// Thumbnail textures kept alive at most.
+		static const std::size_t max_textures = 256;
+		/// Thumbnails being generated at the same time at most.
+		static const std::size_t max_pending = 4;
+		/// Frames between two checks of a compiled file for changes.
+		static const std::uint64_t check_interval = 60;
+
+		bool initialize();
+		void dispose();
+
+		//-----------------------------------------------------------------------------
+		//  Name : open ()
+		/// <summary>
+		/// Sets the directory the thumbnails are persisted in and drops the
+		/// thumbnails of the previous one.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void open(const fs::path& directory);
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_thumbnail ()
+		/// <summary>
+		/// Returns the thumbnail of a compiled texture. If it is not ready yet its
+		/// generation is queued and an empty handle is returned, the caller
+		/// should show a placeholder meanwhile.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		AssetHandle<Texture> get_thumbnail(const fs::path& absolute);
+
+		//-----------------------------------------------------------------------------
+		//  Name : frame_end ()
+		/// <summary>
+		/// Uploads the generated thumbnails and releases the ones over budget.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void frame_end(std::chrono::duration<float> dt);
+
+	private:
+		struct Job
+		{
+			/// Set by the worker once pixels, width and height are final.
+			std::atomic<bool> done{ false };
+			/// Rgba8 pixels, empty if the texture could not be decoded.
+			std::vector<std::uint8_t> pixels;
+			///
+			std::uint32_t width = 0;
+			///
+			std::uint32_t height = 0;
+		};
+
+		struct Entry
+		{
+			/// Write time of the compiled file the thumbnail was made from.
+			fs::file_time_type write_time;
+			/// Generation in flight.
+			std::shared_ptr<Job> job;
+			/// Uploaded thumbnail.
+			AssetHandle<Texture> texture;
+			/// Frame the thumbnail was last asked for.
+			std::uint64_t last_used = 0;
+			/// Frame the write time was last checked at.
+			std::uint64_t checked = 0;
+			/// The compiled file changed since the thumbnail was generated.
+			bool outdated = false;
+		};
+
+		/// Thumbnails by absolute path of the compiled texture.
+		std::unordered_map<std::string, Entry> _entries;
+		/// Directory the thumbnails are persisted in.
+		fs::path _directory;
+		/// Number of jobs in flight.
+		std::size_t _pending = 0;
+		/// Frame counter for the lru.
+		std::uint64_t _frame = 1;
+	};
+}
@@ -27,6 +27,8 @@ ConsoleLog::entries_t ConsoleLog::get_items()
 
 void ConsoleLog::clearLog()
 {
+	// entries are added from the logging thread
+	std::lock_guard<std::mutex> lock(_mutex);
 	_entries = entries_t();
 	_pending = 0;
 }
\ No newline at end of file
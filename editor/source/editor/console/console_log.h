@@ -4,6 +4,7 @@
 #include <core/console/console.h>
 #include <string>
 #include <deque>
+#include <atomic>
 class ConsoleLog : public logging::sinks::base_sink<std::mutex>, public Console
 {
 public:
@@ -72,7 +73,7 @@ private:
 	///
 	entries_t _entries;
 	///
-	int _pending = 0;
+	std::atomic<int> _pending = { 0 };
 	///
 	static const std::size_t _max_size = 50;
 };
\ No newline at end of file
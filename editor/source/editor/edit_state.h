@@ -109,6 +109,8 @@ namespace editor
 		bool show_grid = true;
 		/// enable wireframe selection
 		bool wireframe_selection = true;
+		/// enable bounds of all models in view
+		bool show_bounds = false;
 		/// current manipulation gizmo operation.
 		imguizmo::OPERATION operation = imguizmo::TRANSLATE;
 		/// current manipulation gizmo space.
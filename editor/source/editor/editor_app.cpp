@@ -8,6 +8,7 @@
 #include "project.h"
 #include "systems/picking_system.h"
 #include "systems/debugdraw_system.h"
+#include "assets/thumbnail_cache.h"
 
 namespace editor
 {
@@ -35,6 +36,7 @@ namespace editor
 		core::add_subsystem<EditState>();
 		core::add_subsystem<PickingSystem>();
 		core::add_subsystem<DebugDrawSystem>();
+		core::add_subsystem<ThumbnailCache>();
 		core::add_subsystem<ProjectManager>();
 	}
 }
\ No newline at end of file
@@ -54,7 +54,11 @@ void default_scene()
 		object.assign<TransformComponent>().lock()
 			->set_local_position({ 1.0f, 6.0f, -3.0f })
 			.rotate_local(50.0f, -30.0f, 0.0f);
-		object.assign<LightComponent>();
+
+		Light light;
+		light.casts_shadows = true;
+		object.assign<LightComponent>().lock()
+			->set_light(light);
 	}
 	{
 		auto object = ecs->create();
@@ -90,7 +94,7 @@ void default_scene()
 		am->load<Mesh>("embedded:/plane", false)
 			.then([&model](auto asset)
 		{
-			model.set_lod(asset, 0);
+			model = ecs::utils::create_model(asset);
 		});
 
 		//Add component and configure it.
@@ -109,7 +113,7 @@ void default_scene()
 		am->load<Mesh>("embedded:/sphere", false)
 			.then([&model](auto asset)
 		{
-			model.set_lod(asset, 0);
+			model = ecs::utils::create_model(asset);
 		});
 
 		//Add component and configure it.
@@ -180,6 +184,40 @@ void save_scene_as()
 	es->save_editor_camera();
 }
 
+void edit_mesh_lods()
+{
+	auto pm = core::get_subsystem<editor::ProjectManager>();
+	auto& settings = pm->get_options().mesh_lods;
+	auto& ratios = settings.triangle_ratios;
+
+	bool changed = false;
+	for (std::size_t i = 0; i < ratios.size(); ++i)
+	{
+		const std::string label = "Lod " + std::to_string(i + 1);
+		changed |= gui::SliderFloat(label.c_str(), &ratios[i], 0.01f, 1.0f, "%.2f of the triangles");
+	}
+	changed |= gui::SliderFloat("Max Error", &settings.max_error, 0.001f, 1.0f, "%.3f");
+
+	if (gui::Button("Add"))
+	{
+		ratios.push_back(ratios.empty() ? 0.5f : ratios.back() * 0.5f);
+		changed = true;
+	}
+	gui::SameLine();
+	if (gui::Button("Remove") && !ratios.empty())
+	{
+		ratios.pop_back();
+		changed = true;
+	}
+
+	// applies to meshes compiled from now on
+	if (changed)
+	{
+		MeshCompiler::set_lod_settings(settings);
+		pm->save_config();
+	}
+}
+
 
 MainEditorWindow::MainEditorWindow()
 {
@@ -296,6 +334,12 @@ void MainEditorWindow::on_menubar()
 			if (gui::MenuItem("Paste", "CTRL+V"))
 			{
 
+			}
+			gui::Separator();
+			if (gui::BeginMenu("Mesh Levels Of Detail"))
+			{
+				edit_mesh_lods();
+				gui::EndMenu();
 			}
 			gui::EndMenu();
 		}
@@ -13,7 +13,9 @@
 #include "runtime/input/input.h"
 #include "../../edit_state.h"
 #include "../../project.h"
+#include "../../assets/thumbnail_cache.h"
 #include "../../filedialog/filedialog.h"
+#include <algorithm>
 #include <cstdio>
 
 template<typename T>
@@ -23,11 +25,6 @@ AssetHandle<Texture> get_asset_icon(T asset)
 	return es->icons["folder"];
 }
 
-template<>
-AssetHandle<Texture> get_asset_icon(AssetHandle<Texture> asset)
-{
-	return asset;
-}
 template<>
 AssetHandle<Texture> get_asset_icon(AssetHandle<Prefab> asset)
 {
@@ -74,6 +71,39 @@ AssetHandle<Texture>& get_icon()
 	return tex;
 }
 
+template<typename Wrapper>
+AssetHandle<Texture> get_list_icon(const Wrapper& entry, const fs::path& absolute, const float size, bool& loading)
+{
+	loading = !entry;
+	return loading ? get_loading_icon() : get_asset_icon(entry);
+}
+
+AssetHandle<Texture> get_list_icon(const AssetHandle<Texture>& entry, const fs::path& absolute, const float size, bool& loading)
+{
+	// Textures are not loaded just to be listed, they show a thumbnail instead
+	// which is only requested once the item is actually on screen.
+	AssetHandle<Texture> thumbnail;
+	if (gui::IsRectVisible({ size, size }))
+	{
+		auto thumbnails = core::get_subsystem<editor::ThumbnailCache>();
+		thumbnail = thumbnails->get_thumbnail(absolute);
+	}
+
+	loading = !thumbnail;
+	return loading ? get_loading_icon() : thumbnail;
+}
+
+template<typename Wrapper>
+void request_asset(Wrapper& entry, const std::string& relative, runtime::AssetManager& manager)
+{
+}
+
+void request_asset(AssetHandle<Texture>& entry, const std::string& relative, runtime::AssetManager& manager)
+{
+	if (!entry)
+		entry = manager.load<Texture>(relative, true).asset;
+}
+
 template<typename Wrapper, typename T>
 int list_item(Wrapper& entry,
 	const std::string& name,
@@ -141,20 +171,16 @@ int list_item(Wrapper& entry,
 		// 		}
 	}
 
-	bool loading = !entry;
-
-	AssetHandle<Texture>& icon = get_icon();
-
-	if (loading)
-		icon = get_loading_icon();
-	else
-		icon = get_asset_icon(entry);
-
 	gui::PushID(relative.c_str());
 
 	if (gui::GetContentRegionAvailWidth() < size)
 		gui::NewLine();
 
+	bool loading = false;
+
+	AssetHandle<Texture>& icon = get_icon();
+	icon = get_list_icon(entry, absolute, size, loading);
+
 	static std::string inputBuff(64, 0);
 	std::memset(&inputBuff[0], 0, 64);
 	std::memcpy(&inputBuff[0], name.c_str(), name.size() < 64 ? name.size() : 64);
@@ -186,6 +212,7 @@ int list_item(Wrapper& entry,
 
 	if (action == 1)
 	{
+		request_asset(entry, relative, manager);
 		edit_state.select(entry);
 	}
 	else if (action == 2)
@@ -213,6 +240,7 @@ int list_item(Wrapper& entry,
 	{
 		if (gui::IsMouseClicked(gui::drag_button) && !edit_state.drag_data.object)
 		{
+			request_asset(entry, relative, manager);
 			edit_state.drag(entry, relative);
 		}
 
@@ -226,135 +254,162 @@ int list_item(Wrapper& entry,
 };
 
 
-void list_dir(std::weak_ptr<editor::AssetFolder>& opened_folder, const float size)
+void list_file(const editor::AssetFile& file,
+	const float size,
+	std::weak_ptr<editor::AssetFolder> opened_folder,
+	runtime::AssetManager* am,
+	runtime::Input* input,
+	editor::EditState* es)
 {
-	if (opened_folder.expired())
-		return;
-
-	editor::AssetFolder* dir = opened_folder.lock().get();
-	
-	auto es = core::get_subsystem<editor::EditState>();
-	auto am = core::get_subsystem<runtime::AssetManager>();
-	auto input = core::get_subsystem<runtime::Input>();
+	if (file.extension == extensions::texture)
+	{
+		AssetHandle<Texture> asset;
+		if (auto request = am->find_asset_entry<Texture>(file.relative))
+			asset = request->asset;
+
+		list_item<AssetHandle<Texture>, Texture>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+	}
+	if (file.extension == extensions::mesh)
 	{
-		std::unique_lock<std::mutex> lock(dir->directories_mutex);
 
-		for (auto& entry : dir->directories)
+		auto asset = am->find_or_create_asset_entry<Mesh>(file.relative).asset;
+
+		list_item<AssetHandle<Mesh>, Mesh>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+	}
+	if (file.extension == extensions::material)
+	{
+		auto asset = am->find_or_create_asset_entry<Material>(file.relative).asset;
+
+		list_item<AssetHandle<Material>, Material>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+	}
+	if (file.extension == extensions::prefab)
+	{
+		auto asset = am->find_or_create_asset_entry<Prefab>(file.relative).asset;
+
+		list_item<AssetHandle<Prefab>, Prefab>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+	}
+	if (file.extension == extensions::scene)
+	{
+		auto asset = am->find_or_create_asset_entry<Scene>(file.relative).asset;
+
+		int action = list_item<AssetHandle<Scene>, Scene>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+
+		if (action == 3)
 		{
-			int action = list_item<std::shared_ptr<editor::AssetFolder>, editor::AssetFolder>(
-				entry,
-				entry->name,
-				entry->relative,
-				entry->absolute,
-				size,
-				opened_folder,
-				*am, *input, *es);
-			if (action == 3)
+			if (asset)
 			{
-				opened_folder = entry;
+				auto es = core::get_subsystem<editor::EditState>();
+				auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+
+				ecs->dispose();
+				es->load_editor_camera();
+				asset->instantiate();
+				es->scene = fs::resolve_protocol(asset.id()).string() + extensions::scene;
+
 			}
+
 		}
 	}
+	if (file.extension == extensions::shader)
 	{
-		std::unique_lock<std::mutex> lock(dir->files_mutex);
+		auto asset = am->find_or_create_asset_entry<Shader>(file.relative).asset;
+
+		list_item<AssetHandle<Shader>, Shader>(
+			asset,
+			file.name,
+			file.relative,
+			file.absolute,
+			size,
+			opened_folder,
+			*am, *input, *es);
+	}
+}
 
-		for (auto& file : dir->files)
-		{
-			if (file.extension == extensions::texture)
-			{
-				auto asset = am->find_or_create_asset_entry<Texture>(file.relative).asset;
-
-				list_item<AssetHandle<Texture>, Texture>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-			}
-			if (file.extension == extensions::mesh)
-			{
+void list_dir(std::weak_ptr<editor::AssetFolder>& opened_folder,
+	const std::vector<std::shared_ptr<editor::AssetFolder>>& directories,
+	const std::vector<editor::AssetFile>& files,
+	const float size)
+{
+	if (opened_folder.expired())
+		return;
+
+	auto es = core::get_subsystem<editor::EditState>();
+	auto am = core::get_subsystem<runtime::AssetManager>();
+	auto input = core::get_subsystem<runtime::Input>();
 
-				auto asset = am->find_or_create_asset_entry<Mesh>(file.relative).asset;
+	// Items are laid out in rows of equal height, so only the rows on screen
+	// have to be submitted.
+	const float spacing = gui::GetStyle().ItemSpacing.x;
+	const auto columns = std::max(1, static_cast<int>((gui::GetContentRegionAvailWidth() + spacing) / (size + spacing)));
+	const auto count = static_cast<int>(directories.size() + files.size());
+	const auto rows = (count + columns - 1) / columns;
 
-				list_item<AssetHandle<Mesh>, Mesh>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-			}
-			if (file.extension == extensions::material)
-			{
-				auto asset = am->find_or_create_asset_entry<Material>(file.relative).asset;
-
-				list_item<AssetHandle<Material>, Material>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-			}
-			if (file.extension == extensions::prefab)
-			{
-				auto asset = am->find_or_create_asset_entry<Prefab>(file.relative).asset;
-
-				list_item<AssetHandle<Prefab>, Prefab>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-			}
-			if (file.extension == extensions::scene)
+	ImGuiListClipper clipper(rows);
+	while (clipper.Step())
+	{
+		for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+		{
+			const int end = std::min(count, (row + 1) * columns);
+			for (int i = row * columns; i < end; ++i)
 			{
-				auto asset = am->find_or_create_asset_entry<Scene>(file.relative).asset;
-
-				int action = list_item<AssetHandle<Scene>, Scene>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-
-				if (action == 3)
+				if (i < static_cast<int>(directories.size()))
 				{
-					if (asset)
+					auto& entry = directories[i];
+					auto item = entry;
+					int action = list_item<std::shared_ptr<editor::AssetFolder>, editor::AssetFolder>(
+						item,
+						entry->name,
+						entry->relative,
+						entry->absolute,
+						size,
+						opened_folder,
+						*am, *input, *es);
+					if (action == 3)
 					{
-						auto es = core::get_subsystem<editor::EditState>();
-						auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
-
-						ecs->dispose();
-						es->load_editor_camera();
-						asset->instantiate();
-						es->scene = fs::resolve_protocol(asset.id()).string() + extensions::scene;
-
+						opened_folder = entry;
 					}
-
+				}
+				else
+				{
+					list_file(files[i - directories.size()], size, opened_folder, am, input, es);
 				}
 			}
-			if (file.extension == extensions::shader)
-			{
-				auto asset = am->find_or_create_asset_entry<Shader>(file.relative).asset;
-
-				list_item<AssetHandle<Shader>, Shader>(
-					asset,
-					file.name,
-					file.relative,
-					file.absolute,
-					size,
-					opened_folder,
-					*am, *input, *es);
-			}
+			gui::NewLine();
 		}
 	}
 
@@ -412,6 +467,75 @@ void list_dir(std::weak_ptr<editor::AssetFolder>& opened_folder, const float siz
 
 }
 
+void collect_files(editor::AssetFolder& folder, std::vector<editor::AssetFile>& files)
+{
+	std::vector<std::shared_ptr<editor::AssetFolder>> directories;
+	{
+		std::unique_lock<std::mutex> lock(folder.files_mutex);
+		files.insert(std::end(files), std::begin(folder.files), std::end(folder.files));
+	}
+	{
+		std::unique_lock<std::mutex> lock(folder.directories_mutex);
+		directories = folder.directories;
+	}
+
+	for (auto& directory : directories)
+	{
+		collect_files(*directory, files);
+	}
+}
+
+void AssetsDock::refresh_listing()
+{
+	auto folder = opened_folder.lock();
+	if (!folder)
+		return;
+
+	const auto revision = folder->revision.load();
+	if (_listed_folder.lock() == folder && _listed_revision == revision)
+		return;
+
+	_listed_folder = folder;
+	_listed_revision = revision;
+	{
+		std::unique_lock<std::mutex> lock(folder->directories_mutex);
+		_listed_directories = folder->directories;
+	}
+	{
+		std::unique_lock<std::mutex> lock(folder->files_mutex);
+		_listed_files = folder->files;
+	}
+}
+
+void AssetsDock::refresh_search()
+{
+	auto project = core::get_subsystem<editor::ProjectManager>();
+	auto root = project->get_root_directory().lock();
+	if (!root)
+		return;
+
+	const auto revision = root->revision.load();
+	if (_indexed_root.lock() != root || _indexed_revision != revision)
+	{
+		_indexed_root = root;
+		_indexed_revision = revision;
+		_search_index.clear();
+		collect_files(*root, _search_index);
+		_search_dirty = true;
+	}
+
+	if (!_search_dirty)
+		return;
+
+	_search_files.clear();
+	for (const auto& file : _search_index)
+	{
+		if (_filter.PassFilter(file.relative.c_str()))
+			_search_files.push_back(file);
+	}
+	_search_dirty = false;
+}
+
 void AssetsDock::render(const ImVec2& area)
 {
 	auto project = core::get_subsystem<editor::ProjectManager>();
@@ -479,6 +603,9 @@ void AssetsDock::render(const ImVec2& area)
 	}
 	gui::PopItemWidth();
 	gui::SameLine();
+	if (_filter.Draw("Search", 150.0f))
+		_search_dirty = true;
+	gui::SameLine();
 
 	std::vector<editor::AssetFolder*> hierarchy;
 	editor::AssetFolder* folder = opened_folder.lock().get();
@@ -530,7 +657,16 @@ void AssetsDock::render(const ImVec2& area)
 		}
 
 		get_icon() = AssetHandle<Texture>();
-		list_dir(opened_folder, 88.0f * scale_icons);
+		if (_filter.IsActive())
+		{
+			refresh_search();
+			list_dir(opened_folder, {}, _search_files, 88.0f * scale_icons);
+		}
+		else
+		{
+			refresh_listing();
+			list_dir(opened_folder, _listed_directories, _listed_files, 88.0f * scale_icons);
+		}
 		get_icon() = AssetHandle<Texture>();
 		gui::EndChild();
 	}
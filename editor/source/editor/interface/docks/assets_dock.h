@@ -1,11 +1,9 @@
 #pragma once
 #include "imguidock.h"
+#include "../../project.h"
+#include <cstdint>
 #include <memory>
-
-namespace editor
-{
-	struct AssetFolder;
-}
+#include <vector>
 
 struct AssetsDock : public ImGuiDock::Dock
 {
@@ -13,6 +11,44 @@ struct AssetsDock : public ImGuiDock::Dock
 	void render(const ImVec2& area);
 
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : refresh_listing ()
+	/// <summary>
+	/// Copies the contents of the opened folder if they changed since the last
+	/// copy, so that listing them does not hold the folder locks.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void refresh_listing();
+
+	//-----------------------------------------------------------------------------
+	//  Name : refresh_search ()
+	/// <summary>
+	/// Rebuilds the index of all project files if the project changed and the
+	/// files matching the filter if the index or the filter changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void refresh_search();
+
 	std::weak_ptr<editor::AssetFolder> opened_folder;
 	float scale_icons = 0.7f;
+	/// Folder the listing was copied from.
+	std::weak_ptr<editor::AssetFolder> _listed_folder;
+	/// Revision of the folder when it was copied.
+	std::uint64_t _listed_revision = 0;
+	///
+	std::vector<std::shared_ptr<editor::AssetFolder>> _listed_directories;
+	///
+	std::vector<editor::AssetFile> _listed_files;
+	/// Root folder the index was built from.
+	std::weak_ptr<editor::AssetFolder> _indexed_root;
+	/// Revision of the root folder when the index was built.
+	std::uint64_t _indexed_revision = 0;
+	/// Every file of the project.
+	std::vector<editor::AssetFile> _search_index;
+	/// Files matching the filter.
+	std::vector<editor::AssetFile> _search_files;
+	///
+	ImGuiTextFilter _filter;
+	/// The index or the filter changed since the matches were collected.
+	bool _search_dirty = true;
 };
\ No newline at end of file
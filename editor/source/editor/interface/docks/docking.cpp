@@ -9,6 +9,7 @@
 #include "assets_dock.h"
 #include "console_dock.h"
 #include "style_dock.h"
+#include "profiler_dock.h"
 #include "../../console/console_log.h"
 
 bool DockingSystem::initialize()
@@ -21,6 +22,7 @@ bool DockingSystem::initialize()
 	_docks.emplace_back(std::make_unique<AssetsDock>("Assets", true, ImVec2(200.0f, 200.0f)));
 	_docks.emplace_back(std::make_unique<ConsoleDock>("Console", true, ImVec2(200.0f, 200.0f), console_log));
 	_docks.emplace_back(std::make_unique<StyleDock>("Style", true, ImVec2(300.0f, 200.0f)));
+	_docks.emplace_back(std::make_unique<ProfilerDock>("Profiler", true, ImVec2(300.0f, 200.0f)));
 
 	auto& scene = _docks[0];
 	auto& game = _docks[1];
@@ -29,6 +31,7 @@ bool DockingSystem::initialize()
 	auto& assets = _docks[4];
 	auto& console = _docks[5];
 	auto& style = _docks[6];
+	auto& profiler = _docks[7];
 
 	auto engine = core::get_subsystem<runtime::Engine>();
 	const auto& windows = engine->get_windows();
@@ -40,6 +43,7 @@ bool DockingSystem::initialize()
 	dockspace.dock_with(hierarchy.get(), scene.get(), ImGuiDock::DockSlot::Left, 300, true);
 	dockspace.dock(console.get(), ImGuiDock::DockSlot::Bottom, 250, true);
 	dockspace.dock_with(assets.get(), console.get(), ImGuiDock::DockSlot::Tab, 250, true);
+	dockspace.dock_with(profiler.get(), console.get(), ImGuiDock::DockSlot::Tab, 250, false);
 	dockspace.dock_with(style.get(), assets.get(), ImGuiDock::DockSlot::Right, 300, true);
 
 	auto logger = logging::get(APPLOG);
@@ -5,11 +5,11 @@
 #include "runtime/ecs/utils.h"
 #include "runtime/ecs/components/transform_component.h"
 #include "runtime/ecs/components/model_component.h"
-#include "runtime/ecs/systems/scene_graph.h"
 #include "runtime/input/input.h"
 #include "runtime/system/filesystem.h"
 #include "runtime/rendering/mesh.h"
 #include "runtime/assets/asset_handle.h"
+#include <algorithm>
 
 void check_context_menu(runtime::Entity entity)
 {
@@ -120,8 +120,7 @@ void check_drag(runtime::Entity entity)
 					if (gui::IsMouseReleased(gui::drag_button))
 					{
 						auto mesh = dragged.get_value<AssetHandle<Mesh>>();
-						Model model;
-						model.set_lod(mesh, 0);
+						auto model = ecs::utils::create_model(mesh);
 
 						auto object = ecs->create();
 						//Add component and configure it.
@@ -132,6 +131,9 @@ void check_drag(runtime::Entity entity)
 							->set_casts_shadow(true)
 							.set_casts_reflection(false)
 							.set_model(model);
+						//Create the bones of skinned meshes.
+						if (mesh)
+							ecs::utils::create_armature(object, *mesh.get());
 
 						es->drop();
 						es->select(object);
@@ -143,11 +145,8 @@ void check_drag(runtime::Entity entity)
 
 }
 
-void draw_entity(runtime::Entity entity)
+bool draw_entity(runtime::Entity entity, bool has_children, bool expanded)
 {
-	if (!entity)
-		return;
-
 	gui::PushID(entity.id().index());
 	gui::AlignFirstTextHeightToWidgets();
 	auto es = core::get_subsystem<editor::EditState>();
@@ -177,16 +176,15 @@ void draw_entity(runtime::Entity entity)
 	}
 
 	auto transformComponent = entity.component<TransformComponent>().lock();
-	bool no_children = true;
-	if (transformComponent)
-		no_children = transformComponent->get_children().empty();
 
-	if (no_children)
+	// Rows are laid out flat by the dock, so the node is not pushed and its
+	// open state is kept by the dock rather than by imgui.
+	flags |= ImGuiTreeNodeFlags_NoTreePushOnOpen;
+	if (!has_children)
 		flags |= ImGuiTreeNodeFlags_Leaf;
 
-
-
 	auto pos = gui::GetCursorScreenPos();
+	gui::SetNextTreeNodeOpen(expanded, ImGuiSetCond_Always);
 	bool opened = gui::TreeNodeEx(name.c_str(), flags);
 
 	if (edit_label && is_selected)
@@ -245,34 +243,116 @@ void draw_entity(runtime::Entity entity)
 		check_drag(entity);
 	}
 
+	gui::PopID();
+
+	return opened;
+}
+
+void HierarchyDock::rebuild_rows()
+{
+	auto es = core::get_subsystem<editor::EditState>();
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+
+	std::vector<runtime::Entity> roots;
+	ecs->each<TransformComponent>([&roots](runtime::Entity e, TransformComponent& transformComponent)
+	{
+		if (transformComponent.get_parent().expired())
+			roots.push_back(e);
+	});
+
+	// The editor camera goes first so that it can be separated from the scene.
+	auto& editor_camera = es->camera;
+	std::stable_partition(std::begin(roots), std::end(roots), [&editor_camera](const runtime::Entity& e)
+	{
+		return e == editor_camera;
+	});
+
+	_rows.clear();
+	for (const auto& root : roots)
+	{
+		add_rows(root, 0);
+	}
+}
+
+void HierarchyDock::add_rows(runtime::Entity entity, std::uint32_t depth)
+{
+	auto transformComponent = entity.component<TransformComponent>().lock();
+
+	Row row;
+	row.entity = entity;
+	row.depth = depth;
+	row.has_children = transformComponent && !transformComponent->get_children().empty();
+	_rows.push_back(row);
+
+	if (!row.has_children || _expanded.count(entity.id().id()) == 0)
+		return;
+
+	for (auto& child : transformComponent->get_children())
+	{
+		if (!child.expired())
+			add_rows(child.lock()->get_entity(), depth + 1);
+	}
+}
 
-	if (opened)
+void HierarchyDock::rebuild_search()
+{
+	if (_index_dirty)
 	{
-		if (!no_children)
+		auto es = core::get_subsystem<editor::EditState>();
+		auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+		auto& editor_camera = es->camera;
+
+		_search_index.clear();
+		ecs->each<TransformComponent>([this, &editor_camera](runtime::Entity e, TransformComponent&)
 		{
-			auto children = entity.component<TransformComponent>().lock()->get_children();
-			for (auto& child : children)
-			{
-				if (!child.expired())
-					draw_entity(child.lock()->get_entity());
-			}
-		}
+			if (e != editor_camera)
+				_search_index.push_back({ e, e.to_string() });
+		});
+		_index_dirty = false;
+		_search_dirty = true;
+	}
 
-		gui::TreePop();
+	if (!_search_dirty)
+		return;
+
+	_search_rows.clear();
+	for (const auto& entry : _search_index)
+	{
+		if (_filter.PassFilter(entry.name.c_str()))
+		{
+			Row row;
+			row.entity = entry.entity;
+			_search_rows.push_back(row);
+		}
 	}
+	_search_dirty = false;
+}
 
-	gui::PopID();
+void HierarchyDock::on_entity_changed(runtime::Entity entity)
+{
+	_rows_dirty = true;
+	_index_dirty = true;
+}
+
+void HierarchyDock::on_entity_destroyed(runtime::Entity entity)
+{
+	_expanded.erase(entity.id().id());
+	_rows_dirty = true;
+	_index_dirty = true;
+}
+
+void HierarchyDock::on_component_changed(runtime::Entity entity, runtime::CHandle<runtime::Component> component)
+{
+	_rows_dirty = true;
+	_index_dirty = true;
 }
 
 void HierarchyDock::render(const ImVec2& area)
 {
 	auto es = core::get_subsystem<editor::EditState>();
 	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
-	auto sg = core::get_subsystem<runtime::SceneGraph>();
 	auto input = core::get_subsystem<runtime::Input>();
 
-	auto& roots = sg->get_roots();
-
 	auto& editor_camera = es->camera;
 	auto& selected = es->selection_data.object;
 	auto& dragged = es->drag_data.object;
@@ -313,17 +393,62 @@ void HierarchyDock::render(const ImVec2& area)
 		}
 	}
 
-	for (auto& root : roots)
+	if (_filter.Draw("Search", 180.0f))
+		_search_dirty = true;
+
+	if (_rows_dirty)
 	{
-		if (!root.expired())
+		rebuild_rows();
+		_rows_dirty = false;
+	}
+
+	const bool searching = _filter.IsActive();
+	if (searching)
+		rebuild_search();
+
+	const auto& rows = searching ? _search_rows : _rows;
+
+	// Only the rows on screen are drawn, the rest is skipped by the clipper.
+	std::size_t first = 0;
+	if (!searching && !rows.empty() && rows.front().entity == editor_camera)
+	{
+		draw_entity(editor_camera, false, false);
+		gui::Separator();
+		first = 1;
+	}
+
+	const float indent = gui::GetStyle().IndentSpacing;
+	ImGuiListClipper clipper(static_cast<int>(rows.size() - first));
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
 		{
-			auto entity = root.lock()->get_entity();
-			draw_entity(entity);
-			if (entity == editor_camera)
-				gui::Separator();
-		}
+			const auto& row = rows[first + i];
+			if (!row.entity)
+			{
+				// Destroyed this frame, keep the row height.
+				gui::NewLine();
+				continue;
+			}
 
+			const float row_indent = indent * row.depth;
+			if (row_indent > 0.0f)
+				gui::Indent(row_indent);
 
+			const auto id = row.entity.id().id();
+			const bool expanded = _expanded.count(id) != 0;
+			if (draw_entity(row.entity, row.has_children, expanded) != expanded)
+			{
+				if (expanded)
+					_expanded.erase(id);
+				else
+					_expanded.insert(id);
+				_rows_dirty = true;
+			}
+
+			if (row_indent > 0.0f)
+				gui::Unindent(row_indent);
+		}
 	}
 
 	if (gui::IsWindowHovered() && !gui::IsAnyItemHovered())
@@ -363,8 +488,7 @@ void HierarchyDock::render(const ImVec2& area)
 				if (gui::IsMouseReleased(gui::drag_button))
 				{
 					auto mesh = dragged.get_value<AssetHandle<Mesh>>();
-					Model model;
-					model.set_lod(mesh, 0);
+					auto model = ecs::utils::create_model(mesh);
 
 					auto object = ecs->create();
 					//Add component and configure it.
@@ -374,6 +498,9 @@ void HierarchyDock::render(const ImVec2& area)
 						->set_casts_shadow(true)
 						.set_casts_reflection(false)
 						.set_model(model);
+					//Create the bones of skinned meshes.
+					if (mesh)
+						ecs::utils::create_armature(object, *mesh.get());
 
 					es->drop();
 					es->select(object);
@@ -387,5 +514,22 @@ HierarchyDock::HierarchyDock(const std::string& dtitle, bool dcloseButton, ImVec
 {
 
 	initialize(dtitle, dcloseButton, dminSize, std::bind(&HierarchyDock::render, this, std::placeholders::_1));
+
+	runtime::on_entity_created.connect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_renamed.connect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_reparented.connect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_destroyed.connect(this, &HierarchyDock::on_entity_destroyed);
+	runtime::on_component_added.connect(this, &HierarchyDock::on_component_changed);
+	runtime::on_component_removed.connect(this, &HierarchyDock::on_component_changed);
+}
+
+HierarchyDock::~HierarchyDock()
+{
+	runtime::on_entity_created.disconnect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_renamed.disconnect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_reparented.disconnect(this, &HierarchyDock::on_entity_changed);
+	runtime::on_entity_destroyed.disconnect(this, &HierarchyDock::on_entity_destroyed);
+	runtime::on_component_added.disconnect(this, &HierarchyDock::on_component_changed);
+	runtime::on_component_removed.disconnect(this, &HierarchyDock::on_component_changed);
 }
 
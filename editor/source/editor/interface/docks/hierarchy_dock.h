@@ -1,10 +1,80 @@
 #pragma once
 
 #include "imguidock.h"
+#include "runtime/ecs/ecs.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 struct HierarchyDock : public ImGuiDock::Dock
 {
 	HierarchyDock(const std::string& dtitle, bool dcloseButton, ImVec2 dminSize);
+	~HierarchyDock();
 
 	void render(const ImVec2& area);
-};
\ No newline at end of file
+
+private:
+	struct Row
+	{
+		///
+		runtime::Entity entity;
+		/// Nesting level in the hierarchy.
+		std::uint32_t depth = 0;
+		///
+		bool has_children = false;
+	};
+
+	struct SearchEntry
+	{
+		///
+		runtime::Entity entity;
+		///
+		std::string name;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : rebuild_rows ()
+	/// <summary>
+	/// Flattens the expanded part of the hierarchy into rows.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rebuild_rows();
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_rows ()
+	/// <summary>
+	/// Adds the row of an entity and the rows of its children if it is expanded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_rows(runtime::Entity entity, std::uint32_t depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : rebuild_search ()
+	/// <summary>
+	/// Rebuilds the name index if needed and the rows matching the filter.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rebuild_search();
+
+	void on_entity_changed(runtime::Entity entity);
+	void on_entity_destroyed(runtime::Entity entity);
+	void on_component_changed(runtime::Entity entity, runtime::CHandle<runtime::Component> component);
+
+	/// Visible part of the hierarchy, one entry per row.
+	std::vector<Row> _rows;
+	/// Entities whose children are shown, by id.
+	std::unordered_set<std::uint64_t> _expanded;
+	/// Names of all entities.
+	std::vector<SearchEntry> _search_index;
+	/// Entities matching the filter.
+	std::vector<Row> _search_rows;
+	///
+	ImGuiTextFilter _filter;
+	/// The hierarchy changed since the rows were built.
+	bool _rows_dirty = true;
+	/// Entities were created, destroyed or renamed since the index was built.
+	bool _index_dirty = true;
+	/// The index or the filter changed since the search rows were built.
+	bool _search_dirty = true;
+};
@@ -0,0 +1,233 @@
+#include "profiler_dock.h"
+#include "../../filedialog/filedialog.h"
+#include "runtime/system/filesystem.h"
+#include "core/logging/logging.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	const float nanoseconds_to_ms = 1.0f / 1000000.0f;
+
+	ImU32 get_zone_color(const char* name)
+	{
+		// the same name always gets the same color, across runs too
+		std::uint32_t hash = 2166136261u;
+		for (; *name != 0; ++name)
+			hash = (hash ^ static_cast<std::uint8_t>(*name)) * 16777619u;
+
+		return ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.6f);
+	}
+}
+
+ProfilerDock::ProfilerDock(const std::string& dtitle, bool dcloseButton, ImVec2 dminSize)
+{
+	initialize(dtitle, dcloseButton, dminSize, std::bind(&ProfilerDock::render, this, std::placeholders::_1));
+}
+
+void ProfilerDock::render(const ImVec2& area)
+{
+	bool recording = core::profiler::is_enabled();
+	if (gui::Checkbox("Record", &recording))
+		core::profiler::set_enabled(recording);
+
+	gui::SameLine();
+	gui::Checkbox("Pause", &_paused);
+	gui::SameLine();
+	if (gui::Button("Export Trace"))
+		export_trace();
+
+	if (!_paused)
+	{
+		_frames = core::profiler::get_frames();
+		_selected = -1;
+	}
+
+	if (_frames.empty())
+	{
+		gui::TextUnformatted("No frames recorded.");
+		return;
+	}
+
+	draw_frames();
+
+	const int selected = _selected >= 0 && _selected < int(_frames.size()) ? _selected : int(_frames.size()) - 1;
+	const auto& frame = *_frames[selected];
+	gui::Text("Frame %llu: %.3f ms, %u zones", static_cast<unsigned long long>(frame.index),
+		(frame.end - frame.start) * nanoseconds_to_ms, static_cast<unsigned int>(frame.zones.size()));
+	if (frame.dropped > 0)
+	{
+		gui::SameLine();
+		gui::TextColored(ImVec4(1.0f, 0.494f, 0.0f, 1.0f), "(%llu zones dropped)", static_cast<unsigned long long>(frame.dropped));
+	}
+
+	gui::BeginChild("Timeline", ImVec2(0, gui::GetContentRegionAvail().y * 0.6f), true, ImGuiWindowFlags_HorizontalScrollbar);
+	draw_timeline(frame);
+	gui::EndChild();
+
+	gui::BeginChild("Summary");
+	draw_summary(frame);
+	gui::EndChild();
+}
+
+void ProfilerDock::draw_frames()
+{
+	std::vector<float> durations;
+	durations.reserve(_frames.size());
+	for (const auto& frame : _frames)
+		durations.push_back((frame->end - frame->start) * nanoseconds_to_ms);
+
+	const float height = gui::GetTextLineHeightWithSpacing() * 3.0f;
+	gui::PlotHistogram("##Frames", durations.data(), int(durations.size()), 0, nullptr, 0.0f, FLT_MAX, ImVec2(gui::GetContentRegionAvailWidth(), height));
+	if (gui::IsItemHovered() && gui::IsMouseClicked(0))
+	{
+		// selecting a frame only makes sense if the frames stay put
+		const auto min = gui::GetItemRectMin();
+		const auto max = gui::GetItemRectMax();
+		const float t = (gui::GetMousePos().x - min.x) / std::max(1.0f, max.x - min.x);
+		_selected = std::min(int(t * durations.size()), int(durations.size()) - 1);
+		_paused = true;
+	}
+}
+
+void ProfilerDock::draw_timeline(const core::profiler::Frame& frame)
+{
+	const auto threads = core::profiler::get_threads();
+
+	// a thread gets as many rows as its deepest zone needs
+	std::vector<std::uint32_t> rows(threads.size(), 0);
+	for (const auto& zone : frame.zones)
+	{
+		if (zone.thread < rows.size())
+			rows[zone.thread] = std::max(rows[zone.thread], zone.depth + 1);
+	}
+
+	auto draw_list = gui::GetWindowDrawList();
+	const float row_height = gui::GetTextLineHeightWithSpacing();
+	const float label_width = 100.0f;
+	const ImVec2 origin = gui::GetCursorScreenPos();
+	const float width = std::max(100.0f, gui::GetContentRegionAvailWidth() - label_width);
+	const auto duration = std::max<std::uint64_t>(1, frame.end - frame.start);
+	const float scale = width / float(duration);
+	const ImU32 text_color = gui::GetColorU32(ImGuiCol_Text);
+	const ImVec2 clip_min = gui::GetWindowPos();
+	const ImVec2 clip_max(clip_min.x + gui::GetWindowWidth(), clip_min.y + gui::GetWindowHeight());
+
+	const core::profiler::Zone* hovered = nullptr;
+	float y = origin.y;
+	for (std::uint32_t thread = 0; thread < threads.size(); ++thread)
+	{
+		if (rows[thread] == 0)
+			continue;
+
+		draw_list->AddText(ImVec2(origin.x, y), text_color, threads[thread].name.c_str());
+
+		for (const auto& zone : frame.zones)
+		{
+			if (zone.thread != thread)
+				continue;
+
+			// zones of long tasks may have started before the frame did
+			const auto start = zone.start > frame.start ? zone.start - frame.start : 0;
+			const auto end = std::min(zone.end > frame.start ? zone.end - frame.start : 0, duration);
+			const ImVec2 min(origin.x + label_width + start * scale, y + zone.depth * row_height);
+			const ImVec2 max(std::max(min.x + 1.0f, origin.x + label_width + end * scale), min.y + row_height - 1.0f);
+			if (max.x < clip_min.x || min.x > clip_max.x || max.y < clip_min.y || min.y > clip_max.y)
+				continue;
+
+			draw_list->AddRectFilled(min, max, get_zone_color(zone.name));
+			if (gui::CalcTextSize(zone.name).x + 4.0f < max.x - min.x)
+				draw_list->AddText(ImVec2(min.x + 2.0f, min.y), text_color, zone.name);
+
+			if (gui::IsMouseHoveringRect(min, max))
+				hovered = &zone;
+		}
+
+		y += rows[thread] * row_height + gui::GetStyle().ItemSpacing.y;
+	}
+
+	gui::Dummy(ImVec2(label_width + width, y - origin.y));
+
+	if (hovered != nullptr)
+		gui::SetTooltip("%s\n%.3f ms", hovered->name, (hovered->end - hovered->start) * nanoseconds_to_ms);
+}
+
+void ProfilerDock::draw_summary(const core::profiler::Frame& frame)
+{
+	struct Total
+	{
+		std::string name;
+		std::uint64_t time = 0;
+		std::uint32_t count = 0;
+	};
+
+	// names from different sources may be separate copies of the same text
+	std::unordered_map<std::string, std::size_t> indices;
+	std::vector<Total> totals;
+	for (const auto& zone : frame.zones)
+	{
+		auto it = indices.find(zone.name);
+		if (it == indices.end())
+		{
+			it = indices.emplace(zone.name, totals.size()).first;
+			totals.emplace_back();
+			totals.back().name = zone.name;
+		}
+
+		auto& total = totals[it->second];
+		total.time += zone.end - zone.start;
+		total.count++;
+	}
+
+	std::sort(std::begin(totals), std::end(totals), [](const Total& lhs, const Total& rhs)
+	{
+		return lhs.time > rhs.time;
+	});
+
+	gui::Columns(3, "Summary");
+	gui::TextUnformatted("Zone");
+	gui::NextColumn();
+	gui::TextUnformatted("Total (ms)");
+	gui::NextColumn();
+	gui::TextUnformatted("Count");
+	gui::NextColumn();
+	gui::Separator();
+
+	ImGuiListClipper clipper(int(totals.size()));
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+		{
+			const auto& total = totals[i];
+			gui::TextUnformatted(total.name.c_str());
+			gui::NextColumn();
+			gui::Text("%.3f", total.time * nanoseconds_to_ms);
+			gui::NextColumn();
+			gui::Text("%u", total.count);
+			gui::NextColumn();
+		}
+	}
+	gui::Columns(1);
+}
+
+void ProfilerDock::export_trace()
+{
+	std::string path;
+	if (!save_file_dialog("json", fs::resolve_protocol("app:/").string(), path))
+		return;
+
+	if (!fs::path(path).has_extension())
+		path += ".json";
+
+	std::ofstream stream(path, std::ios::out | std::ios::trunc);
+	if (!stream)
+	{
+		APPLOG_ERROR("Could not write the trace to {0}", path);
+		return;
+	}
+
+	core::profiler::write_chrome_trace(stream);
+	APPLOG_INFO("Wrote the trace of {0} frames to {1}", core::profiler::get_frames().size(), path);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "imguidock.h"
+#include "core/profiling/profiler.h"
+#include <memory>
+#include <vector>
+
+struct ProfilerDock : public ImGuiDock::Dock
+{
+	ProfilerDock(const std::string& dtitle, bool dcloseButton, ImVec2 dminSize);
+
+	void render(const ImVec2& area);
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : draw_frames ()
+	/// <summary>
+	/// Draws the duration of the collected frames, clicking one selects it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_frames();
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_timeline ()
+	/// <summary>
+	/// Draws the zones of the selected frame, one lane per thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_timeline(const core::profiler::Frame& frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_summary ()
+	/// <summary>
+	/// Lists the total time and count of every zone name in the selected frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_summary(const core::profiler::Frame& frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : export_trace ()
+	/// <summary>
+	/// Asks for a file and writes the collected frames as a chrome trace.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void export_trace();
+
+	/// Frames shown, refreshed every frame unless paused.
+	std::vector<std::shared_ptr<const core::profiler::Frame>> _frames;
+	/// Index of the selected frame in _frames, the latest if negative.
+	int _selected = -1;
+	/// Keep showing the same frames.
+	bool _paused = false;
+};
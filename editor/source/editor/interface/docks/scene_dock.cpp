@@ -1,18 +1,23 @@
 #include "scene_dock.h"
 #include "../../edit_state.h"
 #include "../../project.h"
+#include "../../systems/debugdraw_system.h"
 #include "core/subsystem/simulation.h"
 #include "runtime/system/engine.h"
 #include "runtime/input/input.h"
 #include "runtime/ecs/components/transform_component.h"
 #include "runtime/ecs/components/camera_component.h"
 #include "runtime/ecs/components/model_component.h"
+#include "runtime/ecs/systems/deferred_rendering.h"
 #include "runtime/ecs/prefab.h"
+#include "runtime/ecs/utils.h"
 #include "runtime/rendering/render_pass.h"
 #include "runtime/rendering/camera.h"
 #include "runtime/rendering/render_window.h"
 #include "runtime/rendering/mesh.h"
+#include "runtime/rendering/debugdraw/debugdraw.h"
 #include "runtime/assets/asset_handle.h"
+#include "core/memory/frame_allocator.hpp"
 
 
 static bool show_gbuffer = false;
@@ -40,6 +45,21 @@ void show_statistics(const unsigned int frameRate)
 	gui::Text("Draw calls: %u", stats->numDraw);
 	gui::Text("Compute calls: %u", stats->numCompute);
 	gui::Text("Render passes: %u", RenderPass::get_pass());
+	auto frame_memory = core::frame_memory::get_last_frame_stats();
+	gui::Text("Frame memory: %.1f KB (%.1f KB from heap)", frame_memory.arena_bytes / 1024.0f, frame_memory.heap_bytes / 1024.0f);
+	const auto& encoder_stats = gfx::get_encoder_stats();
+	gui::Text("Encoded draws: %u in %u encoders (%.1f KB, replay %fms)", encoder_stats.submits, encoder_stats.encoders, encoder_stats.bytes / 1024.0f, encoder_stats.replay_time * 1000.0);
+	if (auto deferred_rendering = core::get_subsystem<runtime::DeferredRendering>())
+	{
+		const auto& reflection_stats = deferred_rendering->get_reflection_stats();
+		gui::Text("Reflection faces: %u rendered, %u pending (update %.2fms, mean %.2fms, std dev %.2fms)",
+			reflection_stats.faces_rendered, reflection_stats.faces_pending,
+			reflection_stats.update_time * 1000.0, reflection_stats.update_time_mean * 1000.0, reflection_stats.update_time_deviation * 1000.0);
+	}
+	if (auto debug_draw = core::get_subsystem<editor::DebugDrawSystem>())
+	{
+		gui::Text("Debug draw: %u draw calls, %u batched lines", ddGetDrawCalls(), static_cast<unsigned int>(debug_draw->get_batch().get_line_count()));
+	}
 	static bool more_stats = false;
 	if (gui::Checkbox("More Stats", &more_stats))
 	{
@@ -51,6 +71,7 @@ void show_statistics(const unsigned int frameRate)
 	}
 	gui::Separator();
 	gui::Checkbox("Show G-Buffer", &show_gbuffer);
+	gui::Checkbox("Show Bounds", &core::get_subsystem<editor::EditState>()->show_bounds);
 	gui::End();
 
 }
@@ -452,8 +473,7 @@ void SceneDock::render(const ImVec2& area)
 				if (gui::IsMouseReleased(gui::drag_button))
 				{
 					auto mesh = dragged.get_value<AssetHandle<Mesh>>();
-					Model model;
-					model.set_lod(mesh, 0);
+					auto model = ecs::utils::create_model(mesh);
 
 					auto object = ecs->create();
 					//Add component and configure it.
@@ -464,6 +484,9 @@ void SceneDock::render(const ImVec2& area)
 						->set_casts_shadow(true)
 						.set_casts_reflection(false)
 						.set_model(model);
+					//Create the bones of skinned meshes.
+					if (mesh)
+						ecs::utils::create_armature(object, *mesh.get());
 
 					es->drop();
 					es->select(object);
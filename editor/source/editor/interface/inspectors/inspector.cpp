@@ -15,7 +15,7 @@ void Tooltip(const rttr::property& prop)
 
 void Tooltip(const std::string& tooltip)
 {
-	if (gui::IsItemHovered())
+	if (!tooltip.empty() && gui::IsItemHovered())
 	{
 		gui::SetMouseCursor(ImGuiMouseCursor_Help);
 		gui::SetTooltip(tooltip.c_str());	
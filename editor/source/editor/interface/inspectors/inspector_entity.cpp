@@ -1,5 +1,6 @@
 #include "inspector_entity.h"
 #include "inspectors.h"
+#include <algorithm>
 
 
 struct Inspector_Entity::component
@@ -34,6 +35,14 @@ Inspector_Entity::component::instance::instance() :
 
 void Inspector_Entity::component::instance::setup(const std::vector<runtime::CHandle<runtime::Component>>& list)
 {
+	// The tree only has to be rebuilt when the components changed.
+	auto same_component = [](const runtime::CHandle<runtime::Component>& lhs, const runtime::CHandle<runtime::Component>& rhs)
+	{
+		return lhs.lock() == rhs.lock();
+	};
+	if (list.size() == _list.size() && std::equal(std::begin(list), std::end(list), std::begin(_list), same_component))
+		return;
+
 	_list = list;
 	_tree.reset();
 	{
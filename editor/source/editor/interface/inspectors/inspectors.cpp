@@ -28,76 +28,171 @@ struct InspectorRegistry
 std::shared_ptr<Inspector> get_inspector(rttr::type type)
 {
 	static InspectorRegistry registry;
-	auto inspector = registry.type_map[type];
-	return inspector;
+	auto it = registry.type_map.find(type);
+	if (it == registry.type_map.end())
+		return nullptr;
+
+	return it->second;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : InspectedProperty (Struct)
+/// <summary>
+/// Everything about a property that inspect_var needs and that does not
+/// change from frame to frame.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct InspectedProperty
+{
+	InspectedProperty(const rttr::property& p)
+		: prop(p)
+		, name(p.get_name().data())
+		, is_readonly(p.is_readonly())
+		, is_array(p.is_array())
+		, is_enum(p.is_enumeration())
+	{
+		auto tooltip_var = p.get_metadata("Tooltip");
+		if (tooltip_var)
+			tooltip = tooltip_var.to_string();
+
+		// Only values held through a pointer or a wrapper can be of a type
+		// other than the declared one.
+		const auto type = p.get_type();
+		polymorphic = type.is_pointer() || type.is_wrapper();
+		if (!polymorphic)
+			inspector = get_inspector(type);
+
+		get_metadata = [p](const rttr::variant& name) -> rttr::variant
+		{
+			return p.get_metadata(name);
+		};
+	}
+
+	///
+	rttr::property prop;
+	///
+	std::string name;
+	///
+	std::string tooltip;
+	///
+	bool is_readonly = false;
+	///
+	bool is_array = false;
+	///
+	bool is_enum = false;
+	/// The inspector has to be looked up from the value each time.
+	bool polymorphic = false;
+	/// Inspector of the declared type, if it has one.
+	std::shared_ptr<Inspector> inspector;
+	/// Metadata lookup handed to the inspectors.
+	std::function<rttr::variant(const rttr::variant&)> get_metadata;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : InspectedType (Struct)
+/// <summary>
+/// Flattened property layout of a type, built the first time the type is
+/// inspected and reused afterwards.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct InspectedType
+{
+	InspectedType(const rttr::type& type)
+		: inspector(get_inspector(type))
+		, is_enum(type.is_enumeration())
+	{
+		if (inspector)
+			return;
+
+		for (auto& prop : type.get_properties())
+		{
+			properties.emplace_back(prop);
+		}
+	}
+
+	/// Inspector of the type, if it has one.
+	std::shared_ptr<Inspector> inspector;
+	///
+	bool is_enum = false;
+	///
+	std::vector<InspectedProperty> properties;
+};
+
+const InspectedType& get_inspected_type(const rttr::type& type)
+{
+	static std::unordered_map<rttr::type, InspectedType> types;
+	auto it = types.find(type);
+	if (it == types.end())
+		it = types.emplace(type, InspectedType(type)).first;
+
+	return it->second;
 }
 
 bool inspect_var(rttr::variant& var, bool read_only, std::function<rttr::variant(const rttr::variant&)> get_metadata)
 {
 	rttr::instance object = var;
 	auto type = object.get_derived_type();
-	auto name = type.get_name();
-	auto properties = type.get_properties();
+	const auto& inspected = get_inspected_type(type);
 
 	bool changed = false;
 
-	auto inspector = get_inspector(type);
-	if (inspector)
+	if (inspected.inspector)
 	{
-		changed |= inspector->inspect(var, read_only, get_metadata);
+		changed |= inspected.inspector->inspect(var, read_only, get_metadata);
 	}
-	else if (properties.empty())
+	else if (inspected.properties.empty())
 	{
-		if (type.is_enumeration())
+		if (inspected.is_enum)
 		{
 			changed |= inspect_enum(var, type.get_enumeration(), read_only);
 		}
 	}
 	else
 	{
-		for (auto& prop : properties)
+		for (auto& property : inspected.properties)
 		{
+			auto& prop = property.prop;
 			auto prop_var = prop.get_value(object);
-			auto prop_name = prop.get_name();
-			bool is_readonly = prop.is_readonly();
-			bool is_array = prop.is_array();
-			bool is_enum = prop.is_enumeration();
-			rttr::instance prop_object = prop_var;
-			bool has_inspector = !!get_inspector(prop_object.get_derived_type());
-			bool details = !has_inspector && !is_enum;
-			PropertyLayout layout(prop);
+			bool has_inspector = !!property.inspector;
+			if (property.polymorphic)
+			{
+				rttr::instance prop_object = prop_var;
+				has_inspector = !!get_inspector(prop_object.get_derived_type());
+			}
+			bool details = !has_inspector && !property.is_enum;
+			PropertyLayout layout(property.name, property.tooltip);
 			bool open = true;
 			if (details)
 			{
 				open = gui::TreeNode("details");
 			}
 
+			bool prop_changed = false;
 			if (open)
 			{
-				auto get_meta = [&prop](const rttr::variant& name) -> rttr::variant
-				{
-					return prop.get_metadata(name);
-				};
-				if (is_array)
+				if (property.is_array)
 				{
-					changed |= inspect_array(prop_var, is_readonly);
+					prop_changed |= inspect_array(prop_var, property.is_readonly);
 				}
-				else if (is_enum)
+				else if (property.is_enum)
 				{
-					changed |= inspect_enum(prop_var, prop.get_enumeration(), is_readonly);
+					prop_changed |= inspect_enum(prop_var, prop.get_enumeration(), property.is_readonly);
 				}
 				else
 				{
-					changed |= inspect_var(prop_var, is_readonly, get_meta);
+					prop_changed |= inspect_var(prop_var, property.is_readonly, property.get_metadata);
 				}
 
 				if(details)
 					gui::TreePop();
 			}
-			
-			if (changed && !is_readonly)
+
+			// Setting a value touches the object, so skip edits that ended up
+			// with the value it already has.
+			if (prop_changed && !property.is_readonly && !(prop.get_value(object) == prop_var))
 			{
 				prop.set_value(object, prop_var);
+				changed = true;
 			}
 		}
 
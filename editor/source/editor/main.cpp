@@ -1,9 +1,44 @@
 #include "runtime/runtime.h"
+#include "runtime/system/task.h"
+#include "core/logging/logging.h"
 #include "editor_app.h"
+#include "assets/asset_compiler.h"
+#include "assets/asset_compiler_cache.h"
+#include <cstring>
 //Regex to count lines of code
 //^(?!(\s*\*))(?!(\s*\-\-\>))(?!(\s*\<\!\-\-))(?!(\s*\n))(?!(\s*\*\/))(?!(\s*\/\*))(?!(\s*\/\/\/))(?!(\s*\/\/))(?!(\s*\}))(?!(\s*\{))(?!(\s(using))).*$
 
 
+// builds the binaries of every engine and editor shader whose sources changed
+// and exits. runs after every build of the editor, so the binaries in
+// engine_data and editor_data always match their sources. the compile cache
+// next to the executable keys them on their contents, not on file times.
+int compile_shaders(const fs::path& exe_path)
+{
+	core::details::initialize();
+	logging::create(APPLOG, { std::make_shared<logging::sinks::stdout_sink_mt>() });
+	core::add_subsystem<runtime::TaskSystem>();
+	AssetCompilerCache::open(exe_path / "shader_cache");
+
+	std::vector<fs::path> sources;
+	for (const auto& protocol : { "engine_data:/shaders", "editor_data:/shaders" })
+	{
+		std::error_code err;
+		fs::directory_iterator end;
+		for (fs::directory_iterator it(fs::resolve_protocol(protocol), err); !err && it != end; it.increment(err))
+		{
+			if (it->path().extension() == ".sc")
+				sources.push_back(it->path());
+		}
+	}
+
+	const bool compiled = ShaderCompiler::compile(sources);
+
+	AssetCompilerCache::close();
+	core::details::dispose();
+	return compiled ? 0 : 1;
+}
+
 int main(int _argc, char* _argv[])
 {
 	fs::path exe_path = fs::canonical(fs::executable_path(_argv[0]).remove_filename());
@@ -14,6 +49,9 @@ int main(int _argc, char* _argv[])
 	fs::add_path_protocol("engine_data:", engine_data.string());
 	fs::add_path_protocol("editor_data:", editor_data.string());
 
+	if (_argc > 1 && std::strcmp(_argv[1], "--compile-shaders") == 0)
+		return compile_shaders(exe_path);
+
 	auto& app = singleton<runtime::App>::get_instance();
 	int return_code = app.run();
 
@@ -4,6 +4,7 @@
 #include "core/serialization/serialization.h"
 #include "core/serialization/cereal/types/deque.hpp"
 #include "core/serialization/cereal/types/string.hpp"
+#include "core/serialization/cereal/types/vector.hpp"
 #include "core/logging/logging.h"
 
 namespace editor
@@ -11,10 +12,14 @@ namespace editor
 	SAVE(ProjectManager::Options)
 	{
 		try_save(ar, cereal::make_nvp("recent_projects", obj.recent_project_paths));
+		try_save(ar, cereal::make_nvp("mesh_lod_ratios", obj.mesh_lods.triangle_ratios));
+		try_save(ar, cereal::make_nvp("mesh_lod_max_error", obj.mesh_lods.max_error));
 	}
 
 	LOAD(ProjectManager::Options)
 	{
 		try_load(ar, cereal::make_nvp("recent_projects", obj.recent_project_paths));
+		try_load(ar, cereal::make_nvp("mesh_lod_ratios", obj.mesh_lods.triangle_ratios));
+		try_load(ar, cereal::make_nvp("mesh_lod_max_error", obj.mesh_lods.max_error));
 	}
 }
\ No newline at end of file
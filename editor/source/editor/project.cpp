@@ -7,6 +7,8 @@
 #include "edit_state.h"
 #include "editor_window.h"
 #include "assets/asset_compiler.h"
+#include "assets/asset_compiler_cache.h"
+#include "assets/thumbnail_cache.h"
 #include "runtime/system/engine.h"
 #include "core/serialization/archives.h"
 #include "meta/project.hpp"
@@ -22,7 +24,7 @@ namespace editor
 
 
 	template<typename T>
-	void watch_assets(const fs::path& protocol, const std::string& wildcard, bool initialList, bool reloadAsync)
+	void watch_assets(const fs::path& protocol, const std::string& wildcard, bool initialList, bool reloadAsync, bool loadedOnly = false)
 	{
 		auto am = core::get_subsystem<runtime::AssetManager>();
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
@@ -30,7 +32,7 @@ namespace editor
 		const fs::path dir = fs::resolve_protocol(protocol);
 		fs::path watchDir = dir / wildcard;
 
-		fs::watcher::watch(watchDir, initialList, [am, ts, protocol, reloadAsync](const std::vector<fs::watcher::Entry>& entries)
+		fs::watcher::watch(watchDir, initialList, [am, ts, protocol, reloadAsync, loadedOnly](const std::vector<fs::watcher::Entry>& entries)
 		{
 			for (auto& entry : entries)
 			{
@@ -54,8 +56,12 @@ namespace editor
 					else
 					{
 						//created or modified
-						auto task = ts->create("Load Asset", [reloadAsync, key, am]()
+						auto task = ts->create("Load Asset", [reloadAsync, loadedOnly, key, am]()
 						{
+							// Assets nobody requested yet are left to be loaded on demand.
+							if (loadedOnly && !am->find_asset_entry<T>(key))
+								return;
+
 							am->load<T>(key, reloadAsync, true);
 						});
 						ts->run(task, true);
@@ -95,10 +101,12 @@ namespace editor
 					else
 					{
 						// created or modified or renamed
-						auto task = ts->create("", [p]()
+						auto task = ts->create("Compile Asset", [p]()
 						{
 							AssetCompiler<T>::compile(p);
+							AssetCompilerCache::end_compile();
 						});
+						AssetCompilerCache::begin_compile();
 						ts->run(task);
 					}
 				}
@@ -119,6 +127,7 @@ namespace editor
 					{
 						std::unique_lock<std::mutex> lock(directories_mutex);
 						directories.emplace_back(std::make_shared<AssetFolder>(this, p, p.filename().string(), root_path, recompile_assets));
+						touch();
 
 					}
 					else if (entry.state == fs::watcher::Entry::Modified)
@@ -136,6 +145,7 @@ namespace editor
 						{
 							auto e = *it;
 							e->populate(this, p, p.filename().string(), root_path, false);
+							touch();
 						}
 
 					}
@@ -145,6 +155,7 @@ namespace editor
 						directories.erase(std::remove_if(std::begin(directories), std::end(directories),
 							[&entry](const std::shared_ptr<AssetFolder>& other) { return entry.path.filename().string() == other->name; }
 						), std::end(directories));
+						touch();
 					}
 				}
 				else if (entry.type == fs::file_type::regular)
@@ -155,6 +166,7 @@ namespace editor
 						fs::path filename = p.stem();
 						fs::path ext = p.extension();
 						files.emplace_back(AssetFile(p, filename.string(), ext.string(), root_path));
+						touch();
 					}
 					else if (entry.state == fs::watcher::Entry::Modified)
 					{
@@ -173,6 +185,7 @@ namespace editor
 							fs::path filename = p.stem();
 							fs::path ext = p.extension();
 							e.populate(p, filename.string(), ext.string(), root_path);
+							touch();
 						}
 					}
 					else if (entry.state == fs::watcher::Entry::Removed)
@@ -181,6 +194,7 @@ namespace editor
 						files.erase(std::remove_if(std::begin(files), std::end(files),
 							[&entry](const AssetFile& other) { return entry.path == other.absolute; }
 						), std::end(files));
+						touch();
 					}
 				}
 			}
@@ -189,7 +203,9 @@ namespace editor
 
 		watch_assets<Material>(relative, wildcard + extensions::material, true, false);
 
-		watch_assets<Texture>(relative, wildcard + extensions::texture, !recompile_assets, true);
+		// Textures are big, only keep the ones in use up to date. The assets
+		// dock shows thumbnails instead of loading them.
+		watch_assets<Texture>(relative, wildcard + extensions::texture, !recompile_assets, true, true);
 		static const std::array<std::string, 6>  raw_texture_formats = 
 		{ 
 			"*.png", "*.jpg", "*.tga", "*.dds", "*.ktx", "*.pvr" 
@@ -261,6 +277,14 @@ namespace editor
 		fs::watcher::unwatch(absolute / fs::path("*"), true);
 	}
 
+	void AssetFolder::touch()
+	{
+		for (auto folder = this; folder != nullptr; folder = folder->parent)
+		{
+			folder->revision++;
+		}
+	}
+
 	void ProjectManager::open_project(const fs::path& project_path, bool recompile_assets)
 	{
 		if (!fs::exists(project_path, std::error_code{}))
@@ -282,6 +306,8 @@ namespace editor
 		save_config();
 
 		fs::watcher::unwatch_all();
+		AssetCompilerCache::open(fs::resolve_protocol("app:/cache"));
+		core::get_subsystem<ThumbnailCache>()->open(fs::resolve_protocol("app:/cache/thumbnails"));
 
 		static const std::string wildcard = "*";
 
@@ -340,6 +366,7 @@ namespace editor
 			cereal::iarchive_json_t ar(output);
 
 			try_load(ar, cereal::make_nvp("options", _options));
+			MeshCompiler::set_lod_settings(_options.mesh_lods);
 
 			auto& items = _options.recent_project_paths;
 			auto iter = std::begin(items);
@@ -385,6 +412,7 @@ namespace editor
 	{
 		save_config();
 		fs::watcher::unwatch_all();
+		AssetCompilerCache::close();
 		root_directory.reset();
 	}
 
@@ -2,6 +2,8 @@
 #include "core/subsystem/subsystem.h"
 #include "core/math/math_includes.h"
 #include "runtime/system/filesystem.h"
+#include "assets/asset_compiler.h"
+#include <atomic>
 #include <deque>
 #include <mutex>
 
@@ -36,6 +38,15 @@ namespace editor
 		void watch(bool recompile_assets);
 
 		void unwatch();
+
+		//-----------------------------------------------------------------------------
+		//  Name : touch ()
+		/// <summary>
+		/// Marks the contents of this folder and of its parents as changed.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void touch();
+
 		///
 		fs::path absolute;
 		///
@@ -54,6 +65,8 @@ namespace editor
 		std::mutex directories_mutex;
 		///
 		std::vector<std::shared_ptr<AssetFolder>> directories;
+		/// Bumped whenever a file or folder in this folder or below it changes.
+		std::atomic<std::uint64_t> revision{ 0 };
 	};
 
 
@@ -64,6 +77,8 @@ namespace editor
 		{
 			///
 			std::deque<std::string> recent_project_paths;
+			/// Levels of detail generated for compiled meshes.
+			MeshCompiler::LodSettings mesh_lods;
 		};
 
 		//-----------------------------------------------------------------------------
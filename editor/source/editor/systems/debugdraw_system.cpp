@@ -17,11 +17,65 @@
 #include "runtime/assets/asset_manager.h"
 #include "../edit_state.h"
 #include "runtime/system/engine.h"
+#include "runtime/system/task.h"
+#include "core/memory/frame_allocator.hpp"
+#include "core/profiling/profiler.h"
 
 namespace editor
 {
+	/// Models whose bounds are transformed by one task.
+	static const std::uint32_t BoundsPerTask = 256;
+
+	void DebugDrawSystem::add_model_bounds(const math::frustum& frustum)
+	{
+		struct Bounds
+		{
+			math::bbox bounds;
+			math::transform_t world;
+		};
+
+		// World transforms are resolved lazily by the components, so they are
+		// read here and only the culling and line generation run in parallel.
+		core::frame_vector<Bounds> models;
+		auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+		ecs->each<TransformComponent, ModelComponent>([&models](
+			runtime::Entity ce,
+			TransformComponent& transform_comp,
+			ModelComponent& model_comp
+			)
+		{
+			const auto mesh = model_comp.get_model().get_lod(0);
+			if (mesh)
+				models.push_back({ mesh->get_bounds(), transform_comp.get_transform() });
+		});
+
+		auto add_bounds = [this, &models, &frustum](std::uint32_t begin, std::uint32_t end)
+		{
+			for (std::uint32_t i = begin; i < end && i < models.size(); ++i)
+			{
+				const auto& model = models[i];
+				if (math::frustum::test_obb(frustum, model.bounds, model.world))
+					_batch.add_bbox(model.bounds, model.world, 0xff808080);
+			}
+		};
+
+		const std::uint32_t count = std::uint32_t(models.size());
+		auto ts = core::get_subsystem<runtime::TaskSystem>();
+		if (ts == nullptr || count <= BoundsPerTask)
+		{
+			add_bounds(0, count);
+		}
+		else
+		{
+			auto master = ts->create_parallel_for("Debug Draw Bounds", add_bounds, std::uint32_t(0), count, BoundsPerTask);
+			ts->run(master);
+			ts->wait(master);
+		}
+	}
+
 	void DebugDrawSystem::frame_render(std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Debug Draw");
 		auto es = core::get_subsystem<EditState>();
 		auto& editor_camera = es->camera;
 		auto& selected = es->selection_data.object;
@@ -91,6 +145,16 @@ namespace editor
 			}
 		}
 
+		if (es->show_bounds)
+			add_model_bounds(camera.get_frustum());
+
+		// Everything batched this frame, possibly from other threads, goes
+		// out in a few large draws instead of one draw per shape.
+		ddPush();
+		ddSetState(true, false, true);
+		_batch.submit();
+		ddPop();
+
 
 		if (!selected || !selected.is_type<runtime::Entity>())
 			return;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/subsystem/subsystem.h"
+#include "runtime/rendering/debugdraw/debugdraw_batch.h"
 #include <memory>
 #include <chrono>
 
@@ -15,7 +16,25 @@ namespace editor
 		void dispose();
 		virtual void frame_render(std::chrono::duration<float> dt);
 
+		//-----------------------------------------------------------------------------
+		//  Name : get_batch ()
+		/// <summary>
+		/// Lines added to the batch from any thread are drawn in the next frame.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline DebugDrawBatch& get_batch() { return _batch; }
+
 	private:
+		//-----------------------------------------------------------------------------
+		//  Name : add_model_bounds ()
+		/// <summary>
+		/// Adds the bounds of all models in the view frustum to the batch.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void add_model_bounds(const math::frustum& frustum);
+
 		std::unique_ptr<Program> _program;
+		///
+		DebugDrawBatch _batch;
 	};
 }
\ No newline at end of file
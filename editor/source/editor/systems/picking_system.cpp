@@ -10,6 +10,7 @@
 #include "runtime/rendering/vertex_buffer.h"
 #include "runtime/rendering/index_buffer.h"
 #include "runtime/rendering/texture.h"
+#include "core/profiling/profiler.h"
 #include "runtime/rendering/material.h"
 #include "runtime/rendering/render_window.h"
 #include "runtime/system/engine.h"
@@ -21,6 +22,7 @@ namespace editor
 {
 	void PickingSystem::frame_render(std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Picking");
 		auto es = core::get_subsystem<EditState>();
 		auto input = core::get_subsystem<runtime::Input>();
 		auto engine = core::get_subsystem<runtime::Engine>();
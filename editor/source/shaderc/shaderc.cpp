@@ -14,7 +14,8 @@ extern "C"
 
 namespace bgfx
 {
-	bool g_verbose = false;
+	// per thread, so that concurrent invocations don't share options
+	thread_local bool g_verbose = false;
 
 	static const char* s_ARB_shader_texture_lod[] =
 	{
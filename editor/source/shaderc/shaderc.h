@@ -8,7 +8,7 @@
 
 namespace bgfx
 {
-	extern bool g_verbose;
+	extern thread_local bool g_verbose;
 }
 
 
@@ -39,7 +39,7 @@ namespace bgfx
 
 namespace bgfx
 {
-	extern bool g_verbose;
+	extern thread_local bool g_verbose;
 
 	class LineReader
 	{
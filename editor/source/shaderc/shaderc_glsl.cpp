@@ -5,9 +5,43 @@
 
 #include "shaderc.h"
 #include "glsl_optimizer.h"
+#include <mutex>
 
 namespace bgfx { namespace glsl
 {
+	// glsl-optimizer keeps its type tables in globals shared by all contexts,
+	// so optimizing is the only step of the compilation that is serialized.
+	// Contexts are created once per target and reused, since initializing and
+	// cleaning up one rebuilds those tables.
+	struct Optimizer
+	{
+		~Optimizer()
+		{
+			for (auto& ctx : contexts)
+			{
+				if (ctx.second)
+					glslopt_cleanup(ctx.second);
+			}
+		}
+
+		glslopt_ctx* get_context(glslopt_target target)
+		{
+			auto& ctx = contexts[target];
+			if (!ctx)
+				ctx = glslopt_initialize(target);
+			return ctx;
+		}
+
+		std::mutex mutex;
+		std::unordered_map<int, glslopt_ctx*> contexts;
+	};
+
+	static Optimizer& getOptimizer()
+	{
+		static Optimizer optimizer;
+		return optimizer;
+	}
+
 	static bool compile(bx::CommandLine& _cmdLine, uint32_t _version, const std::string& _code, bx::WriterI* _writer, std::string& err)
 	{
 		char ch = char(tolower(_cmdLine.findOption('\0', "type")[0]) );
@@ -35,13 +69,24 @@ namespace bgfx { namespace glsl
 			break;
 		}
 
-		glslopt_ctx* ctx = glslopt_initialize(target);
-
-		glslopt_shader* shader = glslopt_optimize(ctx, type, _code.c_str(), 0);
+		std::string optimized;
+		std::string log;
+		bool status = false;
+		{
+			Optimizer& optimizer = getOptimizer();
+			std::lock_guard<std::mutex> lock(optimizer.mutex);
+
+			glslopt_shader* shader = glslopt_optimize(optimizer.get_context(target), type, _code.c_str(), 0);
+			status = glslopt_get_status(shader);
+			if (status)
+				optimized = glslopt_get_output(shader);
+			else
+				log = glslopt_get_log(shader);
+			glslopt_shader_delete(shader);
+		}
 
-		if (!glslopt_get_status(shader) )
+		if (!status)
 		{
-			const char* log = glslopt_get_log(shader);
 			int32_t source  = 0;
 			int32_t line    = 0;
 			int32_t column  = 0;
@@ -49,7 +94,7 @@ namespace bgfx { namespace glsl
 			int32_t end     = INT32_MAX;
 
 			bool found = false
-				|| 3 == sscanf(log, "%u:%u(%u):", &source, &line, &column)
+				|| 3 == sscanf(log.c_str(), "%u:%u(%u):", &source, &line, &column)
 				;
 
 			if (found
@@ -60,13 +105,12 @@ namespace bgfx { namespace glsl
 			}
 
 			printCode(err, _code.c_str(), line, start, end, column);
-			bx::stringPrintf(err, "Error: %s\n", log);
-			fprintf(stderr, "Error: %s\n", log);
-			glslopt_cleanup(ctx);
+			bx::stringPrintf(err, "Error: %s\n", log.c_str());
+			fprintf(stderr, "Error: %s\n", log.c_str());
 			return false;
 		}
 
-		const char* optimizedShader = glslopt_get_output(shader);
+		const char* optimizedShader = optimized.c_str();
 
 		// Trim all directives.
 		while ('#' == *optimizedShader)
@@ -280,8 +324,6 @@ namespace bgfx { namespace glsl
 			writeFile(disasmfp.c_str(), optimizedShader, shaderSize);
 		}
 
-		glslopt_cleanup(ctx);
-
 		return true;
 	}
 
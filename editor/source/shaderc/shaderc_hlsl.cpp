@@ -17,6 +17,7 @@
 #include <d3dcompiler.h>
 #include <d3d11shader.h>
 #include "graphics/bx/os.h"
+#include <mutex>
 
 #ifndef D3D_SVF_USED
 #	define D3D_SVF_USED 2
@@ -79,6 +80,7 @@ namespace bgfx { namespace hlsl
 
 	static const D3DCompiler* s_compiler;
 	static void* s_d3dcompilerdll;
+	static std::mutex s_compilerMutex;
 
 	const D3DCompiler* load()
 	{
@@ -119,9 +121,16 @@ namespace bgfx { namespace hlsl
 		return NULL;
 	}
 
-	void unload()
+	// Shaders are compiled concurrently, so the dll is loaded once by the
+	// first compilation and kept. D3DCompile itself is thread safe.
+	const D3DCompiler* getCompiler()
 	{
-		bx::dlclose(s_d3dcompilerdll);
+		std::lock_guard<std::mutex> lock(s_compilerMutex);
+		if (NULL == s_compiler)
+		{
+			s_compiler = load();
+		}
+		return s_compiler;
 	}
 
 	struct CTHeader
@@ -553,8 +562,7 @@ namespace bgfx { namespace hlsl
 			return false;
 		}
 
-		s_compiler = load();
-		if (!s_compiler)
+		if (!getCompiler() )
 		{
 			bx::stringPrintf(err, "Could not load d3dcompiler dll.\n");
 			fprintf(stderr, "Could not load d3dcompiler dll.\n");
@@ -802,7 +810,6 @@ namespace bgfx { namespace hlsl
 
 	error:
 		code->Release();
-		unload();
 		return result;
 	}
 
@@ -3,9 +3,12 @@ $output v_bc
 
 #include "common.sh"
 
+uniform vec4 u_position_decode; // position = a_position * w + xyz
+
 void main()
 {
-	gl_Position = mul(u_modelViewProj, vec4(a_position, 1.0) );
+	vec3 position = a_position * u_position_decode.w + u_position_decode.xyz;
+	gl_Position = mul(u_modelViewProj, vec4(position, 1.0) );
 
 	v_bc = a_color1;
 }
@@ -37,6 +37,7 @@ namespace spdlog
 }
 #endif
 #include "spdlog/sinks/file_sinks.h"
+#include <atomic>
 
 
 namespace logging
@@ -44,10 +45,32 @@ namespace logging
 	using namespace spdlog;
 
 #define APPLOG "Log"
-#define APPLOG_INFO(...) spdlog::get("Log")->info().write(__VA_ARGS__)
-#define APPLOG_TRACE(...) spdlog::get("Log")->trace().write(__VA_ARGS__)
-#define APPLOG_ERROR(...) spdlog::get("Log")->error().write(__VA_ARGS__)
-#define APPLOG_WARNING(...) spdlog::get("Log")->warn().write(__VA_ARGS__)
-#define APPLOG_NOTICE(...) spdlog::get("Log")->notice().write(__VA_ARGS__)
+#define APPLOG_INFO(...) logging::get_applog()->info().write(__VA_ARGS__)
+#define APPLOG_TRACE(...) logging::get_applog()->trace().write(__VA_ARGS__)
+#define APPLOG_ERROR(...) logging::get_applog()->error().write(__VA_ARGS__)
+#define APPLOG_WARNING(...) logging::get_applog()->warn().write(__VA_ARGS__)
+#define APPLOG_NOTICE(...) logging::get_applog()->notice().write(__VA_ARGS__)
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_applog ()
+	/// <summary>
+	/// Retrieves the application logger used by the APPLOG macros. The registry
+	/// is only searched until the logger is found, after that the pointer is
+	/// cached so that logging does not take the registry mutex. The registry
+	/// keeps the logger alive, it is never dropped while the engine runs.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline spdlog::logger* get_applog()
+	{
+		static std::atomic<spdlog::logger*> applog(nullptr);
+
+		auto logger = applog.load(std::memory_order_acquire);
+		if (!logger)
+		{
+			logger = spdlog::get(APPLOG);
+			applog.store(logger, std::memory_order_release);
+		}
+		return logger;
+	}
 
 }
\ No newline at end of file
@@ -62,6 +62,12 @@ public:
 
 
     void flush() override;
+
+    // sinks are handed to the worker thread through the queue, so that it never has to lock them
+    void add_sink(sink_ptr single_sink) override;
+
+    // number of messages discarded so far by the discard_log_msg overflow policy
+    size_t discarded_count() const;
 protected:
     void _log_msg(details::log_msg& msg) override;
     void _set_formatter(spdlog::formatter_ptr msg_formatter) override;
@@ -21,6 +21,7 @@
 #include "os.h"
 #include "../formatter.h"
 
+#include <atomic>
 #include <chrono>
 #include <exception>
 #include <functional>
@@ -43,6 +44,7 @@ class async_log_helper
     {
         log,
         flush,
+        add_sink,
         terminate
     };
     struct async_msg
@@ -53,6 +55,7 @@ class async_log_helper
         size_t thread_id;
         std::string txt;
         async_msg_type msg_type;
+        sink_ptr sink;
 
         async_msg() = default;
         ~async_msg() = default;
@@ -62,8 +65,10 @@ async_msg(async_msg&& other) SPDLOG_NOEXCEPT:
         logger_name(std::move(other.logger_name)),
                     level(std::move(other.level)),
                     time(std::move(other.time)),
+                    thread_id(other.thread_id),
                     txt(std::move(other.txt)),
-                    msg_type(std::move(other.msg_type))
+                    msg_type(std::move(other.msg_type)),
+                    sink(std::move(other.sink))
         {}
 
         async_msg(async_msg_type m_type) :msg_type(m_type)
@@ -77,6 +82,7 @@ async_msg(async_msg&& other) SPDLOG_NOEXCEPT:
             thread_id = other.thread_id;
             txt = std::move(other.txt);
             msg_type = other.msg_type;
+            sink = std::move(other.sink);
             return *this;
         }
 
@@ -133,6 +139,11 @@ public:
 
     void flush();
 
+    // hand a new sink over to the worker thread
+    void add_sink(sink_ptr);
+
+    size_t discarded_count() const;
+
 
 private:
     formatter_ptr _formatter;
@@ -152,6 +163,9 @@ private:
     // overflow policy
     const async_overflow_policy _overflow_policy;
 
+    // messages dropped so far by the discard_log_msg policy
+    std::atomic<size_t> _discarded;
+
     // worker thread warmup callback - one can set thread priority, affinity, etc
     const std::function<void()> _worker_warmup_cb;
 
@@ -202,6 +216,7 @@ inline spdlog::details::async_log_helper::async_log_helper(
     _flush_requested(false),
     _terminate_requested(false),
     _overflow_policy(overflow_policy),
+    _discarded(0),
     _worker_warmup_cb(worker_warmup_cb),
     _flush_interval_ms(flush_interval_ms),
     _worker_teardown_cb(worker_teardown_cb),
@@ -233,7 +248,15 @@ inline void spdlog::details::async_log_helper::log(const details::log_msg& msg)
 inline void spdlog::details::async_log_helper::push_msg(details::async_log_helper::async_msg&& new_msg)
 {
     throw_if_bad_worker();
-    if (!_q.enqueue(std::move(new_msg)) && _overflow_policy != async_overflow_policy::discard_log_msg)
+    if (_q.enqueue(std::move(new_msg)))
+        return;
+
+    // only log messages may be dropped, control messages always get through
+    if (_overflow_policy == async_overflow_policy::discard_log_msg && new_msg.msg_type == async_msg_type::log)
+    {
+        _discarded.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
     {
         auto last_op_time = details::os::now();
         auto now = last_op_time;
@@ -252,6 +275,18 @@ inline void spdlog::details::async_log_helper::flush()
     push_msg(async_msg(async_msg_type::flush));
 }
 
+inline void spdlog::details::async_log_helper::add_sink(sink_ptr single_sink)
+{
+    async_msg msg(async_msg_type::add_sink);
+    msg.sink = std::move(single_sink);
+    push_msg(std::move(msg));
+}
+
+inline size_t spdlog::details::async_log_helper::discarded_count() const
+{
+    return _discarded.load(std::memory_order_relaxed);
+}
+
 inline void spdlog::details::async_log_helper::worker_loop()
 {
     try
@@ -289,6 +324,10 @@ inline bool spdlog::details::async_log_helper::process_next_msg(log_clock::time_
             _flush_requested = true;
             break;
 
+        case async_msg_type::add_sink:
+            _sinks.push_back(std::move(incoming_async_msg.sink));
+            break;
+
         case async_msg_type::terminate:
             _flush_requested = true;
             _terminate_requested = true;
@@ -58,6 +58,17 @@ inline void spdlog::async_logger::flush()
     _async_log_helper->flush();
 }
 
+inline void spdlog::async_logger::add_sink(spdlog::sink_ptr single_sink)
+{
+    logger::add_sink(single_sink);
+    _async_log_helper->add_sink(single_sink);
+}
+
+inline size_t spdlog::async_logger::discarded_count() const
+{
+    return _async_log_helper->discarded_count();
+}
+
 inline void spdlog::async_logger::_set_formatter(spdlog::formatter_ptr msg_formatter)
 {
     _formatter = msg_formatter;
@@ -74,4 +85,10 @@ inline void spdlog::async_logger::_set_pattern(const std::string& pattern)
 inline void spdlog::async_logger::_log_msg(details::log_msg& msg)
 {
     _async_log_helper->log(msg);
+
+    // the worker flushes on the next flush message or interval, so only ask when
+    // the message is severe enough
+    const auto flush_level = _flush_level.load(std::memory_order_relaxed);
+    if (msg.level >= flush_level)
+        flush();
 }
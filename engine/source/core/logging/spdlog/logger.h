@@ -35,7 +35,7 @@ public:
     logger(const logger&) = delete;
     logger& operator=(const logger&) = delete;
 
-	void add_sink(sink_ptr single_sink);
+	virtual void add_sink(sink_ptr single_sink);
 
     void set_level(level::level_enum);
     level::level_enum level() const;
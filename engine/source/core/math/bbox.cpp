@@ -745,7 +745,7 @@ namespace math
 
 		// Compute new center (we use 'transformNormal' because we only
 		// want to apply rotation and scale).
-		t.transform_normal(bounds_center, bounds_center);
+		bounds_center = t.transform_normal(bounds_center);
 
 		// Calculate final bounding box (add on translation)
 		const vec3 & vTranslation = t.get_position();
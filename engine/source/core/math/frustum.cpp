@@ -4,6 +4,29 @@
 
 namespace math
 {
+	namespace
+	{
+		//-----------------------------------------------------------------------------
+		//  Name : to_local_planes ()
+		/// <summary>
+		/// Bring the frustum planes into the local space of an object placed by the
+		/// given transform. Planes transform by the inverse transpose of the
+		/// inverse, which is just the transpose, so nothing needs to be inverted.
+		/// The planes are left unnormalized, the sign tests do not need it.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void to_local_planes(plane planes[], const transform_t & t)
+		{
+			const mat4 & m = t.matrix();
+			for (unsigned int i = 0; i < 6; ++i)
+			{
+				const vec4 p = planes[i].data;
+				planes[i].data = vec4(dot(m[0], p), dot(m[1], p), dot(m[2], p), dot(m[3], p));
+
+			} // Next plane
+		}
+	}
+
 	///////////////////////////////////////////////////////////////////////////////
 	// frustum Member Functions
 	///////////////////////////////////////////////////////////////////////////////
@@ -252,9 +275,7 @@ namespace math
 	//-----------------------------------------------------------------------------
 	VolumeQuery::E frustum::classify_obb(frustum frustum, const bbox & AABB, const transform_t & t)
 	{
-		transform_t invTransform = inverse(t);
-
-		frustum.mul(invTransform);
+		to_local_planes(frustum.planes, t);
 
 		return frustum.classify_aabb(AABB);
 	}
@@ -348,9 +369,7 @@ namespace math
 	//-----------------------------------------------------------------------------
 	VolumeQuery::E frustum::classify_obb(frustum frustum, const bbox & AABB, const transform_t & t, unsigned int & FrustumBits, int & LastOutside)
 	{
-		transform_t invTransform = inverse(t);
-
-		frustum.mul(invTransform);
+		to_local_planes(frustum.planes, t);
 
 		return frustum.classify_aabb(AABB, FrustumBits, LastOutside);
 	}
@@ -397,9 +416,7 @@ namespace math
 	//-----------------------------------------------------------------------------
 	bool frustum::test_obb(frustum frustum, const bbox & AABB, const transform_t & t)
 	{
-		transform_t invTransform = inverse(t);
-
-		frustum.mul(invTransform);
+		to_local_planes(frustum.planes, t);
 
 		return frustum.test_aabb(AABB);
 	}
@@ -7,6 +7,50 @@
 #define MinAxisLength 1e-5f
 namespace math
 {
+	namespace
+	{
+		// states of the rotation and scale cache
+		enum CacheState : std::uint8_t
+		{
+			CacheInvalid,
+			CacheFilling,
+			CacheValid
+		};
+
+		//-----------------------------------------------------------------------------
+		//  Name : decompose_rotation_scale()
+		/// <summary>
+		/// Decompose the rotation and the axis lengths of a matrix. A matrix that
+		/// mirrors gets a negative length along its X axis, so that composing the
+		/// two gives back the matrix.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void decompose_rotation_scale(const mat4 & m, quat & qRotation, vec3 & vScale)
+		{
+			vScale = vec3(glm::length(vec3(m[0])), glm::length(vec3(m[1])), glm::length(vec3(m[2])));
+			qRotation = quat(1, 0, 0, 0);
+
+			// Degenerate axes can not be decomposed, treat them as unrotated.
+			if (vScale.x <= 0.0f || vScale.y <= 0.0f || vScale.z <= 0.0f)
+				return;
+
+			// glm::decompose flips every axis of a mirroring matrix but only the
+			// sign of the X scale, so unmirror the matrix before decomposing it.
+			mat4 mUnmirrored = m;
+			if (glm::determinant(mat3(m)) < 0.0f)
+			{
+				vScale.x = -vScale.x;
+				mUnmirrored[0] = -mUnmirrored[0];
+				mUnmirrored[0][3] = m[0][3];
+			}
+
+			vec3 vGlmScale, vShear, vTranslation;
+			vec4 vPersp;
+			if (!glm::decompose(mUnmirrored, vGlmScale, qRotation, vTranslation, vShear, vPersp))
+				qRotation = quat(1, 0, 0, 0);
+		}
+	}
+
 	//-----------------------------------------------------------------------------
 	// Static Member Definitions
 	//-----------------------------------------------------------------------------
@@ -33,7 +77,10 @@ namespace math
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	transform_t::transform_t(const transform_t & t) :
-		_matrix(t._matrix)
+		_matrix(t._matrix),
+		_rotation(t._rotation),
+		_scale(t._scale),
+		_cache_state(t._cache_state.load(std::memory_order_acquire) == CacheValid ? CacheValid : CacheInvalid)
 	{
 	}
 
@@ -71,6 +118,24 @@ namespace math
 		position() = vTranslation;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : operator= () (transform_t&)
+	/// <summary>
+	/// Overloaded assignment operator, copies the cached decomposition along
+	/// with the matrix.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	transform_t & transform_t::operator=(const transform_t & t)
+	{
+		_matrix = t._matrix;
+		_rotation = t._rotation;
+		_scale = t._scale;
+		_cache_state.store(t._cache_state.load(std::memory_order_acquire) == CacheValid ? CacheValid : CacheInvalid, std::memory_order_relaxed);
+
+		// Return reference to self in order to allow multiple assignments (i.e. a=b=c)
+		return *this;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : operator= () (mat4&)
 	/// <summary>
@@ -82,6 +147,7 @@ namespace math
 	transform_t & transform_t::operator=(const mat4 & m)
 	{
 		_matrix = m;
+		invalidate();
 
 		// Return reference to self in order to allow multiple assignments (i.e. a=b=c)
 		return *this;
@@ -129,6 +195,9 @@ namespace math
 	//-----------------------------------------------------------------------------
 	transform_t::operator mat4*()
 	{
+		// Caller may write through the pointer.
+		invalidate();
+
 		// Return address of internal matrix
 		return &_matrix;
 	}
@@ -147,6 +216,7 @@ namespace math
 
 	transform_t::operator float*()
 	{
+		invalidate();
 		return &_matrix[0][0];
 	}
 
@@ -157,6 +227,7 @@ namespace math
 
 	mat4::col_type & transform_t::operator[](mat4::length_type i)
 	{
+		invalidate();
 		return _matrix[i];
 	}
 
@@ -237,6 +308,7 @@ namespace math
 	transform_t & transform_t::operator*= (const transform_t & t)
 	{
 		_matrix *= t._matrix;
+		invalidate();
 		return *this;
 	}
 
@@ -249,6 +321,7 @@ namespace math
 	transform_t & transform_t::operator*= (float f)
 	{
 		_matrix *= f;
+		invalidate();
 
 		return *this;
 	}
@@ -262,6 +335,7 @@ namespace math
 	transform_t & transform_t::operator+= (const transform_t & t)
 	{
 		_matrix += t._matrix;
+		invalidate();
 		return *this;
 	}
 
@@ -274,18 +348,23 @@ namespace math
 	transform_t & transform_t::operator-= (const transform_t & t)
 	{
 		_matrix -= t._matrix;
+		invalidate();
 		return *this;
 	}
 
 	//-----------------------------------------------------------------------------
 	//  Name : get_scale()
 	/// <summary>
-	/// Retrieve the scale of the transformation along its local axes.
+	/// Retrieve the scale of the transformation along its local axes. An axis
+	/// the transformation mirrors has a negative scale.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::get_scale() const
 	{
-		return vec3(glm::length(x_axis()), glm::length(y_axis()), glm::length(z_axis()));
+		quat qRotation;
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		return vScale;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -370,8 +449,10 @@ namespace math
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::x_unit_axis() const
 	{
-		vec3 v = glm::normalize(x_axis());
-		return v;
+		quat qRotation;
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		return x_axis() / glm::abs(vScale.x);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -382,8 +463,10 @@ namespace math
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::y_unit_axis() const
 	{
-		vec3 v = glm::normalize(y_axis());
-		return v;
+		quat qRotation;
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		return y_axis() / glm::abs(vScale.y);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -394,8 +477,10 @@ namespace math
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::z_unit_axis() const
 	{
-		vec3 v = glm::normalize(z_axis());
-		return v;
+		quat qRotation;
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		return z_axis() / glm::abs(vScale.z);
 	}
 
 
@@ -411,6 +496,7 @@ namespace math
 	}
 	mat4& transform_t::matrix()
 	{
+		invalidate();
 		return _matrix;
 	}
 
@@ -422,12 +508,51 @@ namespace math
 	//-----------------------------------------------------------------------------
 	quat transform_t::get_rotation() const
 	{
-		vec3 vScale, vShear, vTranslation;
 		quat qRotation;
-		if (decompose(vScale, vShear, qRotation, vTranslation))
-			return qRotation;
-		else
-			return quat(0, 0, 0, 1);
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		return qRotation;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_rotation_scale() (Private)
+	/// <summary>
+	/// Retrieve the rotation and axis lengths, decomposing them from the matrix
+	/// unless that was already done since it last changed. The first caller
+	/// fills the cache, callers on other threads that find it being filled
+	/// decompose on their own rather than waiting or writing it too.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void transform_t::get_rotation_scale(quat & qRotation, vec3 & vScale) const
+	{
+		if (_cache_state.load(std::memory_order_acquire) == CacheValid)
+		{
+			qRotation = _rotation;
+			vScale = _scale;
+			return;
+		}
+
+		decompose_rotation_scale(_matrix, qRotation, vScale);
+
+		std::uint8_t expected = CacheInvalid;
+		if (_cache_state.compare_exchange_strong(expected, CacheFilling, std::memory_order_acquire))
+		{
+			_rotation = qRotation;
+			_scale = vScale;
+			_cache_state.store(CacheValid, std::memory_order_release);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate() (Private)
+	/// <summary>
+	/// Called whenever the rotation or scale part of the matrix may have changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void transform_t::invalidate()
+	{
+		// Mutators are never called concurrently with the getters.
+		_cache_state.store(CacheInvalid, std::memory_order_relaxed);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -439,6 +564,7 @@ namespace math
 	transform_t & transform_t::zero()
 	{
 		memset(&_matrix, 0, sizeof(mat4));
+		invalidate();
 		return *this;
 	}
 
@@ -564,6 +690,7 @@ namespace math
 
 		// identity fourth column.
 		_matrix[0][3] = 0.0f; _matrix[1][3] = 0.0f; _matrix[2][3] = 0.0f; _matrix[3][3] = 1.0f;
+		invalidate();
 
 		// Return reference to self in order to allow consecutive operations (i.e. a.rotate(...).scale(...))
 		return *this;
@@ -586,6 +713,7 @@ namespace math
 	{
 		// Convert rotation quat to matrix form.
 		_matrix = glm::mat4_cast(qRotation);
+		invalidate();
 
 		// translation
 		_matrix[3][0] = vTranslation.x; _matrix[3][1] = vTranslation.y; _matrix[3][2] = vTranslation.z;
@@ -602,11 +730,75 @@ namespace math
 	//-----------------------------------------------------------------------------
 	transform_t & transform_t::invert()
 	{
-		_matrix = glm::inverse(_matrix);
+		affine_inverse(_matrix, _matrix);
+		invalidate();
 
 		return *this;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : is_affine()
+	/// <summary>
+	/// Determine whether the fourth row is <0,0,0,1>, i.e. the transform has no
+	/// projective part.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool transform_t::is_affine() const
+	{
+		return _matrix[0][3] == 0.0f && _matrix[1][3] == 0.0f && _matrix[2][3] == 0.0f && _matrix[3][3] == 1.0f;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : affine_inverse() (Static)
+	/// <summary>
+	/// Invert a matrix, taking the cheaper route of inverting only the upper 3x3
+	/// and the translation when the matrix has no projective part. Falls back to
+	/// a general inverse otherwise. Returns false for affine matrices that are
+	/// singular, in which case the result is left untouched. The result may
+	/// alias the source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool transform_t::affine_inverse(const mat4 & m, mat4 & result)
+	{
+		if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f || m[3][3] != 1.0f)
+		{
+			result = glm::inverse(m);
+			return true;
+		}
+
+		// Cofactors of the upper 3x3 (column major, m[column][row]).
+		const float c00 = m[1][1] * m[2][2] - m[2][1] * m[1][2];
+		const float c01 = m[2][1] * m[0][2] - m[0][1] * m[2][2];
+		const float c02 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+		const float det = m[0][0] * c00 + m[1][0] * c01 + m[2][0] * c02;
+		if (det == 0.0f)
+			return false;
+
+		const float inv_det = 1.0f / det;
+		mat4 r;
+		r[0][0] = c00 * inv_det;
+		r[0][1] = c01 * inv_det;
+		r[0][2] = c02 * inv_det;
+		r[1][0] = (m[2][0] * m[1][2] - m[1][0] * m[2][2]) * inv_det;
+		r[1][1] = (m[0][0] * m[2][2] - m[2][0] * m[0][2]) * inv_det;
+		r[1][2] = (m[1][0] * m[0][2] - m[0][0] * m[1][2]) * inv_det;
+		r[2][0] = (m[1][0] * m[2][1] - m[2][0] * m[1][1]) * inv_det;
+		r[2][1] = (m[2][0] * m[0][1] - m[0][0] * m[2][1]) * inv_det;
+		r[2][2] = (m[0][0] * m[1][1] - m[1][0] * m[0][1]) * inv_det;
+		r[0][3] = 0.0f; r[1][3] = 0.0f; r[2][3] = 0.0f;
+
+		// Inverse translation is the negated translation brought back through
+		// the inverted 3x3.
+		const float tx = m[3][0], ty = m[3][1], tz = m[3][2];
+		r[3][0] = -(r[0][0] * tx + r[1][0] * ty + r[2][0] * tz);
+		r[3][1] = -(r[0][1] * tx + r[1][1] * ty + r[2][1] * tz);
+		r[3][2] = -(r[0][2] * tx + r[1][2] * ty + r[2][2] * tz);
+		r[3][3] = 1.0f;
+
+		result = r;
+		return true;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : transformCoord()
 	/// <summary>
@@ -643,7 +835,8 @@ namespace math
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::inverse_transform_coord(const vec3 & v) const
 	{
-		mat4 im = glm::inverse(_matrix);
+		mat4 im = _matrix;
+		affine_inverse(_matrix, im);
 		vec3 vOut;
 		vOut = im * vec4{ v, 1.0f };
 		return vOut;
@@ -695,7 +888,8 @@ namespace math
 	//-----------------------------------------------------------------------------
 	vec3 transform_t::inverse_transform_normal(const vec3 & v) const
 	{
-		mat4 im = glm::inverse(_matrix);
+		mat4 im = _matrix;
+		affine_inverse(_matrix, im);
 		vec3 vOut;
 		vOut = im * vec4{ v, 0.0f };
 		return vOut;
@@ -814,6 +1008,7 @@ namespace math
 	// 
 		// Apply scale
 		_matrix = glm::scale(_matrix, vec3{ x, y, z });
+		invalidate();
 
 
 		// Return reference to self in order to allow multiple operations (i.e. a.rotate(...).scale(...))
@@ -913,15 +1108,29 @@ namespace math
 	transform_t & transform_t::set_scale(float x, float y, float z)
 	{
 
-		// Clamp the various scales to the minimum length.
-		x = glm::max<float>(MinAxisLength, x);
-		y = glm::max<float>(MinAxisLength, y);
-		z = glm::max<float>(MinAxisLength, z);
+		// Clamp the various scales to the minimum length, keeping their sign.
+		// A negative scale mirrors the axis, like it does for compose().
+		x = (x < 0.0f) ? glm::min<float>(-MinAxisLength, x) : glm::max<float>(MinAxisLength, x);
+		y = (y < 0.0f) ? glm::min<float>(-MinAxisLength, y) : glm::max<float>(MinAxisLength, y);
+		z = (z < 0.0f) ? glm::min<float>(-MinAxisLength, z) : glm::max<float>(MinAxisLength, z);
+
+		// The axes of the rotation, which are the current axes unmirrored.
+		quat qRotation;
+		vec3 vScale;
+		get_rotation_scale(qRotation, vScale);
+		const vec3 vX = x_axis() / vScale.x;
+		const vec3 vY = y_axis() / vScale.y;
+		const vec3 vZ = z_axis() / vScale.z;
 
 		// Generate the new axis vectors;
-		(vec3&)_matrix[0] = x_unit_axis() * x;
-		(vec3&)_matrix[1] = y_unit_axis() * y;
-		(vec3&)_matrix[2] = z_unit_axis() * z;
+		(vec3&)_matrix[0] = vX * x;
+		(vec3&)_matrix[1] = vY * y;
+		(vec3&)_matrix[2] = vZ * z;
+
+		// Only the axis lengths changed, the rotation still holds.
+		_rotation = qRotation;
+		_scale = vec3(x, y, z);
+		_cache_state.store(CacheValid, std::memory_order_relaxed);
 
 		// Return reference to self in order to allow multiple operations (i.e. a.rotate(...).scale(...))
 		return *this;
@@ -988,6 +1197,7 @@ namespace math
 		(vec3&)m[3] = get_position();
 
 		_matrix = m;
+		invalidate();
 		// Return reference to self in order to allow multiple operations (i.e. a.rotate(...).scale(...))
 		return *this;
 	}
@@ -1014,6 +1224,7 @@ namespace math
 		(vec3&)_matrix[0] *= vScale.x;
 		(vec3&)_matrix[1] *= vScale.y;
 		(vec3&)_matrix[2] *= vScale.z;
+		invalidate();
 
 		// Return reference to self in order to allow multiple operations (i.e. a.rotate(...).scale(...))
 		return *this;
@@ -1040,6 +1251,7 @@ namespace math
 	transform_t & transform_t::look_at(const vec3 & vEye, const vec3 & vAt, const vec3 & vUpAlign)
 	{
 		_matrix = glm::lookAt(vEye, vAt, vUpAlign);
+		invalidate();
 
 		// Return reference to self in order to allow multiple operations (i.e. a.rotate(...).scale(...))
 		return *this;
@@ -1054,6 +1266,7 @@ namespace math
 	transform_t & transform_t::scaling(float x, float y, float z)
 	{
 		_matrix = glm::scale(vec3{ x, y, z });
+		invalidate();
 		return *this;
 	}
 
@@ -1072,6 +1285,7 @@ namespace math
 		qz = glm::angleAxis(z, vec3{ 0.0f, 0.0f, 1.0f });
 		quat q = qx * qy * qz;
 		_matrix = glm::mat4_cast(q);
+		invalidate();
 		return *this;
 	}
 
@@ -1086,6 +1300,7 @@ namespace math
 	{
 		quat q = glm::angleAxis(a, v);
 		_matrix = glm::mat4_cast(q);
+		invalidate();
 		return *this;
 	}
 
@@ -1098,6 +1313,7 @@ namespace math
 	transform_t & transform_t::translation(float x, float y, float z)
 	{
 		_matrix = glm::translate(vec3{ x, y, z });
+		invalidate();
 		return *this;
 	}
 
@@ -1110,6 +1326,7 @@ namespace math
 	transform_t & transform_t::translation(const vec3 & v)
 	{
 		_matrix = glm::translate(v);
+		invalidate();
 		return *this;
 	}
 
@@ -1183,8 +1400,8 @@ namespace math
 
 	math::transform_t inverse(transform_t const & t)
 	{
-		glm::mat4 m = t.matrix();
-		glm::mat4 inv = glm::inverse(m);
+		glm::mat4 inv = t.matrix();
+		transform_t::affine_inverse(t.matrix(), inv);
 		return inv;
 	}
 
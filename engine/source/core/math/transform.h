@@ -3,6 +3,8 @@
 // transform Header Includes
 //-----------------------------------------------------------------------------
 #include "glm_includes.h"
+#include <atomic>
+#include <cstdint>
 
 namespace math
 {
@@ -16,6 +18,12 @@ namespace math
 	/// General purpose transformation class designed to maintain each component of
 	/// the transformation separate (translation, rotation, scale and shear) whilst
 	/// providing much of the same functionality provided by standard matrices.
+	/// The rotation and scale are decomposed from the matrix on first request
+	/// and cached until the matrix changes. The const getters may be called
+	/// from several threads at once, the first of them fills the cache. Any
+	/// non-const access to the matrix (matrix(), operator[], the pointer casts)
+	/// drops the cache, so references obtained that way must not be held
+	/// across calls to the getters.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	class transform_t
@@ -41,6 +49,7 @@ namespace math
 		bool decompose(vec3 & scale, quat & rotation, vec3 & translation) const;
 		bool decompose(quat & rotation, vec3 & translation) const;
 		transform_t& invert();
+		bool is_affine() const;
 
 		const vec3& get_position() const;
 		vec3 get_scale() const;
@@ -105,6 +114,7 @@ namespace math
 		mat4::col_type& operator[](mat4::length_type i);
 		mat4::col_type const& operator[](mat4::length_type i) const;
 
+		transform_t& operator=(const transform_t & t);
 		transform_t& operator=(const mat4 & m);
 		bool operator==(const transform_t & t) const;
 		bool operator!=(const transform_t & t) const;
@@ -133,6 +143,7 @@ namespace math
 		static bool decompose(vec3 & scale, quat & rotation, vec3 & translation, const transform_t & t);
 		static bool decompose(quat & rotation, vec3 & translation, const transform_t & t);
 		static transform_t lerp(transform_t & t1, transform_t & t2, float dt);
+		static bool affine_inverse(const mat4 & m, mat4 & result);
 		//-------------------------------------------------------------------------
 		// Public Static Variables
 		//-------------------------------------------------------------------------
@@ -140,10 +151,20 @@ namespace math
 
 	private:
 		vec3& position();
+		void get_rotation_scale(quat & rotation, vec3 & scale) const;
+		void invalidate();
 		//-------------------------------------------------------------------------
 		// Protected Variables
 		//-------------------------------------------------------------------------
 		mat4 _matrix;
+		/// Rotation decomposed from the matrix, valid when the cache is.
+		mutable quat _rotation;
+		/// Length of the local axes, negative where the matrix mirrors them.
+		/// Valid when the cache is.
+		mutable vec3 _scale;
+		/// Whether _rotation and _scale match the current matrix, or are being
+		/// written by the getter that fills them.
+		mutable std::atomic<std::uint8_t> _cache_state{ 0 };
 	};
 
 	transform_t inverse(transform_t const& t);
@@ -0,0 +1,204 @@
+#include "transform_batch.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MATH_BATCH_SSE 1
+#include <xmmintrin.h>
+#else
+#define MATH_BATCH_SSE 0
+#endif
+
+namespace math
+{
+	namespace batch
+	{
+#if MATH_BATCH_SSE
+		namespace
+		{
+			// Broadcast one lane of a register to all four.
+			#define MATH_SPLAT(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+
+			//-----------------------------------------------------------------------------
+			//  Name : load3 ()
+			/// <summary>
+			/// Loads x, y and z of a vec3 into the lower lanes without reading past it.
+			/// </summary>
+			//-----------------------------------------------------------------------------
+			inline __m128 load3(const vec3& v)
+			{
+				const __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(&v.x));
+				return _mm_movelh_ps(xy, _mm_load_ss(&v.z));
+			}
+
+			//-----------------------------------------------------------------------------
+			//  Name : store3 ()
+			/// <summary>
+			/// Stores the lower three lanes to a vec3 without writing past it.
+			/// </summary>
+			//-----------------------------------------------------------------------------
+			inline void store3(vec3& v, __m128 r)
+			{
+				_mm_storel_pi(reinterpret_cast<__m64*>(&v.x), r);
+				_mm_store_ss(&v.z, _mm_movehl_ps(r, r));
+			}
+
+			//-----------------------------------------------------------------------------
+			//  Name : mul4 ()
+			/// <summary>
+			/// Column major 4x4 multiply with the columns of lhs already loaded.
+			/// </summary>
+			//-----------------------------------------------------------------------------
+			inline void mul4(const __m128 a[4], const float* b, float* r)
+			{
+				// Load all of rhs before storing anything, so that r may alias it.
+				const __m128 b_cols[4] = { _mm_loadu_ps(b), _mm_loadu_ps(b + 4), _mm_loadu_ps(b + 8), _mm_loadu_ps(b + 12) };
+
+				__m128 c[4];
+				for (int j = 0; j < 4; ++j)
+				{
+					const __m128 bj = b_cols[j];
+					__m128 v = _mm_mul_ps(a[0], MATH_SPLAT(bj, 0));
+					v = _mm_add_ps(v, _mm_mul_ps(a[1], MATH_SPLAT(bj, 1)));
+					v = _mm_add_ps(v, _mm_mul_ps(a[2], MATH_SPLAT(bj, 2)));
+					v = _mm_add_ps(v, _mm_mul_ps(a[3], MATH_SPLAT(bj, 3)));
+					c[j] = v;
+				}
+
+				_mm_storeu_ps(r, c[0]);
+				_mm_storeu_ps(r + 4, c[1]);
+				_mm_storeu_ps(r + 8, c[2]);
+				_mm_storeu_ps(r + 12, c[3]);
+			}
+
+			//-----------------------------------------------------------------------------
+			//  Name : load_columns ()
+			/// <summary>
+			/// Loads the four columns of a matrix.
+			/// </summary>
+			//-----------------------------------------------------------------------------
+			inline void load_columns(const mat4& m, __m128 a[4])
+			{
+				const float* p = &m[0][0];
+				a[0] = _mm_loadu_ps(p);
+				a[1] = _mm_loadu_ps(p + 4);
+				a[2] = _mm_loadu_ps(p + 8);
+				a[3] = _mm_loadu_ps(p + 12);
+			}
+		}
+#endif
+
+		//-----------------------------------------------------------------------------
+		//  Name : mul ()
+		/// <summary>
+		/// Pairwise matrix multiply.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void mul(const mat4* lhs, const mat4* rhs, mat4* result, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+#if MATH_BATCH_SSE
+				__m128 a[4];
+				load_columns(lhs[i], a);
+				mul4(a, &rhs[i][0][0], &result[i][0][0]);
+#else
+				result[i] = lhs[i] * rhs[i];
+#endif
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : mul ()
+		/// <summary>
+		/// Matrix multiply with a shared left hand side.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void mul(const mat4& lhs, const mat4* rhs, mat4* result, std::size_t count)
+		{
+#if MATH_BATCH_SSE
+			__m128 a[4];
+			load_columns(lhs, a);
+			for (std::size_t i = 0; i < count; ++i)
+				mul4(a, &rhs[i][0][0], &result[i][0][0]);
+#else
+			for (std::size_t i = 0; i < count; ++i)
+				result[i] = lhs * rhs[i];
+#endif
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : transform_coords ()
+		/// <summary>
+		/// Affine point transform.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void transform_coords(const mat4& m, const vec3* points, vec3* result, std::size_t count)
+		{
+#if MATH_BATCH_SSE
+			__m128 a[4];
+			load_columns(m, a);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const __m128 p = load3(points[i]);
+				__m128 v = _mm_add_ps(_mm_mul_ps(a[0], MATH_SPLAT(p, 0)), a[3]);
+				v = _mm_add_ps(v, _mm_mul_ps(a[1], MATH_SPLAT(p, 1)));
+				v = _mm_add_ps(v, _mm_mul_ps(a[2], MATH_SPLAT(p, 2)));
+				store3(result[i], v);
+			}
+#else
+			for (std::size_t i = 0; i < count; ++i)
+				result[i] = vec3(m * vec4(points[i], 1.0f));
+#endif
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : transform_bounds ()
+		/// <summary>
+		/// Box transform by center and extents: the center goes through the full
+		/// matrix, the extents through the absolute value of its 3x3 part.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void transform_bounds(const mat4* matrices, const bbox* bounds, bbox* result, std::size_t count)
+		{
+#if MATH_BATCH_SSE
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 sign = _mm_set1_ps(-0.0f);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				__m128 a[4];
+				load_columns(matrices[i], a);
+
+				const __m128 min = load3(bounds[i].min);
+				const __m128 max = load3(bounds[i].max);
+				const __m128 c = _mm_mul_ps(_mm_add_ps(min, max), half);
+				const __m128 e = _mm_mul_ps(_mm_sub_ps(max, min), half);
+
+				__m128 center = _mm_add_ps(_mm_mul_ps(a[0], MATH_SPLAT(c, 0)), a[3]);
+				center = _mm_add_ps(center, _mm_mul_ps(a[1], MATH_SPLAT(c, 1)));
+				center = _mm_add_ps(center, _mm_mul_ps(a[2], MATH_SPLAT(c, 2)));
+
+				__m128 extents = _mm_mul_ps(_mm_andnot_ps(sign, a[0]), MATH_SPLAT(e, 0));
+				extents = _mm_add_ps(extents, _mm_mul_ps(_mm_andnot_ps(sign, a[1]), MATH_SPLAT(e, 1)));
+				extents = _mm_add_ps(extents, _mm_mul_ps(_mm_andnot_ps(sign, a[2]), MATH_SPLAT(e, 2)));
+
+				store3(result[i].min, _mm_sub_ps(center, extents));
+				store3(result[i].max, _mm_add_ps(center, extents));
+			}
+#else
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				const mat4& m = matrices[i];
+				const vec3 c = (bounds[i].min + bounds[i].max) * 0.5f;
+				const vec3 e = (bounds[i].max - bounds[i].min) * 0.5f;
+				const vec3 center = vec3(m * vec4(c, 1.0f));
+				const vec3 extents = abs(vec3(m[0])) * e.x + abs(vec3(m[1])) * e.y + abs(vec3(m[2])) * e.z;
+				result[i].min = center - extents;
+				result[i].max = center + extents;
+			}
+#endif
+		}
+
+#if MATH_BATCH_SSE
+#undef MATH_SPLAT
+#endif
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+//-----------------------------------------------------------------------------
+// transform_batch Header Includes
+//-----------------------------------------------------------------------------
+#include "transform.h"
+#include "bbox.h"
+#include <cstddef>
+
+namespace math
+{
+	//-----------------------------------------------------------------------------
+	// Batch kernels
+	//-----------------------------------------------------------------------------
+	// Array versions of the common transform operations, for the places that
+	// push many matrices, points or boxes through the same operation in a row
+	// (skinning palettes, culling, particle bounds). They use SSE when the
+	// target has it and plain glm otherwise. Matrices are taken as mat4 arrays,
+	// use transform_t::matrix() to feed single transforms.
+	//-----------------------------------------------------------------------------
+	namespace batch
+	{
+		//-----------------------------------------------------------------------------
+		//  Name : mul ()
+		/// <summary>
+		/// Computes result[i] = lhs[i] * rhs[i] for count matrices. The result may
+		/// alias either input.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void mul(const mat4* lhs, const mat4* rhs, mat4* result, std::size_t count);
+
+		//-----------------------------------------------------------------------------
+		//  Name : mul ()
+		/// <summary>
+		/// Computes result[i] = lhs * rhs[i] for count matrices, e.g. to bring a
+		/// list of local transforms into the space of a common parent. The result
+		/// may alias rhs.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void mul(const mat4& lhs, const mat4* rhs, mat4* result, std::size_t count);
+
+		//-----------------------------------------------------------------------------
+		//  Name : transform_coords ()
+		/// <summary>
+		/// Transforms count points by an affine matrix. Unlike
+		/// transform_t::transform_coord there is no projection back into w = 1.
+		/// The result may alias the source.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void transform_coords(const mat4& m, const vec3* points, vec3* result, std::size_t count);
+
+		//-----------------------------------------------------------------------------
+		//  Name : transform_bounds ()
+		/// <summary>
+		/// Computes the axis aligned box enclosing each of the count boxes once
+		/// transformed by the matching affine matrix, the same as bbox::mul. The
+		/// result may alias the source.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void transform_bounds(const mat4* matrices, const bbox* bounds, bbox* result, std::size_t count);
+
+	}
+}
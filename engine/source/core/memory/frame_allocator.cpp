@@ -0,0 +1,171 @@
+#include "frame_allocator.hpp"
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace core
+{
+
+	LinearArena::LinearArena(size_t page_size)
+	{
+		_page_index = 0;
+		_cursor = nullptr;
+		_end = nullptr;
+		_page_size = page_size;
+		_used = 0;
+		_heap_bytes = 0;
+	}
+
+	LinearArena::~LinearArena()
+	{
+		free_pages();
+	}
+
+	void* LinearArena::allocate_slow(size_t size, size_t alignment)
+	{
+		// move on to the next page that is large enough, pages skipped here
+		// are reused after the next reset
+		for (size_t i = _cursor ? _page_index + 1 : 0; i < _pages.size(); ++i)
+		{
+			if (_pages[i].size >= size + alignment)
+			{
+				set_page(i);
+				return allocate(size, alignment);
+			}
+		}
+
+		// out of pages, oversized requests get a page of their own
+		if (!add_page(size + alignment > _page_size ? size + alignment : _page_size))
+			return nullptr;
+
+		set_page(_pages.size() - 1);
+		return allocate(size, alignment);
+	}
+
+	void LinearArena::reset()
+	{
+		if (_pages.size() > 1)
+		{
+			// merge the pages into one, the next round then fits in it. the
+			// growth was already counted when the pages were added.
+			auto total = capacity();
+			free_pages();
+			add_page(total);
+		}
+
+		_page_index = 0;
+		_cursor = nullptr;
+		_end = nullptr;
+		if (!_pages.empty())
+			set_page(0);
+
+		_used = 0;
+		_heap_bytes = 0;
+	}
+
+	size_t LinearArena::capacity() const
+	{
+		size_t total = 0;
+		for (const auto& page : _pages)
+			total += page.size;
+		return total;
+	}
+
+	bool LinearArena::add_page(size_t size)
+	{
+		auto data = static_cast<uint8_t*>(::malloc(size));
+		if (data == nullptr)
+			return false;
+
+		_pages.push_back({ data, size });
+		_heap_bytes.store(_heap_bytes.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+		return true;
+	}
+
+	void LinearArena::set_page(size_t index)
+	{
+		_page_index = index;
+		_cursor = _pages[index].data;
+		_end = _pages[index].data + _pages[index].size;
+	}
+
+	void LinearArena::free_pages()
+	{
+		for (auto& page : _pages)
+			::free(page.data);
+
+		_pages.clear();
+		_page_index = 0;
+		_cursor = nullptr;
+		_end = nullptr;
+	}
+
+	namespace frame_memory
+	{
+		namespace
+		{
+			const size_t page_size = 256 * 1024;
+
+			struct Registry
+			{
+				std::mutex mutex;
+				// arenas outlive their threads, they are only released on exit
+				std::vector<std::unique_ptr<LinearArena>> arenas;
+				Stats last_frame;
+			};
+
+			Registry& get_registry()
+			{
+				static Registry registry;
+				return registry;
+			}
+
+			thread_local LinearArena* thread_arena = nullptr;
+		}
+
+		LinearArena& get_arena()
+		{
+			if (thread_arena == nullptr)
+			{
+				auto& registry = get_registry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.arenas.emplace_back(new LinearArena(page_size));
+				thread_arena = registry.arenas.back().get();
+			}
+			return *thread_arena;
+		}
+
+		void* allocate(size_t size, size_t alignment)
+		{
+			auto ptr = get_arena().allocate(size, alignment);
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return ptr;
+		}
+
+		void reset()
+		{
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			Stats stats;
+			for (auto& arena : registry.arenas)
+			{
+				stats.arena_bytes += arena->used();
+				stats.heap_bytes += arena->heap_bytes();
+				arena->reset();
+			}
+			stats.arenas = registry.arenas.size();
+			registry.last_frame = stats;
+		}
+
+		Stats get_last_frame_stats()
+		{
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			return registry.last_frame;
+		}
+	}
+
+}
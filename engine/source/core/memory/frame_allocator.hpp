@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace core
+{
+
+	// a linear arena hands out memory by moving a cursor through large pages
+	// and releases everything at once when reset. allocating is a pointer bump
+	// and deallocating does nothing, which suits scratch data that is thrown
+	// away as a whole, e.g. at the end of a frame.
+	// an arena is not synchronized, only its owner thread may allocate from it.
+	struct LinearArena
+	{
+		LinearArena(size_t page_size);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		// acquire size bytes aligned to alignment (a power of two)
+		void* allocate(size_t size, size_t alignment);
+		// rewind to the beginning of the first page. if the previous round
+		// needed several pages they are replaced by a single one big enough
+		// for all of it, so that steady state usage never touches the heap.
+		void reset();
+
+		// returns the number of bytes handed out since the last reset
+		size_t used() const;
+		// returns the number of bytes requested from the heap since the last reset
+		size_t heap_bytes() const;
+		// returns the size of all pages
+		size_t capacity() const;
+
+	protected:
+		struct Page
+		{
+			uint8_t* data;
+			size_t size;
+		};
+
+		void* allocate_slow(size_t size, size_t alignment);
+		bool add_page(size_t size);
+		void set_page(size_t index);
+		void free_pages();
+
+		std::vector<Page> _pages;
+
+		size_t _page_index;
+		uint8_t* _cursor;
+		uint8_t* _end;
+		size_t _page_size;
+
+		// written by the owner thread only, read by whoever collects statistics
+		std::atomic<size_t> _used;
+		std::atomic<size_t> _heap_bytes;
+	};
+
+	inline void* LinearArena::allocate(size_t size, size_t alignment)
+	{
+		auto address = (reinterpret_cast<uintptr_t>(_cursor) + (alignment - 1)) & ~uintptr_t(alignment - 1);
+		if (_cursor == nullptr || address + size > reinterpret_cast<uintptr_t>(_end))
+			return allocate_slow(size, alignment);
+
+		_cursor = reinterpret_cast<uint8_t*>(address + size);
+		_used.store(_used.load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+		return reinterpret_cast<void*>(address);
+	}
+
+	inline size_t LinearArena::used() const
+	{
+		return _used.load(std::memory_order_relaxed);
+	}
+
+	inline size_t LinearArena::heap_bytes() const
+	{
+		return _heap_bytes.load(std::memory_order_relaxed);
+	}
+
+	// per thread linear arenas that are reset once per frame. every thread
+	// that allocates gets its own arena, so task system workers never contend.
+	// memory taken from them is valid until the end of the current frame only,
+	// containers using it must not be kept across frames, not even cleared ones.
+	namespace frame_memory
+	{
+		struct Stats
+		{
+			// bytes handed out by the frame arenas
+			size_t arena_bytes = 0;
+			// bytes the frame arenas had to request from the heap
+			size_t heap_bytes = 0;
+			// number of threads that own an arena
+			size_t arenas = 0;
+		};
+
+		// returns the arena of the calling thread, it is created on first use
+		LinearArena& get_arena();
+
+		// acquire memory from the arena of the calling thread
+		void* allocate(size_t size, size_t alignment);
+
+		// rewind the arenas of all threads. call once at the end of the frame
+		// when no task is using frame memory anymore.
+		void reset();
+
+		// returns the usage of the last completed frame
+		Stats get_last_frame_stats();
+	}
+
+	// stl compatible allocator on top of the frame arenas
+	template<typename T> struct FrameAllocator
+	{
+		using value_type = T;
+
+		FrameAllocator() = default;
+
+		template<typename U> FrameAllocator(const FrameAllocator<U>&)
+		{}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(frame_memory::allocate(count * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, size_t)
+		{}
+	};
+
+	template<typename T, typename U>
+	inline bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&)
+	{
+		return true;
+	}
+
+	template<typename T, typename U>
+	inline bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&)
+	{
+		return false;
+	}
+
+	template<typename T> using frame_vector = std::vector<T, FrameAllocator<T>>;
+
+}
@@ -3,3 +3,5 @@
 #include "tracey.hpp"
 #include "checked_delete.h"
 #include "memory_pool.hpp"
+#include "frame_allocator.hpp"
+#include "pool_allocator.hpp"
@@ -1,5 +1,6 @@
 #include "memory_pool.hpp"
 #include <cstdlib>
+#include <cstring>
 
 namespace core
 {
@@ -3,6 +3,8 @@
 #include <vector>
 #include <type_traits>
 #include <limits>
+#include <cstddef>
+#include <cstdint>
 
 namespace core
 {
@@ -0,0 +1,239 @@
+#include "pool_allocator.hpp"
+#include <atomic>
+#include <limits>
+
+namespace core
+{
+
+	namespace
+	{
+		constexpr const size_t max_pools = 64;
+		constexpr const size_t invalid_slot = std::numeric_limits<size_t>::max();
+
+		struct ThreadCaches;
+
+		// the pools with a cache slot and the caches of the live threads. the
+		// mutex keeps a pool from going away while an exiting thread gives its
+		// blocks back, and a thread from going away while a dying pool clears
+		// its slot. it is never destroyed, threads may exit after main returns.
+		struct Registry
+		{
+			std::mutex mutex;
+			ConcurrentMemoryPool* pools[max_pools] = {};
+			ThreadCaches* threads = nullptr;
+		};
+
+		Registry& get_registry()
+		{
+			static auto registry = new Registry();
+			return *registry;
+		}
+
+		std::atomic<size_t> next_slot(0);
+
+		// set once the caches of the current thread are gone. blocks freed
+		// after that, by the destructors of other thread locals for instance,
+		// go straight to the shared free list.
+		thread_local bool thread_caches_destroyed = false;
+
+		// free blocks the current thread holds on to, one cache per pool
+		struct ThreadCaches
+		{
+			ConcurrentMemoryPool::Cache caches[max_pools];
+			ThreadCaches* previous = nullptr;
+			ThreadCaches* next = nullptr;
+
+			ThreadCaches()
+			{
+				auto& registry = get_registry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				next = registry.threads;
+				if (next)
+					next->previous = this;
+				registry.threads = this;
+			}
+
+			~ThreadCaches()
+			{
+				auto& registry = get_registry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+
+				// hand the blocks back so that other threads can reuse them
+				for (size_t i = 0; i < max_pools; ++i)
+				{
+					if (registry.pools[i] && caches[i].head)
+						registry.pools[i]->release(caches[i]);
+				}
+
+				if (previous)
+					previous->next = next;
+				else
+					registry.threads = next;
+				if (next)
+					next->previous = previous;
+
+				thread_caches_destroyed = true;
+			}
+		};
+
+		thread_local ThreadCaches thread_caches;
+	}
+
+	ConcurrentMemoryPool::ConcurrentMemoryPool(size_t block_size, size_t chunk_size)
+		: _pool(block_size < sizeof(FreeBlock) ? sizeof(FreeBlock) : block_size, chunk_size)
+	{
+		_free = nullptr;
+
+		// pools beyond the cache slots still work, they just lock every time
+		_slot = next_slot.fetch_add(1);
+		if (_slot < max_pools)
+		{
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.pools[_slot] = this;
+		}
+		else
+		{
+			_slot = invalid_slot;
+		}
+	}
+
+	ConcurrentMemoryPool::~ConcurrentMemoryPool()
+	{
+		if (_slot == invalid_slot)
+			return;
+
+		// the blocks still cached by any thread belong to the chunks freed with
+		// this pool, so every cache forgets them. the slot is not reused, the
+		// threads never look at it again.
+		auto& registry = get_registry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.pools[_slot] = nullptr;
+		for (auto thread = registry.threads; thread != nullptr; thread = thread->next)
+			thread->caches[_slot] = Cache();
+	}
+
+	void* ConcurrentMemoryPool::malloc()
+	{
+		auto cache = get_cache();
+		if (cache == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_free != nullptr)
+			{
+				auto block = _free;
+				_free = block->next;
+				return block;
+			}
+			return _pool.malloc();
+		}
+
+		if (cache->head == nullptr)
+		{
+			refill(*cache);
+			if (cache->head == nullptr)
+				return nullptr;
+		}
+
+		auto block = cache->head;
+		cache->head = block->next;
+		cache->count--;
+		return block;
+	}
+
+	void ConcurrentMemoryPool::free(void* ptr)
+	{
+		if (ptr == nullptr)
+			return;
+
+		auto block = static_cast<FreeBlock*>(ptr);
+		auto cache = get_cache();
+		if (cache == nullptr)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			block->next = _free;
+			_free = block;
+			return;
+		}
+
+		block->next = cache->head;
+		cache->head = block;
+		cache->count++;
+
+		// keep half a batch of slack so that alternating malloc and free
+		// around the limit does not bounce blocks through the lock
+		if (cache->count >= 2 * batch_size)
+			drain(*cache, batch_size);
+	}
+
+	size_t ConcurrentMemoryPool::capacity()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _pool.capacity();
+	}
+
+	void ConcurrentMemoryPool::release(Cache& cache)
+	{
+		drain(cache, 0);
+	}
+
+	ConcurrentMemoryPool::Cache* ConcurrentMemoryPool::get_cache()
+	{
+		if (_slot == invalid_slot || thread_caches_destroyed)
+			return nullptr;
+
+		return &thread_caches.caches[_slot];
+	}
+
+	void ConcurrentMemoryPool::refill(Cache& cache)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// prefer blocks given back by other threads, carve new ones after that
+		while (cache.count < batch_size)
+		{
+			FreeBlock* block = _free;
+			if (block != nullptr)
+				_free = block->next;
+			else
+				block = static_cast<FreeBlock*>(_pool.malloc());
+
+			if (block == nullptr)
+				break;
+
+			block->next = cache.head;
+			cache.head = block;
+			cache.count++;
+		}
+	}
+
+	void ConcurrentMemoryPool::drain(Cache& cache, size_t keep)
+	{
+		if (cache.count <= keep)
+			return;
+
+		// the blocks past the first keep ones go back to the shared list
+		FreeBlock* first = cache.head;
+		FreeBlock* last_kept = nullptr;
+		for (size_t i = 0; i < keep; ++i)
+		{
+			last_kept = first;
+			first = first->next;
+		}
+
+		FreeBlock* last = first;
+		while (last->next != nullptr)
+			last = last->next;
+
+		if (last_kept)
+			last_kept->next = nullptr;
+		else
+			cache.head = nullptr;
+		cache.count = keep;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		last->next = _free;
+		_free = first;
+	}
+
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "memory_pool.hpp"
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace core
+{
+
+	// a thread safe front end for MemoryPool. every thread keeps a small cache
+	// of free blocks per pool, so that most allocations and deallocations never
+	// touch shared state. threads only lock the pool to take a batch of blocks
+	// from the shared free list (which grows the underlying MemoryPool when it
+	// runs dry) or to give a batch back when their cache gets too large.
+	// blocks may be freed by a different thread than the one that allocated them.
+	// a pool may be destroyed while threads still cache its blocks, they drop
+	// them, and threads that exit give their cached blocks back to the pools
+	// that are still alive.
+	struct ConcurrentMemoryPool
+	{
+		ConcurrentMemoryPool(size_t block_size, size_t chunk_size);
+		virtual ~ConcurrentMemoryPool();
+
+		ConcurrentMemoryPool(const ConcurrentMemoryPool&) = delete;
+		ConcurrentMemoryPool& operator=(const ConcurrentMemoryPool&) = delete;
+
+		// accquire a unused block of memory
+		void* malloc();
+		// recycle the memory to pool
+		void free(void*);
+
+		// returns the capacity of current pool
+		size_t capacity();
+
+		// blocks moved between a thread cache and the shared free list at once
+		constexpr const static size_t batch_size = 32;
+
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		struct Cache
+		{
+			FreeBlock* head = nullptr;
+			size_t count = 0;
+		};
+
+		// give every block of a thread cache back to the shared free list,
+		// used when a thread exits
+		void release(Cache& cache);
+
+	protected:
+		Cache* get_cache();
+		void refill(Cache& cache);
+		void drain(Cache& cache, size_t keep);
+
+		std::mutex _mutex;
+		MemoryPool _pool;
+		FreeBlock* _free;
+		// slot of this pool in the thread caches, invalid when out of slots
+		size_t _slot;
+	};
+
+	// the pool shared by all objects of type T. it lives until the process
+	// exits, because objects of type T may be freed until then.
+	template<typename T, size_t Growth = 256>
+	inline ConcurrentMemoryPool& get_pool()
+	{
+		using aligned_storage_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+		static auto pool = new ConcurrentMemoryPool(sizeof(aligned_storage_t), Growth);
+		return *pool;
+	}
+
+	// stl compatible allocator that takes single objects from the pool of
+	// their type and everything else from the heap. meant for allocate_shared,
+	// which allocates the object and its reference counts in one block.
+	template<typename T> struct PoolAllocator
+	{
+		using value_type = T;
+
+		PoolAllocator() = default;
+
+		template<typename U> PoolAllocator(const PoolAllocator<U>&)
+		{}
+
+		T* allocate(size_t count)
+		{
+			if (count != 1)
+				return static_cast<T*>(::operator new(count * sizeof(T)));
+
+			auto ptr = get_pool<T>().malloc();
+			if (ptr == nullptr)
+				throw std::bad_alloc();
+			return static_cast<T*>(ptr);
+		}
+
+		void deallocate(T* ptr, size_t count)
+		{
+			if (count != 1)
+				::operator delete(ptr);
+			else
+				get_pool<T>().free(ptr);
+		}
+	};
+
+	template<typename T, typename U>
+	inline bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+	{
+		return true;
+	}
+
+	template<typename T, typename U>
+	inline bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+	{
+		return false;
+	}
+
+}
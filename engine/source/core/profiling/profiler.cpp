@@ -0,0 +1,292 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace core
+{
+
+	namespace profiler
+	{
+		std::atomic<bool> enabled{ false };
+
+		namespace
+		{
+			using clock_type = std::chrono::high_resolution_clock;
+
+			const clock_type::time_point epoch = clock_type::now();
+
+			// a ring of zones written by its owner thread only. the owner
+			// publishes a zone by bumping written, the collector reads up to
+			// the published count. zones the owner overwrote while they were
+			// being read are detected afterwards and dropped.
+			struct ThreadBuffer
+			{
+				// a power of two
+				static const std::size_t capacity = 16 * 1024;
+
+				ThreadBuffer(std::uint32_t index)
+					: zones(new Zone[capacity])
+					, index(index)
+				{
+				}
+
+				std::unique_ptr<Zone[]> zones;
+				std::atomic<std::uint64_t> written{ 0 };
+				// read by the collector only
+				std::uint64_t collected = 0;
+				// touched by the owner thread only
+				std::uint32_t depth = 0;
+				std::uint32_t index = 0;
+				// guarded by the registry mutex
+				std::string name;
+			};
+
+			struct Registry
+			{
+				std::mutex mutex;
+				// buffers outlive their threads, they are only released on exit
+				std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+				std::deque<std::shared_ptr<const Frame>> frames;
+				std::unordered_set<std::string> names;
+				std::uint64_t frame_index = 0;
+				std::uint64_t frame_start = 0;
+			};
+
+			Registry& get_registry()
+			{
+				static Registry registry;
+				return registry;
+			}
+
+			thread_local ThreadBuffer* thread_buffer = nullptr;
+
+			ThreadBuffer& get_thread_buffer()
+			{
+				if (thread_buffer == nullptr)
+				{
+					auto& registry = get_registry();
+					std::lock_guard<std::mutex> lock(registry.mutex);
+					const auto index = static_cast<std::uint32_t>(registry.buffers.size());
+					registry.buffers.emplace_back(new ThreadBuffer(index));
+					registry.buffers.back()->name = "Thread " + std::to_string(index);
+					thread_buffer = registry.buffers.back().get();
+				}
+				return *thread_buffer;
+			}
+
+			// moves the zones the thread published since the last call into zones
+			std::uint64_t collect(ThreadBuffer& buffer, std::vector<Zone>& zones)
+			{
+				const auto written = buffer.written.load(std::memory_order_acquire);
+				auto from = buffer.collected;
+				std::uint64_t dropped = 0;
+				if (written - from > ThreadBuffer::capacity)
+				{
+					dropped += written - ThreadBuffer::capacity - from;
+					from = written - ThreadBuffer::capacity;
+				}
+
+				const auto first = zones.size();
+				for (auto i = from; i < written; ++i)
+					zones.push_back(buffer.zones[i & (ThreadBuffer::capacity - 1)]);
+
+				// the owner kept writing meanwhile, anything it wrapped around
+				// onto may be torn
+				const auto now_written = buffer.written.load(std::memory_order_acquire);
+				if (now_written - from > ThreadBuffer::capacity)
+				{
+					const auto torn = std::min<std::uint64_t>(now_written - ThreadBuffer::capacity - from, written - from);
+					zones.erase(zones.begin() + first, zones.begin() + first + static_cast<std::size_t>(torn));
+					dropped += torn;
+				}
+
+				buffer.collected = written;
+				return dropped;
+			}
+
+			void write_string(std::ostream& stream, const char* str)
+			{
+				stream << '"';
+				for (; *str != 0; ++str)
+				{
+					const char c = *str;
+					switch (c)
+					{
+					case '"': stream << "\\\""; break;
+					case '\\': stream << "\\\\"; break;
+					case '\n': stream << "\\n"; break;
+					case '\r': stream << "\\r"; break;
+					case '\t': stream << "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20)
+						{
+							const char* digits = "0123456789abcdef";
+							stream << "\\u00" << digits[(c >> 4) & 0xf] << digits[c & 0xf];
+						}
+						else
+						{
+							stream << c;
+						}
+					}
+				}
+				stream << '"';
+			}
+
+			void write_event(std::ostream& stream, const char* name, const char* category, std::uint64_t start, std::uint64_t end, std::uint32_t thread)
+			{
+				// timestamps are in microseconds
+				stream << ",\n{\"name\":";
+				write_string(stream, name);
+				stream << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread
+					<< ",\"ts\":" << start / 1000 << '.' << (start % 1000) / 100 << (start % 100) / 10 << start % 10
+					<< ",\"dur\":" << (end - start) / 1000 << '.' << ((end - start) % 1000) / 100 << ((end - start) % 100) / 10 << (end - start) % 10
+					<< '}';
+			}
+		}
+
+		void set_enabled(bool enable)
+		{
+			enabled.store(enable, std::memory_order_relaxed);
+		}
+
+		std::uint64_t now()
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - epoch).count());
+		}
+
+		const char* intern(const std::string& name)
+		{
+			// workers mostly look up the same few names, keep them away from
+			// the registry lock
+			thread_local std::unordered_map<std::string, const char*> cache;
+			auto it = cache.find(name);
+			if (it != cache.end())
+				return it->second;
+
+			auto& registry = get_registry();
+			const char* interned = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				interned = registry.names.insert(name).first->c_str();
+			}
+			cache.emplace(name, interned);
+			return interned;
+		}
+
+		void set_thread_name(const std::string& name)
+		{
+			auto& buffer = get_thread_buffer();
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			buffer.name = name;
+		}
+
+		std::uint64_t enter_zone()
+		{
+			++get_thread_buffer().depth;
+			return now();
+		}
+
+		void leave_zone(const char* name, std::uint64_t start)
+		{
+			const auto end = now();
+			auto& buffer = get_thread_buffer();
+			--buffer.depth;
+
+			const auto written = buffer.written.load(std::memory_order_relaxed);
+			auto& zone = buffer.zones[written & (ThreadBuffer::capacity - 1)];
+			zone.name = name;
+			zone.start = start;
+			zone.end = end;
+			zone.thread = buffer.index;
+			zone.depth = buffer.depth;
+			buffer.written.store(written + 1, std::memory_order_release);
+		}
+
+		void next_frame()
+		{
+			const auto end = now();
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			auto frame = std::make_shared<Frame>();
+			frame->index = registry.frame_index++;
+			frame->start = registry.frame_start;
+			frame->end = end;
+			registry.frame_start = end;
+
+			for (auto& buffer : registry.buffers)
+			{
+				const auto first = frame->zones.size();
+				frame->dropped += collect(*buffer, frame->zones);
+
+				// zones are published when they end, so children come before
+				// their parents. order them by start, parents first.
+				std::sort(frame->zones.begin() + first, frame->zones.end(), [](const Zone& lhs, const Zone& rhs)
+				{
+					return lhs.start < rhs.start || (lhs.start == rhs.start && lhs.depth < rhs.depth);
+				});
+			}
+
+			// while disabled the history is kept as it was for inspection
+			if (frame->zones.empty() && !is_enabled())
+				return;
+
+			registry.frames.push_back(frame);
+			while (registry.frames.size() > history_size)
+				registry.frames.pop_front();
+		}
+
+		std::vector<std::shared_ptr<const Frame>> get_frames()
+		{
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			return { registry.frames.begin(), registry.frames.end() };
+		}
+
+		std::vector<Thread> get_threads()
+		{
+			auto& registry = get_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			std::vector<Thread> threads;
+			threads.reserve(registry.buffers.size());
+			for (const auto& buffer : registry.buffers)
+				threads.push_back({ buffer->name });
+			return threads;
+		}
+
+		void write_chrome_trace(std::ostream& stream)
+		{
+			const auto frames = get_frames();
+			const auto threads = get_threads();
+			// frames get a lane of their own after the threads
+			const auto frame_lane = static_cast<std::uint32_t>(threads.size());
+
+			stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+			stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Engine\"}}";
+			for (std::uint32_t i = 0; i <= frame_lane; ++i)
+			{
+				stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+				write_string(stream, i < frame_lane ? threads[i].name.c_str() : "Frames");
+				stream << "}}";
+			}
+
+			for (const auto& frame : frames)
+			{
+				const auto name = "Frame " + std::to_string(frame->index);
+				write_event(stream, name.c_str(), "frame", frame->start, frame->end, frame_lane);
+
+				for (const auto& zone : frame->zones)
+					write_event(stream, zone.name, "zone", zone.start, zone.end, zone.thread);
+			}
+
+			stream << "\n]}\n";
+		}
+	}
+
+}
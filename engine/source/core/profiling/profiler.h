@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// zones are compiled in unless PROFILER_ENABLED is defined to 0. compiled in
+// but disabled at runtime a zone costs one relaxed atomic load.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+namespace core
+{
+
+	// a lightweight cpu profiler. scoped zones record their start and end time
+	// into a buffer owned by the calling thread, so recording never locks. once
+	// per frame the buffers of all threads are collected into a frame record,
+	// the last history_size frames are kept for inspection and export.
+	namespace profiler
+	{
+		// number of collected frames kept
+		const std::size_t history_size = 300;
+
+		struct Zone
+		{
+			// interned name, valid for the lifetime of the program
+			const char* name = nullptr;
+			// nanoseconds since the profiler started
+			std::uint64_t start = 0;
+			std::uint64_t end = 0;
+			// index into get_threads()
+			std::uint32_t thread = 0;
+			// nesting level on its thread
+			std::uint32_t depth = 0;
+		};
+
+		struct Frame
+		{
+			std::uint64_t index = 0;
+			// nanoseconds since the profiler started
+			std::uint64_t start = 0;
+			std::uint64_t end = 0;
+			// zones that ended during the frame ordered by thread and start
+			std::vector<Zone> zones;
+			// zones lost because a thread buffer overflowed
+			std::uint64_t dropped = 0;
+		};
+
+		struct Thread
+		{
+			std::string name;
+		};
+
+		// the runtime switch, relaxed since a zone that misses a change just
+		// records or skips one more time
+		extern std::atomic<bool> enabled;
+
+		inline bool is_enabled()
+		{
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		void set_enabled(bool enable);
+
+		// returns nanoseconds since the profiler started
+		std::uint64_t now();
+
+		// returns a copy of the string that lives as long as the program. meant
+		// for names that are not literals, like task and render pass names.
+		const char* intern(const std::string& name);
+
+		// names the calling thread in the timeline and the exported trace
+		void set_thread_name(const std::string& name);
+
+		// the halves of a scoped zone. enter returns the start time, leave
+		// records the zone on the calling thread. calls must nest.
+		std::uint64_t enter_zone();
+		void leave_zone(const char* name, std::uint64_t start);
+
+		// collects the zones of all threads into a new frame. call once per
+		// frame from the main thread.
+		void next_frame();
+
+		// returns the collected frames, oldest first. the frames are not
+		// modified after they are collected, only dropped from the history.
+		std::vector<std::shared_ptr<const Frame>> get_frames();
+
+		// returns the threads that recorded zones so far
+		std::vector<Thread> get_threads();
+
+		// writes the collected frames in the chrome trace event format, as
+		// read by chrome://tracing and other trace viewers
+		void write_chrome_trace(std::ostream& stream);
+
+		// records its lifetime, only if the profiler was enabled when it was
+		// created. compiled out along with the macros.
+		struct ScopedZone
+		{
+			ScopedZone(const char* name)
+			{
+				if (PROFILER_ENABLED && is_enabled())
+				{
+					_name = name;
+					_start = enter_zone();
+				}
+			}
+
+			ScopedZone(const std::string& name)
+			{
+				if (PROFILER_ENABLED && is_enabled())
+				{
+					_name = intern(name);
+					_start = enter_zone();
+				}
+			}
+
+			~ScopedZone()
+			{
+				if (_name != nullptr)
+					leave_zone(_name, _start);
+			}
+
+			ScopedZone(const ScopedZone&) = delete;
+			ScopedZone& operator=(const ScopedZone&) = delete;
+
+		private:
+			const char* _name = nullptr;
+			std::uint64_t _start = 0;
+		};
+	}
+
+}
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#if PROFILER_ENABLED
+// records the rest of the enclosing scope, the name is a literal or a string
+#define PROFILE_SCOPE(name) core::profiler::ScopedZone PROFILER_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name)
+#endif
@@ -0,0 +1,480 @@
+#include "encoder.h"
+#include "bx/bx.h"
+#include <chrono>
+#include <cstring>
+
+namespace gfx
+{
+	namespace
+	{
+		enum Command : std::uint8_t
+		{
+			SetTransform,
+			SetTransformCached,
+			SetState,
+			SetStencil,
+			SetScissor,
+			SetScissorCached,
+			SetUniform,
+			SetIndexBuffer,
+			SetDynamicIndexBuffer,
+			SetTransientIndexBuffer,
+			SetVertexBuffer,
+			SetDynamicVertexBuffer,
+			SetTransientVertexBuffer,
+			SetTexture,
+			Touch,
+			Submit,
+		};
+
+		struct TransformData { uint16_t num; };
+		struct TransformCachedData { uint32_t cache; uint16_t num; };
+		struct StateData { uint64_t state; uint32_t rgba; };
+		struct StencilData { uint32_t fstencil; uint32_t bstencil; };
+		struct ScissorData { uint16_t x, y, width, height; };
+		struct ScissorCachedData { uint16_t cache; };
+		struct UniformData { UniformHandle handle; uint16_t num; };
+		template<typename Handle> struct BufferData { Handle handle; uint32_t first; uint32_t num; };
+		struct TextureData { uint8_t stage; UniformHandle sampler; TextureHandle handle; uint32_t flags; };
+		struct TouchData { uint8_t id; };
+		struct SubmitData { uint8_t id; ProgramHandle program; int32_t depth; bool preserve_state; };
+
+		// Size of a single element of every uniform, by handle. Written on
+		// the main thread when uniforms are created, read while recording.
+		std::uint32_t uniform_sizes[512] = {};
+
+		thread_local Encoder* current_encoder = nullptr;
+
+		// Cache indices handed out while recording have their top bit set, to
+		// tell them apart from bgfx cache indices taken before the recording.
+		// bgfx keeps far fewer matrices and rectangles per frame than that.
+		const std::uint32_t recorded_transform = 0x80000000u;
+		const std::uint16_t recorded_scissor = 0x8000u;
+
+		EncoderStats last_frame_stats;
+		EncoderStats frame_stats;
+
+		std::uint32_t get_uniform_type_size(UniformType::Enum type)
+		{
+			switch (type)
+			{
+			case UniformType::Int1: return sizeof(int32_t);
+			case UniformType::Vec4: return 4 * sizeof(float);
+			case UniformType::Mat3: return 3 * 3 * sizeof(float);
+			case UniformType::Mat4: return 4 * 4 * sizeof(float);
+			default: return 0;
+			}
+		}
+
+		template<typename T>
+		T read(const std::uint8_t*& cursor)
+		{
+			T data;
+			std::memcpy(&data, cursor, sizeof(T));
+			cursor += sizeof(T);
+			return data;
+		}
+	}
+
+	struct EncoderWriter
+	{
+		template<typename T>
+		static void write(Encoder& encoder, Command command, const T& data, const void* extra = nullptr, std::size_t extra_size = 0)
+		{
+			auto& commands = encoder._commands;
+			const auto offset = commands.size();
+			commands.resize(offset + 1 + sizeof(T) + extra_size);
+			commands[offset] = command;
+			std::memcpy(&commands[offset + 1], &data, sizeof(T));
+			if (extra_size)
+				std::memcpy(&commands[offset + 1 + sizeof(T)], extra, extra_size);
+
+			if (command == Submit)
+				encoder._submits++;
+		}
+
+		static uint32_t add_transforms(Encoder& encoder, uint16_t num)
+		{
+			const auto cache = encoder._transforms;
+			encoder._transforms += num;
+			return recorded_transform | cache;
+		}
+
+		static uint16_t add_scissor(Encoder& encoder)
+		{
+			BX_CHECK(encoder._scissors < recorded_scissor - 1, "Too many scissor rectangles recorded.");
+			if (encoder._scissors >= recorded_scissor - 1)
+				return UINT16_MAX;
+			return uint16_t(recorded_scissor | encoder._scissors++);
+		}
+
+		static void check_transform(const Encoder& encoder, uint32_t cache, uint16_t num)
+		{
+			BX_CHECK(0 == (cache & recorded_transform) || (cache & ~recorded_transform) + num <= encoder._transforms
+				, "Transform cache index recorded by another encoder.");
+			BX_UNUSED(encoder, cache, num);
+		}
+
+		static void check_scissor(const Encoder& encoder, uint16_t cache)
+		{
+			BX_CHECK(UINT16_MAX == cache || 0 == (cache & recorded_scissor) || (cache & ~recorded_scissor) < encoder._scissors
+				, "Scissor cache index recorded by another encoder.");
+			BX_UNUSED(encoder, cache);
+		}
+	};
+
+	uint32_t setTransform(const void* _mtx, uint16_t _num)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::write(*encoder, SetTransform, TransformData{ _num }, _mtx, std::size_t(_num) * 16 * sizeof(float));
+			return EncoderWriter::add_transforms(*encoder, _num);
+		}
+		return bgfx::setTransform(_mtx, _num);
+	}
+
+	void setTransform(uint32_t _cache, uint16_t _num)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::check_transform(*encoder, _cache, _num);
+			EncoderWriter::write(*encoder, SetTransformCached, TransformCachedData{ _cache, _num });
+		}
+		else
+			bgfx::setTransform(_cache, _num);
+	}
+
+	void setState(uint64_t _state, uint32_t _rgba)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetState, StateData{ _state, _rgba });
+		else
+			bgfx::setState(_state, _rgba);
+	}
+
+	void setStencil(uint32_t _fstencil, uint32_t _bstencil)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetStencil, StencilData{ _fstencil, _bstencil });
+		else
+			bgfx::setStencil(_fstencil, _bstencil);
+	}
+
+	uint16_t setScissor(uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::write(*encoder, SetScissor, ScissorData{ _x, _y, _width, _height });
+			return EncoderWriter::add_scissor(*encoder);
+		}
+		return bgfx::setScissor(_x, _y, _width, _height);
+	}
+
+	void setScissor(uint16_t _cache)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::check_scissor(*encoder, _cache);
+			EncoderWriter::write(*encoder, SetScissorCached, ScissorCachedData{ _cache });
+		}
+		else
+			bgfx::setScissor(_cache);
+	}
+
+	void setUniform(UniformHandle _handle, const void* _value, uint16_t _num)
+	{
+		if (auto encoder = get_encoder())
+		{
+			const auto size = isValid(_handle) ? uniform_sizes[_handle.idx] : 0;
+			BX_CHECK(size != 0, "Uniform not created through gfx::createUniform, it cannot be recorded.");
+			if (size != 0)
+				EncoderWriter::write(*encoder, SetUniform, UniformData{ _handle, _num }, _value, std::size_t(size) * _num);
+		}
+		else
+		{
+			bgfx::setUniform(_handle, _value, _num);
+		}
+	}
+
+	void setIndexBuffer(IndexBufferHandle _handle)
+	{
+		gfx::setIndexBuffer(_handle, 0, UINT32_MAX);
+	}
+
+	void setIndexBuffer(IndexBufferHandle _handle, uint32_t _firstIndex, uint32_t _numIndices)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetIndexBuffer, BufferData<IndexBufferHandle>{ _handle, _firstIndex, _numIndices });
+		else
+			bgfx::setIndexBuffer(_handle, _firstIndex, _numIndices);
+	}
+
+	void setIndexBuffer(DynamicIndexBufferHandle _handle)
+	{
+		gfx::setIndexBuffer(_handle, 0, UINT32_MAX);
+	}
+
+	void setIndexBuffer(DynamicIndexBufferHandle _handle, uint32_t _firstIndex, uint32_t _numIndices)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetDynamicIndexBuffer, BufferData<DynamicIndexBufferHandle>{ _handle, _firstIndex, _numIndices });
+		else
+			bgfx::setIndexBuffer(_handle, _firstIndex, _numIndices);
+	}
+
+	void setIndexBuffer(const TransientIndexBuffer* _tib)
+	{
+		gfx::setIndexBuffer(_tib, 0, UINT32_MAX);
+	}
+
+	void setIndexBuffer(const TransientIndexBuffer* _tib, uint32_t _firstIndex, uint32_t _numIndices)
+	{
+		// the buffer description is copied, the data it points to lives until the frame is done
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetTransientIndexBuffer, BufferData<TransientIndexBuffer>{ *_tib, _firstIndex, _numIndices });
+		else
+			bgfx::setIndexBuffer(_tib, _firstIndex, _numIndices);
+	}
+
+	void setVertexBuffer(VertexBufferHandle _handle)
+	{
+		gfx::setVertexBuffer(_handle, 0, UINT32_MAX);
+	}
+
+	void setVertexBuffer(VertexBufferHandle _handle, uint32_t _startVertex, uint32_t _numVertices)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetVertexBuffer, BufferData<VertexBufferHandle>{ _handle, _startVertex, _numVertices });
+		else
+			bgfx::setVertexBuffer(_handle, _startVertex, _numVertices);
+	}
+
+	void setVertexBuffer(DynamicVertexBufferHandle _handle)
+	{
+		gfx::setVertexBuffer(_handle, 0, UINT32_MAX);
+	}
+
+	void setVertexBuffer(DynamicVertexBufferHandle _handle, uint32_t _startVertex, uint32_t _numVertices)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetDynamicVertexBuffer, BufferData<DynamicVertexBufferHandle>{ _handle, _startVertex, _numVertices });
+		else
+			bgfx::setVertexBuffer(_handle, _startVertex, _numVertices);
+	}
+
+	void setVertexBuffer(const TransientVertexBuffer* _tvb)
+	{
+		gfx::setVertexBuffer(_tvb, 0, UINT32_MAX);
+	}
+
+	void setVertexBuffer(const TransientVertexBuffer* _tvb, uint32_t _startVertex, uint32_t _numVertices)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetTransientVertexBuffer, BufferData<TransientVertexBuffer>{ *_tvb, _startVertex, _numVertices });
+		else
+			bgfx::setVertexBuffer(_tvb, _startVertex, _numVertices);
+	}
+
+	void setTexture(uint8_t _stage, UniformHandle _sampler, TextureHandle _handle, uint32_t _flags)
+	{
+		if (auto encoder = get_encoder())
+			EncoderWriter::write(*encoder, SetTexture, TextureData{ _stage, _sampler, _handle, _flags });
+		else
+			bgfx::setTexture(_stage, _sampler, _handle, _flags);
+	}
+
+	uint32_t touch(uint8_t _id)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::write(*encoder, Touch, TouchData{ _id });
+			return encoder->get_submit_count();
+		}
+		return bgfx::touch(_id);
+	}
+
+	uint32_t submit(uint8_t _id, ProgramHandle _program, int32_t _depth, bool _preserveState)
+	{
+		if (auto encoder = get_encoder())
+		{
+			EncoderWriter::write(*encoder, Submit, SubmitData{ _id, _program, _depth, _preserveState });
+			return encoder->get_submit_count();
+		}
+		return bgfx::submit(_id, _program, _depth, _preserveState);
+	}
+
+	UniformHandle createUniform(const char* _name, UniformType::Enum _type, uint16_t _num)
+	{
+		auto handle = bgfx::createUniform(_name, _type, _num);
+		if (isValid(handle) && handle.idx < sizeof(uniform_sizes) / sizeof(uniform_sizes[0]))
+			uniform_sizes[handle.idx] = get_uniform_type_size(_type);
+		return handle;
+	}
+
+	void Encoder::replay()
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		_transform_caches.clear();
+		_scissor_caches.clear();
+
+		const std::uint8_t* cursor = _commands.data();
+		const std::uint8_t* end = cursor + _commands.size();
+		while (cursor < end)
+		{
+			const auto command = Command(*cursor++);
+			switch (command)
+			{
+			case SetTransform:
+			{
+				const auto data = read<TransformData>(cursor);
+				const auto cache = bgfx::setTransform(cursor, data.num);
+				for (uint16_t i = 0; i < data.num; ++i)
+					_transform_caches.push_back(cache + i);
+				cursor += std::size_t(data.num) * 16 * sizeof(float);
+				break;
+			}
+			case SetTransformCached:
+			{
+				const auto data = read<TransformCachedData>(cursor);
+				auto cache = data.cache;
+				if (cache & recorded_transform)
+					cache = _transform_caches[cache & ~recorded_transform];
+				bgfx::setTransform(cache, data.num);
+				break;
+			}
+			case SetState:
+			{
+				const auto data = read<StateData>(cursor);
+				bgfx::setState(data.state, data.rgba);
+				break;
+			}
+			case SetStencil:
+			{
+				const auto data = read<StencilData>(cursor);
+				bgfx::setStencil(data.fstencil, data.bstencil);
+				break;
+			}
+			case SetScissor:
+			{
+				const auto data = read<ScissorData>(cursor);
+				_scissor_caches.push_back(bgfx::setScissor(data.x, data.y, data.width, data.height));
+				break;
+			}
+			case SetScissorCached:
+			{
+				const auto data = read<ScissorCachedData>(cursor);
+				auto cache = data.cache;
+				if (cache != UINT16_MAX && (cache & recorded_scissor))
+					cache = _scissor_caches[cache & ~recorded_scissor];
+				bgfx::setScissor(cache);
+				break;
+			}
+			case SetUniform:
+			{
+				const auto data = read<UniformData>(cursor);
+				bgfx::setUniform(data.handle, cursor, data.num);
+				cursor += std::size_t(uniform_sizes[data.handle.idx]) * data.num;
+				break;
+			}
+			case SetIndexBuffer:
+			{
+				const auto data = read<BufferData<IndexBufferHandle>>(cursor);
+				bgfx::setIndexBuffer(data.handle, data.first, data.num);
+				break;
+			}
+			case SetDynamicIndexBuffer:
+			{
+				const auto data = read<BufferData<DynamicIndexBufferHandle>>(cursor);
+				bgfx::setIndexBuffer(data.handle, data.first, data.num);
+				break;
+			}
+			case SetTransientIndexBuffer:
+			{
+				const auto data = read<BufferData<TransientIndexBuffer>>(cursor);
+				bgfx::setIndexBuffer(&data.handle, data.first, data.num);
+				break;
+			}
+			case SetVertexBuffer:
+			{
+				const auto data = read<BufferData<VertexBufferHandle>>(cursor);
+				bgfx::setVertexBuffer(data.handle, data.first, data.num);
+				break;
+			}
+			case SetDynamicVertexBuffer:
+			{
+				const auto data = read<BufferData<DynamicVertexBufferHandle>>(cursor);
+				bgfx::setVertexBuffer(data.handle, data.first, data.num);
+				break;
+			}
+			case SetTransientVertexBuffer:
+			{
+				const auto data = read<BufferData<TransientVertexBuffer>>(cursor);
+				bgfx::setVertexBuffer(&data.handle, data.first, data.num);
+				break;
+			}
+			case SetTexture:
+			{
+				const auto data = read<TextureData>(cursor);
+				bgfx::setTexture(data.stage, data.sampler, data.handle, data.flags);
+				break;
+			}
+			case Touch:
+			{
+				const auto data = read<TouchData>(cursor);
+				bgfx::touch(data.id);
+				break;
+			}
+			case Submit:
+			{
+				const auto data = read<SubmitData>(cursor);
+				bgfx::submit(data.id, data.program, data.depth, data.preserve_state);
+				break;
+			}
+			}
+		}
+
+		frame_stats.encoders++;
+		frame_stats.submits += _submits;
+		frame_stats.bytes += _commands.size();
+		frame_stats.replay_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		clear();
+	}
+
+	void Encoder::clear()
+	{
+		_commands.clear();
+		_submits = 0;
+		_transforms = 0;
+		_scissors = 0;
+	}
+
+	EncoderScope::EncoderScope(Encoder& encoder)
+		: _previous(current_encoder)
+	{
+		current_encoder = &encoder;
+	}
+
+	EncoderScope::~EncoderScope()
+	{
+		current_encoder = _previous;
+	}
+
+	Encoder* get_encoder()
+	{
+		return current_encoder;
+	}
+
+	const EncoderStats& get_encoder_stats()
+	{
+		return last_frame_stats;
+	}
+
+	uint32_t frame(bool _capture)
+	{
+		last_frame_stats = frame_stats;
+		frame_stats = EncoderStats();
+		return bgfx::frame(_capture);
+	}
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "bgfx/bgfx.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfx
+{
+	using namespace bgfx;
+
+	//-----------------------------------------------------------------------------
+	// Draw submission
+	//-----------------------------------------------------------------------------
+	// bgfx only accepts draw state and submissions from the main thread. To
+	// record draws on other threads, a thread makes an Encoder current with
+	// EncoderScope. The draw functions below then append to the command buffer
+	// of that encoder instead of going to bgfx, and the main thread replays
+	// the buffers in a fixed order once recording is done. Without a current
+	// encoder they forward to bgfx directly.
+	//
+	// Only the functions declared here may be used while recording. Anything
+	// else that talks to bgfx (creating resources, transient buffers, views)
+	// still has to happen on the main thread. Uniforms must be created through
+	// gfx::createUniform so that their size is known when recording them.
+	//
+	// Nothing reaches bgfx until the replay, so while recording:
+	// - setTransform and setScissor return a cache index that is only valid
+	//   within the same encoder. Passing it back to setTransform or setScissor
+	//   while recording into that encoder reuses the matrices or the rectangle
+	//   they recorded, the replay translates it to the bgfx cache index.
+	// - touch and submit return the number of draws recorded so far by the
+	//   encoder, not the number of draws of the frame.
+	//-----------------------------------------------------------------------------
+	uint32_t setTransform(const void* _mtx, uint16_t _num = 1);
+	void setTransform(uint32_t _cache, uint16_t _num = 1);
+	void setState(uint64_t _state, uint32_t _rgba = 0);
+	void setStencil(uint32_t _fstencil, uint32_t _bstencil = BGFX_STENCIL_NONE);
+	uint16_t setScissor(uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height);
+	void setScissor(uint16_t _cache = UINT16_MAX);
+	void setUniform(UniformHandle _handle, const void* _value, uint16_t _num = 1);
+	void setIndexBuffer(IndexBufferHandle _handle);
+	void setIndexBuffer(IndexBufferHandle _handle, uint32_t _firstIndex, uint32_t _numIndices);
+	void setIndexBuffer(DynamicIndexBufferHandle _handle);
+	void setIndexBuffer(DynamicIndexBufferHandle _handle, uint32_t _firstIndex, uint32_t _numIndices);
+	void setIndexBuffer(const TransientIndexBuffer* _tib);
+	void setIndexBuffer(const TransientIndexBuffer* _tib, uint32_t _firstIndex, uint32_t _numIndices);
+	void setVertexBuffer(VertexBufferHandle _handle);
+	void setVertexBuffer(VertexBufferHandle _handle, uint32_t _startVertex, uint32_t _numVertices);
+	void setVertexBuffer(DynamicVertexBufferHandle _handle);
+	void setVertexBuffer(DynamicVertexBufferHandle _handle, uint32_t _startVertex, uint32_t _numVertices);
+	void setVertexBuffer(const TransientVertexBuffer* _tvb);
+	void setVertexBuffer(const TransientVertexBuffer* _tvb, uint32_t _startVertex, uint32_t _numVertices);
+	void setTexture(uint8_t _stage, UniformHandle _sampler, TextureHandle _handle, uint32_t _flags = UINT32_MAX);
+	uint32_t touch(uint8_t _id);
+	uint32_t submit(uint8_t _id, ProgramHandle _program, int32_t _depth = 0, bool _preserveState = false);
+
+	//-----------------------------------------------------------------------------
+	//  Name : createUniform ()
+	/// <summary>
+	/// Same as bgfx::createUniform, also remembers the size of the uniform for
+	/// the encoders.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	UniformHandle createUniform(const char* _name, UniformType::Enum _type, uint16_t _num = 1);
+
+	//-----------------------------------------------------------------------------
+	// Main Class Declarations
+	//-----------------------------------------------------------------------------
+	//-----------------------------------------------------------------------------
+	//  Name : Encoder (Class)
+	/// <summary>
+	/// Command buffer for the draw functions above. An encoder is recorded by
+	/// one thread at a time and replayed on the main thread. Its memory is
+	/// kept between frames, so encoders are best reused.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class Encoder
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : replay ()
+		/// <summary>
+		/// Issues the recorded commands to bgfx and clears the encoder. Must be
+		/// called on the main thread.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void replay();
+
+		//-----------------------------------------------------------------------------
+		//  Name : clear ()
+		/// <summary>
+		/// Drops the recorded commands.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void clear();
+
+		//-----------------------------------------------------------------------------
+		//  Name : empty ()
+		/// <summary>
+		/// Returns true if nothing was recorded.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline bool empty() const { return _commands.empty(); }
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_submit_count ()
+		/// <summary>
+		/// Returns the number of draws recorded.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline std::uint32_t get_submit_count() const { return _submits; }
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_size ()
+		/// <summary>
+		/// Returns the size of the recorded commands in bytes.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline std::size_t get_size() const { return _commands.size(); }
+
+	private:
+		friend struct EncoderWriter;
+
+		/// Recorded commands, each one is a command id followed by its data.
+		std::vector<std::uint8_t> _commands;
+		/// Number of draws recorded.
+		std::uint32_t _submits = 0;
+		/// Number of matrices recorded, the next transform cache index.
+		std::uint32_t _transforms = 0;
+		/// Number of scissor rectangles recorded, the next scissor cache index.
+		std::uint16_t _scissors = 0;
+		/// bgfx cache index of every recorded matrix, filled during the replay.
+		std::vector<std::uint32_t> _transform_caches;
+		/// bgfx cache index of every recorded rectangle, filled during the replay.
+		std::vector<std::uint16_t> _scissor_caches;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : EncoderScope (Struct)
+	/// <summary>
+	/// Makes an encoder current for the calling thread during its lifetime.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct EncoderScope
+	{
+		EncoderScope(Encoder& encoder);
+		~EncoderScope();
+
+		EncoderScope(const EncoderScope&) = delete;
+		EncoderScope& operator=(const EncoderScope&) = delete;
+
+	private:
+		Encoder* _previous;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_encoder ()
+	/// <summary>
+	/// Returns the encoder current for the calling thread, if any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Encoder* get_encoder();
+
+	//-----------------------------------------------------------------------------
+	//  Name : EncoderStats (Struct)
+	/// <summary>
+	/// Work replayed from encoders during the last frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct EncoderStats
+	{
+		/// Number of encoders replayed.
+		std::uint32_t encoders = 0;
+		/// Number of draws replayed.
+		std::uint32_t submits = 0;
+		/// Size of the replayed commands in bytes.
+		std::uint64_t bytes = 0;
+		/// Time spent replaying, in seconds.
+		double replay_time = 0.0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_encoder_stats ()
+	/// <summary>
+	/// Returns what the encoders replayed during the last frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const EncoderStats& get_encoder_stats();
+
+	//-----------------------------------------------------------------------------
+	//  Name : frame ()
+	/// <summary>
+	/// Same as bgfx::frame, also rolls over the encoder statistics.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	uint32_t frame(bool _capture = false);
+}
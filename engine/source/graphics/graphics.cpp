@@ -362,7 +362,7 @@ namespace gfx
 			vertex[2].u = maxu;
 			vertex[2].v = maxv;
 
-			setVertexBuffer(&vb);
+			gfx::setVertexBuffer(&vb);
 		}
 
 		return 0;
@@ -424,7 +424,7 @@ namespace gfx
 			vertex[3].u = maxu;
 			vertex[3].v = minv;
 
-			setVertexBuffer(&vb);
+			gfx::setVertexBuffer(&vb);
 		}
 
 		return BGFX_STATE_PT_TRISTRIP;
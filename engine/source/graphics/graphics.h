@@ -8,6 +8,7 @@
 #include "bx/readerwriter.h"
 #include "bx/error.h"
 #include "src/vertexdecl.h"
+#include "encoder.h"
 namespace gfx
 {
 
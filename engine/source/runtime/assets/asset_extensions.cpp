@@ -5,6 +5,8 @@ std::string extensions::texture = ".txc";
 
 std::string extensions::mesh = ".msc";
 
+std::string extensions::mesh_lods = ".lods";
+
 std::string extensions::shader = ".shc";
 
 std::string extensions::material = ".mat";
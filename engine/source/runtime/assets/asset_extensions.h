@@ -5,6 +5,7 @@ struct extensions
 {
 	static std::string texture;
 	static std::string mesh;
+	static std::string mesh_lods;
 	static std::string shader;
 	static std::string material;
 	static std::string prefab;
@@ -376,6 +376,26 @@ namespace runtime
 			return find_or_create_asset_impl<T>(key, storage->container);
 		}
 
+		//-----------------------------------------------------------------------------
+		//  Name : find_asset_entry ()
+		/// <summary>
+		/// Returns the entry of an asset that was already requested or nullptr.
+		/// Unlike find_or_create_asset_entry it never adds an entry.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		template<typename T>
+		LoadRequest<T>* find_asset_entry(
+			const std::string& key
+		)
+		{
+			auto storage = get_storage<T>();
+			auto it = storage->container.find(key);
+			if (it == std::end(storage->container))
+				return nullptr;
+
+			return &it->second;
+		}
+
 	private:
 		//-----------------------------------------------------------------------------
 		//  Name : load_asset_from_file_impl ()
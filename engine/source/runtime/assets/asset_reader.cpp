@@ -9,53 +9,278 @@
 #include "../system/filesystem.h"
 #include "../ecs/prefab.h"
 #include "../system/task.h"
+#include "../system/engine.h"
+#include "core/profiling/profiler.h"
 #include "core/serialization/serialization.h"
 #include "core/serialization/archives.h"
 #include "core/serialization/cereal/types/unordered_map.hpp"
 #include "core/serialization/cereal/types/vector.hpp"
 #include "meta/rendering/material.hpp"
 #include "meta/rendering/mesh.hpp"
+#include <algorithm>
 #include <cstdint>
+#include <atomic>
+#include <mutex>
 
-void AssetReader::load_texture_from_file(const std::string& key, const fs::path& absolute_key, bool async, LoadRequest<Texture>& request)
+namespace
 {
-	auto read_memory = std::make_shared<fs::byte_array_t>();
+	std::atomic<std::uint64_t> s_transient_texture_bytes(0);
+	std::atomic<std::uint64_t> s_transient_texture_peak(0);
 
-	auto read_memory_func = [read_memory, absolute_key]()
+	void add_transient_texture_bytes(std::uint64_t size)
 	{
-		if (!read_memory)
-			return;
+		const auto current = s_transient_texture_bytes.fetch_add(size) + size;
+		auto peak = s_transient_texture_peak.load();
+		while (current > peak && !s_transient_texture_peak.compare_exchange_weak(peak, current))
+		{
+		}
+	}
 
-		*read_memory = fs::read_stream(std::ifstream{ absolute_key, std::ios::in | std::ios::binary });
+	void remove_transient_texture_bytes(std::uint64_t size)
+	{
+		s_transient_texture_bytes.fetch_sub(size);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : TextureBuffer (Struct)
+	/// <summary>
+	/// Texture file contents. Handed to the renderer with gfx::makeRef so the file
+	/// is read once and never copied. Goes back to the pool when the renderer
+	/// releases the last reference to it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct TextureBuffer
+	{
+		std::unique_ptr<char[]> data;
+		std::size_t size = 0;
+		std::size_t capacity = 0;
+		/// gfx::Memory references the renderer has not released yet.
+		std::atomic<std::uint32_t> refs{ 0 };
 	};
 
-	auto create_resource_func = [read_memory, key, &request]() mutable
+	struct TextureBufferPool
 	{
-		// if someone destroyed our memory
-		if (!read_memory)
-			return;
-		// if nothing was read
-		if (read_memory->empty())
-			return;
+		/// Buffers bigger than this are freed instead of being kept around.
+		static const std::size_t max_pooled_capacity = 16 * 1024 * 1024;
+		static const std::size_t max_pooled_buffers = 4;
 
-		const gfx::Memory* mem = gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-		read_memory->clear();
-		read_memory.reset();
+		~TextureBufferPool()
+		{
+			for (auto buffer : free_buffers)
+				delete buffer;
+		}
 
-		if (nullptr != mem)
+		TextureBuffer* acquire()
 		{
-			auto texture = std::make_shared<Texture>(mem, 0, 0, nullptr);
-			request.set_data(key, texture);
-			request.invoke_callbacks();
+			std::lock_guard<std::mutex> lock(mutex);
+			if (free_buffers.empty())
+				return new TextureBuffer();
+
+			auto buffer = free_buffers.back();
+			free_buffers.pop_back();
+			return buffer;
 		}
-		
+
+		void release(TextureBuffer* buffer)
+		{
+			remove_transient_texture_bytes(buffer->size);
+			buffer->size = 0;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (free_buffers.size() < max_pooled_buffers && buffer->capacity <= max_pooled_capacity)
+				free_buffers.push_back(buffer);
+			else
+				delete buffer;
+		}
+
+		std::mutex mutex;
+		std::vector<TextureBuffer*> free_buffers;
+	};
+
+	TextureBufferPool& get_texture_buffer_pool()
+	{
+		static TextureBufferPool pool;
+		return pool;
+	}
+
+	bool read_texture_file(const fs::path& absolute_key, TextureBuffer& buffer)
+	{
+		std::ifstream stream{ absolute_key, std::ios::in | std::ios::binary };
+		if (!stream)
+			return false;
+
+		stream.seekg(0, stream.end);
+		const auto length = static_cast<std::size_t>(stream.tellg());
+		stream.seekg(0, stream.beg);
+		if (length == 0)
+			return false;
+
+		if (buffer.capacity < length)
+		{
+			buffer.data.reset(new char[length]);
+			buffer.capacity = length;
+		}
+		stream.read(buffer.data.get(), length);
+		buffer.size = static_cast<std::size_t>(stream.gcount());
+		add_transient_texture_bytes(buffer.size);
+		return buffer.size > 0;
+	}
+
+	void release_texture_buffer(void* /*_ptr*/, void* _user_data)
+	{
+		auto buffer = static_cast<TextureBuffer*>(_user_data);
+		if (buffer->refs.fetch_sub(1) == 1)
+			get_texture_buffer_pool().release(buffer);
+	}
+
+	const gfx::Memory* make_texture_memory(TextureBuffer* buffer)
+	{
+		return gfx::makeRef(buffer->data.get(), static_cast<std::uint32_t>(buffer->size), release_texture_buffer, buffer);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : TextureUpgradeQueue (Struct)
+	/// <summary>
+	/// Full mip chain uploads of textures created mip tail first. An upload is
+	/// held back until at least one frame was submitted after the texture was
+	/// created, so the tail gets displayed before the full chain replaces it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct TextureUpgradeQueue
+	{
+		struct Upgrade
+		{
+			std::shared_ptr<Texture> texture;
+			TextureBuffer* buffer = nullptr;
+			std::uint64_t frame = 0;
+		};
+
+		TextureUpgradeQueue()
+		{
+			runtime::on_frame_begin.connect(this, &TextureUpgradeQueue::frame_begin);
+			runtime::on_frame_end.connect(this, &TextureUpgradeQueue::frame_end);
+		}
+
+		~TextureUpgradeQueue()
+		{
+			runtime::on_frame_begin.disconnect(this, &TextureUpgradeQueue::frame_begin);
+			runtime::on_frame_end.disconnect(this, &TextureUpgradeQueue::frame_end);
+
+			// the uploads never happen, give back the references they held
+			for (auto& upgrade : pending)
+				release_texture_buffer(nullptr, upgrade.buffer);
+		}
+
+		void push(std::shared_ptr<Texture> texture, TextureBuffer* buffer)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending.push_back({ std::move(texture), buffer, frame });
+		}
+
+		void frame_begin(std::chrono::duration<float>)
+		{
+			std::vector<Upgrade> ready;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = std::stable_partition(std::begin(pending), std::end(pending), [this](const Upgrade& upgrade)
+				{
+					return upgrade.frame >= frame;
+				});
+				ready.assign(std::make_move_iterator(it), std::make_move_iterator(std::end(pending)));
+				pending.erase(it, std::end(pending));
+			}
+
+			for (auto& upgrade : ready)
+				upgrade.texture->populate(make_texture_memory(upgrade.buffer), 0, 0, nullptr);
+		}
+
+		void frame_end(std::chrono::duration<float>)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++frame;
+		}
+
+		std::mutex mutex;
+		std::vector<Upgrade> pending;
+		/// Frames submitted so far.
+		std::uint64_t frame = 0;
+	};
+
+	TextureUpgradeQueue& get_texture_upgrade_queue()
+	{
+		static TextureUpgradeQueue queue;
+		return queue;
+	}
+}
+
+bool AssetReader::texture_mip_tail_first = false;
+std::uint8_t AssetReader::texture_mip_tail_skip = 3;
+
+AssetReader::TransientMemoryStats AssetReader::get_transient_texture_memory()
+{
+	TransientMemoryStats stats;
+	stats.current = s_transient_texture_bytes.load();
+	stats.peak = s_transient_texture_peak.load();
+	return stats;
+}
+
+void AssetReader::reset_transient_texture_peak()
+{
+	s_transient_texture_peak = s_transient_texture_bytes.load();
+}
+
+void AssetReader::load_texture_from_file(const std::string& key, const fs::path& absolute_key, bool async, LoadRequest<Texture>& request)
+{
+	struct Wrapper
+	{
+		~Wrapper()
+		{
+			// read but never handed to the renderer
+			if (buffer)
+				get_texture_buffer_pool().release(buffer);
+		}
+
+		TextureBuffer* buffer = nullptr;
+	};
+
+	auto wrapper = std::make_shared<Wrapper>();
+
+	auto read_memory_func = [wrapper, key, absolute_key]()
+	{
+		PROFILE_SCOPE(key);
+		auto& pool = get_texture_buffer_pool();
+		auto buffer = pool.acquire();
+		if (read_texture_file(absolute_key, *buffer))
+			wrapper->buffer = buffer;
+		else
+			pool.release(buffer);
+	};
+
+	auto create_resource_func = [wrapper, key, &request]() mutable
+	{
+		// if nothing was read
+		auto buffer = wrapper->buffer;
+		if (!buffer)
+			return;
+		wrapper->buffer = nullptr;
+
+		const bool mip_tail_first = texture_mip_tail_first && texture_mip_tail_skip > 0;
+		// Every upload keeps a reference to the buffer until the renderer consumed it.
+		buffer->refs = mip_tail_first ? 2 : 1;
+
+		auto texture = std::make_shared<Texture>(make_texture_memory(buffer), 0, mip_tail_first ? texture_mip_tail_skip : 0, nullptr);
+		request.set_data(key, texture);
+		request.invoke_callbacks();
+
+		if (mip_tail_first)
+			get_texture_upgrade_queue().push(texture, buffer);
 	};
 
 	if (async)
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, read_memory_func, create_resource_func]()
+		auto task = ts->create("Load Texture", [ts, read_memory_func, create_resource_func]()
 		{
 			read_memory_func();
 
@@ -82,8 +307,9 @@ void AssetReader::load_shader_from_file(const std::string& key, const fs::path&
 	};
 
 	auto wrapper = std::make_shared<Wrapper>();
-	auto deserialize = [wrapper, absolute_key]() mutable
+	auto deserialize = [wrapper, key, absolute_key]() mutable
 	{
+		PROFILE_SCOPE(key);
 		std::ifstream stream{ absolute_key, std::ios::in | std::ios::binary };
 		cereal::iarchive_binary_t ar(stream);
 
@@ -121,7 +347,7 @@ void AssetReader::load_shader_from_file(const std::string& key, const fs::path&
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, deserialize, create_resource_func]() mutable
+		auto task = ts->create("Load Shader", [ts, deserialize, create_resource_func]() mutable
 		{
 			deserialize();
 
@@ -182,8 +408,9 @@ void AssetReader::load_mesh_from_file(const std::string& key, const fs::path& ab
 
 	auto wrapper = std::make_shared<Wrapper>();
 	wrapper->mesh = std::make_shared<Mesh>();
-	auto deserialize = [wrapper, absolute_key]() mutable
+	auto deserialize = [wrapper, key, absolute_key]() mutable
 	{
+		PROFILE_SCOPE(key);
 		Mesh::LoadData data;
 		{
 			std::ifstream stream{ absolute_key, std::ios::in | std::ios::binary };
@@ -192,6 +419,7 @@ void AssetReader::load_mesh_from_file(const std::string& key, const fs::path& ab
 			try_load(ar, cereal::make_nvp("mesh", data));
 		}	
 		wrapper->mesh->prepare_mesh(data.vertex_format);
+		wrapper->mesh->set_position_decode(data.position_decode);
 		wrapper->mesh->set_vertex_source(&data.vertex_data[0], data.vertex_count, data.vertex_format);
 		wrapper->mesh->add_primitives(data.triangle_data);
 		wrapper->mesh->bind_skin(data.skin_data);
@@ -217,7 +445,7 @@ void AssetReader::load_mesh_from_file(const std::string& key, const fs::path& ab
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, deserialize, create_resource_func]() mutable
+		auto task = ts->create("Load Mesh", [ts, deserialize, create_resource_func]() mutable
 		{
 			deserialize();
 
@@ -244,8 +472,9 @@ void AssetReader::load_material_from_file(const std::string& key, const fs::path
 
 	auto wrapper = std::make_shared<MatWrapper>();
 	wrapper->material = std::make_shared<Material>();
-	auto deserialize = [wrapper, absolute_key]() mutable
+	auto deserialize = [wrapper, key, absolute_key]() mutable
 	{
+		PROFILE_SCOPE(key);
 		std::ifstream stream{ absolute_key, std::ios::in | std::ios::binary };
 		cereal::iarchive_json_t ar(stream);
 
@@ -263,7 +492,7 @@ void AssetReader::load_material_from_file(const std::string& key, const fs::path
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, deserialize, create_resource_func]() mutable
+		auto task = ts->create("Load Material", [ts, deserialize, create_resource_func]() mutable
 		{
 			deserialize();
 
@@ -286,8 +515,9 @@ void AssetReader::load_prefab_from_file(const std::string& key, const fs::path&
 
 	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
 
-	auto read_memory_func = [read_memory, absolute_key]()
+	auto read_memory_func = [read_memory, key, absolute_key]()
 	{
+		PROFILE_SCOPE(key);
 		if (!read_memory)
 			return;
 
@@ -308,7 +538,7 @@ void AssetReader::load_prefab_from_file(const std::string& key, const fs::path&
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, read_memory_func, create_resource_func]() mutable
+		auto task = ts->create("Load Prefab", [ts, read_memory_func, create_resource_func]() mutable
 		{
 			read_memory_func();
 
@@ -331,8 +561,9 @@ void AssetReader::load_scene_from_file(const std::string& key, const fs::path& a
 
 	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
 
-	auto read_memory_func = [read_memory, absolute_key]()
+	auto read_memory_func = [read_memory, key, absolute_key]()
 	{
+		PROFILE_SCOPE(key);
 		if (!read_memory)
 			return;
 
@@ -353,7 +584,7 @@ void AssetReader::load_scene_from_file(const std::string& key, const fs::path& a
 	{
 		auto ts = core::get_subsystem<runtime::TaskSystem>();
 
-		auto task = ts->create("", [ts, read_memory_func, create_resource_func]() mutable
+		auto task = ts->create("Load Scene", [ts, read_memory_func, create_resource_func]() mutable
 		{
 			read_memory_func();
 
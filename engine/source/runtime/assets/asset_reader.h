@@ -11,6 +11,14 @@ struct Scene;
 
 struct AssetReader
 {
+	struct TransientMemoryStats
+	{
+		/// Bytes read from disk that the renderer has not consumed yet.
+		std::uint64_t current = 0;
+		/// Highest value of current since the last reset.
+		std::uint64_t peak = 0;
+	};
+
 	//-----------------------------------------------------------------------------
 	//  Name : load_texture_from_file ()
 	/// <summary>
@@ -20,6 +28,23 @@ struct AssetReader
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static void load_texture_from_file(const std::string& key, const fs::path& absoluteKey, bool async, LoadRequest<Texture>& request);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_transient_texture_memory ()
+	/// <summary>
+	/// Returns the texture file memory currently in flight between the disk and
+	/// the renderer together with its peak value.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static TransientMemoryStats get_transient_texture_memory();
+
+	//-----------------------------------------------------------------------------
+	//  Name : reset_transient_texture_peak ()
+	/// <summary>
+	/// Resets the peak to the current value. Call before a bulk load to measure it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void reset_transient_texture_peak();
 	
 	//-----------------------------------------------------------------------------
 	//  Name : load_shader_from_file ()
@@ -81,4 +106,11 @@ struct AssetReader
 	//-----------------------------------------------------------------------------
 	static void load_scene_from_file(const std::string& key, const fs::path& absoluteKey, bool async, LoadRequest<Scene>& request);
 
+	/// When enabled textures are first created with their top mips skipped so
+	/// that something can be displayed right away, and are then upgraded to
+	/// full resolution on the main thread once at least one frame was submitted.
+	static bool texture_mip_tail_first;
+	/// Number of top mips skipped by the first upload in mip tail first mode.
+	static std::uint8_t texture_mip_tail_skip;
+
 };
\ No newline at end of file
@@ -1,4 +1,11 @@
 #include "model_component.h"
+#include "transform_component.h"
+#include "../../rendering/mesh.h"
+#include "graphics/graphics.h"
+#include "core/math/transform_batch.h"
+#include "core/logging/logging.h"
+#include <deque>
+#include <unordered_map>
 
 ModelComponent::ModelComponent()
 {
@@ -80,3 +87,186 @@ bool ModelComponent::casts_reflection() const
 	return _casts_reflection;
 }
 
+
+bool ModelComponent::update_bones()
+{
+	const auto& lods = _model.get_lods();
+	bool skinned = false;
+	for (const auto& lod : lods)
+	{
+		const auto mesh = lod.get();
+		skinned |= mesh && mesh->get_skin_bind_data().has_bones();
+	}
+
+	if (!skinned)
+	{
+		_skins.clear();
+		return false;
+	}
+
+	auto transform_comp = get_entity().component<TransformComponent>().lock();
+	const math::mat4 root_transform = transform_comp ? transform_comp->get_transform().matrix() : math::mat4(1.0f);
+
+	_skins.resize(lods.size());
+	for (std::size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		auto& skin = _skins[lod];
+		const auto mesh = lods[lod].get();
+		if (!mesh || !mesh->get_skin_bind_data().has_bones())
+		{
+			skin = Skin();
+			continue;
+		}
+
+		auto copy_bone_transforms = [&skin, &root_transform]()
+		{
+			std::size_t found = 0;
+			for (std::size_t i = 0; i < skin.bones.size(); ++i)
+			{
+				auto bone = skin.bones[i].lock();
+				skin.bone_transforms[i] = bone ? bone->get_transform().matrix() : root_transform;
+				found += bone ? 1 : 0;
+			}
+			return found == skin.found;
+		};
+
+		// Bones are looked up once, and again only when the mesh changes or
+		// one of the bone entities goes away.
+		if (skin.palettes.mesh != mesh || !copy_bone_transforms())
+		{
+			resolve_bones(skin, *mesh);
+			copy_bone_transforms();
+		}
+	}
+
+	return true;
+}
+
+void ModelComponent::update_skinning()
+{
+	for (auto& skin : _skins)
+	{
+		if (skin.bones.empty())
+			continue;
+
+		// Skinning matrix of each bone, world * bind pose, then gathered into
+		// the palettes that reference it.
+		const auto mesh = skin.palettes.mesh;
+		auto& bone_transforms = skin.bone_transforms;
+		math::batch::mul(bone_transforms.data(), skin.bind_poses.data(), bone_transforms.data(), bone_transforms.size());
+
+		const auto& palettes = mesh->get_bone_palettes();
+		auto& matrices = skin.palettes.matrices;
+		for (std::size_t i = 0; i < palettes.size(); ++i)
+		{
+			const auto& bones = palettes[i].get_bones();
+			const std::uint32_t offset = skin.palettes.offsets[i];
+			const std::uint32_t count = skin.palettes.offsets[i + 1] - offset;
+			for (std::uint32_t j = 0; j < count; ++j)
+				matrices[offset + j] = bone_transforms[bones[j]];
+		}
+	}
+}
+
+bool ModelComponent::upload_skinning(std::uint32_t& matrix_budget)
+{
+	bool uploaded = true;
+	for (auto& skin : _skins)
+	{
+		auto& palettes = skin.palettes;
+		palettes.cache = UINT32_MAX;
+		if (skin.bones.empty() || palettes.matrices.empty())
+			continue;
+
+		const auto count = std::uint32_t(palettes.matrices.size());
+		if (count > matrix_budget || count > UINT16_MAX)
+		{
+			uploaded = false;
+			continue;
+		}
+
+		palettes.cache = gfx::setTransform(&palettes.matrices[0][0][0], std::uint16_t(count));
+		matrix_budget -= count;
+	}
+	return uploaded;
+}
+
+const SkinningPalettes* ModelComponent::get_skinning(std::uint32_t lod) const
+{
+	if (lod >= _skins.size() || _skins[lod].bones.empty() || _skins[lod].palettes.cache == UINT32_MAX)
+		return nullptr;
+
+	return &_skins[lod].palettes;
+}
+
+bool ModelComponent::is_skinned(std::uint32_t lod) const
+{
+	return lod < _skins.size() && !_skins[lod].bones.empty();
+}
+
+void ModelComponent::resolve_bones(Skin& skin, const Mesh& mesh)
+{
+	// Name of every entity below this one. The first one found wins when
+	// names repeat, which keeps the closest match.
+	std::unordered_map<std::string, runtime::CHandle<TransformComponent>> nodes;
+	std::deque<runtime::CHandle<TransformComponent>> pending;
+	pending.push_back(get_entity().component<TransformComponent>());
+	while (!pending.empty())
+	{
+		auto node = pending.front().lock();
+		pending.pop_front();
+		if (!node)
+			continue;
+
+		for (const auto& child : node->get_children())
+		{
+			auto child_ptr = child.lock();
+			if (!child_ptr)
+				continue;
+
+			nodes.emplace(child_ptr->get_entity().get_name(), child);
+			pending.push_back(child);
+		}
+	}
+
+	const auto& bind_bones = mesh.get_skin_bind_data().get_bones();
+	skin.bones.resize(bind_bones.size());
+	skin.bind_poses.resize(bind_bones.size());
+	skin.bone_transforms.resize(bind_bones.size());
+	skin.found = 0;
+	for (std::size_t i = 0; i < bind_bones.size(); ++i)
+	{
+		auto it = nodes.find(bind_bones[i].bone_id);
+		if (it != nodes.end())
+		{
+			skin.bones[i] = it->second;
+			skin.bind_poses[i] = bind_bones[i].bind_pose_transform.matrix();
+			++skin.found;
+		}
+		else
+		{
+			// Follows the entity with an identity bind pose, which leaves the
+			// vertices where they were imported.
+			skin.bones[i] = runtime::CHandle<TransformComponent>();
+			skin.bind_poses[i] = math::mat4(1.0f);
+		}
+	}
+
+	if (skin.found < bind_bones.size())
+	{
+		APPLOG_WARNING("{0} of {1} bones of a skinned mesh were not found below entity '{2}', they stay in bind pose.",
+			bind_bones.size() - skin.found, bind_bones.size(), get_entity().get_name());
+	}
+
+	// The palettes keep the same layout for as long as the mesh does.
+	const auto& palettes = mesh.get_bone_palettes();
+	const std::uint32_t max_blend_transforms = gfx::get_max_blend_transforms();
+	auto& offsets = skin.palettes.offsets;
+	offsets.resize(palettes.size() + 1);
+	offsets[0] = 0;
+	for (std::size_t i = 0; i < palettes.size(); ++i)
+		offsets[i + 1] = offsets[i] + std::min(std::uint32_t(palettes[i].get_bones().size()), max_blend_transforms);
+
+	skin.palettes.matrices.resize(offsets.back());
+	skin.palettes.mesh = &mesh;
+}
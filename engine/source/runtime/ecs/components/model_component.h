@@ -4,6 +4,8 @@
 #include "../../rendering/model.h"
 
 class Material;
+class Mesh;
+class TransformComponent;
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -113,7 +115,86 @@ public:
 	//-----------------------------------------------------------------------------
 	ModelComponent& set_model(const Model& model);
 
+	//-----------------------------------------------------------------------------
+	//  Name : update_bones ()
+	/// <summary>
+	/// Finds the entities driving the bones of the skinned lods, by name among
+	/// the descendants of the entity, once for each mesh, and copies their
+	/// world transforms. Reads other components, so it has to be called on
+	/// the main thread. Returns false if no lod is skinned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool update_bones();
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_skinning ()
+	/// <summary>
+	/// Computes the skinning palettes of the skinned lods from the transforms
+	/// copied by update_bones. Only touches this component, so components can
+	/// be updated in parallel.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_skinning();
+
+	//-----------------------------------------------------------------------------
+	//  Name : upload_skinning ()
+	/// <summary>
+	/// Uploads the skinning palettes of the skinned lods to the transform cache
+	/// of the frame, once for every pass that draws them. Lods whose palettes
+	/// do not fit in the matrix budget left are not uploaded, the budget is
+	/// reduced by what was. Has to be called on the main thread, every frame.
+	/// Returns false if some lod did not fit.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool upload_skinning(std::uint32_t& matrix_budget);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_skinning ()
+	/// <summary>
+	/// Returns the skinning palettes of a lod for the current frame, nullptr
+	/// if its mesh is not skinned or they were not uploaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const SkinningPalettes* get_skinning(std::uint32_t lod) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_skinned ()
+	/// <summary>
+	/// Returns whether the mesh of a lod is skinned, uploaded or not.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_skinned(std::uint32_t lod) const;
+
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : Skin (Struct)
+	/// <summary>
+	/// Bones of the skinned mesh of a lod.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct Skin
+	{
+		/// Transforms driving the bones, in the order of the skin bind data.
+		/// Bones that were not found follow the entity itself.
+		std::vector<runtime::CHandle<TransformComponent>> bones;
+		/// Bind pose of each bone.
+		std::vector<math::mat4> bind_poses;
+		/// World transform of each bone, then its skinning matrix.
+		std::vector<math::mat4> bone_transforms;
+		/// Number of bones that were found.
+		std::size_t found = 0;
+		/// Result, palettes.mesh is the mesh the bones were found for.
+		SkinningPalettes palettes;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : resolve_bones ()
+	/// <summary>
+	/// Looks up the bones of a mesh and lays out its palettes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void resolve_bones(Skin& skin, const Mesh& mesh);
+
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
@@ -125,4 +206,6 @@ private:
 	bool _casts_reflection = true;
 	///
 	Model _model;
+	/// Skins of the lods, not copied along with the component.
+	std::vector<Skin> _skins;
 };
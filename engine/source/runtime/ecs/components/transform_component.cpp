@@ -524,6 +524,8 @@ TransformComponent& TransformComponent::set_parent(runtime::CHandle<TransformCom
 		parent_ptr->attach_child(handle());
 	}
 
+	runtime::on_entity_reparented(get_entity());
+
 	if (world_position_stays)
 	{
 		resolve(true);
@@ -599,6 +601,7 @@ void TransformComponent::resolve(bool force, float dt)
 		if (!_parent.expired())
 		{
 			auto target = _parent.lock()->get_transform() * _local_transform;
+			const auto previous = _world_transform;
 
 			if (_slow_parenting)
 			{
@@ -611,6 +614,10 @@ void TransformComponent::resolve(bool force, float dt)
 			{
 				_world_transform = target;
 			}
+
+			// Moved along with a parent, let change queries know.
+			if (_world_transform.compare(previous, 0.0f) != 0)
+				mark_changed();
 		}
 		else
 		{
@@ -6,6 +6,8 @@ namespace runtime
 	event<void(Entity)> on_entity_destroyed;
 	event<void(Entity, CHandle<Component>)> on_component_added;
 	event<void(Entity, CHandle<Component>)> on_component_removed;
+	event<void(Entity)> on_entity_renamed;
+	event<void(Entity)> on_entity_reparented;
 
 	ComponentStorage::ComponentStorage(std::size_t size)
 	{
@@ -19,11 +21,13 @@ namespace runtime
 	void ComponentStorage::expand(std::size_t n)
 	{
 		data.resize(n);
+		versions.resize(n, 0);
 	}
 
 	void ComponentStorage::reserve(std::size_t n)
 	{
 		data.reserve(n);
+		versions.reserve(n);
 	}
 
 	std::shared_ptr<Component> ComponentStorage::get(std::size_t n)
@@ -43,6 +47,7 @@ namespace runtime
 		Expects(n < size());
 		auto& element = data[n];
 		element.reset();
+		versions[n] = 0;
 	}
 
 	std::weak_ptr<Component> ComponentStorage::set(unsigned int index, std::shared_ptr<Component> component)
@@ -92,6 +97,11 @@ namespace runtime
 
 	EntityComponentSystem::EntityComponentSystem()
 	{
+		// The simulation is created first by the engine, fall back to a frame
+		// counter that never advances when it is missing.
+		static const std::uint64_t no_frame = 0;
+		auto sim = core::get_subsystem<core::Simulation>();
+		frame_ = sim ? &sim->get_frame() : &no_frame;
 	}
 
 	EntityComponentSystem::~EntityComponentSystem()
@@ -102,6 +112,7 @@ namespace runtime
 	void EntityComponentSystem::set_entity_name(Entity::Id id, std::string name)
 	{
 		entity_names_[id.id()] = name;
+		on_entity_renamed(get(id));
 	}
 
 	const std::string& EntityComponentSystem::get_entity_name(Entity::Id id)
@@ -109,6 +120,16 @@ namespace runtime
 		return entity_names_[id.id()];
 	}
 
+	void EntityComponentSystem::reserve(std::size_t n)
+	{
+		const std::size_t count = free_list_.size() < n ? index_counter_ + n - free_list_.size() : index_counter_;
+		entity_component_mask_.reserve(count);
+		entity_version_.reserve(count);
+		entity_names_.reserve(entity_names_.size() + n);
+		for (ComponentStorage *pool : component_pools_)
+			if (pool) pool->reserve(count);
+	}
+
 	void EntityComponentSystem::dispose()
 	{
 		for (Entity entity : all_entities()) entity.destroy();
@@ -209,6 +230,7 @@ namespace runtime
 
 		// Create and return handle.
 		component->_entity = get(id);
+		component->touch();
 		component->on_entity_set();
 		CHandle<Component> handle(ptr);
 		on_component_added(get(id), handle);
@@ -5,9 +5,11 @@
 #include "core/events/event.hpp"
 #include "core/common/assert.hpp"
 #include "core/common/type_traits.hpp"
+#include "core/memory/pool_allocator.hpp"
 #include "core/reflection/reflection.h"
 #include "core/serialization/serialization.h"
 
+#include <atomic>
 #include <bitset>
 #include <mutex>
 #include <cstdint>
@@ -65,14 +67,21 @@ namespace runtime
 		template <typename T, typename ... Args>
 		std::weak_ptr<T> set(unsigned int index, Args && ... args)
 		{
-			auto element = std::make_shared<T>(std::forward<Args>(args) ...);
+			auto element = std::allocate_shared<T>(core::PoolAllocator<T>(), std::forward<Args>(args) ...);
 			data[index] = std::move(element);
 			return std::static_pointer_cast<T>(data[index]);
 		}
 
 		std::weak_ptr<Component> set(unsigned int index, std::shared_ptr<Component> component);
+
+		/// Change version of the component in slot n, see EntityComponentSystem::get_change_version.
+		inline std::uint64_t get_version(std::size_t n) const { return versions[n]; }
+		inline void set_version(std::size_t n, std::uint64_t version) { versions[n] = version; }
 	private:
 		std::vector<std::shared_ptr<Component>> data;
+		/// Change version of every slot, kept apart from the components so that
+		/// change queries do not have to dereference them.
+		std::vector<std::uint64_t> versions;
 	};
 
 
@@ -217,6 +226,8 @@ namespace runtime
 		std::bitset<MAX_COMPONENTS> component_mask() const;
 
 	private:
+		friend class Component;
+
 		EntityComponentSystem *manager_ = nullptr;
 		Entity::Id id_ = INVALID;
 	};
@@ -235,7 +246,7 @@ runtime::CHandle<type> handle()													\
 }																				\
 virtual std::shared_ptr<Component> clone() const								\
 {																				\
-	return std::static_pointer_cast<Component>(std::make_shared<type>(*this));	\
+	return std::static_pointer_cast<Component>(std::allocate_shared<type>(core::PoolAllocator<type>(), *this));	\
 }
 
 	class Component
@@ -287,22 +298,30 @@ virtual std::shared_ptr<Component> clone() const								\
 		//-----------------------------------------------------------------------------
 		//  Name : touch (virtual )
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Flags the component as changed. It stays dirty for the rest of this
+		/// frame and the next one, and gets a new change version.
 		/// </summary>
 		//-----------------------------------------------------------------------------	
-		virtual void touch() { _last_touched = core::get_subsystem<core::Simulation>()->get_frame() + 1; }
+		virtual void touch();
 
 		//-----------------------------------------------------------------------------
 		//  Name : isDirty (virtual )
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Was the component touched during this frame or the previous one.
+		/// Components that are not assigned to an entity are never dirty, they
+		/// are touched when they are assigned.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		virtual bool is_dirty() const;
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_version ()
+		/// <summary>
+		/// Change version given to the component the last time it was touched,
+		/// see EntityComponentSystem::get_change_version.
 		/// </summary>
 		//-----------------------------------------------------------------------------
-		virtual bool is_dirty() const { return _last_touched >= core::get_subsystem<core::Simulation>()->get_frame(); }
+		std::uint64_t get_version() const { return _version; }
 
 		//-----------------------------------------------------------------------------
 		//  Name : onEntitySet (virtual )
@@ -334,10 +353,23 @@ virtual std::shared_ptr<Component> clone() const								\
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		virtual core::TypeInfo::index_t runtime_id() const = 0;
+
+		//-----------------------------------------------------------------------------
+		//  Name : mark_changed ()
+		/// <summary>
+		/// Gives the component a new change version without making it dirty. Used
+		/// for state that is derived every frame, like world transforms, so that
+		/// change queries see it while is_dirty keeps meaning "touched".
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void mark_changed();
+
 		/// Owning Entity
 		Entity _entity;
-		/// Was the component touched.
+		/// Frame after which the component is no longer dirty.
 		std::uint64_t _last_touched = 0;
+		/// Change version of the last touch.
+		std::uint64_t _version = 0;
 	};
 
 
@@ -345,6 +377,10 @@ virtual std::shared_ptr<Component> clone() const								\
 	extern event<void(Entity)> on_entity_destroyed;
 	extern event<void(Entity, CHandle<Component>)> on_component_added;
 	extern event<void(Entity, CHandle<Component>)> on_component_removed;
+	/// Fired when an entity gets a new name.
+	extern event<void(Entity)> on_entity_renamed;
+	/// Fired when an entity is attached to another parent in the hierarchy.
+	extern event<void(Entity)> on_entity_reparented;
 	
 	/**
 	* Manages Entity::Id creation and component assignment.
@@ -384,14 +420,24 @@ virtual std::shared_ptr<Component> clone() const								\
 					free_cursor_ = 0;
 				}
 			}
-			ViewIterator(EntityComponentSystem *manager, const ComponentMask mask, std::uint32_t index)
-				: manager_(manager), mask_(mask), i_(index), capacity_(manager_->capacity()), free_cursor_(~0UL)
+			ViewIterator(EntityComponentSystem *manager, const ComponentMask mask, std::uint32_t index, std::uint64_t since = 0)
+				: manager_(manager), mask_(mask), i_(index), capacity_(manager_->capacity()), free_cursor_(~0UL), since_(since)
 			{
 				if (All)
 				{
 					std::sort(manager_->free_list_.begin(), manager_->free_list_.end());
 					free_cursor_ = 0;
 				}
+
+				// change queries only look at the versions of the requested types
+				if (since_ != 0)
+				{
+					for (std::size_t family = 0; family < manager_->component_pools_.size(); ++family)
+					{
+						if (mask_.test(family))
+							families_.push_back(family);
+					}
+				}
 			}
 
 			void next()
@@ -410,7 +456,8 @@ virtual std::shared_ptr<Component> clone() const								\
 
 			inline bool predicate()
 			{
-				return (All && valid_entity()) || (manager_->entity_component_mask_[i_] & mask_) == mask_;
+				return (All && valid_entity()) ||
+					((manager_->entity_component_mask_[i_] & mask_) == mask_ && (since_ == 0 || manager_->changed_since(i_, families_, since_)));
 			}
 
 			inline bool valid_entity()
@@ -429,6 +476,10 @@ virtual std::shared_ptr<Component> clone() const								\
 			std::uint32_t i_;
 			size_t capacity_;
 			size_t free_cursor_;
+			// When not zero, only entities with a component of the mask changed after this version.
+			std::uint64_t since_ = 0;
+			// Families of the mask, set for change queries.
+			std::vector<std::size_t> families_;
 		};
 
 		template <bool All>
@@ -440,7 +491,8 @@ virtual std::shared_ptr<Component> clone() const								\
 			public:
 				Iterator(EntityComponentSystem *manager,
 					const ComponentMask mask,
-					std::uint32_t index) : ViewIterator<Iterator, All>(manager, mask, index)
+					std::uint32_t index,
+					std::uint64_t since) : ViewIterator<Iterator, All>(manager, mask, index, since)
 				{
 					ViewIterator<Iterator, All>::next();
 				}
@@ -448,20 +500,21 @@ virtual std::shared_ptr<Component> clone() const								\
 				void next_entity(Entity &entity) {}
 			};
 
-			Iterator begin() { return Iterator(manager_, mask_, 0); }
-			Iterator end() { return Iterator(manager_, mask_, std::uint32_t(manager_->capacity())); }
-			const Iterator begin() const { return Iterator(manager_, mask_, 0); }
-			const Iterator end() const { return Iterator(manager_, mask_, manager_->capacity()); }
+			Iterator begin() { return Iterator(manager_, mask_, 0, since_); }
+			Iterator end() { return Iterator(manager_, mask_, std::uint32_t(manager_->capacity()), since_); }
+			const Iterator begin() const { return Iterator(manager_, mask_, 0, since_); }
+			const Iterator end() const { return Iterator(manager_, mask_, manager_->capacity(), since_); }
 
 		private:
 			friend class EntityComponentSystem;
 
 			explicit BaseView(EntityComponentSystem *manager) : manager_(manager) { mask_.set(); }
-			BaseView(EntityComponentSystem *manager, ComponentMask mask) :
-				manager_(manager), mask_(mask) {}
+			BaseView(EntityComponentSystem *manager, ComponentMask mask, std::uint64_t since = 0) :
+				manager_(manager), mask_(mask), since_(since) {}
 
 			EntityComponentSystem *manager_;
 			ComponentMask mask_;
+			std::uint64_t since_ = 0;
 		};
 
 		template <bool All, typename ... Components>
@@ -480,7 +533,7 @@ virtual std::shared_ptr<Component> clone() const								\
 			friend class EntityComponentSystem;
 
 			explicit TypedView(EntityComponentSystem *manager) : BaseView<All>(manager) {}
-			TypedView(EntityComponentSystem *manager, ComponentMask mask) : BaseView<All>(manager, mask) {}
+			TypedView(EntityComponentSystem *manager, ComponentMask mask, std::uint64_t since = 0) : BaseView<All>(manager, mask, since) {}
 		};
 
 		template <typename ... Components> using View = TypedView<false, Components...>;
@@ -524,7 +577,8 @@ virtual std::shared_ptr<Component> clone() const								\
 				Iterator(EntityComponentSystem *manager,
 					const ComponentMask mask,
 					std::uint32_t index,
-					const Unpacker &unpacker) : ViewIterator<Iterator>(manager, mask, index), unpacker_(unpacker)
+					std::uint64_t since,
+					const Unpacker &unpacker) : ViewIterator<Iterator>(manager, mask, index, since), unpacker_(unpacker)
 				{
 					ViewIterator<Iterator>::next();
 				}
@@ -539,20 +593,21 @@ virtual std::shared_ptr<Component> clone() const								\
 			};
 
 
-			Iterator begin() { return Iterator(manager_, mask_, 0, unpacker_); }
-			Iterator end() { return Iterator(manager_, mask_, static_cast<std::uint32_t>(manager_->capacity()), unpacker_); }
-			const Iterator begin() const { return Iterator(manager_, mask_, 0, unpacker_); }
-			const Iterator end() const { return Iterator(manager_, mask_, static_cast<std::uint32_t>(manager_->capacity()), unpacker_); }
+			Iterator begin() { return Iterator(manager_, mask_, 0, since_, unpacker_); }
+			Iterator end() { return Iterator(manager_, mask_, static_cast<std::uint32_t>(manager_->capacity()), since_, unpacker_); }
+			const Iterator begin() const { return Iterator(manager_, mask_, 0, since_, unpacker_); }
+			const Iterator end() const { return Iterator(manager_, mask_, static_cast<std::uint32_t>(manager_->capacity()), since_, unpacker_); }
 
 
 		private:
 			friend class EntityComponentSystem;
 
-			UnpackingView(EntityComponentSystem *manager, ComponentMask mask, CHandle<Components> & ... handles) :
-				manager_(manager), mask_(mask), unpacker_(handles...) {}
+			UnpackingView(EntityComponentSystem *manager, ComponentMask mask, std::uint64_t since, CHandle<Components> & ... handles) :
+				manager_(manager), mask_(mask), since_(since), unpacker_(handles...) {}
 
 			EntityComponentSystem *manager_;
 			ComponentMask mask_;
+			std::uint64_t since_;
 			Unpacker unpacker_;
 		};
 
@@ -566,6 +621,12 @@ virtual std::shared_ptr<Component> clone() const								\
 		*/
 		size_t capacity() const { return entity_component_mask_.size(); }
 
+		/**
+		* Reserve room for n more entities and their components, so that a batch
+		* of creations does not reallocate the entity and component arrays.
+		*/
+		void reserve(std::size_t n);
+
 		/**
 		* Return true if the given entity ID is still valid.
 		*/
@@ -643,12 +704,16 @@ virtual std::shared_ptr<Component> clone() const								\
 		*
 		*     Position &position = em.assign<Position>(e, x, y);
 		*
+		* Components are allocated together with their reference counts from the
+		* pool of their type, see core::PoolAllocator.
+		*
 		* @returns Smart pointer to newly created component.
 		*/
 		template <typename C, typename ... Args>
 		CHandle<C> assign(Entity::Id id, Args && ... args)
 		{
-			return std::static_pointer_cast<C>(assign(id, std::make_shared<C>(std::forward<Args>(args) ...)).lock());
+			auto component = std::allocate_shared<C>(core::PoolAllocator<C>(), std::forward<Args>(args) ...);
+			return std::static_pointer_cast<C>(assign(id, std::move(component)).lock());
 		}
 
 		CHandle<Component> assign(Entity::Id id, std::shared_ptr<Component> component);
@@ -774,7 +839,67 @@ virtual std::shared_ptr<Component> clone() const								\
 		UnpackingView<Components...> entities_with_components(CHandle<Components> & ... components)
 		{
 			auto mask = component_mask<Components...>();
-			return UnpackingView<Components...>(this, mask, components...);
+			return UnpackingView<Components...>(this, mask, 0, components...);
+		}
+
+		/**
+		* Current change version. Every touch of a component hands out a new,
+		* higher version, so a system that remembers this value can later ask for
+		* whatever changed after it:
+		*
+		* @code
+		* auto since = last_version;
+		* last_version = ecs.get_change_version();
+		* for (Entity entity : ecs.entities_changed_since<Position>(since)) {}
+		* @endcode
+		*/
+		std::uint64_t get_change_version() const { return change_version_.load(std::memory_order_relaxed); }
+
+		/**
+		* Current simulation frame, without going through the subsystem lookup.
+		*/
+		std::uint64_t get_frame() const { return *frame_; }
+
+		/**
+		* Find Entities that have all of the specified Components and at least one
+		* of them changed after the given change version. A version of 0 matches
+		* every entity with the Components.
+		*/
+		template <typename ... Components>
+		View<Components...> entities_changed_since(std::uint64_t version)
+		{
+			auto mask = component_mask<Components ...>();
+			return View<Components...>(this, mask, version);
+		}
+
+		/**
+		* Same as above, assigning the Components to the given parameters.
+		*/
+		template <typename ... Components>
+		UnpackingView<Components...> entities_changed_since(std::uint64_t version, CHandle<Components> & ... components)
+		{
+			auto mask = component_mask<Components...>();
+			return UnpackingView<Components...>(this, mask, version, components...);
+		}
+
+		template <typename ... Components>
+		void each_changed_since(std::uint64_t version, typename identity<std::function<void(Entity entity, Components&...)>>::type f)
+		{
+			return entities_changed_since<Components...>(version).each(f);
+		}
+
+		/**
+		* Return true if the Component of the entity changed after the given
+		* change version.
+		*/
+		template <typename C>
+		bool changed_since(Entity::Id id, std::uint64_t version) const
+		{
+			assert_valid(id);
+			auto family = core::TypeInfo::id<Component, C>();
+			if (family >= component_pools_.size() || !component_pools_[family] || !entity_component_mask_[id.index()][family])
+				return false;
+			return component_pools_[family]->get_version(id.index()) > version;
 		}
 
 		/**
@@ -826,6 +951,34 @@ virtual std::shared_ptr<Component> clone() const								\
 	private:
 		friend class Entity;
 
+		friend class Component;
+
+		/**
+		* Hand out a new change version to the component of the given family on
+		* the entity at index. Components may be touched from tasks, the versions
+		* stay unique across threads.
+		*/
+		inline std::uint64_t stamp_change(std::uint32_t index, core::TypeInfo::index_t family)
+		{
+			const std::uint64_t version = change_version_.fetch_add(1, std::memory_order_relaxed) + 1;
+			component_pools_[family]->set_version(index, version);
+			return version;
+		}
+
+		/**
+		* Return true if any component of the given families on the entity at
+		* index changed after the given change version.
+		*/
+		inline bool changed_since(std::uint32_t index, const std::vector<std::size_t>& families, std::uint64_t version) const
+		{
+			for (auto family : families)
+			{
+				if (component_pools_[family]->get_version(index) > version)
+					return true;
+			}
+			return false;
+		}
+
 		inline void assert_valid(Entity::Id id) const
 		{
 			Expects(id.index() < entity_component_mask_.size() && "Entity::Id ID outside entity vector range");
@@ -896,6 +1049,7 @@ virtual std::shared_ptr<Component> clone() const								\
 			if (!component_pools_[family])
 			{
 				ComponentStorage *pool = new ComponentStorage();
+				pool->reserve(entity_component_mask_.capacity());
 				pool->expand(index_counter_);
 				component_pools_[family] = pool;
 			}
@@ -916,8 +1070,39 @@ virtual std::shared_ptr<Component> clone() const								\
 		std::vector<std::uint32_t> free_list_;
 
 		std::unordered_map<std::uint64_t, std::string>	entity_names_;
+
+		// Last change version handed out, see get_change_version().
+		std::atomic<std::uint64_t> change_version_{ 0 };
+		// Frame counter of the simulation, cached so that dirty checks need no subsystem lookup.
+		const std::uint64_t* frame_ = nullptr;
 	};
 
+	inline void Component::touch()
+	{
+		// Not assigned yet, EntityComponentSystem::assign touches it again.
+		if (!_entity.valid())
+			return;
+
+		EntityComponentSystem* manager = _entity.manager_;
+		_last_touched = manager->get_frame() + 1;
+		_version = manager->stamp_change(_entity.id().index(), runtime_id());
+	}
+
+	inline bool Component::is_dirty() const
+	{
+		// Not assigned yet, nothing has seen it change.
+		if (!_entity.valid())
+			return false;
+
+		return _last_touched >= _entity.manager_->get_frame();
+	}
+
+	inline void Component::mark_changed()
+	{
+		if (_entity.valid())
+			_version = _entity.manager_->stamp_change(_entity.id().index(), runtime_id());
+	}
+
 
 	template <typename C, typename ... Args>
 	CHandle<C> Entity::assign(Args && ... args)
@@ -3,16 +3,59 @@
 
 runtime::Entity Prefab::instantiate()
 {
+	if (_template)
+		return instantiate_from_template();
+
 	std::vector<runtime::Entity> outDataVec;
 	if (!data)
 		return runtime::Entity();
-		
+
+	auto entity_system = core::get_subsystem<runtime::EntityComponentSystem>();
+	const auto size_before = entity_system->size();
+
 	if(!ecs::utils::deserialize_data(*data, outDataVec))
 		return runtime::Entity();
 
+	if (outDataVec.empty())
+		return runtime::Entity();
+
+	// Re-serialize the fresh instance in binary form so that further
+	// instances do not have to parse the source data again.
+	_entity_count = entity_system->size() - size_before;
+	_template = std::make_shared<std::stringstream>(std::ios::in | std::ios::out | std::ios::binary);
+	ecs::utils::serialize_data(*_template, { outDataVec[0] }, ecs::utils::DataFormat::Binary);
+
+	return outDataVec[0];
+}
+
+std::vector<runtime::Entity> Prefab::instantiate(std::size_t count)
+{
+	std::vector<runtime::Entity> instances;
+	if (count == 0)
+		return instances;
+
+	instances.reserve(count);
+	instances.push_back(instantiate());
+	if (!_template)
+		return instances;
+
+	auto entity_system = core::get_subsystem<runtime::EntityComponentSystem>();
+	entity_system->reserve(_entity_count * (count - 1));
+
+	for (std::size_t i = 1; i < count; ++i)
+		instances.push_back(instantiate_from_template());
+
+	return instances;
+}
+
+runtime::Entity Prefab::instantiate_from_template()
+{
+	std::vector<runtime::Entity> outDataVec;
+	if (!ecs::utils::deserialize_data(*_template, outDataVec))
+		return runtime::Entity();
+
 	if (outDataVec.empty())
 		return runtime::Entity();
 	else
 		return outDataVec[0];
-
 }
@@ -3,10 +3,43 @@
 #include "ecs.h"
 #include <memory>
 #include <fstream>
+#include <sstream>
 
 
 struct Prefab
 {
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates a new instance of the prefab. The source data is parsed only
+	/// once, every following instance is created from a cached binary template.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	runtime::Entity instantiate();
+
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates count instances of the prefab, reserving entity and component
+	/// storage for all of them up front.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<runtime::Entity> instantiate(std::size_t count);
+
+	/// Source data as read from disk.
 	std::shared_ptr<std::istream> data;
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate_from_template ()
+	/// <summary>
+	/// Creates a new instance from the cached binary template.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	runtime::Entity instantiate_from_template();
+
+	/// Pre-parsed binary copy of the data. Built on first instantiation.
+	std::shared_ptr<std::stringstream> _template;
+	/// Number of entities a single instance consists of.
+	std::size_t _entity_count = 0;
 };
@@ -2,11 +2,13 @@
 #include "../components/transform_component.h"
 #include "../components/camera_component.h"
 #include "../../system/engine.h"
+#include "core/profiling/profiler.h"
 
 namespace runtime
 {
 	void CameraSystem::frame_update(std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Camera System");
 		auto ecs = core::get_subsystem<EntityComponentSystem>();
 
 		ecs->each<TransformComponent, CameraComponent>([this](
@@ -13,10 +13,88 @@
 #include "../../rendering/texture.h"
 #include "../../rendering/material.h"
 #include "../../system/engine.h"
+#include "../../system/task.h"
 #include "../../assets/asset_manager.h"
+#include "core/profiling/profiler.h"
+#include "core/logging/logging.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace runtime
 {
+	namespace
+	{
+		// Number of visible models recorded by a single task.
+		const std::uint32_t DrawsPerTask = 64;
+		// Number of skinned models whose palettes are evaluated by a single task.
+		const std::uint32_t SkinnedModelsPerTask = 16;
+		// Skinning matrices uploaded per frame, a quarter of the transform
+		// cache of bgfx, the rest is left to the draws of the passes.
+		const std::uint32_t MaxSkinningMatrices = 16384;
+
+		// Size of the shadow atlas and of the maps of every kind of light.
+		const std::uint32_t ShadowAtlasSize = 4096;
+		const std::uint32_t MinShadowMapSize = 128;
+		const std::uint32_t CascadeShadowMapSize = 1024;
+		const std::uint32_t SpotShadowMapSize = 512;
+		const std::uint32_t PointShadowMapSize = 256;
+		// Texels a face of a point light overlaps its neighbours by.
+		const std::uint32_t PointShadowMapBorder = 2;
+		// Cascades end at this distance from the camera, or at its far clip.
+		const float MaxCascadeDistance = 150.0f;
+		// Directional lights pick up casters this far outside of the camera
+		// frustum towards the light.
+		const float CascadeCasterDistance = 100.0f;
+		// Shadow maps rendered in a frame at most, the others keep what they
+		// had for another frame.
+		const std::uint32_t MaxShadowMapUpdates = 32;
+		// Depth bias, in shadow map depth, and normal offset, in world units,
+		// of shadow lookups.
+		const float DirectionalShadowBias = 0.001f;
+		const float DirectionalShadowNormalOffset = 0.05f;
+		const float LocalShadowBias = 0.0005f;
+		const float LocalShadowNormalOffset = 0.02f;
+		// Every frame a dirty reflection probe waits counts as if it were this
+		// much closer to the camera.
+		const float ProbeWaitDistance = 10.0f;
+		// Dirty reflection probes that waited this many frames are rendered
+		// before any other, the ones that waited longest first.
+		const std::uint32_t MaxProbeWaitFrames = 30;
+
+		struct ShadowCaster
+		{
+			Entity entity;
+			std::shared_ptr<ModelComponent> model_comp;
+			math::transform_t world_transform;
+			math::bbox bounds;
+			std::uint64_t version = 0;
+			bool is_static = true;
+		};
+
+		// Frees the maps past count, for lights that changed type or splits.
+		void resize_light_shadows(LightShadows& shadows, std::uint32_t count, shadow_maps::ShadowAtlas& atlas)
+		{
+			for (std::uint32_t i = count; i < shadows.count; ++i)
+			{
+				atlas.free(shadows.maps[i].rect);
+				shadows.maps[i] = ShadowMap();
+			}
+			shadows.count = count;
+		}
+
+		struct GBufferDraw
+		{
+			std::shared_ptr<ModelComponent> model_comp;
+			math::transform_t world_transform;
+			std::uint32_t current_lod_index = 0;
+			std::uint32_t target_lod_index = 0;
+			math::vec3 params;
+			math::vec3 params_inv;
+			bool transition = false;
+		};
+	}
+
 	Camera get_face_camera(std::uint32_t face,  const math::transform_t& transform)
 	{
 		Camera camera;
@@ -106,15 +184,12 @@ namespace runtime
 		}
 	}
 
-	bool should_rebuild_reflections(VisibilitySetModels& visibility_set, const ReflectionProbe& probe)
+	std::uint32_t get_dirty_reflection_faces(VisibilitySetModels& visibility_set, const std::array<math::frustum, 6>& frustums)
 	{
-
- 		if (probe.method == ReflectMethod::Environment)
- 			return false;
-
+		const std::uint32_t all_faces = (1 << 6) - 1;
+		std::uint32_t dirty_faces = 0;
 		for (auto& element : visibility_set)
 		{
-			auto& e = std::get<0>(element);
 			auto& transform_comp_handle = std::get<1>(element);
 			auto& model_comp_handle = std::get<2>(element);
 			auto transform_comp_ptr = transform_comp_handle.lock();
@@ -122,41 +197,35 @@ namespace runtime
 			if (!transform_comp_ptr || !model_comp_ptr)
 				continue;
 
-			auto& transform_comp_ref = *transform_comp_ptr.get();
-			auto& model_comp_ref = *model_comp_ptr.get();
-
-			const auto& model = model_comp_ref.get_model();
+			const auto& model = model_comp_ptr->get_model();
 			if (!model.is_valid())
 				continue;
 
 			const auto mesh = model.get_lod(0);
+			if (!mesh)
+				continue;
 
-			const auto& world_transform = transform_comp_ref.get_transform();
-
+			const auto& world_transform = transform_comp_ptr->get_transform();
 			const auto& bounds = mesh->get_bounds();
-
-
-			bool result = false;
-
 			for (std::uint32_t i = 0; i < 6; ++i)
-			{			
-				const auto& frustum = get_face_camera(i, world_transform).get_frustum();
-				result |= math::frustum::test_obb(frustum, bounds, world_transform);
+			{
+				if ((dirty_faces & (1 << i)) == 0 && math::frustum::test_obb(frustums[i], bounds, world_transform))
+					dirty_faces |= 1 << i;
 			}
 
-			if (result)
-				return true;
+			if (dirty_faces == all_faces)
+				break;
 		}
 
-		return false;
+		return dirty_faces;
 	}
 
-	VisibilitySetModels DeferredRendering::gather_visible_models(EntityComponentSystem& ecs, Camera* camera, bool dirty_only/* = false*/, bool static_only /*= true*/, bool require_reflection_caster /*= false*/)
+	VisibilitySetModels DeferredRendering::gather_visible_models(EntityComponentSystem& ecs, Camera* camera, std::uint64_t changed_since/* = 0*/, bool static_only /*= true*/, bool require_reflection_caster /*= false*/)
 	{
 		VisibilitySetModels result;
 		CHandle<TransformComponent> transform_comp_handle;
 		CHandle<ModelComponent> model_comp_handle;
-		for (auto entity : ecs.entities_with_components(transform_comp_handle, model_comp_handle))
+		for (auto entity : ecs.entities_changed_since(changed_since, transform_comp_handle, model_comp_handle))
 		{
 			auto model_comp_ptr = model_comp_handle.lock();
 			auto transform_comp_ptr = transform_comp_handle.lock();
@@ -186,39 +255,11 @@ namespace runtime
 				const auto& bounds = mesh->get_bounds();
 
 				// Test the bounding box of the mesh
-				if (math::frustum::test_obb(frustum, bounds, world_transform))
-				{
-					// Only dirty Mesh components.
-					if (dirty_only)
-					{
-						if (transform_comp_ptr->is_dirty() || model_comp_ptr->is_dirty())
-						{
-							result.push_back({ entity, transform_comp_handle, model_comp_handle });
-						}
-					} // End if dirty_only
-					else
-					{
-						result.push_back({ entity, transform_comp_handle, model_comp_handle });
-					}
-
-				} // Enf if visble
-			}
-			else
-			{
-				// Only dirty Mesh components.
-				if (dirty_only)
-				{
-					if (transform_comp_ptr->is_dirty() || model_comp_ptr->is_dirty())
-					{
-						result.push_back({ entity, transform_comp_handle, model_comp_handle });
-					}
-				} // End if dirty_only
-				else
-				{
-					result.push_back({ entity, transform_comp_handle, model_comp_handle });
-				}
+				if (!math::frustum::test_obb(frustum, bounds, world_transform))
+					continue;
 			}
 
+			result.push_back({ entity, transform_comp_handle, model_comp_handle });
 		}
 		return result;
 	}
@@ -226,48 +267,188 @@ namespace runtime
 
 	void DeferredRendering::frame_render(std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Deferred Rendering");
 		auto& ecs = *core::get_subsystem<EntityComponentSystem>();
 
+		update_skinning(ecs);
 		build_reflections_pass(ecs, dt);
 		build_shadows_pass(ecs, dt);
 		camera_pass(ecs, dt);		
 	}
 
+	void DeferredRendering::update_skinning(EntityComponentSystem& ecs)
+	{
+		PROFILE_SCOPE("Skinning");
+		core::frame_vector<ModelComponent*> skinned;
+		ecs.each<ModelComponent>([&skinned](
+			Entity ce,
+			ModelComponent& model_comp
+			)
+		{
+			if (model_comp.update_bones())
+				skinned.push_back(&model_comp);
+		});
+
+		const std::uint32_t count = std::uint32_t(skinned.size());
+		auto ts = core::get_subsystem<TaskSystem>();
+		if (ts == nullptr || count <= SkinnedModelsPerTask)
+		{
+			for (auto model_comp : skinned)
+				model_comp->update_skinning();
+		}
+		else
+		{
+			auto master = ts->create_parallel_for("Skinning Palettes", [&skinned, count](std::uint32_t begin, std::uint32_t end)
+			{
+				for (std::uint32_t i = begin; i < end && i < count; ++i)
+					skinned[i]->update_skinning();
+			}, std::uint32_t(0), count, SkinnedModelsPerTask);
+			ts->run(master);
+			ts->wait(master);
+		}
+
+		// Uploaded once here for all passes and encoders drawing the models,
+		// the ones over budget are drawn in bind pose.
+		std::uint32_t budget = MaxSkinningMatrices;
+		std::uint32_t left_out = 0;
+		for (auto model_comp : skinned)
+		{
+			if (!model_comp->upload_skinning(budget))
+				left_out++;
+		}
+
+		// Reported when the budget starts to overflow, not every frame it does.
+		if (left_out > 0 && !_skinning_overflow)
+		{
+			APPLOG_WARNING("More than {0} skinning matrices needed in a frame, {1} skinned model(s) drawn in bind pose.",
+				MaxSkinningMatrices, left_out);
+		}
+		_skinning_overflow = left_out > 0;
+	}
+
 	void DeferredRendering::build_reflections_pass(EntityComponentSystem& ecs, std::chrono::duration<float> dt)
 	{
-		auto dirty_models = gather_visible_models(ecs, nullptr, true, true, true);
-		ecs.each<TransformComponent, ReflectionProbeComponent>([this, &ecs, dt, &dirty_models](
+		PROFILE_SCOPE("Reflection Probes");
+		const auto start = std::chrono::high_resolution_clock::now();
+		const std::uint32_t all_faces = (1 << 6) - 1;
+
+		// Everything changed after the previous pass, changes made while
+		// rendering this one are picked up by the next.
+		const auto since = _reflections_version;
+		_reflections_version = ecs.get_change_version();
+		++_reflections_frame;
+
+		core::frame_vector<math::vec3> camera_positions;
+		ecs.each<CameraComponent>([&camera_positions](
+			Entity ce,
+			CameraComponent& camera_comp
+			)
+		{
+			camera_positions.push_back(camera_comp.get_camera().get_position());
+		});
+
+		struct PendingProbe
+		{
+			Entity entity;
+			TransformComponent* transform_comp = nullptr;
+			ReflectionProbeComponent* reflection_probe_comp = nullptr;
+			ProbeUpdate* update = nullptr;
+			float priority = 0.0f;
+			bool overdue = false;
+		};
+		core::frame_vector<PendingProbe> pending;
+
+		auto dirty_models = gather_visible_models(ecs, nullptr, since, true, true);
+		ecs.each<TransformComponent, ReflectionProbeComponent>([this, &dirty_models, &camera_positions, &pending, since, all_faces](
 			Entity ce,
 			TransformComponent& transform_comp,
 			ReflectionProbeComponent& reflection_probe_comp
 			)
 		{
-			const auto& world_tranform = transform_comp.get_transform();
+			const auto& world_transform = transform_comp.get_transform();
 			const auto& probe = reflection_probe_comp.get_probe();
-			
-			auto cubemap_fbo = reflection_probe_comp.get_cubemap_fbo();
-			bool should_rebuild = true;
 
-			if (!transform_comp.is_dirty() && !reflection_probe_comp.is_dirty())
+			auto& update = _probe_updates[ce];
+			update.frame = _reflections_frame;
+			if (!update.valid || update.transform != world_transform)
+			{
+				// The face frustums only depend on the transform of the probe.
+				update.transform = world_transform;
+				for (std::uint32_t i = 0; i < 6; ++i)
+					update.frustums[i] = get_face_camera(i, world_transform).get_frustum();
+				update.dirty_faces = all_faces;
+				update.valid = true;
+			}
+			else if (reflection_probe_comp.get_version() > since)
+			{
+				update.dirty_faces = all_faces;
+			}
+			else if (probe.method != ReflectMethod::Environment && update.dirty_faces != all_faces)
 			{
-				// If reflections shouldn't be rebuilt - continue.
-				should_rebuild = should_rebuild_reflections(dirty_models, probe);
+				update.dirty_faces |= get_dirty_reflection_faces(dirty_models, update.frustums);
 			}
 
-			if (!should_rebuild)
+			if (update.dirty_faces == 0)
 				return;
 
-			//iterate trough each cube face
+			// Probes closer to a camera, measured from the edge of their
+			// influence, come first. Every frame waited brings a probe closer
+			// by a fixed distance, so that far away probes catch up even with
+			// probes the camera stands in, and probes that waited too long
+			// jump the queue.
+			const auto& probe_position = world_transform.get_position();
+			const float influence_radius = probe.probe_type == ProbeType::Sphere ?
+				probe.sphere_data.range : math::length(probe.box_data.extents);
+			float distance = camera_positions.empty() ? 0.0f : std::numeric_limits<float>::max();
+			for (const auto& camera_position : camera_positions)
+				distance = math::min(distance, math::max(math::length(camera_position - probe_position) - influence_radius, 0.0f));
+
+			PendingProbe pending_probe;
+			pending_probe.entity = ce;
+			pending_probe.transform_comp = &transform_comp;
+			pending_probe.reflection_probe_comp = &reflection_probe_comp;
+			pending_probe.update = &update;
+			pending_probe.priority = distance - float(update.waiting_frames) * ProbeWaitDistance;
+			pending_probe.overdue = update.waiting_frames >= MaxProbeWaitFrames;
+			pending.push_back(pending_probe);
+		});
+
+		std::stable_sort(pending.begin(), pending.end(), [](const PendingProbe& a, const PendingProbe& b)
+		{
+			if (a.overdue != b.overdue)
+				return a.overdue;
+			if (a.overdue)
+				return a.update->waiting_frames > b.update->waiting_frames;
+			return a.priority < b.priority;
+		});
+
+		std::uint32_t faces_rendered = 0;
+		std::uint32_t faces_pending = 0;
+		for (auto& pending_probe : pending)
+		{
+			auto& update = *pending_probe.update;
+			auto& reflection_probe_comp = *pending_probe.reflection_probe_comp;
+			const auto& world_tranform = pending_probe.transform_comp->get_transform();
+			const auto& probe = reflection_probe_comp.get_probe();
+			auto cubemap_fbo = reflection_probe_comp.get_cubemap_fbo();
+
+			bool rendered = false;
 			for (std::uint32_t i = 0; i < 6; ++i)
 			{
+				if ((update.dirty_faces & (1 << i)) == 0)
+					continue;
+
+				if (_reflection_face_budget != 0 && faces_rendered >= _reflection_face_budget)
+					break;
+
 				auto camera = get_face_camera(i, world_tranform);
 				auto& render_view = reflection_probe_comp.get_render_view(i);
 				camera.set_viewport_size(cubemap_fbo->get_size());
-				auto& camera_lods = _lod_data[ce];
+				auto& camera_lods = _lod_data[pending_probe.entity];
 				VisibilitySetModels visibility_set;
 
 				if (probe.method != ReflectMethod::Environment)
-					visibility_set = gather_visible_models(ecs, &camera, !should_rebuild, true, true);
+					visibility_set = gather_visible_models(ecs, &camera, 0, true, true);
 
 				std::shared_ptr<FrameBuffer> output = nullptr;
 				output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
@@ -277,22 +458,386 @@ namespace runtime
 
 				RenderPass pass("cubemap_fill");
 				gfx::blit(pass.id, gfx::getTexture(cubemap_fbo->handle), 0, 0, 0, i, gfx::getTexture(output->handle));
+
+				update.dirty_faces &= ~(1 << i);
+				++faces_rendered;
+				rendered = true;
 			}
 
-			RenderPass pass("cubemap_generate_mips");
-			pass.bind(cubemap_fbo.get());
+			if (rendered)
+			{
+				RenderPass pass("cubemap_generate_mips");
+				pass.bind(cubemap_fbo.get());
+			}
 
-		});
+			if (update.dirty_faces != 0)
+			{
+				++update.waiting_frames;
+				for (std::uint32_t i = 0; i < 6; ++i)
+					faces_pending += (update.dirty_faces >> i) & 1;
+			}
+			else
+			{
+				update.waiting_frames = 0;
+			}
+		}
+
+		for (auto it = _probe_updates.begin(); it != _probe_updates.end();)
+		{
+			if (it->second.frame != _reflections_frame)
+				it = _probe_updates.erase(it);
+			else
+				++it;
+		}
+
+		const std::chrono::duration<double> update_time = std::chrono::high_resolution_clock::now() - start;
+		_reflection_times[_reflection_time_count % _reflection_times.size()] = update_time.count();
+		++_reflection_time_count;
+
+		const auto samples = std::min<std::size_t>(_reflection_time_count, _reflection_times.size());
+		double mean = 0.0;
+		for (std::size_t i = 0; i < samples; ++i)
+			mean += _reflection_times[i];
+		mean /= double(samples);
+		double variance = 0.0;
+		for (std::size_t i = 0; i < samples; ++i)
+			variance += (_reflection_times[i] - mean) * (_reflection_times[i] - mean);
+		variance /= double(samples);
+
+		_reflection_stats.faces_rendered = faces_rendered;
+		_reflection_stats.faces_pending = faces_pending;
+		_reflection_stats.update_time = update_time.count();
+		_reflection_stats.update_time_mean = mean;
+		_reflection_stats.update_time_deviation = std::sqrt(variance);
 	}
 
 	void DeferredRendering::build_shadows_pass(EntityComponentSystem& ecs, std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Shadows");
+		if (!_shadow_program || !_shadow_program->begin_pass())
+			return;
+
+		if (!_shadow_atlas_fbo)
+		{
+			// Shadow maps are sampled with hardware depth comparison.
+			static const bool supported =
+				gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::TextureFormat::D16) &&
+				(gfx::getCaps()->supported & BGFX_CAPS_TEXTURE_COMPARE_LEQUAL) != 0;
+			if (!supported)
+				return;
+
+			_shadow_atlas.reset(ShadowAtlasSize, MinShadowMapSize);
+			_shadow_atlas_texture = std::make_shared<Texture>(
+				std::uint16_t(ShadowAtlasSize),
+				std::uint16_t(ShadowAtlasSize),
+				false,
+				1,
+				gfx::TextureFormat::D16,
+				BGFX_TEXTURE_RT | BGFX_TEXTURE_COMPARE_LEQUAL | BGFX_TEXTURE_U_CLAMP | BGFX_TEXTURE_V_CLAMP);
+			_shadow_atlas_fbo = std::make_shared<FrameBuffer>(std::vector<std::shared_ptr<Texture>>{ _shadow_atlas_texture });
+		}
+
+		const auto version = ecs.get_change_version();
+		const bool homogeneous_depth = gfx::is_homogeneous_depth();
+		const bool origin_bottom_left = gfx::is_origin_bottom_left();
+		++_shadow_frame;
+
+		core::frame_vector<ShadowCaster> casters;
+		std::unordered_map<Entity, std::size_t> caster_indices;
+		CHandle<TransformComponent> transform_comp_handle;
+		CHandle<ModelComponent> model_comp_handle;
+		for (auto entity : ecs.entities_with_components(transform_comp_handle, model_comp_handle))
+		{
+			auto model_comp_ptr = model_comp_handle.lock();
+			auto transform_comp_ptr = transform_comp_handle.lock();
+			if (!model_comp_ptr || !transform_comp_ptr || !model_comp_ptr->casts_shadow())
+				continue;
+
+			const auto& model = model_comp_ptr->get_model();
+			if (!model.is_valid())
+				continue;
+
+			auto mesh = model.get_lod(0);
+			if (!mesh)
+				continue;
+
+			ShadowCaster caster;
+			caster.entity = entity;
+			caster.model_comp = model_comp_ptr;
+			caster.world_transform = transform_comp_ptr->get_transform();
+			caster.bounds = mesh->get_bounds();
+			caster.version = std::max(transform_comp_ptr->get_version(), model_comp_ptr->get_version());
+			// Posed skins change with their bones rather than with the model.
+			caster.is_static = model_comp_ptr->is_static() && !model_comp_ptr->is_skinned(0);
+			caster_indices[entity] = casters.size();
+			casters.push_back(std::move(caster));
+		}
 
+		// The atlas may hand out a smaller tile than asked for when it is
+		// full, views that depend on the resolution are computed from the
+		// size of the tile the map actually got.
+		auto allocate_map = [this](ShadowMap& map, std::uint32_t size)
+		{
+			if (map.size != size || map.rect.width() == 0)
+			{
+				_shadow_atlas.free(map.rect);
+				map = ShadowMap();
+				map.size = size;
+				if (!_shadow_atlas.allocate(size, map.rect))
+				{
+					map.rect = uRect(0, 0, 0, 0);
+					return false;
+				}
+			}
+			return true;
+		};
+
+		std::uint32_t updates = 0;
+		auto update_map = [this, &casters, &caster_indices, &updates, version, homogeneous_depth, origin_bottom_left](
+			ShadowMap& map,
+			const shadow_maps::ShadowView& shadow_view)
+		{
+			const math::mat4 view_proj = shadow_view.proj.matrix() * shadow_view.view.matrix();
+			const math::frustum frustum(shadow_view.view, shadow_view.proj, homogeneous_depth);
+
+			// Anything that changed inside of the map, or that left it or went
+			// away since it was rendered, makes it dirty.
+			core::frame_vector<std::size_t> visible;
+			bool dirty = !map.rendered || view_proj != map.view_proj;
+			for (std::size_t i = 0; i < casters.size(); ++i)
+			{
+				const auto& caster = casters[i];
+				if (!math::frustum::test_obb(frustum, caster.bounds, caster.world_transform))
+					continue;
+
+				visible.push_back(i);
+				dirty |= !caster.is_static || caster.version > map.version;
+			}
+			for (std::size_t i = 0; i < map.casters.size() && !dirty; ++i)
+			{
+				auto it = caster_indices.find(map.casters[i]);
+				dirty |= it == caster_indices.end() || casters[it->second].version > map.version;
+			}
+
+			if (!dirty || updates >= MaxShadowMapUpdates)
+				return;
+
+			++updates;
+
+			RenderPass pass("shadow_map_fill");
+			pass.bind(_shadow_atlas_fbo.get());
+			gfx::setViewRect(pass.id, std::uint16_t(map.rect.left), std::uint16_t(map.rect.top), std::uint16_t(map.rect.width()), std::uint16_t(map.rect.height()));
+			gfx::setViewScissor(pass.id, std::uint16_t(map.rect.left), std::uint16_t(map.rect.top), std::uint16_t(map.rect.width()), std::uint16_t(map.rect.height()));
+			pass.clear(BGFX_CLEAR_DEPTH, 0, 1.0f, 0);
+			pass.set_view_proj(shadow_view.view, shadow_view.proj);
+
+			map.casters.clear();
+			for (auto i : visible)
+			{
+				const auto& caster = casters[i];
+				const auto skinning = _shadow_skinned_program ? caster.model_comp->get_skinning(0) : nullptr;
+				caster.model_comp->get_model().render(
+					pass.id,
+					caster.world_transform,
+					true,
+					true,
+					true,
+					0,
+					0,
+					skinning ? _shadow_skinned_program.get() : _shadow_program.get(),
+					[](Program& program) {},
+					skinning);
+				map.casters.push_back(caster.entity);
+			}
+
+			map.view_proj = view_proj;
+			map.atlas_matrix = shadow_maps::get_atlas_matrix(shadow_view, map.rect, ShadowAtlasSize, homogeneous_depth, origin_bottom_left);
+			map.version = version;
+			map.rendered = true;
+		};
+
+		// Cascades first, they cover what the cameras look at.
+		ecs.each<CameraComponent>([this, &ecs, &allocate_map, &update_map, homogeneous_depth](
+			Entity ce,
+			CameraComponent& camera_comp
+			)
+		{
+			auto& camera = camera_comp.get_camera();
+			const float near_clip = camera.get_near_clip();
+			const float far_clip = camera.get_far_clip();
+			const float shadow_far_clip = math::min(far_clip, MaxCascadeDistance);
+			if (shadow_far_clip <= near_clip)
+				return;
+
+			auto& camera_shadows = _cascade_shadows[&camera];
+			const auto& view = camera.get_view();
+			const auto& proj = camera.get_projection();
+
+			ecs.each<TransformComponent, LightComponent>([this, &camera_shadows, &allocate_map, &update_map, &view, &proj, near_clip, far_clip, shadow_far_clip, homogeneous_depth](
+				Entity e,
+				TransformComponent& transform_comp_ref,
+				LightComponent& light_comp_ref
+				)
+			{
+				const auto& light = light_comp_ref.get_light();
+				if (!light.casts_shadows || light.light_type != LightType::Directional)
+					return;
+
+				const auto& light_direction = transform_comp_ref.get_transform().z_unit_axis();
+				const auto count = math::clamp<std::uint32_t>(light.directional_data.num_splits, 1, shadow_maps::MaxCascades);
+
+				auto& shadows = camera_shadows[e];
+				shadows.frame = _shadow_frame;
+				resize_light_shadows(shadows, count, _shadow_atlas);
+
+				float splits[shadow_maps::MaxCascades + 1];
+				shadow_maps::compute_cascade_splits(near_clip, shadow_far_clip, count, light.directional_data.split_distribution, splits);
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					shadows.splits[i] = splits[i + 1];
+					auto& map = shadows.maps[i];
+					if (!allocate_map(map, CascadeShadowMapSize))
+						continue;
+
+					math::vec3 corners[8];
+					shadow_maps::get_frustum_corners(proj, near_clip, far_clip, splits[i], splits[i + 1], homogeneous_depth, corners);
+					const auto shadow_view = shadow_maps::compute_directional_view(
+						light_direction,
+						view,
+						corners,
+						map.rect.width(),
+						light.directional_data.stabilize,
+						CascadeCasterDistance,
+						homogeneous_depth);
+
+					update_map(map, shadow_view);
+				}
+			});
+		});
+
+		ecs.each<TransformComponent, LightComponent>([this, &allocate_map, &update_map, homogeneous_depth](
+			Entity e,
+			TransformComponent& transform_comp_ref,
+			LightComponent& light_comp_ref
+			)
+		{
+			const auto& light = light_comp_ref.get_light();
+			if (!light.casts_shadows || light.light_type == LightType::Directional)
+				return;
+
+			const auto& world_transform = transform_comp_ref.get_transform();
+			const auto& light_position = world_transform.get_position();
+			const auto& light_direction = world_transform.z_unit_axis();
+
+			auto& shadows = _local_shadows[e];
+			shadows.frame = _shadow_frame;
+			if (light.light_type == LightType::Spot)
+			{
+				resize_light_shadows(shadows, 1, _shadow_atlas);
+				if (!allocate_map(shadows.maps[0], SpotShadowMapSize))
+					return;
+
+				const auto shadow_view = shadow_maps::compute_spot_view(
+					light_position,
+					light_direction,
+					light.spot_data.get_outer_angle(),
+					light.spot_data.get_range(),
+					homogeneous_depth);
+
+				update_map(shadows.maps[0], shadow_view);
+			}
+			else
+			{
+				resize_light_shadows(shadows, 6, _shadow_atlas);
+				for (std::uint32_t face = 0; face < 6; ++face)
+				{
+					auto& map = shadows.maps[face];
+					if (!allocate_map(map, PointShadowMapSize))
+						continue;
+
+					const auto shadow_view = shadow_maps::compute_point_view(
+						light_position,
+						face,
+						light.point_data.range,
+						map.rect.width(),
+						PointShadowMapBorder,
+						homogeneous_depth);
+
+					update_map(map, shadow_view);
+				}
+			}
+		});
+
+		// Give back the tiles of lights and cameras that were not seen.
+		auto release_unused = [this](std::unordered_map<Entity, LightShadows>& light_shadows)
+		{
+			for (auto it = light_shadows.begin(); it != light_shadows.end();)
+			{
+				if (it->second.frame == _shadow_frame)
+				{
+					++it;
+					continue;
+				}
+
+				resize_light_shadows(it->second, 0, _shadow_atlas);
+				it = light_shadows.erase(it);
+			}
+		};
+
+		release_unused(_local_shadows);
+		for (auto it = _cascade_shadows.begin(); it != _cascade_shadows.end();)
+		{
+			release_unused(it->second);
+			if (it->second.empty())
+				it = _cascade_shadows.erase(it);
+			else
+				++it;
+		}
+	}
+
+	const LightShadows* DeferredRendering::find_light_shadows(Entity e, const Light& light, const Camera& camera) const
+	{
+		if (!light.casts_shadows || !_shadow_atlas_texture)
+			return nullptr;
+
+		const LightShadows* shadows = nullptr;
+		if (light.light_type == LightType::Directional)
+		{
+			auto camera_it = _cascade_shadows.find(&camera);
+			if (camera_it == _cascade_shadows.end())
+				return nullptr;
+
+			auto it = camera_it->second.find(e);
+			if (it == camera_it->second.end())
+				return nullptr;
+
+			shadows = &it->second;
+		}
+		else
+		{
+			auto it = _local_shadows.find(e);
+			if (it == _local_shadows.end())
+				return nullptr;
+
+			shadows = &it->second;
+		}
+
+		if (shadows->count == 0)
+			return nullptr;
+
+		for (std::uint32_t i = 0; i < shadows->count; ++i)
+		{
+			if (!shadows->maps[i].rendered)
+				return nullptr;
+		}
+
+		return shadows;
 	}
 
 
 	void DeferredRendering::camera_pass(EntityComponentSystem& ecs, std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Camera Passes");
 		ecs.each<CameraComponent>([this, &ecs, dt](
 			Entity ce,
 			CameraComponent& camera_comp
@@ -316,7 +861,7 @@ namespace runtime
 	{
 		std::shared_ptr<FrameBuffer> output = nullptr;
 
-		auto visibility_set = gather_visible_models(ecs, &camera, false, false, false);
+		auto visibility_set = gather_visible_models(ecs, &camera, 0, false, false);
 
 		output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
 
@@ -349,6 +894,15 @@ namespace runtime
 		pass.clear();
 		pass.set_view_proj(view, proj);
 
+		const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
+
+		// Lods are updated and the draws are prepared on the main thread, the
+		// draw calls of hardware meshes are then recorded by the task system
+		// workers and replayed in visibility set order.
+		core::frame_vector<GBufferDraw> draws;
+		core::frame_vector<GBufferDraw> main_thread_draws;
+		draws.reserve(visibility_set.size());
+
 		for(auto& element : visibility_set)
 		{
 			auto& e = std::get<0>(element);
@@ -367,7 +921,6 @@ namespace runtime
 				continue;
 
 			const auto& world_transform = transform_comp_ref.get_transform();
-			const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
 
 			auto& lod_data = camera_lods[e];
 			const auto transition_time = model.get_lod_transition_time();
@@ -411,54 +964,114 @@ namespace runtime
 					distance,
 					dt.count());
 			}
-			
-			const auto params = math::vec3{
+
+			GBufferDraw draw;
+			draw.model_comp = model_comp_ptr;
+			draw.world_transform = world_transform;
+			draw.current_lod_index = current_lod_index;
+			draw.target_lod_index = target_lod_index;
+			draw.transition = current_time != 0.0f;
+			draw.params = math::vec3{
 				0.0f,
 				-1.0f,
 				(transition_time - current_time) / transition_time
 			};
-
-			const auto params_inv = math::vec3{
+			draw.params_inv = math::vec3{
 				1.0f,
 				1.0f,
 				current_time / transition_time
 			};
 
+			// Programs are recreated when their shaders get reloaded, which
+			// has to happen here rather than on a worker. Both programs are
+			// primed, a material may be used by skinned and static meshes.
+			for (const auto& mat : model.get_materials())
+			{
+				if (mat)
+					mat->begin_pass();
+			}
+
+			const auto target_mesh = draw.transition ? model.get_lod(target_lod_index) : current_mesh;
+			const bool hardware = current_mesh->is_hardware_mesh() && (!target_mesh || target_mesh->is_hardware_mesh());
+			if (hardware)
+				draws.push_back(std::move(draw));
+			else
+				main_thread_draws.push_back(std::move(draw));
+		}
+
+		auto render_draw = [&camera, &clip_planes, &pass](const GBufferDraw& draw)
+		{
+			const auto& model = draw.model_comp->get_model();
+
 			model.render(
 				pass.id,
-				world_transform,
+				draw.world_transform,
 				true,
 				true,
 				true,
 				0,
-				current_lod_index,
+				draw.current_lod_index,
 				nullptr,
-				[&camera, &clip_planes, &params](Program& program)
+				[&camera, &clip_planes, &draw](Program& program)
 			{
 				program.set_uniform("u_camera_wpos", &camera.get_position());
 				program.set_uniform("u_camera_clip_planes", &clip_planes);
-				program.set_uniform("u_lod_params", &params);
-			});
+				program.set_uniform("u_lod_params", &draw.params);
+			},
+				draw.model_comp->get_skinning(draw.current_lod_index));
 
-			if (current_time != 0.0f)
+			if (draw.transition)
 			{
 				model.render(
 					pass.id,
-					world_transform,
+					draw.world_transform,
 					true,
 					true,
 					true,
 					0,
-					target_lod_index,
+					draw.target_lod_index,
 					nullptr,
-					[&camera, &clip_planes, &params_inv](Program& program)
+					[&draw](Program& program)
 				{
-					program.set_uniform("u_lod_params", &params_inv);
-				});
+					program.set_uniform("u_lod_params", &draw.params_inv);
+				},
+					draw.model_comp->get_skinning(draw.target_lod_index));
 			}
+		};
+
+		const std::uint32_t count = std::uint32_t(draws.size());
+		auto ts = core::get_subsystem<TaskSystem>();
+		if (ts == nullptr || count <= DrawsPerTask)
+		{
+			for (const auto& draw : draws)
+				render_draw(draw);
+		}
+		else
+		{
+			// One encoder per range rather than per thread keeps the replay
+			// order independent of which worker picked up which range.
+			const std::uint32_t range_count = (count + DrawsPerTask - 1) / DrawsPerTask;
+			if (_encoders.size() < range_count)
+				_encoders.resize(range_count);
 
+			auto master = ts->create_parallel_for("G-Buffer Recording", [this, &draws, &render_draw, count](std::uint32_t begin, std::uint32_t end)
+			{
+				gfx::EncoderScope scope(_encoders[begin / DrawsPerTask]);
+				for (std::uint32_t i = begin; i < end && i < count; ++i)
+					render_draw(draws[i]);
+			}, std::uint32_t(0), count, DrawsPerTask);
+			ts->run(master);
+			ts->wait(master);
+
+			// Replay right away so that everything submitted after this pass
+			// keeps its place relative to these draws.
+			for (std::uint32_t i = 0; i < range_count; ++i)
+				_encoders[i].replay();
 		}
 
+		for (const auto& draw : main_thread_draws)
+			render_draw(draw);
+
 		return g_buffer_fbo;
 	}
 
@@ -495,13 +1108,21 @@ namespace runtime
 
 		auto refl_buffer = render_view.get_texture("RBUFFER", viewport_size.width, viewport_size.height, false, 1, light_buffer_format).get();
 
-		ecs.each<TransformComponent, LightComponent>([this, bind_indirect_specular, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo, refl_buffer](
+		const bool clustered = _clustered_lighting && clustered_light_pass(pass.id, camera, render_view, ecs, g_buffer_fbo, refl_buffer);
+
+		ecs.each<TransformComponent, LightComponent>([this, bind_indirect_specular, clustered, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo, refl_buffer](
 			Entity e,
 			TransformComponent& transform_comp_ref,
 			LightComponent& light_comp_ref
 			)
 		{
 			const auto& light = light_comp_ref.get_light();
+			const auto shadows = find_light_shadows(e, light, camera);
+
+			// Lights with shadows are not shaded through the clusters.
+			if (clustered && light.light_type != LightType::Directional && !shadows)
+				return;
+
 			const auto& world_transform = transform_comp_ref.get_transform();
 			const auto& light_position = world_transform.get_position();
 			const auto& light_direction = world_transform.z_unit_axis();
@@ -556,6 +1177,32 @@ namespace runtime
 
 			if (program)
 			{
+				float shadow_params[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				if (shadows)
+				{
+					const bool directional = light.light_type == LightType::Directional;
+					math::mat4 shadow_matrices[6];
+					const float no_split = std::numeric_limits<float>::max();
+					float shadow_splits[4] = { no_split, no_split, no_split, no_split };
+					for (std::uint32_t i = 0; i < shadows->count; ++i)
+					{
+						shadow_matrices[i] = shadows->maps[i].atlas_matrix;
+						if (directional)
+							shadow_splits[i] = shadows->splits[i];
+					}
+					const float shadow_atlas[4] = { 1.0f / float(ShadowAtlasSize), float(ShadowAtlasSize), 0.0f, 0.0f };
+
+					shadow_params[0] = light.sm_impl == SmImpl::Hard ? 1.0f : 2.0f;
+					shadow_params[1] = directional ? DirectionalShadowBias : LocalShadowBias;
+					shadow_params[2] = directional ? DirectionalShadowNormalOffset : LocalShadowNormalOffset;
+					shadow_params[3] = float(shadows->count);
+					program->set_uniform("u_shadow_matrix", shadow_matrices, std::uint16_t(shadows->count));
+					program->set_uniform("u_shadow_splits", shadow_splits);
+					program->set_uniform("u_shadow_atlas", shadow_atlas);
+					program->set_texture(6, "s_tex6", _shadow_atlas_texture.get());
+				}
+				program->set_uniform("u_shadow_params", shadow_params);
+
 				float light_color_intensity[4] =
 				{
 					light.color.value.r,
@@ -587,6 +1234,193 @@ namespace runtime
 		return l_buffer_fbo;
 	}
 
+	bool DeferredRendering::clustered_light_pass(
+		std::uint8_t view_id,
+		Camera& camera,
+		RenderView& render_view,
+		EntityComponentSystem& ecs,
+		FrameBuffer* g_buffer_fbo,
+		Texture* refl_buffer)
+	{
+		if (!_clustered_light_program || !_clustered_light_program->begin_pass())
+			return false;
+
+		// Light lists are fetched from float textures.
+		static const bool supported =
+			gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_2D, gfx::TextureFormat::R32F) &&
+			gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_2D, gfx::TextureFormat::RG32F) &&
+			gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_2D, gfx::TextureFormat::RGBA32F);
+		if (!supported)
+			return false;
+
+		// Light data is four texels per light, so a row holds 256 lights.
+		const std::uint16_t data_texture_width = 1024;
+		const std::uint16_t index_texture_width = 1024;
+		const std::uint32_t sampler_flags = 0
+			| BGFX_TEXTURE_MIN_POINT
+			| BGFX_TEXTURE_MAG_POINT
+			| BGFX_TEXTURE_MIP_POINT
+			| BGFX_TEXTURE_U_CLAMP
+			| BGFX_TEXTURE_V_CLAMP;
+
+		const auto& view = camera.get_view();
+		core::frame_vector<LightClusters::Light> lights;
+		core::frame_vector<float> light_data;
+
+		ecs.each<TransformComponent, LightComponent>([this, &lights, &light_data, &view, &camera](
+			Entity e,
+			TransformComponent& transform_comp_ref,
+			LightComponent& light_comp_ref
+			)
+		{
+			const auto& light = light_comp_ref.get_light();
+			if (light.light_type != LightType::Point && light.light_type != LightType::Spot)
+				return;
+
+			// Drawn one by one by the lighting pass.
+			if (find_light_shadows(e, light, camera))
+				return;
+
+			const auto& world_transform = transform_comp_ref.get_transform();
+			const auto& light_position = world_transform.get_position();
+			const auto& light_direction = world_transform.z_unit_axis();
+			const bool spot = light.light_type == LightType::Spot;
+
+			LightClusters::Light cluster_light;
+			cluster_light.position = view.transform_coord(light_position);
+			cluster_light.direction = math::normalize(view.transform_normal(light_direction));
+			float data[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			if (spot)
+			{
+				const float half_angle = math::radians(light.spot_data.get_outer_angle() * 0.5f);
+				cluster_light.range = light.spot_data.get_range();
+				cluster_light.cos_half_angle = math::cos(half_angle);
+				cluster_light.sin_half_angle = math::sin(half_angle);
+				data[0] = light.spot_data.get_range();
+				data[1] = math::cos(math::radians(light.spot_data.get_inner_angle() * 0.5f));
+				data[2] = math::cos(half_angle);
+			}
+			else
+			{
+				cluster_light.range = light.point_data.range;
+				data[0] = light.point_data.range;
+				data[1] = light.point_data.exponent_falloff;
+			}
+			lights.push_back(cluster_light);
+
+			const float texels[16] =
+			{
+				light_position.x, light_position.y, light_position.z, cluster_light.range,
+				light_direction.x, light_direction.y, light_direction.z, spot ? 1.0f : 0.0f,
+				light.color.value.r, light.color.value.g, light.color.value.b, light.intensity,
+				data[0], data[1], data[2], data[3]
+			};
+			light_data.insert(light_data.end(), std::begin(texels), std::end(texels));
+		});
+
+		if (lights.empty())
+			return true;
+
+		_light_clusters.build(camera.get_projection(), camera.get_near_clip(), camera.get_far_clip(), gfx::is_homogeneous_depth());
+		_light_clusters.assign(lights.data(), lights.size());
+
+		// Reported when clusters start to overflow, not every frame they do.
+		const auto dropped = _light_clusters.get_dropped_count();
+		if (dropped > 0 && !_light_clusters_overflow)
+		{
+			APPLOG_WARNING("More than {0} lights affect some light clusters, {1} light(s) left out of them.",
+				std::uint32_t(LightClusters::MaxClusterLights), dropped);
+		}
+		_light_clusters_overflow = dropped > 0;
+
+		const auto& clusters = _light_clusters.get_clusters();
+		const auto& indices = _light_clusters.get_light_indices();
+
+		// Texture heights are rounded up to powers of two, so that the cached
+		// textures of the render view are not recreated for every light added.
+		// Counted in 32 bits, a scene with too many lights for the largest
+		// texture falls back to the per light pass instead of wrapping around.
+		auto get_rows = [](std::size_t texels, std::uint32_t width)
+		{
+			std::uint32_t rows = 1;
+			while (std::size_t(rows) * width < texels)
+				rows *= 2;
+			return rows;
+		};
+
+		const std::uint32_t max_size = gfx::getCaps()->limits.maxTextureSize;
+		const std::uint32_t cluster_columns = _light_clusters.get_tiles_x() * _light_clusters.get_tiles_y();
+		const std::uint32_t index_rows = get_rows(indices.size(), index_texture_width);
+		const std::uint32_t data_rows = get_rows(light_data.size() / 4, data_texture_width);
+		if (cluster_columns > max_size || _light_clusters.get_slices() > max_size || index_rows > max_size || data_rows > max_size)
+			return false;
+
+		const auto cluster_width = std::uint16_t(cluster_columns);
+		const auto cluster_height = std::uint16_t(_light_clusters.get_slices());
+		const auto index_height = std::uint16_t(index_rows);
+		const auto data_height = std::uint16_t(data_rows);
+
+		auto cluster_texture = render_view.get_texture("LIGHT_CLUSTERS", cluster_width, cluster_height, false, 1, gfx::TextureFormat::RG32F, sampler_flags);
+		auto index_texture = render_view.get_texture("LIGHT_INDICES", index_texture_width, index_height, false, 1, gfx::TextureFormat::R32F, sampler_flags);
+		auto data_texture = render_view.get_texture("LIGHT_DATA", data_texture_width, data_height, false, 1, gfx::TextureFormat::RGBA32F, sampler_flags);
+
+		{
+			auto mem = gfx::alloc(std::uint32_t(clusters.size() * 2 * sizeof(float)));
+			auto dst = reinterpret_cast<float*>(mem->data);
+			for (const auto& cluster : clusters)
+			{
+				*dst++ = float(cluster.offset);
+				*dst++ = float(cluster.count);
+			}
+			gfx::updateTexture2D(cluster_texture->handle, 0, 0, 0, 0, cluster_width, cluster_height, mem);
+		}
+		{
+			auto mem = gfx::alloc(std::uint32_t(index_texture_width) * index_height * sizeof(float));
+			auto dst = reinterpret_cast<float*>(mem->data);
+			std::fill(dst, dst + std::size_t(index_texture_width) * index_height, 0.0f);
+			for (std::size_t i = 0; i < indices.size(); ++i)
+				dst[i] = float(indices[i]);
+			gfx::updateTexture2D(index_texture->handle, 0, 0, 0, 0, index_texture_width, index_height, mem);
+		}
+		{
+			auto mem = gfx::alloc(std::uint32_t(data_texture_width) * data_height * 4 * sizeof(float));
+			auto dst = reinterpret_cast<float*>(mem->data);
+			std::fill(dst, dst + std::size_t(data_texture_width) * data_height * 4, 0.0f);
+			std::copy(light_data.begin(), light_data.end(), dst);
+			gfx::updateTexture2D(data_texture->handle, 0, 0, 0, 0, data_texture_width, data_height, mem);
+		}
+
+		const float grid[4] = { float(_light_clusters.get_tiles_x()), float(_light_clusters.get_tiles_y()), float(_light_clusters.get_slices()), 0.0f };
+		const float slicing[4] = { _light_clusters.get_slice_scale(), _light_clusters.get_slice_bias(), 0.0f, 0.0f };
+		const float texture_sizes[4] = { float(index_texture_width), float(index_height), float(data_texture_width), float(data_height) };
+
+		auto program = _clustered_light_program.get();
+		program->set_uniform("u_camera_position", &camera.get_position());
+		program->set_uniform("u_cluster_grid", grid);
+		program->set_uniform("u_cluster_slicing", slicing);
+		program->set_uniform("u_cluster_textures", texture_sizes);
+		program->set_texture(0, "s_tex0", gfx::getTexture(g_buffer_fbo->handle, 0));
+		program->set_texture(1, "s_tex1", gfx::getTexture(g_buffer_fbo->handle, 1));
+		program->set_texture(2, "s_tex2", gfx::getTexture(g_buffer_fbo->handle, 2));
+		program->set_texture(3, "s_tex3", gfx::getTexture(g_buffer_fbo->handle, 3));
+		program->set_texture(4, "s_tex4", gfx::getTexture(g_buffer_fbo->handle, 4));
+		program->set_texture(5, "s_tex5", refl_buffer->handle);
+		program->set_texture(6, "s_tex6", cluster_texture.get());
+		program->set_texture(7, "s_tex7", index_texture.get());
+		program->set_texture(8, "s_tex8", data_texture.get());
+
+		auto topology = gfx::clip_quad(1.0f);
+		gfx::setState(topology
+			| BGFX_STATE_RGB_WRITE
+			| BGFX_STATE_ALPHA_WRITE
+			| BGFX_STATE_BLEND_ADD
+		);
+		gfx::submit(view_id, program->handle);
+		gfx::setState(BGFX_STATE_DEFAULT);
+
+		return true;
+	}
+
 	std::shared_ptr<FrameBuffer> DeferredRendering::reflection_probe_pass(
 		std::shared_ptr<FrameBuffer> input,
 		Camera& camera,
@@ -661,7 +1495,7 @@ namespace runtime
 				program->set_uniform("u_inv_world", &u_inv_world);
 				program->set_uniform("u_data2", data2);
 				
-				influence_radius = math::length(t.get_scale() + probe.box_data.transition_distance);
+				influence_radius = math::length(math::abs(t.get_scale()) + probe.box_data.transition_distance);
 			}
 
 			if (program)
@@ -806,6 +1640,7 @@ namespace runtime
 	void DeferredRendering::receive(Entity e)
 	{
 		_lod_data.erase(e);
+		_probe_updates.erase(e);
 		for (auto& pair : _lod_data)
 		{
 			pair.second.erase(e);
@@ -832,6 +1667,12 @@ namespace runtime
 				_spot_light_program = std::make_unique<Program>(vs, fs);
 			});
 
+			am->load<Shader>("engine_data:/shaders/fs_deferred_clustered_light", false)
+				.then([this, vs](auto fs)
+			{
+				_clustered_light_program = std::make_unique<Program>(vs, fs);
+			});
+
 			am->load<Shader>("engine_data:/shaders/fs_deferred_directional_light", false)
 				.then([this, vs](auto fs)
 			{
@@ -845,6 +1686,26 @@ namespace runtime
 			});
 		});
 
+		am->load<Shader>("engine_data:/shaders/vs_shadow", false)
+			.then([this, am](auto vs)
+		{
+			am->load<Shader>("engine_data:/shaders/fs_shadow", false)
+				.then([this, vs](auto fs)
+			{
+				_shadow_program = std::make_unique<Program>(vs, fs);
+			});
+		});
+
+		am->load<Shader>("engine_data:/shaders/vs_shadow_skinned", false)
+			.then([this, am](auto vs)
+		{
+			am->load<Shader>("engine_data:/shaders/fs_shadow", false)
+				.then([this, vs](auto fs)
+			{
+				_shadow_skinned_program = std::make_unique<Program>(vs, fs);
+			});
+		});
+
 		am->load<Shader>("engine_data:/shaders/vs_clip_quad_ex", false)
 			.then([this, am](auto vs)
 		{
@@ -1,15 +1,20 @@
 #pragma once
 
 #include "../ecs.h"
+#include "core/memory/frame_allocator.hpp"
 #include <vector>
 #include <memory>
 #include <chrono>
 #include <tuple>
+#include <array>
 #include "../../rendering/program.h"
+#include "../../rendering/light_clusters.h"
+#include "../../rendering/shadow_maps.h"
 #include "../components/transform_component.h"
 #include "../components/model_component.h"
 
 class Camera;
+struct Light;
 class RenderView;
 
 
@@ -22,8 +27,94 @@ namespace runtime
 		float current_time = 0.0f;
 	};
 
+	//-----------------------------------------------------------------------------
+	//  Name : ShadowMap (Struct)
+	/// <summary>
+	/// One shadow map of a light, rendered into a tile of the shadow atlas.
+	/// What it was rendered with is kept so that it is only rendered again
+	/// when the view or its casters change.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct ShadowMap
+	{
+		/// Tile of the shadow atlas, may be smaller than requested when the
+		/// atlas is full.
+		uRect rect = uRect(0, 0, 0, 0);
+		/// Requested size of the tile.
+		std::uint32_t size = 0;
+		/// View projection it was rendered with.
+		math::mat4 view_proj;
+		/// Takes world positions to the tile, for sampling.
+		math::mat4 atlas_matrix;
+		/// Change version it is up to date with.
+		std::uint64_t version = 0;
+		/// Casters it was rendered with.
+		std::vector<Entity> casters;
+		/// False until it was rendered into its current tile.
+		bool rendered = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : LightShadows (Struct)
+	/// <summary>
+	/// Shadow maps of a light. Spot lights have one, point lights one per cube
+	/// face and directional lights one per cascade.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct LightShadows
+	{
+		std::array<ShadowMap, 6> maps;
+		std::uint32_t count = 0;
+		/// Far distance of every cascade.
+		float splits[shadow_maps::MaxCascades] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		/// Last frame the light needed them.
+		std::uint64_t frame = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : ProbeUpdate (Struct)
+	/// <summary>
+	/// Faces of a reflection probe waiting to be rendered again, along with the
+	/// face frustums for the transform of the probe.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct ProbeUpdate
+	{
+		/// Transform the frustums were built for.
+		math::transform_t transform;
+		std::array<math::frustum, 6> frustums;
+		/// One bit per face waiting to be rendered.
+		std::uint32_t dirty_faces = 0;
+		/// Frames the probe waited with dirty faces, raises its priority.
+		std::uint32_t waiting_frames = 0;
+		/// Last frame the probe was seen.
+		std::uint64_t frame = 0;
+		bool valid = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : ReflectionStats (Struct)
+	/// <summary>
+	/// Work done by the reflection probe updates.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct ReflectionStats
+	{
+		/// Faces rendered during the last frame.
+		std::uint32_t faces_rendered = 0;
+		/// Faces left waiting for the next frames.
+		std::uint32_t faces_pending = 0;
+		/// Time of the last update, in seconds.
+		double update_time = 0.0;
+		/// Mean and standard deviation of the update time over the last
+		/// frames, in seconds.
+		double update_time_mean = 0.0;
+		double update_time_deviation = 0.0;
+	};
+
 	using Element = std::tuple<Entity, CHandle<TransformComponent>, CHandle<ModelComponent>>;
-	using VisibilitySetModels = std::vector<Element>;
+	// Visibility sets are rebuilt every frame and live in frame memory.
+	using VisibilitySetModels = core::frame_vector<Element>;
 
 	class DeferredRendering : public core::Subsystem
 	{
@@ -33,12 +124,13 @@ namespace runtime
 		//-----------------------------------------------------------------------------
 		//  Name : gather_visible_models ()
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Collects the models inside the camera frustum, or all of them when no
+		/// camera is given. When changed_since is not zero only models whose
+		/// transform or model component changed after that change version are
+		/// collected (see EntityComponentSystem::get_change_version).
 		/// </summary>
 		//-----------------------------------------------------------------------------
-		VisibilitySetModels gather_visible_models(EntityComponentSystem& ecs, Camera* camera, bool dirty_only = false, bool static_only = true, bool require_reflection_caster = false);
+		VisibilitySetModels gather_visible_models(EntityComponentSystem& ecs, Camera* camera, std::uint64_t changed_since = 0, bool static_only = true, bool require_reflection_caster = false);
 		//-----------------------------------------------------------------------------
 		//  Name : frame_render (virtual )
 		/// <summary>
@@ -82,19 +174,61 @@ namespace runtime
 		//-----------------------------------------------------------------------------
 		//  Name : build_reflections ()
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Renders the faces of the reflection probes that need it. Faces are
+		/// marked when the probe changes or when a model changes inside of
+		/// their frustum, and rendered a few per frame within the face budget,
+		/// probes close to a camera first.
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		void build_reflections_pass(EntityComponentSystem& ecs, std::chrono::duration<float> dt);
 
+		//-----------------------------------------------------------------------------
+		//  Name : set_reflection_face_budget ()
+		/// <summary>
+		/// Sets how many reflection probe faces may be rendered per frame, zero
+		/// renders all of them right away.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline void set_reflection_face_budget(std::uint32_t budget) { _reflection_face_budget = budget; }
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_reflection_face_budget ()
+		/// <summary>
+		/// Returns how many reflection probe faces may be rendered per frame.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline std::uint32_t get_reflection_face_budget() const { return _reflection_face_budget; }
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_reflection_stats ()
+		/// <summary>
+		/// Returns what the reflection probe updates did during the last frame.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline const ReflectionStats& get_reflection_stats() const { return _reflection_stats; }
+
+		//-----------------------------------------------------------------------------
+		//  Name : update_skinning ()
+		/// <summary>
+		/// Computes the skinning palettes of all skinned models for the frame.
+		/// The bone transforms are gathered on the main thread and the palettes
+		/// are evaluated on the task system, then uploaded once to the transform
+		/// cache of the frame for every pass rendering the model afterwards.
+		/// Models whose palettes do not fit in the budget of the frame are
+		/// drawn in bind pose.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void update_skinning(EntityComponentSystem& ecs);
+
 		//-----------------------------------------------------------------------------
 		//  Name : build_shadows ()
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Renders the shadow maps of the lights into the shadow atlas. Cascades
+		/// of directional lights are built for every camera, spot and point
+		/// lights are shared by all of them. A shadow map is only rendered again
+		/// when its view changed or when a caster inside of it, or one that was
+		/// inside of it, changed. Maps containing non static casters are
+		/// rendered every frame.
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		void build_shadows_pass(EntityComponentSystem& ecs, std::chrono::duration<float> dt);
@@ -156,6 +290,39 @@ namespace runtime
 			std::chrono::duration<float> dt,
 			bool bind_indirect_specular);
 
+		//-----------------------------------------------------------------------------
+		//  Name : clustered_light_pass ()
+		/// <summary>
+		/// Bins the point and spot lights into the clusters of the camera and
+		/// shades all of them in a single full screen draw. Returns false if the
+		/// renderer or the shaders do not support it, the lights then have to be
+		/// drawn one by one.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool clustered_light_pass(
+			std::uint8_t view_id,
+			Camera& camera,
+			RenderView& render_view,
+			EntityComponentSystem& ecs,
+			FrameBuffer* g_buffer_fbo,
+			Texture* refl_buffer);
+
+		//-----------------------------------------------------------------------------
+		//  Name : set_clustered_lighting ()
+		/// <summary>
+		/// Enables or disables clustered shading of point and spot lights.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline void set_clustered_lighting(bool enabled) { _clustered_lighting = enabled; }
+
+		//-----------------------------------------------------------------------------
+		//  Name : is_clustered_lighting ()
+		/// <summary>
+		/// Returns true if point and spot lights are shaded through clusters.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		inline bool is_clustered_lighting() const { return _clustered_lighting; }
+
 		//-----------------------------------------------------------------------------
 		//  Name : reflection_probe ()
 		/// <summary>
@@ -199,7 +366,49 @@ namespace runtime
 			Camera& camera,
 			RenderView& render_view);
 	private:
+		//-----------------------------------------------------------------------------
+		//  Name : find_light_shadows ()
+		/// <summary>
+		/// Returns the shadow maps a light is shaded with for the camera, if all
+		/// of them are ready.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		const LightShadows* find_light_shadows(Entity e, const Light& light, const Camera& camera) const;
+
 		std::unordered_map<Entity, std::unordered_map<Entity, LodData>> _lod_data;
+		/// Shadow maps of spot and point lights.
+		std::unordered_map<Entity, LightShadows> _local_shadows;
+		/// Cascades of directional lights, per camera.
+		std::unordered_map<const Camera*, std::unordered_map<Entity, LightShadows>> _cascade_shadows;
+		/// Allocates the tiles of the shadow maps.
+		shadow_maps::ShadowAtlas _shadow_atlas;
+		/// Depth texture all shadow maps are rendered into.
+		std::shared_ptr<Texture> _shadow_atlas_texture;
+		std::shared_ptr<FrameBuffer> _shadow_atlas_fbo;
+		/// Counts the shadow passes, to find lights that went away.
+		std::uint64_t _shadow_frame = 0;
+		/// Encoders the g-buffer pass records into, kept between frames.
+		std::vector<gfx::Encoder> _encoders;
+		/// Light assignment of the clustered lighting pass.
+		LightClusters _light_clusters;
+		/// Some clusters listed too many lights during the last frame.
+		bool _light_clusters_overflow = false;
+		/// Some skinned models did not fit in the skinning budget last frame.
+		bool _skinning_overflow = false;
+		/// Shade point and spot lights through clusters when supported.
+		bool _clustered_lighting = true;
+		/// Change version up to which the reflection probes are up to date.
+		std::uint64_t _reflections_version = 0;
+		/// Counts the reflection passes, to find probes that went away.
+		std::uint64_t _reflections_frame = 0;
+		/// Pending faces and cached frustums of every probe.
+		std::unordered_map<Entity, ProbeUpdate> _probe_updates;
+		/// Probe faces rendered per frame at most, zero for no limit.
+		std::uint32_t _reflection_face_budget = 2;
+		/// Update times of the last frames, for the statistics.
+		std::array<double, 120> _reflection_times = {};
+		std::uint32_t _reflection_time_count = 0;
+		ReflectionStats _reflection_stats;
 		/// Program that is responsible for rendering.
 		std::unique_ptr<Program> _directional_light_program;
 		/// Program that is responsible for rendering.
@@ -207,6 +416,12 @@ namespace runtime
 		/// Program that is responsible for rendering.
 		std::unique_ptr<Program> _spot_light_program;
 		/// Program that is responsible for rendering.
+		std::unique_ptr<Program> _clustered_light_program;
+		/// Program that is responsible for rendering.
+		std::unique_ptr<Program> _shadow_program;
+		/// Program that is responsible for rendering.
+		std::unique_ptr<Program> _shadow_skinned_program;
+		/// Program that is responsible for rendering.
 		std::unique_ptr<Program> _box_ref_probe_program;
 		/// Program that is responsible for rendering.
 		std::unique_ptr<Program> _sphere_ref_probe_program;
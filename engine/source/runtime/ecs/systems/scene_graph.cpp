@@ -1,6 +1,7 @@
 #include "scene_graph.h"
 #include "../components/transform_component.h"
 #include "../../system/engine.h"
+#include "core/profiling/profiler.h"
 namespace runtime
 {
 	void update_transform(CHandle<TransformComponent> hTransform, std::chrono::duration<float> dt)
@@ -20,6 +21,7 @@ namespace runtime
 
 	void SceneGraph::frame_update(std::chrono::duration<float> dt)
 	{
+		PROFILE_SCOPE("Scene Graph");
 		auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
 		_roots.clear();
 		ecs->each<TransformComponent>([this](runtime::Entity e, TransformComponent& transformComponent)
@@ -1,13 +1,113 @@
 #include "utils.h"
 #include "core/serialization/serialization.h"
 #include "core/serialization/archives.h"
+#include "core/serialization/cereal/types/string.hpp"
+#include "core/logging/logging.h"
 #include "../Meta/Ecs/Entity.hpp"
 #include "../assets/asset_extensions.h"
+#include "components/transform_component.h"
+#include "../assets/asset_manager.h"
+#include "../rendering/mesh.h"
+#include "../rendering/model.h"
+#include <sstream>
+#include <limits>
 
 namespace ecs
 {
 	namespace utils
 	{
+		namespace
+		{
+			/// Written in front of binary data. Json data always starts with '{'
+			/// so the two formats can never be confused. The fields are written
+			/// one by one in little endian order, so the header reads the same
+			/// on every platform.
+			struct BinaryHeader
+			{
+				static const std::uint32_t MAGIC = 0x42534345; // 'ECSB'
+				/// Bump whenever a serialized type changes, binary archives can
+				/// not skip or default fields the way json archives do. The
+				/// loaders of changed types check getSerializationVersion() to
+				/// keep reading the older versions.
+				/// 2: Light::casts_shadows
+				static const std::uint32_t VERSION = 2;
+				static const std::uint32_t MIN_VERSION = 1;
+				static const std::size_t SIZE = 16;
+
+				std::uint32_t magic = MAGIC;
+				std::uint32_t version = VERSION;
+				/// Total number of entities in the stream (including children).
+				std::uint64_t entity_count = 0;
+			};
+
+			template<typename T>
+			void write_little_endian(char* bytes, T value)
+			{
+				for (std::size_t i = 0; i < sizeof(T); ++i)
+					bytes[i] = static_cast<char>((value >> (i * 8)) & 0xff);
+			}
+
+			template<typename T>
+			T read_little_endian(const char* bytes)
+			{
+				T value = 0;
+				for (std::size_t i = 0; i < sizeof(T); ++i)
+					value |= static_cast<T>(static_cast<unsigned char>(bytes[i])) << (i * 8);
+				return value;
+			}
+
+			void write_binary_header(std::ostream& stream, const BinaryHeader& header)
+			{
+				char bytes[BinaryHeader::SIZE];
+				write_little_endian(bytes, header.magic);
+				write_little_endian(bytes + 4, header.version);
+				write_little_endian(bytes + 8, header.entity_count);
+				stream.write(bytes, BinaryHeader::SIZE);
+			}
+
+			/// Returns false for json data, and for binary data of a version
+			/// that can not be read, in which case the magic of the header
+			/// still matches.
+			bool read_binary_header(std::istream& stream, std::streampos length, BinaryHeader& header)
+			{
+				header.magic = 0;
+				if (length < static_cast<std::streampos>(BinaryHeader::SIZE))
+					return false;
+
+				char bytes[BinaryHeader::SIZE];
+				stream.read(bytes, BinaryHeader::SIZE);
+				if (stream)
+				{
+					header.magic = read_little_endian<std::uint32_t>(bytes);
+					header.version = read_little_endian<std::uint32_t>(bytes + 4);
+					header.entity_count = read_little_endian<std::uint64_t>(bytes + 8);
+					if (header.magic == BinaryHeader::MAGIC && header.version >= BinaryHeader::MIN_VERSION &&
+						header.version <= BinaryHeader::VERSION)
+						return true;
+				}
+
+				stream.clear();
+				stream.seekg(0, stream.beg);
+				return false;
+			}
+
+			void create_armature_node(runtime::EntityComponentSystem& ecs, runtime::CHandle<TransformComponent> parent, const Mesh::ArmatureNode& node)
+			{
+				for (const auto& child : node.children)
+				{
+					if (!child)
+						continue;
+
+					auto entity = ecs.create();
+					entity.set_name(child->name);
+					auto transform_comp = entity.assign<TransformComponent>().lock();
+					transform_comp->set_local_transform(child->transform);
+					transform_comp->set_parent(parent, false, true);
+					create_armature_node(ecs, transform_comp->handle(), *child);
+				}
+			}
+		}
+
 		void save_entity(const fs::path& dir, const runtime::Entity& data)
 		{
 			const fs::path fullPath = dir / fs::path(data.to_string() + extensions::prefab);
@@ -27,10 +127,10 @@ namespace ecs
 		}
 
 
-		void save_data(const fs::path& fullPath, const std::vector<runtime::Entity>& data)
+		void save_data(const fs::path& fullPath, const std::vector<runtime::Entity>& data, DataFormat format)
 		{
 			std::ofstream os(fullPath, std::fstream::binary | std::fstream::trunc);
-			serialize_data(os, data);
+			serialize_data(os, data, format);
 		}
 
 		bool load_data(const fs::path& fullPath, std::vector<runtime::Entity>& outData)
@@ -39,11 +139,30 @@ namespace ecs
 			return deserialize_data(is, outData);
 		}
 
-		void serialize_data(std::ostream& stream, const std::vector<runtime::Entity>& data)
+		void serialize_data(std::ostream& stream, const std::vector<runtime::Entity>& data, DataFormat format)
 		{
-			cereal::oarchive_json_t ar(stream);
+			if (format == DataFormat::Binary)
+			{
+				// The entity count is only known once the hierarchy has been
+				// walked, so serialize the body first and prepend the header.
+				std::stringstream body(std::ios::in | std::ios::out | std::ios::binary);
+				{
+					cereal::oarchive_binary_t ar(body);
+
+					try_save(ar, cereal::make_nvp("data", data));
+				}
+
+				BinaryHeader header;
+				header.entity_count = getSerializationMap().size();
+				write_binary_header(stream, header);
+				stream << body.rdbuf();
+			}
+			else
+			{
+				cereal::oarchive_json_t ar(stream);
 
-			try_save(ar, cereal::make_nvp("data", data));
+				try_save(ar, cereal::make_nvp("data", data));
+			}
 
 			getSerializationMap().clear();
 		}
@@ -57,9 +176,37 @@ namespace ecs
 			stream.seekg(0, stream.beg);
 			if (length > 0)
 			{
-				cereal::iarchive_json_t ar(stream);
+				BinaryHeader header;
+				if (read_binary_header(stream, length, header))
+				{
+					// Allocate entity slots and component storage for the whole
+					// batch up front instead of growing them entity by entity.
+					auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+					ecs->reserve(static_cast<std::size_t>(header.entity_count));
+
+					// older versions are migrated by the loaders of the types
+					// that changed since
+					getSerializationVersion() = header.version;
+					{
+						cereal::iarchive_binary_t ar(stream);
 
-				try_load(ar, cereal::make_nvp("data", outData));
+						try_load(ar, cereal::make_nvp("data", outData));
+					}
+					getSerializationVersion() = std::numeric_limits<std::uint32_t>::max();
+				}
+				else if (header.magic == BinaryHeader::MAGIC)
+				{
+					APPLOG_ERROR("Binary entity data of version {0} can not be loaded, supported versions are {1} to {2}.",
+						header.version, BinaryHeader::MIN_VERSION, BinaryHeader::VERSION);
+					getSerializationMap().clear();
+					return false;
+				}
+				else
+				{
+					cereal::iarchive_json_t ar(stream);
+
+					try_load(ar, cereal::make_nvp("data", outData));
+				}
 
 				stream.clear();
 				stream.seekg(0);
@@ -68,5 +215,70 @@ namespace ecs
 			}
 			return false;
 		}
+
+		void create_armature(runtime::Entity root, const Mesh& mesh)
+		{
+			const auto armature = mesh.get_armature();
+			if (!armature || !mesh.get_skin_bind_data().has_bones() || !root.has_component<TransformComponent>())
+				return;
+
+			auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+			create_armature_node(*ecs, root.component<TransformComponent>(), *armature);
+		}
+
+		void save_mesh_lods(const fs::path& fullPath, const std::vector<std::string>& lods)
+		{
+			std::ofstream os(fullPath, std::fstream::binary | std::fstream::trunc);
+			cereal::oarchive_json_t ar(os);
+
+			try_save(ar, cereal::make_nvp("lods", lods));
+		}
+
+		bool load_mesh_lods(const fs::path& fullPath, std::vector<std::string>& outLods)
+		{
+			outLods.clear();
+			std::ifstream is(fullPath, std::fstream::binary);
+			if (!is)
+				return false;
+
+			cereal::iarchive_json_t ar(is);
+
+			return try_load(ar, cereal::make_nvp("lods", outLods));
+		}
+
+		Model create_model(AssetHandle<Mesh> mesh)
+		{
+			Model model;
+			if (!mesh)
+				return model;
+
+			model.set_lod(mesh, 0);
+
+			const std::string& key = mesh.id();
+			if (key.empty() || key.find("embedded") != std::string::npos)
+				return model;
+
+			std::vector<std::string> lods;
+			if (!load_mesh_lods(fs::resolve_protocol(key + extensions::mesh_lods), lods))
+				return model;
+
+			// the levels are listed by name, next to the mesh
+			const std::string dir = key.substr(0, key.find_last_of('/') + 1);
+			auto am = core::get_subsystem<runtime::AssetManager>();
+			std::uint32_t lod = 1;
+			for (const auto& name : lods)
+			{
+				auto lod_mesh = am->load<Mesh>(dir + name, false).asset;
+				if (!lod_mesh)
+				{
+					APPLOG_WARNING("Level of detail {0} of {1} could not be loaded.", name, key);
+					continue;
+				}
+
+				model.set_lod(lod_mesh, lod++);
+			}
+
+			return model;
+		}
 	}
 }
@@ -4,12 +4,21 @@
 #include <vector>
 #include <fstream>
 #include "../system/filesystem.h"
+#include "../assets/asset_handle.h"
 
+class Mesh;
+class Model;
 
 namespace ecs
 {
 	namespace utils
 	{
+		enum class DataFormat : std::uint32_t
+		{
+			Json = 0,
+			Binary = 1
+		};
+
 		//-----------------------------------------------------------------------------
 		//  Name : save_entity ()
 		/// <summary>
@@ -38,14 +47,13 @@ namespace ecs
 		/// 
 		/// </summary>
 		//-----------------------------------------------------------------------------
-		void save_data(const fs::path& fullPath, const std::vector<runtime::Entity>& data);
+		void save_data(const fs::path& fullPath, const std::vector<runtime::Entity>& data, DataFormat format = DataFormat::Json);
 
 		//-----------------------------------------------------------------------------
 		//  Name : load_data ()
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Loads entities from a file. The format (json or binary) is detected
+		/// from the file contents.
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		bool load_data(const fs::path& fullPath, std::vector<runtime::Entity>& outData);
@@ -58,16 +66,55 @@ namespace ecs
 		/// 
 		/// </summary>
 		//-----------------------------------------------------------------------------
-		void serialize_data(std::ostream& stream, const std::vector<runtime::Entity>& data);
+		void serialize_data(std::ostream& stream, const std::vector<runtime::Entity>& data, DataFormat format = DataFormat::Json);
 
 		//-----------------------------------------------------------------------------
 		//  Name : deserialize_data ()
 		/// <summary>
-		/// 
-		/// 
-		/// 
+		/// Deserializes entities from a stream. Binary streams are recognized by
+		/// their header, which also carries the entity count so that the entity
+		/// component system can allocate storage for all of them up front.
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		bool deserialize_data(std::istream& stream, std::vector<runtime::Entity>& outData);
+
+		//-----------------------------------------------------------------------------
+		//  Name : create_armature ()
+		/// <summary>
+		/// Creates an entity for every node of the armature of a skinned mesh,
+		/// below the root entity and named after the nodes, so that the bones of
+		/// a model using the mesh find them. Does nothing for meshes without a
+		/// skin.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void create_armature(runtime::Entity root, const Mesh& mesh);
+
+		//-----------------------------------------------------------------------------
+		//  Name : save_mesh_lods ()
+		/// <summary>
+		/// Writes the levels of detail compiled for a mesh, in order, by their
+		/// names relative to the directory of the mesh.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void save_mesh_lods(const fs::path& fullPath, const std::vector<std::string>& lods);
+
+		//-----------------------------------------------------------------------------
+		//  Name : load_mesh_lods ()
+		/// <summary>
+		/// Reads the levels of detail listed by save_mesh_lods. Returns false if
+		/// there is no such list.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool load_mesh_lods(const fs::path& fullPath, std::vector<std::string>& outLods);
+
+		//-----------------------------------------------------------------------------
+		//  Name : create_model ()
+		/// <summary>
+		/// Creates a model that shows the mesh, with the levels of detail the
+		/// asset compiler listed next to it (<name>.lods) attached in order.
+		/// Embedded meshes have no levels of detail.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		Model create_model(AssetHandle<Mesh> mesh);
 	}
 }
@@ -4,6 +4,7 @@
 #include "core/serialization/serialization.h"
 #include "core/serialization/cereal/types/vector.hpp"
 #include "core/logging/logging.h"
+#include <limits>
 
 inline std::map<uint32_t, runtime::Entity>& getSerializationMap()
 {
@@ -12,6 +13,15 @@ inline std::map<uint32_t, runtime::Entity>& getSerializationMap()
 	return serializationMap;
 }
 
+inline std::uint32_t& getSerializationVersion()
+{
+	/// Version of the binary entity data being loaded, for the loaders of
+	/// types that gained fields since. Json data and saving always use the
+	/// latest version.
+	static std::uint32_t serializationVersion = std::numeric_limits<std::uint32_t>::max();
+	return serializationVersion;
+}
+
 
 namespace runtime
 {
@@ -4,6 +4,7 @@
 #include "core/reflection/reflection.h"
 #include "core/logging/logging.h"
 #include "../../rendering/light.h"
+#include "../ecs/entity.hpp"
 
 REFLECT(Light)
 {
@@ -95,6 +96,7 @@ REFLECT(Light)
 			rttr::metadata("Max", 10.0f)
 		)
 		.property("Type", &Light::light_type)
+		.property("Casts Shadows", &Light::casts_shadows)
 		.property("Shadows", &Light::sm_impl)
 		.property("Depth", &Light::depth_impl)
 		;
@@ -118,6 +120,7 @@ SAVE(Light)
 	try_save(ar, cereal::make_nvp("dir_stabilize", obj.directional_data.stabilize));
 	try_save(ar, cereal::make_nvp("intensity", obj.intensity));
 	try_save(ar, cereal::make_nvp("color", obj.color));
+	try_save(ar, cereal::make_nvp("casts_shadows", obj.casts_shadows));
 }
 
 LOAD(Light)
@@ -138,4 +141,7 @@ LOAD(Light)
 	try_load(ar, cereal::make_nvp("dir_stabilize", obj.directional_data.stabilize));
 	try_load(ar, cereal::make_nvp("intensity", obj.intensity));
 	try_load(ar, cereal::make_nvp("color", obj.color));
+	// binary entity data before version 2 has no shadow flag
+	if (getSerializationVersion() >= 2)
+		try_load(ar, cereal::make_nvp("casts_shadows", obj.casts_shadows));
 }
\ No newline at end of file
@@ -109,6 +109,7 @@ SAVE(Mesh::LoadData)
 	try_save(ar, cereal::make_nvp("triangle_data", obj.triangle_data));
 	try_save(ar, cereal::make_nvp("skin_data", obj.skin_data));
 	try_save(ar, cereal::make_nvp("root_node", obj.root_node));
+	try_save(ar, cereal::make_nvp("position_decode", obj.position_decode));
 }
 
 LOAD(Mesh::LoadData)
@@ -120,5 +121,6 @@ LOAD(Mesh::LoadData)
 	try_load(ar, cereal::make_nvp("triangle_data", obj.triangle_data));
 	try_load(ar, cereal::make_nvp("skin_data", obj.skin_data));
 	try_load(ar, cereal::make_nvp("root_node", obj.root_node));
+	try_load(ar, cereal::make_nvp("position_decode", obj.position_decode));
 }
 
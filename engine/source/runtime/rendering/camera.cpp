@@ -508,7 +508,7 @@ math::vec3 Camera::estimate_pick_tolerance(float WireTolerance, const math::vec3
 
 	// Convert into object space tolerance.
 	math::vec3 ObjectWireTolerance;
-	math::vec3 vAxisScale = ObjectTransform.get_scale();
+	math::vec3 vAxisScale = math::abs(ObjectTransform.get_scale());
 	ObjectWireTolerance.x = WireTolerance / vAxisScale.x;
 	ObjectWireTolerance.y = WireTolerance / vAxisScale.y;
 	ObjectWireTolerance.z = WireTolerance / vAxisScale.z;
@@ -51,6 +51,8 @@ struct DebugVertex
 
 bgfx::VertexDecl DebugVertex::ms_decl;
 
+BX_STATIC_ASSERT(sizeof(DebugVertex) == sizeof(DdVertex), "DdVertex must match DebugVertex.");
+
 struct DebugUvVertex
 {
 	float m_x;
@@ -802,6 +804,7 @@ struct DebugDraw
 		m_mtx = 0;
 		m_state = State::None;
 		m_stack = 0;
+		m_drawCalls = 0;
 
 		Attrib& attrib = m_attrib[0];
 		attrib.m_state = 0
@@ -1726,6 +1729,78 @@ struct DebugDraw
 		pop();
 	}
 
+	uint64_t lineListState() const
+	{
+		const Attrib& attrib = m_attrib[m_stack];
+		return 0
+			| BGFX_STATE_RGB_WRITE
+			| BGFX_STATE_PT_LINES
+			| attrib.m_state
+			| BGFX_STATE_LINEAA
+			| BGFX_STATE_BLEND_ALPHA
+			;
+	}
+
+	uint32_t drawLineList(const DdVertex* _vertices, uint32_t _num)
+	{
+		BX_CHECK(State::Count != m_state);
+		flush();
+
+		const uint32_t drawCalls = m_drawCalls;
+		const bgfx::ProgramHandle program = m_program[m_attrib[m_stack].m_stipple ? 1 : 0];
+
+		// Lines are drawn without indices, so a batch is only bounded by the
+		// space left in the transient vertex buffer.
+		_num &= ~UINT32_C(1);
+		while (0 != _num)
+		{
+			const uint32_t num = bgfx::getAvailTransientVertexBuffer(_num, DebugVertex::ms_decl) & ~UINT32_C(1);
+			if (0 == num)
+			{
+				break;
+			}
+
+			bgfx::TransientVertexBuffer tvb;
+			bgfx::allocTransientVertexBuffer(&tvb, num, DebugVertex::ms_decl);
+			memcpy(tvb.data, _vertices, num * DebugVertex::ms_decl.m_stride);
+
+			bgfx::setVertexBuffer(&tvb);
+			bgfx::setState(lineListState() );
+			bgfx::setTransform(m_mtx);
+			bgfx::submit(m_viewId, program);
+			++m_drawCalls;
+
+			_vertices += num;
+			_num -= num;
+		}
+
+		return m_drawCalls - drawCalls;
+	}
+
+	uint32_t drawLineList(bgfx::VertexBufferHandle _handle, uint32_t _num)
+	{
+		BX_CHECK(State::Count != m_state);
+		flush();
+
+		if (!bgfx::isValid(_handle) || 0 == _num)
+		{
+			return 0;
+		}
+
+		bgfx::setVertexBuffer(_handle, 0, _num);
+		bgfx::setState(lineListState() );
+		bgfx::setTransform(m_mtx);
+		bgfx::submit(m_viewId, m_program[m_attrib[m_stack].m_stipple ? 1 : 0]);
+		++m_drawCalls;
+
+		return 1;
+	}
+
+	uint32_t getDrawCalls() const
+	{
+		return m_drawCalls;
+	}
+
 private:
 	struct Mesh
 	{
@@ -1781,7 +1856,7 @@ private:
 		};
 	};
 
-	void draw(Mesh::Enum _mesh, const float* _mtx, uint16_t _num, bool _wireframe) const
+	void draw(Mesh::Enum _mesh, const float* _mtx, uint16_t _num, bool _wireframe)
 	{
 		const Mesh& mesh = m_mesh[_mesh];
 
@@ -1838,6 +1913,7 @@ private:
 				: (alpha < 0xff) ? BGFX_STATE_BLEND_ALPHA : 0)
 		);
 		bgfx::submit(m_viewId, m_program[_wireframe ? Program::Fill : Program::FillLit]);
+		++m_drawCalls;
 	}
 
 	void softFlush()
@@ -1876,6 +1952,7 @@ private:
 				bgfx::setTransform(m_mtx);
 				bgfx::ProgramHandle program = m_program[attrib.m_stipple ? 1 : 0];
 				bgfx::submit(m_viewId, program);
+				++m_drawCalls;
 			}
 
 			m_state = State::None;
@@ -1921,6 +1998,7 @@ private:
 				bgfx::setTransform(m_mtx);
 				bgfx::setTexture(0, s_texColor, m_texture);
 				bgfx::submit(m_viewId, m_program[Program::FillTexture]);
+				++m_drawCalls;
 			}
 
 			m_posQuad = 0;
@@ -1953,6 +2031,7 @@ private:
 	uint16_t m_posQuad;
 
 	uint32_t m_mtx;
+	uint32_t m_drawCalls;
 	uint8_t  m_viewId;
 	uint8_t  m_stack;
 	bool     m_depthTestLess;
@@ -2200,3 +2279,23 @@ void ddDrawOrb(float _x, float _y, float _z, float _radius, Axis::Enum _hightlig
 {
 	s_dd.drawOrb(_x, _y, _z, _radius, _hightlight);
 }
+
+const bgfx::VertexDecl& ddGetVertexDecl()
+{
+	return DebugVertex::ms_decl;
+}
+
+uint32_t ddDrawLineList(const DdVertex* _vertices, uint32_t _num)
+{
+	return s_dd.drawLineList(_vertices, _num);
+}
+
+uint32_t ddDrawLineList(bgfx::VertexBufferHandle _handle, uint32_t _num)
+{
+	return s_dd.drawLineList(_handle, _num);
+}
+
+uint32_t ddGetDrawCalls()
+{
+	return s_dd.getDrawCalls();
+}
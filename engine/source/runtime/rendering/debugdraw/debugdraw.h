@@ -24,6 +24,18 @@ struct Axis
 
 struct SpriteHandle { uint16_t idx; };
 
+/// Vertex of a line list, positions are in world space (or relative to
+/// the current transform). m_len is the distance along the line, used for
+/// stippling.
+struct DdVertex
+{
+	float m_x;
+	float m_y;
+	float m_z;
+	float m_len;
+	uint32_t m_abgr;
+};
+
 inline bool isValid(SpriteHandle _handle) { return _handle.idx != UINT16_MAX; }
 
 ///
@@ -146,6 +158,21 @@ void ddDrawGrid(Axis::Enum _axis, const void* _center, uint32_t _size = 20, floa
 ///
 void ddDrawOrb(float _x, float _y, float _z, float _radius, Axis::Enum _highlight = Axis::Count);
 
+/// Vertex layout of DdVertex, for vertex buffers passed to ddDrawLineList.
+const bgfx::VertexDecl& ddGetVertexDecl();
+
+/// Draws pairs of vertices as lines with the current state and transform.
+/// The vertices go into as few transient buffers as possible, returns the
+/// number of draw calls used.
+uint32_t ddDrawLineList(const DdVertex* _vertices, uint32_t _num);
+
+/// Draws the first _num vertices of a vertex buffer as lines, for geometry
+/// that is kept across frames. Returns the number of draw calls used.
+uint32_t ddDrawLineList(bgfx::VertexBufferHandle _handle, uint32_t _num);
+
+/// Number of draw calls submitted since ddBegin.
+uint32_t ddGetDrawCalls();
+
 struct ddRAII
 {
 	ddRAII(uint8_t _viewId)
@@ -0,0 +1,157 @@
+#include "debugdraw_batch.h"
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	std::atomic<std::uint64_t> s_next_id{ 1 };
+
+	/// Last buffer the thread used. Ids are never reused so a cache entry of
+	/// a destroyed batch can not match a new one.
+	struct ThreadCache
+	{
+		std::uint64_t owner = 0;
+		std::vector<DdVertex>* buffer = nullptr;
+	};
+
+	thread_local ThreadCache s_thread_cache;
+
+	void push_line(std::vector<DdVertex>& buffer, const math::vec3& from, const math::vec3& to, std::uint32_t abgr)
+	{
+		buffer.push_back({ from.x, from.y, from.z, 0.0f, abgr });
+		buffer.push_back({ to.x, to.y, to.z, math::distance(from, to), abgr });
+	}
+}
+
+DebugDrawBatch::DebugDrawBatch()
+	: _id(s_next_id++)
+{
+}
+
+std::vector<DdVertex>& DebugDrawBatch::get_thread_buffer()
+{
+	auto& cache = s_thread_cache;
+	if (cache.owner == _id)
+		return *cache.buffer;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto& buffer = _buffers[std::this_thread::get_id()];
+	if (!buffer)
+		buffer = std::make_unique<std::vector<DdVertex>>();
+
+	cache.owner = _id;
+	cache.buffer = buffer.get();
+	return *buffer;
+}
+
+void DebugDrawBatch::add_line(const math::vec3& from, const math::vec3& to, std::uint32_t abgr)
+{
+	push_line(get_thread_buffer(), from, to, abgr);
+}
+
+void DebugDrawBatch::add_bbox(const math::bbox& bounds, const math::transform_t& world, std::uint32_t abgr)
+{
+	math::vec3 corners[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		const math::vec3 corner
+		{
+			(i & 1) ? bounds.max.x : bounds.min.x,
+			(i & 2) ? bounds.max.y : bounds.min.y,
+			(i & 4) ? bounds.max.z : bounds.min.z
+		};
+		corners[i] = world.transform_coord(corner);
+	}
+
+	// Corners are indexed by their max bits, an edge connects two corners
+	// that differ in exactly one bit.
+	static const int edges[12][2] =
+	{
+		{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+		{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+		{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+	};
+
+	auto& buffer = get_thread_buffer();
+	buffer.reserve(buffer.size() + 24);
+	for (const auto& edge : edges)
+	{
+		push_line(buffer, corners[edge[0]], corners[edge[1]], abgr);
+	}
+}
+
+void DebugDrawBatch::set_persistent(std::uint64_t key, std::vector<DdVertex> vertices)
+{
+	_persistent[key] = std::move(vertices);
+	_persistent_dirty = true;
+}
+
+void DebugDrawBatch::remove_persistent(std::uint64_t key)
+{
+	if (_persistent.erase(key) != 0)
+		_persistent_dirty = true;
+}
+
+void DebugDrawBatch::clear_persistent()
+{
+	if (_persistent.empty())
+		return;
+
+	_persistent.clear();
+	_persistent_dirty = true;
+}
+
+void DebugDrawBatch::rebuild_persistent()
+{
+	_persistent_dirty = false;
+	_persistent_count = 0;
+
+	std::size_t count = 0;
+	for (const auto& pair : _persistent)
+		count += pair.second.size() & ~std::size_t(1);
+
+	if (count == 0)
+	{
+		_persistent_buffer.dispose();
+		return;
+	}
+
+	const auto memory = gfx::alloc(static_cast<std::uint32_t>(count * sizeof(DdVertex)));
+	auto data = reinterpret_cast<DdVertex*>(memory->data);
+	for (const auto& pair : _persistent)
+	{
+		const auto size = pair.second.size() & ~std::size_t(1);
+		std::copy(pair.second.begin(), pair.second.begin() + size, data);
+		data += size;
+	}
+
+	_persistent_buffer.populate(memory, ddGetVertexDecl());
+	_persistent_count = static_cast<std::uint32_t>(count);
+}
+
+std::uint32_t DebugDrawBatch::submit()
+{
+	if (_persistent_dirty)
+		rebuild_persistent();
+
+	_merged.clear();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto& pair : _buffers)
+		{
+			auto& buffer = *pair.second;
+			_merged.insert(_merged.end(), buffer.begin(), buffer.end());
+			buffer.clear();
+		}
+	}
+
+	std::uint32_t draw_calls = 0;
+	if (!_merged.empty())
+		draw_calls += ddDrawLineList(_merged.data(), static_cast<std::uint32_t>(_merged.size()));
+
+	if (_persistent_buffer.is_valid())
+		draw_calls += ddDrawLineList(_persistent_buffer.handle, _persistent_count);
+
+	_line_count = (_merged.size() + _persistent_count) / 2;
+	return draw_calls;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "debugdraw.h"
+#include "../vertex_buffer.h"
+#include "core/math/math_includes.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : DebugDrawBatch (Class)
+/// <summary>
+/// Collects debug lines into large lists instead of drawing them shape by
+/// shape. Lines can be added from any thread, each thread fills its own
+/// buffer so no locking happens per line. On submit the buffers of all
+/// threads are merged and drawn with as few draw calls as the transient
+/// buffer allows. Persistent shapes are kept in a static vertex buffer that
+/// is only rebuilt when one of them changes.
+/// </summary>
+//-----------------------------------------------------------------------------
+class DebugDrawBatch
+{
+public:
+	DebugDrawBatch();
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_line ()
+	/// <summary>
+	/// Adds a line for the next submit. Thread safe.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_line(const math::vec3& from, const math::vec3& to, std::uint32_t abgr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_bbox ()
+	/// <summary>
+	/// Adds the 12 edges of a bounding box transformed to world space for the
+	/// next submit. Thread safe.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_bbox(const math::bbox& bounds, const math::transform_t& world, std::uint32_t abgr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_persistent ()
+	/// <summary>
+	/// Sets the lines of a shape that is drawn on every submit until it is
+	/// removed. Vertices are pairs of line end points. Main thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_persistent(std::uint64_t key, std::vector<DdVertex> vertices);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove_persistent ()
+	/// <summary>
+	/// Removes a persistent shape. Main thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove_persistent(std::uint64_t key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear_persistent ()
+	/// <summary>
+	/// Removes all persistent shapes. Main thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear_persistent();
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Draws the lines added since the last submit and the persistent shapes
+	/// with the current debug draw state. Must be called on the main thread
+	/// between ddBegin and ddEnd, after all threads are done adding lines.
+	/// Returns the number of draw calls used.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t submit();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_line_count ()
+	/// <summary>
+	/// Number of lines drawn by the last submit.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::size_t get_line_count() const { return _line_count; }
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : get_thread_buffer ()
+	/// <summary>
+	/// Returns the buffer of the calling thread, creating it on first use.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<DdVertex>& get_thread_buffer();
+
+	//-----------------------------------------------------------------------------
+	//  Name : rebuild_persistent ()
+	/// <summary>
+	/// Uploads the persistent shapes into one vertex buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rebuild_persistent();
+
+	/// Unique id of the batch, used to validate the per thread lookup cache.
+	std::uint64_t _id = 0;
+	/// Guards the buffer map, only locked the first time a thread adds lines.
+	std::mutex _mutex;
+	/// Buffers by thread. They are kept across submits to reuse their memory.
+	std::unordered_map<std::thread::id, std::unique_ptr<std::vector<DdVertex>>> _buffers;
+	/// Lines of all threads merged for drawing.
+	std::vector<DdVertex> _merged;
+	/// Persistent shapes by key.
+	std::unordered_map<std::uint64_t, std::vector<DdVertex>> _persistent;
+	/// Persistent shapes uploaded to the gpu.
+	VertexBuffer _persistent_buffer;
+	/// Number of vertices in the persistent buffer.
+	std::uint32_t _persistent_count = 0;
+	/// Persistent shapes changed since the buffer was uploaded.
+	bool _persistent_dirty = false;
+	/// Lines drawn by the last submit.
+	std::size_t _line_count = 0;
+};
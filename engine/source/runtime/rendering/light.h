@@ -233,4 +233,8 @@ struct Light
 	Directional directional_data;
 	math::color color = { 1.0f, 1.0f, 1.0f, 1.0f };
 	float intensity = 1.0f;
+	/// Shadows are opt in. Point and spot lights that cast shadows are drawn
+	/// one by one instead of through the light clusters, so lights saved
+	/// before this flag existed load without it and stay clustered.
+	bool casts_shadows = false;
 };
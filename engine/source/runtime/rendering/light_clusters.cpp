@@ -0,0 +1,373 @@
+#include "light_clusters.h"
+#include "../system/task.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LIGHT_CLUSTERS_SSE 1
+#include <xmmintrin.h>
+#else
+#define LIGHT_CLUSTERS_SSE 0
+#endif
+
+namespace
+{
+	// Below this many lights binning is not worth spreading over tasks.
+	const std::size_t MinParallelLights = 32;
+
+	math::vec3 unproject(const math::mat4& inv_proj, float x, float y, float z)
+	{
+		const math::vec4 p = inv_proj * math::vec4(x, y, z, 1.0f);
+		return math::vec3(p) / p.w;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : test_cluster ()
+	/// <summary>
+	/// Sphere against box, then for spot lights cone against the bounding
+	/// sphere of the box. The SIMD path performs the exact same operations in
+	/// the same order, so that both agree bit for bit.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename Bounds>
+	inline bool test_cluster(const Bounds& b, std::size_t i, const LightClusters::Light& light)
+	{
+		const float dx = std::max(b.min_x[i] - light.position.x, 0.0f) + std::max(light.position.x - b.max_x[i], 0.0f);
+		const float dy = std::max(b.min_y[i] - light.position.y, 0.0f) + std::max(light.position.y - b.max_y[i], 0.0f);
+		const float dz = std::max(b.min_z[i] - light.position.z, 0.0f) + std::max(light.position.z - b.max_z[i], 0.0f);
+		const float distance_sqr = dx * dx + dy * dy + dz * dz;
+		if (!(distance_sqr <= light.range * light.range))
+			return false;
+
+		if (light.cos_half_angle <= -1.0f)
+			return true;
+
+		const float vx = b.center_x[i] - light.position.x;
+		const float vy = b.center_y[i] - light.position.y;
+		const float vz = b.center_z[i] - light.position.z;
+		const float v_len_sqr = vx * vx + vy * vy + vz * vz;
+		const float v1_len = vx * light.direction.x + vy * light.direction.y + vz * light.direction.z;
+		const float closest = light.cos_half_angle * std::sqrt(std::max(v_len_sqr - v1_len * v1_len, 0.0f)) - v1_len * light.sin_half_angle;
+		const float radius = b.radius[i];
+		const bool culled = closest > radius || v1_len > radius + light.range || v1_len < 0.0f - radius;
+		return !culled;
+	}
+}
+
+void LightClusters::set_grid(std::uint32_t tiles_x, std::uint32_t tiles_y, std::uint32_t slices)
+{
+	tiles_x = std::max(tiles_x, 1u);
+	tiles_y = std::max(tiles_y, 1u);
+	slices = std::max(slices, 1u);
+	if (tiles_x == _tiles_x && tiles_y == _tiles_y && slices == _slices)
+		return;
+
+	_tiles_x = tiles_x;
+	_tiles_y = tiles_y;
+	_slices = slices;
+	_built = false;
+}
+
+void LightClusters::build(const math::mat4& proj, float near_clip, float far_clip, bool homogeneous_depth)
+{
+	if (_built && proj == _proj && near_clip == _near_clip && far_clip == _far_clip && homogeneous_depth == _homogeneous_depth)
+		return;
+
+	_proj = proj;
+	_near_clip = near_clip;
+	_far_clip = far_clip;
+	_homogeneous_depth = homogeneous_depth;
+	_built = true;
+
+	const math::mat4 inv_proj = glm::inverse(proj);
+	const float ndc_near = homogeneous_depth ? -1.0f : 0.0f;
+	_depth_sign = unproject(inv_proj, 0.0f, 0.0f, 1.0f).z >= 0.0f ? 1.0f : -1.0f;
+
+	const float depth_ratio = far_clip / near_clip;
+	_slice_scale = float(_slices) / std::log(depth_ratio);
+	_slice_bias = -std::log(near_clip) * _slice_scale;
+
+	const std::uint32_t tile_count = _tiles_x * _tiles_y;
+	_padded_tiles = (tile_count + 3) & ~3u;
+
+	_bounds.resize(_slices);
+	for (std::uint32_t slice = 0; slice < _slices; ++slice)
+	{
+		const float depths[2] =
+		{
+			near_clip * std::pow(depth_ratio, float(slice) / float(_slices)),
+			near_clip * std::pow(depth_ratio, float(slice + 1) / float(_slices))
+		};
+
+		auto& b = _bounds[slice];
+		for (auto v : { &b.min_x, &b.min_y, &b.min_z })
+			v->assign(_padded_tiles, std::numeric_limits<float>::max());
+		for (auto v : { &b.max_x, &b.max_y, &b.max_z })
+			v->assign(_padded_tiles, -std::numeric_limits<float>::max());
+		for (auto v : { &b.center_x, &b.center_y, &b.center_z, &b.radius })
+			v->assign(_padded_tiles, 0.0f);
+
+		for (std::uint32_t y = 0; y < _tiles_y; ++y)
+		{
+			for (std::uint32_t x = 0; x < _tiles_x; ++x)
+			{
+				const std::uint32_t tile = y * _tiles_x + x;
+				math::bbox box;
+				box.reset();
+
+				// The box around the corners of the tile at both slice depths.
+				for (std::uint32_t corner = 0; corner < 4; ++corner)
+				{
+					const float ndc_x = -1.0f + 2.0f * float(x + (corner & 1)) / float(_tiles_x);
+					const float ndc_y = -1.0f + 2.0f * float(y + (corner >> 1)) / float(_tiles_y);
+					const auto near_point = unproject(inv_proj, ndc_x, ndc_y, ndc_near);
+					const auto far_point = unproject(inv_proj, ndc_x, ndc_y, 1.0f);
+					for (float depth : depths)
+					{
+						const float t = (depth - near_point.z * _depth_sign) / ((far_point.z - near_point.z) * _depth_sign);
+						box.add_point(near_point + (far_point - near_point) * t);
+					}
+				}
+
+				b.min_x[tile] = box.min.x;
+				b.min_y[tile] = box.min.y;
+				b.min_z[tile] = box.min.z;
+				b.max_x[tile] = box.max.x;
+				b.max_y[tile] = box.max.y;
+				b.max_z[tile] = box.max.z;
+				const auto center = box.get_center();
+				b.center_x[tile] = center.x;
+				b.center_y[tile] = center.y;
+				b.center_z[tile] = center.z;
+				b.radius[tile] = math::length(box.max - center);
+			}
+		}
+	}
+}
+
+std::uint32_t LightClusters::get_slice(float depth) const
+{
+	if (!(depth > _near_clip))
+		return 0;
+
+	const float slice = std::floor(std::log(depth) * _slice_scale + _slice_bias);
+	if (!(slice < float(_slices - 1)))
+		return _slices - 1;
+
+	return slice > 0.0f ? std::uint32_t(slice) : 0;
+}
+
+std::uint32_t LightClusters::get_cluster_index(const math::vec3& position) const
+{
+	const auto clip = _proj * math::vec4(position, 1.0f);
+	const float ndc_x = clip.x / clip.w;
+	const float ndc_y = clip.y / clip.w;
+	const auto tile_x = std::uint32_t(math::clamp(std::floor((ndc_x * 0.5f + 0.5f) * float(_tiles_x)), 0.0f, float(_tiles_x - 1)));
+	const auto tile_y = std::uint32_t(math::clamp(std::floor((ndc_y * 0.5f + 0.5f) * float(_tiles_y)), 0.0f, float(_tiles_y - 1)));
+	const auto slice = get_slice(position.z * _depth_sign);
+	return (slice * _tiles_y + tile_y) * _tiles_x + tile_x;
+}
+
+math::bbox LightClusters::get_bounds(std::uint32_t cluster) const
+{
+	const std::uint32_t tile_count = _tiles_x * _tiles_y;
+	const auto& b = _bounds[cluster / tile_count];
+	const std::uint32_t tile = cluster % tile_count;
+	return math::bbox(b.min_x[tile], b.min_y[tile], b.min_z[tile], b.max_x[tile], b.max_y[tile], b.max_z[tile]);
+}
+
+void LightClusters::get_slice_range(const Light& light, std::uint32_t& first, std::uint32_t& last) const
+{
+	// One slice of margin on both sides makes up for rounding between the
+	// slice formula and the box depths, the box test has the last word.
+	const float depth = light.position.z * _depth_sign;
+	first = get_slice(depth - light.range);
+	last = get_slice(depth + light.range);
+	first = first > 0 ? first - 1 : 0;
+	last = std::min(last + 1, _slices - 1);
+}
+
+void LightClusters::assign_slice(std::uint32_t slice, const Light* lights, std::size_t count)
+{
+	const auto& b = _bounds[slice];
+	const std::uint32_t tile_count = _tiles_x * _tiles_y;
+
+	// Gather (tile, light) pairs light by light.
+	auto& hits = _slice_hits[slice];
+	hits.clear();
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (slice < _light_slices[i * 2] || slice > _light_slices[i * 2 + 1])
+			continue;
+
+		const auto& light = lights[i];
+#if LIGHT_CLUSTERS_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 px = _mm_set1_ps(light.position.x);
+		const __m128 py = _mm_set1_ps(light.position.y);
+		const __m128 pz = _mm_set1_ps(light.position.z);
+		const __m128 range = _mm_set1_ps(light.range);
+		const __m128 range_sqr = _mm_set1_ps(light.range * light.range);
+		const bool spot = light.cos_half_angle > -1.0f;
+		const __m128 dir_x = _mm_set1_ps(light.direction.x);
+		const __m128 dir_y = _mm_set1_ps(light.direction.y);
+		const __m128 dir_z = _mm_set1_ps(light.direction.z);
+		const __m128 cos_half = _mm_set1_ps(light.cos_half_angle);
+		const __m128 sin_half = _mm_set1_ps(light.sin_half_angle);
+
+		for (std::uint32_t tile = 0; tile < _padded_tiles; tile += 4)
+		{
+			const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&b.min_x[tile]), px), zero), _mm_max_ps(_mm_sub_ps(px, _mm_loadu_ps(&b.max_x[tile])), zero));
+			const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&b.min_y[tile]), py), zero), _mm_max_ps(_mm_sub_ps(py, _mm_loadu_ps(&b.max_y[tile])), zero));
+			const __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&b.min_z[tile]), pz), zero), _mm_max_ps(_mm_sub_ps(pz, _mm_loadu_ps(&b.max_z[tile])), zero));
+			const __m128 distance_sqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 hit = _mm_cmple_ps(distance_sqr, range_sqr);
+			if (_mm_movemask_ps(hit) == 0)
+				continue;
+
+			if (spot)
+			{
+				const __m128 vx = _mm_sub_ps(_mm_loadu_ps(&b.center_x[tile]), px);
+				const __m128 vy = _mm_sub_ps(_mm_loadu_ps(&b.center_y[tile]), py);
+				const __m128 vz = _mm_sub_ps(_mm_loadu_ps(&b.center_z[tile]), pz);
+				const __m128 v_len_sqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+				const __m128 v1_len = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dir_x), _mm_mul_ps(vy, dir_y)), _mm_mul_ps(vz, dir_z));
+				const __m128 closest = _mm_sub_ps(_mm_mul_ps(cos_half, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(v_len_sqr, _mm_mul_ps(v1_len, v1_len)), zero))), _mm_mul_ps(v1_len, sin_half));
+				const __m128 radius = _mm_loadu_ps(&b.radius[tile]);
+				const __m128 culled = _mm_or_ps(_mm_or_ps(
+					_mm_cmpgt_ps(closest, radius),
+					_mm_cmpgt_ps(v1_len, _mm_add_ps(radius, range))),
+					_mm_cmplt_ps(v1_len, _mm_sub_ps(zero, radius)));
+				hit = _mm_andnot_ps(culled, hit);
+			}
+
+			const int mask = _mm_movemask_ps(hit);
+			for (std::uint32_t lane = 0; lane < 4; ++lane)
+			{
+				if (mask & (1 << lane))
+				{
+					hits.push_back(tile + lane);
+					hits.push_back(std::uint32_t(i));
+				}
+			}
+		}
+#else
+		for (std::uint32_t tile = 0; tile < tile_count; ++tile)
+		{
+			if (test_cluster(b, tile, light))
+			{
+				hits.push_back(tile);
+				hits.push_back(std::uint32_t(i));
+			}
+		}
+#endif
+	}
+
+	// Counting sort by tile. Lights were visited in order, so the lights of
+	// every tile stay sorted and a full tile keeps the first ones. Offsets are
+	// relative to the slice for now.
+	Cluster* clusters = &_clusters[slice * tile_count];
+	for (std::uint32_t tile = 0; tile < tile_count; ++tile)
+		clusters[tile] = Cluster();
+	for (std::size_t i = 0; i < hits.size(); i += 2)
+		clusters[hits[i]].count++;
+
+	std::uint32_t offset = 0;
+	std::size_t dropped = 0;
+	for (std::uint32_t tile = 0; tile < tile_count; ++tile)
+	{
+		if (clusters[tile].count > MaxClusterLights)
+			dropped += clusters[tile].count - MaxClusterLights;
+
+		clusters[tile].offset = offset;
+		offset += std::min(clusters[tile].count, std::uint32_t(MaxClusterLights));
+		clusters[tile].count = 0;
+	}
+	_slice_dropped[slice] = dropped;
+
+	auto& indices = _slice_indices[slice];
+	indices.resize(offset);
+	for (std::size_t i = 0; i < hits.size(); i += 2)
+	{
+		auto& cluster = clusters[hits[i]];
+		if (cluster.count < MaxClusterLights)
+			indices[cluster.offset + cluster.count++] = hits[i + 1];
+	}
+}
+
+void LightClusters::assign(const Light* lights, std::size_t count)
+{
+	const std::uint32_t tile_count = _tiles_x * _tiles_y;
+	_clusters.resize(std::size_t(tile_count) * _slices);
+	_slice_hits.resize(_slices);
+	_slice_indices.resize(_slices);
+	_slice_dropped.resize(_slices);
+
+	_light_slices.resize(count * 2);
+	for (std::size_t i = 0; i < count; ++i)
+		get_slice_range(lights[i], _light_slices[i * 2], _light_slices[i * 2 + 1]);
+
+	auto ts = core::get_subsystem<runtime::TaskSystem>();
+	if (ts == nullptr || count < MinParallelLights)
+	{
+		for (std::uint32_t slice = 0; slice < _slices; ++slice)
+			assign_slice(slice, lights, count);
+	}
+	else
+	{
+		auto master = ts->create_parallel_for("Light Clusters", [this, lights, count](std::uint32_t begin, std::uint32_t end)
+		{
+			for (std::uint32_t slice = begin; slice < end && slice < _slices; ++slice)
+				assign_slice(slice, lights, count);
+		}, std::uint32_t(0), _slices, 1);
+		ts->run(master);
+		ts->wait(master);
+	}
+
+	// Concatenate the per slice lists.
+	_light_indices.clear();
+	_dropped = 0;
+	for (std::uint32_t slice = 0; slice < _slices; ++slice)
+	{
+		_dropped += _slice_dropped[slice];
+		const auto base = std::uint32_t(_light_indices.size());
+		Cluster* clusters = &_clusters[slice * tile_count];
+		for (std::uint32_t tile = 0; tile < tile_count; ++tile)
+			clusters[tile].offset += base;
+
+		const auto& indices = _slice_indices[slice];
+		_light_indices.insert(_light_indices.end(), indices.begin(), indices.end());
+	}
+}
+
+void LightClusters::assign_reference(const Light* lights, std::size_t count)
+{
+	const std::uint32_t tile_count = _tiles_x * _tiles_y;
+	_clusters.resize(std::size_t(tile_count) * _slices);
+	_light_indices.clear();
+	_dropped = 0;
+
+	for (std::uint32_t slice = 0; slice < _slices; ++slice)
+	{
+		for (std::uint32_t tile = 0; tile < tile_count; ++tile)
+		{
+			auto& cluster = _clusters[slice * tile_count + tile];
+			cluster.offset = std::uint32_t(_light_indices.size());
+			cluster.count = 0;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (!test_cluster(_bounds[slice], tile, lights[i]))
+					continue;
+
+				if (cluster.count == MaxClusterLights)
+				{
+					_dropped++;
+					continue;
+				}
+				_light_indices.push_back(std::uint32_t(i));
+				cluster.count++;
+			}
+		}
+	}
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include "core/math/math_includes.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : LightClusters (Class)
+/// <summary>
+/// Assigns local lights to the cells (clusters) of a froxel grid that splits
+/// the view frustum into screen tiles and exponentially spaced depth slices.
+/// The lighting pass then only evaluates the lights listed for the cluster of
+/// each pixel. Everything is computed in view space on the CPU and does not
+/// touch the renderer, the result is a cluster table and a light index list
+/// that the caller uploads.
+/// </summary>
+//-----------------------------------------------------------------------------
+class LightClusters
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : Light (Struct)
+	/// <summary>
+	/// Volume of influence of a light, in view space.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct Light
+	{
+		/// Position of the light.
+		math::vec3 position;
+		/// Distance at which the light stops having an effect.
+		float range = 0.0f;
+		/// Axis of the cone, spot lights only.
+		math::vec3 direction;
+		/// Cosine of half the cone angle, -1 for point lights.
+		float cos_half_angle = -1.0f;
+		/// Sine of half the cone angle.
+		float sin_half_angle = 0.0f;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : Cluster (Struct)
+	/// <summary>
+	/// Range of the light index list that affects a cluster.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct Cluster
+	{
+		std::uint32_t offset = 0;
+		std::uint32_t count = 0;
+	};
+
+	/// Default grid dimensions.
+	static const std::uint32_t DefaultTilesX = 16;
+	static const std::uint32_t DefaultTilesY = 8;
+	static const std::uint32_t DefaultSlices = 24;
+	/// Most lights listed for a cluster, the lighting shader loops over at
+	/// most this many. Must match fs_deferred_clustered_light.sc.
+	static const std::uint32_t MaxClusterLights = 256;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_grid ()
+	/// <summary>
+	/// Sets the number of screen tiles along x and y and the number of depth
+	/// slices. Takes effect on the next call to build.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_grid(std::uint32_t tiles_x, std::uint32_t tiles_y, std::uint32_t slices);
+
+	//-----------------------------------------------------------------------------
+	//  Name : build ()
+	/// <summary>
+	/// Computes the view space bounds of every cluster for the projection.
+	/// Does nothing if neither the projection nor the grid changed since the
+	/// last call. Near and far clip are the distances the slices span and must
+	/// be positive, homogeneous_depth tells if clip space depth goes from -1
+	/// (as with OpenGL) rather than from 0.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void build(const math::mat4& proj, float near_clip, float far_clip, bool homogeneous_depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : assign ()
+	/// <summary>
+	/// Bins the lights into the clusters. Each depth slice is processed as its
+	/// own task on the task system when there is one, testing a light against
+	/// four tiles of a slice at a time. Lights of a cluster are listed in
+	/// ascending order, up to MaxClusterLights of them. The lights past that
+	/// are left out of the cluster and counted by get_dropped_count.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void assign(const Light* lights, std::size_t count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : assign_reference ()
+	/// <summary>
+	/// Same result as assign, by testing every light against every cluster one
+	/// at a time. Slow, meant for validating assign.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void assign_reference(const Light* lights, std::size_t count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_cluster_index ()
+	/// <summary>
+	/// Returns the cluster that contains the view space position.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_cluster_index(const math::vec3& position) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_slice ()
+	/// <summary>
+	/// Returns the depth slice of a view space depth, clamped to the grid.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_slice(float depth) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_slice_scale ()
+	/// <summary>
+	/// Shaders find the slice of a depth as floor(log(depth) * scale + bias).
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline float get_slice_scale() const { return _slice_scale; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_slice_bias ()
+	/// <summary>
+	/// See get_slice_scale.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline float get_slice_bias() const { return _slice_bias; }
+
+	inline std::uint32_t get_tiles_x() const { return _tiles_x; }
+	inline std::uint32_t get_tiles_y() const { return _tiles_y; }
+	inline std::uint32_t get_slices() const { return _slices; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_clusters ()
+	/// <summary>
+	/// Returns the clusters, ordered by slice, then tile row, then tile column.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const std::vector<Cluster>& get_clusters() const { return _clusters; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_light_indices ()
+	/// <summary>
+	/// Returns the light index list the clusters point into.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const std::vector<std::uint32_t>& get_light_indices() const { return _light_indices; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dropped_count ()
+	/// <summary>
+	/// Returns how many lights the last assignment left out of clusters that
+	/// already listed MaxClusterLights, summed over the clusters.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::size_t get_dropped_count() const { return _dropped; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_bounds ()
+	/// <summary>
+	/// Returns the view space bounds of a cluster.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	math::bbox get_bounds(std::uint32_t cluster) const;
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : SliceBounds (Struct)
+	/// <summary>
+	/// Bounds of the clusters of one depth slice laid out for SIMD, the tile
+	/// count is padded to a multiple of four with empty boxes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct SliceBounds
+	{
+		std::vector<float> min_x, min_y, min_z;
+		std::vector<float> max_x, max_y, max_z;
+		/// Bounding spheres of the boxes, for the spot light cone test.
+		std::vector<float> center_x, center_y, center_z, radius;
+	};
+
+	void get_slice_range(const Light& light, std::uint32_t& first, std::uint32_t& last) const;
+	void assign_slice(std::uint32_t slice, const Light* lights, std::size_t count);
+
+	/// Grid dimensions.
+	std::uint32_t _tiles_x = DefaultTilesX;
+	std::uint32_t _tiles_y = DefaultTilesY;
+	std::uint32_t _slices = DefaultSlices;
+	/// Tile count of a slice, padded to a multiple of four.
+	std::uint32_t _padded_tiles = 0;
+	/// Inputs of the last build.
+	math::mat4 _proj;
+	float _near_clip = 0.0f;
+	float _far_clip = 0.0f;
+	bool _homogeneous_depth = false;
+	bool _built = false;
+	/// Slice of a depth is floor(log(depth) * _slice_scale + _slice_bias).
+	float _slice_scale = 0.0f;
+	float _slice_bias = 0.0f;
+	/// 1 if view space depth grows along +z, -1 if along -z.
+	float _depth_sign = 1.0f;
+	/// Cluster bounds, per slice.
+	std::vector<SliceBounds> _bounds;
+	/// Per light range of slices it may touch.
+	std::vector<std::uint32_t> _light_slices;
+	/// Per slice scratch, (tile, light) pairs and light counts per tile.
+	std::vector<std::vector<std::uint32_t>> _slice_hits;
+	std::vector<std::vector<std::uint32_t>> _slice_indices;
+	/// Per slice count of lights left out of full clusters.
+	std::vector<std::size_t> _slice_dropped;
+	/// Result.
+	std::vector<Cluster> _clusters;
+	std::vector<std::uint32_t> _light_indices;
+	std::size_t _dropped = 0;
+};
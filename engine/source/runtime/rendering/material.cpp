@@ -5,6 +5,19 @@
 
 #include "../assets/asset_manager.h"
 
+namespace
+{
+	const char* const standard_samplers[] = { "s_tex_color", "s_tex_normal", "s_tex_roughness", "s_tex_metalness", "s_tex_ao" };
+
+	// submit runs on the recording workers and only looks samplers up, so
+	// they are created along with the program on the main thread
+	void add_standard_samplers(Program& program)
+	{
+		for (auto sampler : standard_samplers)
+			program.add_sampler(sampler);
+	}
+}
+
 Material::Material()
 {
 	auto am = core::get_subsystem<runtime::AssetManager>();
@@ -52,11 +65,19 @@ void Material::set_uniform(const std::string& _name, const void* _value, std::ui
 	get_program()->set_uniform(_name, _value, _num);
 }
 
-Program* Material::get_program() const
+Program* Material::get_program(bool skinned) const
 {
 	return skinned ? _program_skinned.get() : _program.get();
 }
 
+void Material::begin_pass()
+{
+	if (_program)
+		_program->begin_pass();
+	if (_program_skinned)
+		_program_skinned->begin_pass();
+}
+
 std::uint64_t Material::get_render_states(bool apply_cull, bool depth_write, bool depth_test) const
 {
 	// Set render states.
@@ -94,6 +115,7 @@ StandardMaterial::StandardMaterial()
 			.then([this, vs](auto fs)
 		{
 			_program = std::make_unique<Program>(vs, fs);
+			add_standard_samplers(*_program);
 		});
 	});
 
@@ -104,27 +126,33 @@ StandardMaterial::StandardMaterial()
 			.then([this, vs](auto fs)
 		{
 			_program_skinned = std::make_unique<Program>(vs, fs);
+			add_standard_samplers(*_program_skinned);
 		});
 	});
 }
 
-void StandardMaterial::submit()
+void StandardMaterial::submit(Program& program)
 {
-	if (!is_valid())
-		return;
-
-	get_program()->set_uniform("u_base_color", &_base_color);
-	get_program()->set_uniform("u_subsurface_color", &_subsurface_color);
-	get_program()->set_uniform("u_emissive_color", &_emissive_color);
-	get_program()->set_uniform("u_surface_data", &_surface_data);
-	get_program()->set_uniform("u_tiling", &_tiling);
-	get_program()->set_uniform("u_dither_threshold", &_dither_threshold);
-
-	const auto& color_map = _maps["color"];
-	const auto& normal_map = _maps["normal"];
-	const auto& roughness_map = _maps["roughness"];
-	const auto& metalness_map = _maps["metalness"];
-	const auto& ao_map = _maps["ao"];
+	program.set_uniform("u_base_color", &_base_color);
+	program.set_uniform("u_subsurface_color", &_subsurface_color);
+	program.set_uniform("u_emissive_color", &_emissive_color);
+	program.set_uniform("u_surface_data", &_surface_data);
+	program.set_uniform("u_tiling", &_tiling);
+	program.set_uniform("u_dither_threshold", &_dither_threshold);
+
+	// Look the maps up without inserting, materials may be submitted
+	// from several threads at once.
+	auto find_map = [this](const std::string& name)
+	{
+		auto it = _maps.find(name);
+		return it != _maps.end() ? it->second : AssetHandle<Texture>();
+	};
+
+	const auto color_map = find_map("color");
+	const auto normal_map = find_map("normal");
+	const auto roughness_map = find_map("roughness");
+	const auto metalness_map = find_map("metalness");
+	const auto ao_map = find_map("ao");
 
 	auto albedo = color_map ? color_map : _default_color_map;
 	auto normal = normal_map ? normal_map : _default_normal_map;
@@ -132,9 +160,9 @@ void StandardMaterial::submit()
 	auto metalness = metalness_map ? metalness_map : _default_color_map;
 	auto ao = ao_map ? ao_map : _default_color_map;
 
-	get_program()->set_texture(0, "s_tex_color", albedo.get());
-	get_program()->set_texture(1, "s_tex_normal", normal.get());
-	get_program()->set_texture(2, "s_tex_roughness", roughness.get());
-	get_program()->set_texture(3, "s_tex_metalness", metalness.get());
-	get_program()->set_texture(4, "s_tex_ao", ao.get());
+	program.set_texture(0, "s_tex_color", albedo.get());
+	program.set_texture(1, "s_tex_normal", normal.get());
+	program.set_texture(2, "s_tex_roughness", roughness.get());
+	program.set_texture(3, "s_tex_metalness", metalness.get());
+	program.set_texture(4, "s_tex_ao", ao.get());
 }
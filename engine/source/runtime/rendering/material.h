@@ -122,22 +122,29 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : get_program ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Returns the program for meshes with or without skinning.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	Program* get_program() const;
+	Program* get_program(bool skinned = false) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_pass ()
+	/// <summary>
+	/// Lets both programs recreate themselves after their shaders were
+	/// reloaded. Main thread only, draws may then be recorded on any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin_pass();
 
 	//-----------------------------------------------------------------------------
 	//  Name : submit (virtual )
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Sets the parameters of the material on the program it is drawn with.
+	/// Must not modify the material, it may be submitted from several
+	/// threads at once.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void submit() {};
+	virtual void submit(Program& program) {};
 
 	//-----------------------------------------------------------------------------
 	//  Name : get_cull_type ()
@@ -169,7 +176,6 @@ public:
 	//-----------------------------------------------------------------------------
 	std::uint64_t get_render_states(bool apply_cull = true, bool depth_write = true, bool depth_test = true) const;
 
-	bool skinned = false;
 protected:
 	/// Program that is responsible for rendering.
 	std::unique_ptr<Program> _program;
@@ -488,7 +494,7 @@ public:
 	/// 
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void submit();
+	virtual void submit(Program& program);
 private:
 	/// Base color
 	math::color _base_color
@@ -4,7 +4,14 @@
 #include "core/memory/checked_delete.h"
 #include "core/logging/logging.h"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
 #include "mesh_tools.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "core/math/transform_batch.h"
+#include "../system/task.h"
 
 
 #define RMC_DEFINE_DATA                     \
@@ -25,16 +32,616 @@
 //-----------------------------------------------------------------------------
 // Local Module Level Namespaces.
 //-----------------------------------------------------------------------------
-// Settings for the mesh optimizer.
-namespace MeshOptimizer
+namespace
 {
-	const float CacheDecayPower = 1.5f;
-	const float LastTriScore = 0.75f;
-	const float ValenceBoostScale = 2.0f;
-	const float ValenceBoostPower = 0.5f;
-	const std::int32_t MaxVertexCacheSize = 32;
+	// Granularity of the parallel preparation stages. Ranges only depend on
+	// the element count, never on the number of workers, and whatever is
+	// accumulated across ranges is reduced in range order, so the prepared
+	// mesh is the same however the work was scheduled.
+	const std::uint32_t TrianglesPerTask = 4096;
+	const std::uint32_t VerticesPerTask = 8192;
+
+	template<typename F>
+	void parallel_for(const std::string& name, std::uint32_t count, std::uint32_t grain, F&& functor)
+	{
+		auto ts = core::get_subsystem<runtime::TaskSystem>();
+		if (ts == nullptr || count <= grain)
+		{
+			functor(std::uint32_t(0), count);
+			return;
+		}
+
+		auto master = ts->create_parallel_for(name, [&functor, count](std::uint32_t begin, std::uint32_t end)
+		{
+			functor(begin, std::min(end, count));
+		}, std::uint32_t(0), count, grain);
+		ts->run(master);
+		ts->wait(master);
+	}
+
+	std::uint64_t mix_hash(std::uint64_t hash, std::uint64_t value)
+	{
+		// 64 bit finalizer of MurmurHash3 applied to the combined value
+		hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	std::uint64_t hash_bytes(const std::uint8_t* data, std::size_t size, std::uint64_t hash)
+	{
+		std::size_t i = 0;
+		for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+		{
+			std::uint64_t value;
+			std::memcpy(&value, data + i, sizeof(value));
+			hash = mix_hash(hash, value);
+		}
+		if (i < size)
+		{
+			std::uint64_t value = 0;
+			std::memcpy(&value, data + i, size - i);
+			hash = mix_hash(hash, value);
+		}
+		return hash;
+	}
+
+	std::uint64_t hash_position(const math::vec3& position, std::uint64_t hash)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			// adding zero turns -0 into +0, so that both hash alike
+			const float value = position[i] + 0.0f;
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			hash = mix_hash(hash, bits);
+		}
+		return hash;
+	}
+
+	bool equal_positions(const math::vec3& position1, const math::vec3& position2)
+	{
+		// compares what hash_position hashes. a value compare never matches
+		// a nan, not even the same one, and would never end a table probe.
+		for (int i = 0; i < 3; ++i)
+		{
+			const float value1 = position1[i] + 0.0f;
+			const float value2 = position2[i] + 0.0f;
+			if (std::memcmp(&value1, &value2, sizeof(float)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	std::uint16_t get_attribute_size(const gfx::VertexDecl& format, gfx::Attrib::Enum attribute)
+	{
+		if (!format.has(attribute))
+			return 0;
+
+		std::uint8_t num;
+		gfx::AttribType::Enum type;
+		bool normalized, as_int;
+		format.decode(attribute, num, type, normalized, as_int);
+		switch (type)
+		{
+		case gfx::AttribType::Uint8: return num;
+		case gfx::AttribType::Uint10: return 4;
+		case gfx::AttribType::Int16:
+		case gfx::AttribType::Half: return num * 2;
+		default: return num * 4;
+		}
+	}
+
+	std::size_t get_table_capacity(std::size_t count)
+	{
+		// keep the load factor at or below one half
+		std::size_t capacity = 16;
+		while (capacity < count * 2)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : VertexWeldGrid (Class)
+	/// <summary>
+	/// Spatial hash used to weld vertices. Positions are bucketed into cells a few
+	/// times the weld tolerance, and a vertex is looked up in every cell that its
+	/// tolerance box overlaps, which usually is just one. The remaining vertex
+	/// data must match exactly and is folded into the cell hash.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class VertexWeldGrid
+	{
+	public:
+		VertexWeldGrid(const gfx::VertexDecl& format, float tolerance, std::size_t capacity)
+			: _format(format)
+			, _tolerance(tolerance)
+			, _tolerance_sq(tolerance * tolerance)
+			, _cell_size(tolerance > 0.0f ? tolerance * 4.0f : 1.0f)
+		{
+			_position_offset = format.getOffset(gfx::Attrib::Position);
+			_position_size = get_attribute_size(format, gfx::Attrib::Position);
+			_cells.resize(get_table_capacity(capacity));
+			_mask = _cells.size() - 1;
+			_entries.reserve(capacity);
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : weld ()
+		/// <summary>
+		/// Returns the index of the first added vertex that the given vertex can be
+		/// welded with, or adds the vertex under new_index and returns new_index.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::uint32_t weld(const std::uint8_t* vertex, std::uint32_t new_index)
+		{
+			float pos[4];
+			gfx::vertexUnpack(pos, gfx::Attrib::Position, _format, vertex);
+			const math::vec3 position(pos[0], pos[1], pos[2]);
+
+			std::int64_t min_cell[3], max_cell[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				min_cell[i] = get_cell(position[i] - _tolerance);
+				max_cell[i] = get_cell(position[i] + _tolerance);
+			}
+
+			const std::uint64_t data_hash = hash_attributes(vertex);
+
+			// Pick the first added match, so the result doesn't depend on the order
+			// in which the overlapped cells are visited.
+			std::uint32_t match = 0xFFFFFFFF;
+			for (std::int64_t x = min_cell[0]; x <= max_cell[0]; ++x)
+			{
+				for (std::int64_t y = min_cell[1]; y <= max_cell[1]; ++y)
+				{
+					for (std::int64_t z = min_cell[2]; z <= max_cell[2]; ++z)
+					{
+						const Cell* cell = find_cell(hash_cell(x, y, z, data_hash));
+						if (cell == nullptr)
+							continue;
+
+						for (std::uint32_t e = cell->head; e != 0xFFFFFFFF; e = _entries[e].next)
+						{
+							const auto& entry = _entries[e];
+							if (entry.index < match && math::distance2(entry.position, position) <= _tolerance_sq && equal_attributes(entry.vertex, vertex))
+								match = entry.index;
+						}
+					}
+				}
+			}
+
+			if (match != 0xFFFFFFFF)
+				return match;
+
+			const std::int64_t x = get_cell(position[0]), y = get_cell(position[1]), z = get_cell(position[2]);
+			Cell& cell = insert_cell(hash_cell(x, y, z, data_hash));
+
+			Entry entry;
+			entry.vertex = vertex;
+			entry.position = position;
+			entry.index = new_index;
+			entry.next = cell.head;
+			cell.head = std::uint32_t(_entries.size());
+			_entries.push_back(entry);
+			return new_index;
+		}
+
+	private:
+		struct Cell
+		{
+			/// Hash of the cell coordinates and the vertex data.
+			std::uint64_t key = 0;
+			/// First entry in the cell, 0xFFFFFFFF for an unused slot.
+			std::uint32_t head = 0xFFFFFFFF;
+		};
+
+		struct Entry
+		{
+			/// Vertex data.
+			const std::uint8_t* vertex;
+			/// Unpacked position.
+			math::vec3 position;
+			/// Welded index of the vertex.
+			std::uint32_t index;
+			/// Next entry in the same cell.
+			std::uint32_t next;
+		};
+
+		const Cell* find_cell(std::uint64_t key) const
+		{
+			for (std::size_t i = std::size_t(key) & _mask;; i = (i + 1) & _mask)
+			{
+				const Cell& cell = _cells[i];
+				if (cell.head == 0xFFFFFFFF)
+					return nullptr;
+				if (cell.key == key)
+					return &cell;
+			}
+		}
+
+		Cell& insert_cell(std::uint64_t key)
+		{
+			for (std::size_t i = std::size_t(key) & _mask;; i = (i + 1) & _mask)
+			{
+				Cell& cell = _cells[i];
+				if (cell.head == 0xFFFFFFFF)
+					cell.key = key;
+				if (cell.key == key)
+					return cell;
+			}
+		}
+
+		std::int64_t get_cell(float value) const
+		{
+			// keep far away or invalid positions within the integer range
+			const double cell = std::floor(double(value) / double(_cell_size));
+			if (!(cell > -4.0e18))
+				return std::int64_t(-4.0e18);
+			if (!(cell < 4.0e18))
+				return std::int64_t(4.0e18);
+			return std::int64_t(cell);
+		}
+
+		static std::uint64_t hash_cell(std::int64_t x, std::int64_t y, std::int64_t z, std::uint64_t hash)
+		{
+			hash = mix_hash(hash, std::uint64_t(x));
+			hash = mix_hash(hash, std::uint64_t(y));
+			return mix_hash(hash, std::uint64_t(z));
+		}
+
+		std::uint64_t hash_attributes(const std::uint8_t* vertex) const
+		{
+			const std::uint16_t stride = _format.getStride();
+			const std::uint16_t position_end = _position_offset + _position_size;
+			std::uint64_t hash = hash_bytes(vertex, _position_offset, 0);
+			return hash_bytes(vertex + position_end, stride - position_end, hash);
+		}
+
+		bool equal_attributes(const std::uint8_t* vertex1, const std::uint8_t* vertex2) const
+		{
+			const std::uint16_t stride = _format.getStride();
+			const std::uint16_t position_end = _position_offset + _position_size;
+			return std::memcmp(vertex1, vertex2, _position_offset) == 0 &&
+				std::memcmp(vertex1 + position_end, vertex2 + position_end, stride - position_end) == 0;
+		}
+
+		/// Format of the welded vertices.
+		const gfx::VertexDecl& _format;
+		/// Weld tolerance.
+		float _tolerance;
+		/// Squared weld tolerance.
+		float _tolerance_sq;
+		/// Size of a grid cell.
+		float _cell_size;
+		/// Position attribute byte range.
+		std::uint16_t _position_offset = 0;
+		std::uint16_t _position_size = 0;
+		/// Open addressing table of the used cells, the size is a power of two.
+		std::vector<Cell> _cells;
+		/// Size of the cell table minus one.
+		std::size_t _mask = 0;
+		/// Added vertices.
+		std::vector<Entry> _entries;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : AdjacentEdgeHash (Class)
+	/// <summary>
+	/// Open addressing hash table mapping a directed edge to the triangle it
+	/// belongs to. Vertices that share a position are given the same identifier
+	/// up front, so that edges are hashed and compared as a single integer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class AdjacentEdgeHash
+	{
+	public:
+		AdjacentEdgeHash(const std::uint8_t* positions, std::uint16_t stride, std::uint32_t vertex_count, std::size_t edge_count)
+		{
+			auto get_position = [positions, stride](std::uint32_t index) -> const math::vec3&
+			{
+				return *(const math::vec3*)(positions + (index * stride));
+			};
+
+			// The identifier of a position is the index of its first vertex.
+			_position_ids.resize(vertex_count);
+			std::vector<std::uint32_t> first_vertices(get_table_capacity(vertex_count), 0xFFFFFFFF);
+			const std::size_t mask = first_vertices.size() - 1;
+			for (std::uint32_t v = 0; v < vertex_count; ++v)
+			{
+				const math::vec3& position = get_position(v);
+				for (std::size_t i = std::size_t(hash_position(position, 0)) & mask;; i = (i + 1) & mask)
+				{
+					if (first_vertices[i] == 0xFFFFFFFF)
+						first_vertices[i] = v;
+					if (equal_positions(get_position(first_vertices[i]), position))
+					{
+						_position_ids[v] = first_vertices[i];
+						break;
+					}
+				}
+			}
+
+			_slots.resize(get_table_capacity(edge_count));
+			_mask = _slots.size() - 1;
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : insert ()
+		/// <summary>
+		/// Maps the edge between two vertices to the triangle, replacing any
+		/// previous triangle.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void insert(std::uint32_t index1, std::uint32_t index2, std::uint32_t triangle)
+		{
+			const std::uint64_t edge = get_edge(index1, index2);
+			for (std::size_t i = std::size_t(mix_hash(0, edge)) & _mask;; i = (i + 1) & _mask)
+			{
+				Slot& slot = _slots[i];
+				if (slot.triangle == 0xFFFFFFFF || slot.edge == edge)
+				{
+					slot.edge = edge;
+					slot.triangle = triangle;
+					return;
+				}
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : find ()
+		/// <summary>
+		/// Returns the triangle mapped to the edge between two vertices, or
+		/// 0xFFFFFFFF.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::uint32_t find(std::uint32_t index1, std::uint32_t index2) const
+		{
+			const std::uint64_t edge = get_edge(index1, index2);
+			for (std::size_t i = std::size_t(mix_hash(0, edge)) & _mask;; i = (i + 1) & _mask)
+			{
+				const Slot& slot = _slots[i];
+				if (slot.triangle == 0xFFFFFFFF || slot.edge == edge)
+					return slot.triangle;
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			/// Position identifiers of the edge vertices.
+			std::uint64_t edge = 0;
+			/// Triangle of the edge, 0xFFFFFFFF for an unused slot.
+			std::uint32_t triangle = 0xFFFFFFFF;
+		};
+
+		std::uint64_t get_edge(std::uint32_t index1, std::uint32_t index2) const
+		{
+			return (std::uint64_t(_position_ids[index1]) << 32) | _position_ids[index2];
+		}
+
+		/// Position identifier of each vertex.
+		std::vector<std::uint32_t> _position_ids;
+		/// Table slots, the size is a power of two.
+		std::vector<Slot> _slots;
+		/// Size of the table minus one.
+		std::size_t _mask = 0;
+	};
+
+	// Sums the normals of the faces sharing corner j of triangle i.
+	math::vec3 gather_vertex_normal(const std::uint32_t* adjacency_ptr, const math::vec3* normals_ptr, std::uint32_t i, std::uint32_t j)
+	{
+		std::uint32_t start_tri, previous_tri, current_tri, k;
+		math::vec3 vec_normal = normals_ptr[i];
+
+		// To generate vertex normals using the adjacency information we first need to walk backwards
+		// through the list to find the first triangle that references this vertex (using entrance/exit edge strategy).
+		// Once we have the first triangle, step forwards and sum the normals of each of the faces
+		// for each triangle we touch. This is essentially a flood fill through all of the triangles
+		// that touch this vertex, without ever having to test the entire set for shared vertices.
+		// The initial backwards traversal prevents us from having to store (and test) a 'visited' flag for
+		// every triangle in the buffer.
+
+		// First walk backwards...
+		start_tri = i;
+		previous_tri = i;
+		current_tri = adjacency_ptr[(i * 3) + ((j + 2) % 3)];
+		for (; ; )
+		{
+			// Stop walking if we reach the starting triangle again, or if there
+			// is no connectivity out of this edge
+			if (current_tri == start_tri || current_tri == 0xFFFFFFFF)
+				break;
+
+			// Find the edge in the adjacency list that we came in through
+			for (k = 0; k < 3; ++k)
+			{
+				if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
+					break;
 
-};
+			} // Next item in adjacency list
+
+			  // If we found the edge we entered through, the exit edge will
+			  // be the edge counter-clockwise from this one when walking backwards
+			if (k < 3)
+			{
+				previous_tri = current_tri;
+				current_tri = adjacency_ptr[(current_tri * 3) + ((k + 2) % 3)];
+
+			} // End if found entrance edge
+			else
+			{
+				break;
+
+			} // End if failed to find entrance edge
+
+		} // Next Test
+
+		  // We should now be at the starting triangle, we can start to walk forwards
+		  // collecting the face normals. First find the exit edge so we can start walking.
+		if (current_tri != 0xFFFFFFFF)
+		{
+			for (k = 0; k < 3; ++k)
+			{
+				if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
+					break;
+
+			} // Next item in adjacency list
+		}
+		else
+		{
+			// Couldn't step back, so first triangle is the current triangle
+			current_tri = i;
+			k = j;
+		}
+
+		if (k < 3)
+		{
+			start_tri = current_tri;
+			previous_tri = current_tri;
+			current_tri = adjacency_ptr[(current_tri * 3) + k];
+			vec_normal = normals_ptr[start_tri];
+			for (; ; )
+			{
+				// Stop walking if we reach the starting triangle again, or if there
+				// is no connectivity out of this edge
+				if (current_tri == start_tri || current_tri == 0xFFFFFFFF)
+					break;
+
+				// Add this normal.
+				vec_normal += normals_ptr[current_tri];
+
+				// Find the edge in the adjacency list that we came in through
+				for (k = 0; k < 3; ++k)
+				{
+					if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
+						break;
+
+				} // Next item in adjacency list
+
+				  // If we found the edge we came entered through, the exit edge will
+				  // be the edge clockwise from this one when walking forwards
+				if (k < 3)
+				{
+					previous_tri = current_tri;
+					current_tri = adjacency_ptr[(current_tri * 3) + ((k + 1) % 3)];
+
+				} // End if found entrance edge
+				else
+				{
+					break;
+
+				} // End if failed to find entrance edge
+
+			} // Next Test
+
+		} // End if found entrance edge
+
+		// Normalize the new vertex normal
+		return math::normalize(vec_normal);
+	}
+
+	// Vertex cache statistics gathered while optimizing a mesh.
+	struct OptimizerStats
+	{
+		/// Input order.
+		MeshOptimizer::VertexCacheStats before;
+		/// After the vertex cache pass.
+		MeshOptimizer::VertexCacheStats vertex_cache;
+		/// After the overdraw pass.
+		MeshOptimizer::VertexCacheStats overdraw;
+	};
+
+	std::vector<float> unpack_positions(const gfx::VertexDecl& format, const std::uint8_t* vertices, std::uint32_t vertex_count)
+	{
+		std::vector<float> positions(vertex_count * 3);
+		parallel_for("Unpack Mesh Positions", vertex_count, VerticesPerTask, [&](std::uint32_t begin, std::uint32_t end)
+		{
+			for (std::uint32_t i = begin; i < end; ++i)
+			{
+				float position[4];
+				gfx::vertexUnpack(position, gfx::Attrib::Position, format, vertices, i);
+				memcpy(&positions[i * 3], position, 3 * sizeof(float));
+			}
+		});
+		return positions;
+	}
+
+	void optimize_triangle_order(const std::uint32_t* source, std::uint32_t* destination, std::uint32_t face_count, std::uint32_t minimum_vertex, std::uint32_t maximum_vertex, const float* positions, OptimizerStats& stats)
+	{
+		// The passes work on a local vertex range so that their per vertex
+		// tables are only as large as the subset.
+		const std::uint32_t vertex_count = (maximum_vertex - minimum_vertex) + 1;
+		const std::size_t index_count = face_count * 3;
+		std::vector<std::uint32_t> local(index_count);
+		std::vector<std::uint32_t> cache_order(index_count);
+		for (std::size_t i = 0; i < index_count; ++i)
+			local[i] = source[i] - minimum_vertex;
+
+		stats.before += MeshOptimizer::analyze_vertex_cache(local.data(), index_count, vertex_count);
+		MeshOptimizer::optimize_vertex_cache(cache_order.data(), local.data(), index_count, vertex_count);
+		stats.vertex_cache += MeshOptimizer::analyze_vertex_cache(cache_order.data(), index_count, vertex_count);
+		MeshOptimizer::optimize_overdraw(local.data(), cache_order.data(), index_count, positions + minimum_vertex * 3, vertex_count, 3 * sizeof(float));
+		stats.overdraw += MeshOptimizer::analyze_vertex_cache(local.data(), index_count, vertex_count);
+
+		for (std::size_t i = 0; i < index_count; ++i)
+			destination[i] = local[i] + minimum_vertex;
+	}
+
+	// Index range of a subset waiting to be optimized.
+	struct OptimizerRange
+	{
+		const std::uint32_t* source = nullptr;
+		std::uint32_t* destination = nullptr;
+		std::uint32_t face_count = 0;
+		std::uint32_t minimum_vertex = 0;
+		std::uint32_t maximum_vertex = 0;
+	};
+
+	void optimize_triangle_order(const std::vector<OptimizerRange>& ranges, const float* positions, OptimizerStats& stats)
+	{
+		// Subsets do not share any output, so each one is optimized as its own
+		// task. Statistics are summed in subset order afterwards.
+		std::vector<OptimizerStats> range_stats(ranges.size());
+		parallel_for("Optimize Mesh Subsets", (std::uint32_t)ranges.size(), 1, [&](std::uint32_t begin, std::uint32_t end)
+		{
+			for (std::uint32_t i = begin; i < end; ++i)
+			{
+				const OptimizerRange& range = ranges[i];
+				optimize_triangle_order(range.source, range.destination, range.face_count, range.minimum_vertex, range.maximum_vertex, positions, range_stats[i]);
+			}
+		});
+
+		for (const auto& range_stat : range_stats)
+		{
+			stats.before += range_stat.before;
+			stats.vertex_cache += range_stat.vertex_cache;
+			stats.overdraw += range_stat.overdraw;
+		}
+	}
+
+	std::unique_ptr<Mesh::ArmatureNode> clone_armature(const Mesh::ArmatureNode* node)
+	{
+		if (!node)
+			return nullptr;
+
+		auto clone = std::make_unique<Mesh::ArmatureNode>();
+		clone->name = node->name;
+		clone->transform = node->transform;
+		for (const auto& child : node->children)
+			clone->children.push_back(clone_armature(child.get()));
+		return clone;
+	}
+
+	void log_optimizer_stats(const OptimizerStats& stats, std::uint32_t referenced_vertices, std::uint32_t vertex_count)
+	{
+		APPLOG_TRACE("Mesh optimized: ACMR {0:.3f} -> {1:.3f} (vertex cache) -> {2:.3f} (overdraw), ATVR {3:.3f} -> {4:.3f} -> {5:.3f}, {6} of {7} vertices fetched in order",
+			stats.before.get_acmr(), stats.vertex_cache.get_acmr(), stats.overdraw.get_acmr(),
+			stats.before.get_atvr(), stats.vertex_cache.get_atvr(), stats.overdraw.get_atvr(),
+			referenced_vertices, vertex_count);
+	}
+}
 
 Mesh::Mesh()
 {
@@ -123,6 +730,7 @@ void Mesh::dispose()
 	_force_tangent_generation = false;
 	_force_normal_generation = false;
 	_force_barycentric_generation = true;
+	_position_decode = { 0.0f, 0.0f, 0.0f, 1.0f };
 
 	// Reset structures
 	_bbox.reset();
@@ -674,14 +1282,17 @@ bool Mesh::prepare_mesh(const gfx::VertexDecl& format, void* vertices_ptr, std::
 	memset(&_preparation_data.vertex_flags[0], 0, vertex_count);
 	memcpy(&_preparation_data.vertex_data[0], vertices_ptr, vertex_count * format.getStride());
 
-	// Generate the bounding box data for the new geometry.
-	std::int32_t position_offset = format.getOffset(gfx::Attrib::Position);
-	std::int32_t stride = (std::int32_t)format.getStride();
+	// Generate the bounding box data for the new geometry. Positions may be
+	// stored in a packed format.
 	if (format.has(gfx::Attrib::Position))
 	{
-		std::uint8_t* src_ptr = ((std::uint8_t*)vertices_ptr) + position_offset;
-		for (std::uint32_t i = 0; i < vertex_count; ++i, src_ptr += stride)
-			_bbox.add_point(*((math::vec3*)src_ptr));
+		for (std::uint32_t i = 0; i < vertex_count; ++i)
+		{
+			float position[4];
+			gfx::vertexUnpack(position, gfx::Attrib::Position, format, vertices_ptr, i);
+			_bbox.add_point(math::vec3(position[0], position[1], position[2]));
+
+		} // Next vertex
 
 	} // End if has position
 
@@ -2765,27 +3376,30 @@ bool Mesh::end_prepare(bool hardware_copy /* = true */, bool weld /* = true */,
 	std::uint16_t position_offset = _vertex_format.getOffset(gfx::Attrib::Position);
 	std::uint16_t vertex_stride = _vertex_format.getStride();
 	std::uint8_t * src_vertices_ptr = &_preparation_data.vertex_data[0] + position_offset;
-	for (std::uint32_t i = 0; i < _preparation_data.triangle_count; ++i)
+	parallel_for("Find Degenerate Triangles", _preparation_data.triangle_count, TrianglesPerTask, [&](std::uint32_t begin, std::uint32_t end)
 	{
-		Triangle & tri = _preparation_data.triangle_data[i];
-		math::vec3 v1;
-		float vf1[4];
-		gfx::vertexUnpack(vf1, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[0]);
-		math::vec3 v2;
-		float vf2[4];
-		gfx::vertexUnpack(vf2, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[1]);
-		math::vec3 v3;
-		float vf3[4];
-		gfx::vertexUnpack(vf3, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[2]);
-		memcpy(&v1[0], vf1, 3 * sizeof(float));
-		memcpy(&v2[0], vf2, 3 * sizeof(float));
-		memcpy(&v3[0], vf3, 3 * sizeof(float));
-
-		math::vec3 c = math::cross(v2 - v1, v3 - v1);
-		if (math::length2(c) < (4.0f * 0.000001f * 0.000001f))
-			tri.flags |= TriangleFlags::Degenerate;
+		for (std::uint32_t i = begin; i < end; ++i)
+		{
+			Triangle & tri = _preparation_data.triangle_data[i];
+			math::vec3 v1;
+			float vf1[4];
+			gfx::vertexUnpack(vf1, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[0]);
+			math::vec3 v2;
+			float vf2[4];
+			gfx::vertexUnpack(vf2, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[1]);
+			math::vec3 v3;
+			float vf3[4];
+			gfx::vertexUnpack(vf3, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, tri.indices[2]);
+			memcpy(&v1[0], vf1, 3 * sizeof(float));
+			memcpy(&v2[0], vf2, 3 * sizeof(float));
+			memcpy(&v3[0], vf3, 3 * sizeof(float));
 
-	} // Next triangle
+			math::vec3 c = math::cross(v2 - v1, v3 - v1);
+			if (math::length2(c) < (4.0f * 0.000001f * 0.000001f))
+				tri.flags |= TriangleFlags::Degenerate;
+
+		} // Next triangle
+	});
 
 	  // Process the vertex data in order to generate any additional components that may be necessary
 	  // (i.e. Normal, Binormal and Tangent)
@@ -2827,18 +3441,26 @@ bool Mesh::end_prepare(bool hardware_copy /* = true */, bool weld /* = true */,
 	_preparation_data.triangle_count = 0;
 	_preparation_data.triangle_data.clear();
 
-	// Index data has been updated and potentially needs to be serialized.
-	if (build_buffers)
-		build_vb(hardware_copy);
-
-	// Skin binding data has potentially been updated and needs to be serialized.
-
-
 	// Finally perform the final sort of the mesh data in order
 	// to build the index buffer and subset tables.
 	if (!sort_mesh_data(optimize, hardware_copy, build_buffers))
 		return false;
 
+	// Vertex data has been updated (optimization reorders it) and
+	// potentially needs to be serialized.
+	if (build_buffers)
+		build_vb(hardware_copy);
+
+	// Bounds were gathered from the stored positions, bring them back to
+	// object space if those are quantized.
+	if (_position_decode != math::vec4(0.0f, 0.0f, 0.0f, 1.0f))
+	{
+		const math::vec3 offset(_position_decode);
+		_bbox.min = _bbox.min * _position_decode.w + offset;
+		_bbox.max = _bbox.max * _position_decode.w + offset;
+
+	} // End if quantized
+
 	// The mesh is now prepared
 	_prepare_status = MeshStatus::Prepared;
 	_hardware_mesh = hardware_copy;
@@ -3034,6 +3656,7 @@ bool Mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 	src_indices_ptr = dst_indices_ptr;
 	dst_indices_ptr = _system_ib;
 
+	std::vector<OptimizerRange> optimizer_ranges;
 	for (counter = 0, i = 0; i < (size_t)new_subsets.size(); ++i)
 	{
 		Subset* subset = new_subsets[i];
@@ -3041,7 +3664,17 @@ bool Mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 		// Note: Remember that at this stage, the subset's 'vertex_count' member still describes
 		// a 'max' vertex (not a count)... We're correcting this later.
 		if (optimize == true)
-			build_optimized_index_buffer(subset, src_indices_ptr + (subset->face_start * 3), dst_indices_ptr, subset->vertex_start, subset->vertex_count);
+		{
+			// Collected here and optimized all at once below.
+			OptimizerRange range;
+			range.source = src_indices_ptr + (subset->face_start * 3);
+			range.destination = dst_indices_ptr;
+			range.face_count = subset->face_count;
+			range.minimum_vertex = subset->vertex_start;
+			range.maximum_vertex = subset->vertex_count;
+			optimizer_ranges.push_back(range);
+
+		} // End if optimize
 		else
 			memcpy(dst_indices_ptr, src_indices_ptr + (subset->face_start * 3), subset->face_count * 3 * sizeof(std::uint32_t));
 
@@ -3055,9 +3688,52 @@ bool Mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 
 	} // Next Subset
 
+	OptimizerStats optimizer_stats;
+	if (optimize == true)
+	{
+		const auto positions = unpack_positions(_vertex_format, _system_vb, _vertex_count);
+		optimize_triangle_order(optimizer_ranges, positions.data(), optimizer_stats);
+
+	} // End if optimize
+
 	  // Clean up.
 	checked_array_delete(src_indices_ptr);
 
+	// Once every subset is in its final order, store the vertices in the order
+	// in which they are first used so that they are fetched sequentially.
+	if (optimize == true && _face_count > 0)
+	{
+		UInt32Array remap(_vertex_count);
+		const std::uint32_t referenced_vertices = MeshOptimizer::optimize_vertex_fetch(&remap[0], _system_ib, _face_count * 3, _vertex_count);
+		MeshOptimizer::remap_index_buffer(_system_ib, _system_ib, _face_count * 3, &remap[0]);
+
+		const std::uint32_t vertex_stride = _vertex_format.getStride();
+		std::uint8_t* new_vertices_ptr = new std::uint8_t[_vertex_count * vertex_stride];
+		MeshOptimizer::remap_vertex_buffer(new_vertices_ptr, _system_vb, _vertex_count, vertex_stride, &remap[0]);
+		checked_array_delete(_system_vb);
+		_system_vb = new_vertices_ptr;
+		_skin_bind_data.remap_vertices(remap);
+
+		// Vertex ranges of the subsets have moved too.
+		for (i = 0; i < (std::uint32_t)new_subsets.size(); ++i)
+		{
+			Subset* subset = new_subsets[i];
+			const std::uint32_t* indices_ptr = _system_ib + subset->face_start * 3;
+			subset->vertex_start = 0x7FFFFFFF;
+			subset->vertex_count = 0;
+			for (j = 0; j < (std::uint32_t)subset->face_count * 3; ++j)
+			{
+				const std::int32_t index = (std::int32_t)indices_ptr[j];
+				subset->vertex_start = std::min(subset->vertex_start, index);
+				subset->vertex_count = std::max(subset->vertex_count, index);
+			}
+
+		} // Next Subset
+
+		log_optimizer_stats(optimizer_stats, referenced_vertices, _vertex_count);
+
+	} // End if optimize
+
 	// Rebuild the additional triangle data based on the newly sorted
 	// subset data, and also convert the previously recorded maximum
 	// vertex value (stored in "vertex_count") into its final form
@@ -3099,273 +3775,356 @@ bool Mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 }
 
 
-float Mesh::find_vertex_optimizer_score(const OptimizerVertexInfo* vertex_info_ptr)
+void Mesh::optimize_load_data(LoadData& data)
 {
-	float score = 0.0f;
-
-	// Do any remaining triangles use this vertex?
-	if (vertex_info_ptr->unused_triangle_references == 0)
-		return -1.0f;
+	if (data.triangle_data.empty() || data.vertex_count == 0)
+		return;
 
-	std::int32_t cache_position = vertex_info_ptr->cache_position;
-	if (cache_position < 0)
+	// Group the triangles by data group, keeping their relative order, which
+	// is how sort_mesh_data lays out the subsets when the data is loaded.
+	TriangleArray& triangles = data.triangle_data;
+	std::stable_sort(triangles.begin(), triangles.end(), [](const Triangle& lhs, const Triangle& rhs)
 	{
+		return lhs.data_group_id < rhs.data_group_id;
+	});
 
-		// Vertex is not in FIFO cache - no score.
-	}
-	else
+	const std::uint32_t face_count = (std::uint32_t)triangles.size();
+	UInt32Array source_indices(face_count * 3);
+	UInt32Array optimized_indices(face_count * 3);
+	for (std::uint32_t i = 0; i < face_count; ++i)
+		memcpy(&source_indices[i * 3], triangles[i].indices, 3 * sizeof(std::uint32_t));
+
+	const auto positions = unpack_positions(data.vertex_format, &data.vertex_data[0], data.vertex_count);
+
+	// Optimize each data group on its own.
+	std::vector<OptimizerRange> ranges;
+	for (std::uint32_t start = 0, end = 0; start < face_count; start = end)
 	{
-		if (cache_position < 3)
-		{
-			// This vertex was used in the last triangle,
-			// so it has a fixed score, whichever of the three
-			// it's in. Otherwise, you can get very different
-			// answers depending on whether you add
-			// the triangle 1,2,3 or 3,1,2 - which is silly.
-			score = MeshOptimizer::LastTriScore;
-		}
-		else
+		OptimizerRange range;
+		range.source = &source_indices[start * 3];
+		range.destination = &optimized_indices[start * 3];
+		range.minimum_vertex = 0xFFFFFFFF;
+		for (end = start; end < face_count && triangles[end].data_group_id == triangles[start].data_group_id; ++end)
 		{
-			// Points for being high in the cache.
-			const float scaler = 1.0f / (MeshOptimizer::MaxVertexCacheSize - 3);
-			score = 1.0f - (cache_position - 3) * scaler;
-			score = math::pow(score, MeshOptimizer::CacheDecayPower);
+			for (std::uint32_t j = 0; j < 3; ++j)
+			{
+				range.minimum_vertex = std::min(range.minimum_vertex, triangles[end].indices[j]);
+				range.maximum_vertex = std::max(range.maximum_vertex, triangles[end].indices[j]);
+			}
 		}
+		range.face_count = end - start;
+		ranges.push_back(range);
+
+	} // Next data group
+
+	OptimizerStats stats;
+	optimize_triangle_order(ranges, positions.data(), stats);
 
-	} // End if already in vertex cache
+	// Store the vertices in the order in which they are first used.
+	UInt32Array remap(data.vertex_count);
+	const std::uint32_t referenced_vertices = MeshOptimizer::optimize_vertex_fetch(&remap[0], &optimized_indices[0], optimized_indices.size(), data.vertex_count);
+	MeshOptimizer::remap_index_buffer(&optimized_indices[0], &optimized_indices[0], optimized_indices.size(), &remap[0]);
 
-	  // Bonus points for having a low number of tris still to
-	  // use the vert, so we get rid of lone verts quickly.
-	float valence_boost = math::pow((float)vertex_info_ptr->unused_triangle_references, -MeshOptimizer::ValenceBoostPower);
-	score += MeshOptimizer::ValenceBoostScale * valence_boost;
+	std::vector<std::uint8_t> vertex_data(data.vertex_data.size());
+	MeshOptimizer::remap_vertex_buffer(&vertex_data[0], &data.vertex_data[0], data.vertex_count, data.vertex_format.getStride(), &remap[0]);
+	data.vertex_data.swap(vertex_data);
+	data.skin_data.remap_vertices(remap);
 
-	// Return the final score
-	return score;
+	// Triangle flags are recomputed by end_prepare.
+	for (std::uint32_t i = 0; i < face_count; ++i)
+	{
+		memcpy(triangles[i].indices, &optimized_indices[i * 3], 3 * sizeof(std::uint32_t));
+		triangles[i].flags = TriangleFlags::None;
+	}
+
+	log_optimizer_stats(stats, referenced_vertices, data.vertex_count);
 }
 
-void Mesh::build_optimized_index_buffer(const Subset* subset, std::uint32_t* src_buffer_ptr, std::uint32_t* dest_buffer_ptr, std::uint32_t min_vertex, std::uint32_t max_vertex)
+bool Mesh::generate_lod(const LoadData& source, float triangle_ratio, float max_error, LoadData& lod, LodReport& report)
 {
-	OptimizerVertexInfo* vertex_info_ptr = nullptr, *vert_ptr;
-	OptimizerTriangleInfo* triangle_info_ptr = nullptr, *tri_ptr;
-	std::uint32_t i, j, k, vertex_count;
-	float best_score = 0.0f, score;
-	std::int32_t best_triangle = -1;
-	std::uint32_t vertex_cache_size = 0;
-	std::uint32_t index, triangle_index, temp;
-
-	// Declare vertex cache storage (plus one to allow them to drop "off the end")
-	std::uint32_t vertex_cache_ptr[MeshOptimizer::MaxVertexCacheSize + 1];
-
-	// First allocate enough room for the optimization information for each vertex and triangle
-	vertex_count = (max_vertex - min_vertex) + 1;
-	vertex_info_ptr = new OptimizerVertexInfo[vertex_count];
-	triangle_info_ptr = new OptimizerTriangleInfo[subset->face_count];
-
-	// The first pass is to initialize the vertex information with information about the
-	// faces which reference them.
-	for (i = 0; i < (unsigned)subset->face_count; ++i)
-	{
-		index = src_buffer_ptr[i * 3] - min_vertex;
-		vertex_info_ptr[index].unused_triangle_references++;
-		vertex_info_ptr[index].triangle_references.push_back(i);
-		index = src_buffer_ptr[(i * 3) + 1] - min_vertex;
-		vertex_info_ptr[index].unused_triangle_references++;
-		vertex_info_ptr[index].triangle_references.push_back(i);
-		index = src_buffer_ptr[(i * 3) + 2] - min_vertex;
-		vertex_info_ptr[index].unused_triangle_references++;
-		vertex_info_ptr[index].triangle_references.push_back(i);
-
-	} // Next Triangle
+	report = LodReport();
+	report.source_triangles = (std::uint32_t)source.triangle_data.size();
+	report.source_vertices = source.vertex_count;
+	if (source.triangle_data.empty() || source.vertex_count == 0)
+		return false;
 
-	  // Initialize vertex scores
-	for (i = 0; i < vertex_count; ++i)
-		vertex_info_ptr[i].vertex_score = find_vertex_optimizer_score(&vertex_info_ptr[i]);
-
-	// Compute the score for each triangle, and record the triangle with the best score
-	for (i = 0; i < (unsigned)subset->face_count; ++i)
-	{
-		// The triangle score is the sum of the scores of each of
-		// its three vertices.
-		index = src_buffer_ptr[i * 3] - min_vertex;
-		score = vertex_info_ptr[index].vertex_score;
-		index = src_buffer_ptr[(i * 3) + 1] - min_vertex;
-		score += vertex_info_ptr[index].vertex_score;
-		index = src_buffer_ptr[(i * 3) + 2] - min_vertex;
-		score += vertex_info_ptr[index].vertex_score;
-		triangle_info_ptr[i].triangle_score = score;
-
-		// Record the triangle with the highest score
-		if (score > best_score)
-		{
-			best_score = score;
-			best_triangle = (signed)i;
+	const std::uint32_t vertex_count = source.vertex_count;
+	const std::uint32_t vertex_stride = source.vertex_format.getStride();
+	const auto positions = unpack_positions(source.vertex_format, &source.vertex_data[0], vertex_count);
 
-		} // End if better than previous score
+	// Group the triangles by data group, keeping their relative order.
+	TriangleArray triangles = source.triangle_data;
+	std::stable_sort(triangles.begin(), triangles.end(), [](const Triangle& lhs, const Triangle& rhs)
+	{
+		return lhs.data_group_id < rhs.data_group_id;
+	});
 
-	} // Next Triangle
+	const std::uint32_t face_count = (std::uint32_t)triangles.size();
+	UInt32Array source_indices(face_count * 3);
+	for (std::uint32_t i = 0; i < face_count; ++i)
+		memcpy(&source_indices[i * 3], triangles[i].indices, 3 * sizeof(std::uint32_t));
 
-	  // Now we can start adding triangles, beginning with the previous highest scoring triangle.
-	for (i = 0; i < (unsigned)subset->face_count; ++i)
+	// Lock every position referenced by more than one data group so that the
+	// boundaries between materials stay closed.
+	const std::uint32_t NoGroup = 0xFFFFFFFF, MultipleGroups = 0xFFFFFFFE;
+	UInt32Array vertex_data_groups(vertex_count, NoGroup);
+	for (const auto& triangle : triangles)
 	{
-		// If we don't know the best triangle, for whatever reason, find it
-		if (best_triangle < 0)
+		for (std::uint32_t j = 0; j < 3; ++j)
 		{
-			best_triangle = -1;
-			best_score = 0.0f;
+			std::uint32_t& group = vertex_data_groups[triangle.indices[j]];
+			if (group == NoGroup)
+				group = triangle.data_group_id;
+			else if (group != triangle.data_group_id)
+				group = MultipleGroups;
+		}
+	}
 
-			// Iterate through the entire list of un-added faces
-			for (j = 0; j < (unsigned)subset->face_count; ++j)
-			{
-				if (triangle_info_ptr[j].added == false)
-				{
-					score = triangle_info_ptr[j].triangle_score;
+	UInt32Array position_order(vertex_count);
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+		position_order[i] = i;
+	std::sort(position_order.begin(), position_order.end(), [&positions](std::uint32_t lhs, std::uint32_t rhs)
+	{
+		return std::lexicographical_compare(&positions[lhs * 3], &positions[lhs * 3 + 3], &positions[rhs * 3], &positions[rhs * 3 + 3]);
+	});
 
-					// Record the triangle with the highest score
-					if (score > best_score)
-					{
-						best_score = score;
-						best_triangle = (signed)j;
+	std::vector<std::uint8_t> vertex_locks(vertex_count, 0);
+	for (std::uint32_t start = 0, end = 0; start < vertex_count; start = end)
+	{
+		std::uint32_t group = NoGroup;
+		bool shared = false;
+		for (end = start; end < vertex_count && std::equal(&positions[position_order[start] * 3], &positions[position_order[start] * 3 + 3], &positions[position_order[end] * 3]); ++end)
+		{
+			const std::uint32_t vertex_group = vertex_data_groups[position_order[end]];
+			if (vertex_group == NoGroup)
+				continue;
+			shared |= (vertex_group == MultipleGroups || (group != NoGroup && group != vertex_group));
+			group = vertex_group;
+		}
 
-					} // End if better than previous score
+		if (shared)
+		{
+			for (std::uint32_t i = start; i < end; ++i)
+				vertex_locks[position_order[i]] = 1;
+		}
 
-				} // End if not added
+	} // Next position
+
+	// Vertices only collapse onto vertices that are dominated by the same bone,
+	// which keeps the deformation of the simplified skin close to the source.
+	UInt32Array bone_groups;
+	if (source.skin_data.has_bones())
+	{
+		std::vector<float> bone_weights(vertex_count, 0.0f);
+		bone_groups.assign(vertex_count, NoGroup);
+		const auto& bones = source.skin_data.get_bones();
+		for (std::uint32_t i = 0; i < (std::uint32_t)bones.size(); ++i)
+		{
+			for (const auto& influence : bones[i].influences)
+			{
+				if (influence.vertex_index < vertex_count && influence.weight > bone_weights[influence.vertex_index])
+				{
+					bone_weights[influence.vertex_index] = influence.weight;
+					bone_groups[influence.vertex_index] = i;
+				}
+			}
+		}
+	}
 
-			} // Next Triangle
+	// Simplify each data group as its own task.
+	struct GroupRange
+	{
+		std::uint32_t face_start = 0;
+		std::uint32_t face_count = 0;
+		std::size_t index_count = 0;
+		float error = 0.0f;
+	};
+	std::vector<GroupRange> groups;
+	for (std::uint32_t start = 0, end = 0; start < face_count; start = end)
+	{
+		for (end = start; end < face_count && triangles[end].data_group_id == triangles[start].data_group_id; ++end);
 
-		} // End if best triangle is not known
+		GroupRange group;
+		group.face_start = start;
+		group.face_count = end - start;
+		groups.push_back(group);
 
-		  // Use the best scoring triangle from last pass and reset score keeping
-		triangle_index = (unsigned)best_triangle;
-		tri_ptr = &triangle_info_ptr[triangle_index];
-		best_triangle = -1;
-		best_score = 0.0f;
+	} // Next data group
 
-		// This triangle can be added to the 'draw' list, and each
-		// of the vertices it references should be updated.
-		tri_ptr->added = true;
-		for (j = 0; j < 3; ++j)
+	triangle_ratio = math::clamp(triangle_ratio, 0.0f, 1.0f);
+	UInt32Array simplified_indices(face_count * 3);
+	parallel_for("Simplify Mesh Subsets", (std::uint32_t)groups.size(), 1, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		for (std::uint32_t i = begin; i < end; ++i)
 		{
-			// Extract the vertex index and store in the index buffer
-			index = src_buffer_ptr[(triangle_index * 3) + j];
-			*dest_buffer_ptr++ = index;
+			GroupRange& group = groups[i];
+			const std::size_t target_index_count = (std::size_t)std::ceil(group.face_count * triangle_ratio) * 3;
+			group.index_count = MeshSimplifier::simplify(&simplified_indices[group.face_start * 3], &source_indices[group.face_start * 3],
+				group.face_count * 3, positions.data(), vertex_count, 3 * sizeof(float), target_index_count, max_error,
+				vertex_locks.data(), bone_groups.empty() ? nullptr : bone_groups.data(), &group.error);
+		}
+	});
 
-			// Adjust the index so that it points into our info buffer
-			// rather than the actual source vertex itself.
-			index = index - min_vertex;
+	// Gather the surviving triangles.
+	lod.triangle_data.clear();
+	for (const auto& group : groups)
+	{
+		const std::uint32_t data_group_id = triangles[group.face_start].data_group_id;
+		for (std::size_t i = 0; i < group.index_count; i += 3)
+		{
+			Triangle triangle;
+			triangle.data_group_id = data_group_id;
+			memcpy(triangle.indices, &simplified_indices[group.face_start * 3 + i], 3 * sizeof(std::uint32_t));
+			lod.triangle_data.push_back(triangle);
+		}
+		report.error = std::max(report.error, group.error);
+	}
+	lod.triangle_count = (std::uint32_t)lod.triangle_data.size();
 
-			// Retrieve the referenced vertex information
-			vert_ptr = &vertex_info_ptr[index];
+	// Drop the vertices that are no longer referenced.
+	UInt32Array lod_indices(lod.triangle_count * 3);
+	for (std::uint32_t i = 0; i < lod.triangle_count; ++i)
+		memcpy(&lod_indices[i * 3], lod.triangle_data[i].indices, 3 * sizeof(std::uint32_t));
 
-			// Reduce the 'valence' of this vertex (one less triangle is now referencing)
-			vert_ptr->unused_triangle_references--;
+	UInt32Array remap(vertex_count);
+	const std::uint32_t referenced_vertices = MeshOptimizer::optimize_vertex_fetch(&remap[0], lod_indices.data(), lod_indices.size(), vertex_count);
+	for (auto& triangle : lod.triangle_data)
+	{
+		for (std::uint32_t j = 0; j < 3; ++j)
+			triangle.indices[j] = remap[triangle.indices[j]];
+	}
 
-			// Remove this triangle from the list of references in the vertex
-			auto itReference = std::find(vert_ptr->triangle_references.begin(), vert_ptr->triangle_references.end(), triangle_index);
-			if (itReference != vert_ptr->triangle_references.end())
-				vert_ptr->triangle_references.erase(itReference);
+	lod.vertex_format = source.vertex_format;
+	lod.vertex_data.resize(source.vertex_data.size());
+	MeshOptimizer::remap_vertex_buffer(&lod.vertex_data[0], &source.vertex_data[0], vertex_count, vertex_stride, &remap[0]);
+	lod.vertex_data.resize(referenced_vertices * vertex_stride);
+	lod.vertex_count = referenced_vertices;
 
-			// Now we must update the vertex cache to include this vertex. If it was
-			// already in the cache, it should be moved to the head, otherwise it should
-			// be inserted (pushing one off the end).
-			if (vert_ptr->cache_position == -1)
-			{
-				// Not in the vertex cache, insert it at the head.
-				if (vertex_cache_size > 0)
-				{
-					// First shuffle EVERYONE up by one position in the cache.
-					memmove(&vertex_cache_ptr[1], &vertex_cache_ptr[0], vertex_cache_size * sizeof(std::uint32_t));
+	for (auto& index : remap)
+	{
+		if (index >= referenced_vertices)
+			index = 0xFFFFFFFF;
+	}
+	lod.skin_data = source.skin_data;
+	lod.skin_data.remap_vertices(remap);
+	lod.root_node = clone_armature(source.root_node.get());
+	lod.materials = source.materials;
 
-				} // End if any vertices exist in the cache
+	report.triangles = lod.triangle_count;
+	report.vertices = lod.vertex_count;
+	return true;
+}
 
-				  // Grow the cache if applicable
-				if (vertex_cache_size < MeshOptimizer::MaxVertexCacheSize)
-					vertex_cache_size++;
-				else
-				{
-					// Set the associated index of the vertex which dropped "off the end" of the cache.
-					vertex_info_ptr[vertex_cache_ptr[vertex_cache_size]].cache_position = -1;
+gfx::VertexDecl Mesh::get_compressed_format(const gfx::VertexDecl& format, bool quantize_positions)
+{
+	// The bitangent can only be rebuilt when there is a full tangent frame.
+	const bool drop_bitangent = format.has(gfx::Attrib::Normal) && format.has(gfx::Attrib::Tangent);
 
-				} // End if no more room
+	gfx::VertexDecl compressed;
+	compressed.begin();
+	for (std::uint32_t i = 0; i < gfx::Attrib::Count; ++i)
+	{
+		const gfx::Attrib::Enum attribute = gfx::Attrib::Enum(i);
+		if (!format.has(attribute) || (attribute == gfx::Attrib::Bitangent && drop_bitangent))
+			continue;
 
-				  // Overwrite the first entry
-				vertex_cache_ptr[0] = index;
+		std::uint8_t num;
+		gfx::AttribType::Enum type;
+		bool normalized, as_int;
+		format.decode(attribute, num, type, normalized, as_int);
 
-			} // End if not in cache
-			else if (vert_ptr->cache_position > 0)
-			{
-				// Already in the vertex cache, move it to the head.
-				// Note : If the cache position is already 0, we just ignore
-				// it... hence the above 'else if' rather than just 'else'.
-				if (vert_ptr->cache_position == 1)
-				{
-					// We were in the second slot, just swap the two
-					temp = vertex_cache_ptr[0];
-					vertex_cache_ptr[0] = index;
-					vertex_cache_ptr[1] = temp;
+		const bool texcoord = attribute >= gfx::Attrib::TexCoord0 && attribute <= gfx::Attrib::TexCoord7;
+		if (attribute == gfx::Attrib::Position && quantize_positions)
+			compressed.add(attribute, 4, gfx::AttribType::Int16, true, true);
+		else if (texcoord && type == gfx::AttribType::Float)
+			compressed.add(attribute, num, gfx::AttribType::Half);
+		else
+			compressed.add(attribute, num, type, normalized, as_int);
 
-				} // End if simple swap
-				else
-				{
-					// Shuffle EVERYONE up who came before us.
-					memmove(&vertex_cache_ptr[1], &vertex_cache_ptr[0], vert_ptr->cache_position * sizeof(std::uint32_t));
+	} // Next attribute
+	compressed.end();
 
-					// Insert this vertex at the head
-					vertex_cache_ptr[0] = index;
+	return compressed;
+}
 
-				} // End if memory move required
+void Mesh::compress_load_data(LoadData& data, bool quantize_positions, CompressionReport& report)
+{
+	const gfx::VertexDecl source_format = data.vertex_format;
+	quantize_positions &= source_format.has(gfx::Attrib::Position);
+	const gfx::VertexDecl format = get_compressed_format(source_format, quantize_positions);
+
+	report = CompressionReport();
+	report.source_stride = source_format.getStride();
+	report.compressed_stride = format.getStride();
+	report.source_bytes = data.vertex_data.size();
+	report.compressed_bytes = data.vertex_count * format.getStride();
+
+	data.vertex_format = format;
+	data.position_decode = math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	if (data.vertex_count == 0)
+	{
+		data.vertex_data.clear();
+		return;
+	}
 
-			} // End if already in cache
+	std::vector<std::uint8_t> vertex_data(report.compressed_bytes);
+	gfx::vertexConvert(format, &vertex_data[0], source_format, &data.vertex_data[0], data.vertex_count);
 
-			  // Update the cache position records for all vertices in the cache
-			for (k = 0; k < vertex_cache_size; ++k)
-				vertex_info_ptr[vertex_cache_ptr[k]].cache_position = k;
+	// Quantize the positions relative to the center of the bounds. The scale
+	// is the same on every axis so that the whole decode fits in one vec4.
+	std::vector<float> positions;
+	if (quantize_positions)
+	{
+		positions = unpack_positions(source_format, &data.vertex_data[0], data.vertex_count);
 
-		} // Next Index
+		math::bbox bounds;
+		bounds.reset();
+		for (std::uint32_t i = 0; i < data.vertex_count; ++i)
+			bounds.add_point(math::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
 
-		  // Recalculate the of all vertices contained in the cache
-		for (j = 0; j < vertex_cache_size; ++j)
-		{
-			vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
-			vert_ptr->vertex_score = find_vertex_optimizer_score(vert_ptr);
+		const math::vec3 center = (bounds.min + bounds.max) * 0.5f;
+		const math::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+		float scale = std::max(extent.x, std::max(extent.y, extent.z));
+		if (scale <= 0.0f)
+			scale = 1.0f;
+		data.position_decode = math::vec4(center, scale);
 
-		} // Next entry in the vertex cache
+	} // End if quantize
 
-		  // Update the score of the triangles which reference this vertex
-		  // and record the highest scoring.
-		for (j = 0; j < vertex_cache_size; ++j)
+	const bool rebuild_handedness = source_format.has(gfx::Attrib::Bitangent) && !format.has(gfx::Attrib::Bitangent);
+	const math::vec4 decode = data.position_decode;
+	parallel_for("Compress Mesh Vertices", data.vertex_count, VerticesPerTask, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		for (std::uint32_t i = begin; i < end; ++i)
 		{
-			vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
-
-			// For each triangle referenced
-			for (k = 0; k < vert_ptr->unused_triangle_references; ++k)
+			if (quantize_positions)
 			{
-				triangle_index = vert_ptr->triangle_references[k];
-				tri_ptr = &triangle_info_ptr[triangle_index];
-				score = vertex_info_ptr[src_buffer_ptr[(triangle_index * 3)] - min_vertex].vertex_score;
-				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 1] - min_vertex].vertex_score;
-				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 2] - min_vertex].vertex_score;
-				tri_ptr->triangle_score = score;
-
-				// Highest scoring so far?
-				if (score > best_score)
-				{
-					best_score = score;
-					best_triangle = (signed)triangle_index;
-
-				} // End if better than previous score
-
-			} // Next Triangle
+				float position[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (std::uint32_t j = 0; j < 3; ++j)
+					position[j] = math::clamp((positions[i * 3 + j] - decode[j]) / decode.w, -1.0f, 1.0f);
+				gfx::vertexPack(position, true, gfx::Attrib::Position, format, &vertex_data[0], i);
+			}
 
-		} // Next entry in the vertex cache
+			// The bitangent is dropped, make sure that the handedness it
+			// carried is in the tangent.
+			if (rebuild_handedness)
+			{
+				float normal[4], tangent[4], bitangent[4];
+				gfx::vertexUnpack(normal, gfx::Attrib::Normal, source_format, &data.vertex_data[0], i);
+				gfx::vertexUnpack(tangent, gfx::Attrib::Tangent, source_format, &data.vertex_data[0], i);
+				gfx::vertexUnpack(bitangent, gfx::Attrib::Bitangent, source_format, &data.vertex_data[0], i);
+
+				const math::vec3 cross_vec = math::cross(math::vec3(normal[0], normal[1], normal[2]), math::vec3(tangent[0], tangent[1], tangent[2]));
+				tangent[3] = (math::dot(cross_vec, math::vec3(bitangent[0], bitangent[1], bitangent[2])) < 0.0f) ? -1.0f : 1.0f;
+				gfx::vertexPack(tangent, true, gfx::Attrib::Tangent, format, &vertex_data[0], i);
+			}
 
-	} // Next Triangle to Add
+		} // Next vertex
+	});
 
-	// Destroy the temporary arrays
-	checked_array_delete(vertex_info_ptr);
-	checked_array_delete(triangle_info_ptr);
+	data.vertex_data.swap(vertex_data);
 }
 
-
 void Mesh::draw()
 {
 	// Should we get involved in the rendering process?
@@ -3529,9 +4288,8 @@ bool Mesh::generate_vertex_components(bool weld)
 
 bool Mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr, UInt32Array* remap_array_ptr /* = nullptr */)
 {
-	std::uint32_t start_tri, previous_tri, current_tri;
-	math::vec3 vec_edge1, vec_edge2, vec_normal;
-	std::uint32_t i, j, k, index;
+	math::vec3 vec_normal;
+	std::uint32_t i, j, index;
 
 	// Get access to useful data offset information.
 	std::uint16_t position_offset = _vertex_format.getOffset(gfx::Attrib::Position);
@@ -3556,26 +4314,52 @@ bool Mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr, UInt32Array* re
 	std::uint8_t * src_vertices_ptr = &_preparation_data.vertex_data[0];
 	math::vec3 * normals_ptr = new math::vec3[_preparation_data.triangle_count];
 	memset(normals_ptr, 0, _preparation_data.triangle_count * sizeof(math::vec3));
-	for (i = 0; i < _preparation_data.triangle_count; ++i)
+	parallel_for("Generate Face Normals", _preparation_data.triangle_count, TrianglesPerTask, [&](std::uint32_t begin, std::uint32_t end)
 	{
-		// Retrieve positions of each referenced vertex.
-		const Triangle& tri = _preparation_data.triangle_data[i];
-		const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (tri.indices[0] * vertex_stride) + position_offset);
-		const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (tri.indices[1] * vertex_stride) + position_offset);
-		const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (tri.indices[2] * vertex_stride) + position_offset);
+		for (std::uint32_t face = begin; face < end; ++face)
+		{
+			// Retrieve positions of each referenced vertex.
+			const Triangle& tri = _preparation_data.triangle_data[face];
+			const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (tri.indices[0] * vertex_stride) + position_offset);
+			const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (tri.indices[1] * vertex_stride) + position_offset);
+			const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (tri.indices[2] * vertex_stride) + position_offset);
 
-		// Compute the two edge vectors required for generating our normal
-		// We normalize here to prevent problems when the triangles are very small.
-		vec_edge1 = math::normalize(*v2 - *v1);
-		vec_edge2 = math::normalize(*v3 - *v1);
+			// Compute the two edge vectors required for generating our normal
+			// We normalize here to prevent problems when the triangles are very small.
+			math::vec3 edge1 = math::normalize(*v2 - *v1);
+			math::vec3 edge2 = math::normalize(*v3 - *v1);
 
-		// Generate the normal
-		vec_normal = math::cross(vec_edge1, vec_edge2);
-		normals_ptr[i] = math::normalize(vec_normal);
+			// Generate the normal
+			normals_ptr[face] = math::normalize(math::cross(edge1, edge2));
 
-	} // Next Face
+		} // Next Face
+	});
+
+	// Gather the normal of every face corner that needs one. This only reads
+	// the face normals and adjacency, so triangles are processed in parallel.
+	math::vec3 * corner_normals_ptr = new math::vec3[_preparation_data.triangle_count * 3];
+	parallel_for("Gather Vertex Normals", _preparation_data.triangle_count, TrianglesPerTask, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		for (std::uint32_t face = begin; face < end; ++face)
+		{
+			const Triangle & tri = _preparation_data.triangle_data[face];
+			if (tri.flags & TriangleFlags::Degenerate)
+				continue;
+
+			for (std::uint32_t corner = 0; corner < 3; ++corner)
+			{
+				// Skip this vertex if normal information was already provided.
+				if (!_force_normal_generation && (_preparation_data.vertex_flags[tri.indices[corner]] & PreparationData::SourceContainsNormal))
+					continue;
+
+				corner_normals_ptr[(face * 3) + corner] = gather_vertex_normal(adjacency_ptr, normals_ptr, face, corner);
+
+			} // Next Vertex
+
+		} // Next Face
+	});
 
-	  // Now compute the actual VERTEX normals using face adjacency information
+	  // Now store the actual VERTEX normals
 	for (i = 0; i < _preparation_data.triangle_count; ++i)
 	{
 		Triangle & tri = _preparation_data.triangle_data[i];
@@ -3592,111 +4376,9 @@ bool Mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr, UInt32Array* re
 			if (!_force_normal_generation && (_preparation_data.vertex_flags[index] & PreparationData::SourceContainsNormal))
 				continue;
 
-			// To generate vertex normals using the adjacency information we first need to walk backwards
-			// through the list to find the first triangle that references this vertex (using entrance/exit edge strategy).
-			// Once we have the first triangle, step forwards and sum the normals of each of the faces
-			// for each triangle we touch. This is essentially a flood fill through all of the triangles
-			// that touch this vertex, without ever having to test the entire set for shared vertices.
-			// The initial backwards traversal prevents us from having to store (and test) a 'visited' flag for
-			// every triangle in the buffer.
-
-			// First walk backwards...
-			start_tri = i;
-			previous_tri = i;
-			current_tri = adjacency_ptr[(i * 3) + ((j + 2) % 3)];
-			for (; ; )
-			{
-				// Stop walking if we reach the starting triangle again, or if there
-				// is no connectivity out of this edge
-				if (current_tri == start_tri || current_tri == 0xFFFFFFFF)
-					break;
-
-				// Find the edge in the adjacency list that we came in through
-				for (k = 0; k < 3; ++k)
-				{
-					if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
-						break;
-
-				} // Next item in adjacency list
-
-				  // If we found the edge we entered through, the exit edge will
-				  // be the edge counter-clockwise from this one when walking backwards
-				if (k < 3)
-				{
-					previous_tri = current_tri;
-					current_tri = adjacency_ptr[(current_tri * 3) + ((k + 2) % 3)];
-
-				} // End if found entrance edge
-				else
-				{
-					break;
-
-				} // End if failed to find entrance edge
-
-			} // Next Test
-
-			  // We should now be at the starting triangle, we can start to walk forwards
-			  // collecting the face normals. First find the exit edge so we can start walking.
-			if (current_tri != 0xFFFFFFFF)
-			{
-				for (k = 0; k < 3; ++k)
-				{
-					if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
-						break;
-
-				} // Next item in adjacency list
-			}
-			else
-			{
-				// Couldn't step back, so first triangle is the current triangle
-				current_tri = i;
-				k = j;
-			}
-
-			if (k < 3)
-			{
-				start_tri = current_tri;
-				previous_tri = current_tri;
-				current_tri = adjacency_ptr[(current_tri * 3) + k];
-				vec_normal = normals_ptr[start_tri];
-				for (; ; )
-				{
-					// Stop walking if we reach the starting triangle again, or if there
-					// is no connectivity out of this edge
-					if (current_tri == start_tri || current_tri == 0xFFFFFFFF)
-						break;
-
-					// Add this normal.
-					vec_normal += normals_ptr[current_tri];
-
-					// Find the edge in the adjacency list that we came in through
-					for (k = 0; k < 3; ++k)
-					{
-						if (adjacency_ptr[(current_tri * 3) + k] == previous_tri)
-							break;
-
-					} // Next item in adjacency list
-
-					  // If we found the edge we came entered through, the exit edge will
-					  // be the edge clockwise from this one when walking forwards
-					if (k < 3)
-					{
-						previous_tri = current_tri;
-						current_tri = adjacency_ptr[(current_tri * 3) + ((k + 1) % 3)];
-
-					} // End if found entrance edge
-					else
-					{
-						break;
-
-					} // End if failed to find entrance edge
-
-				} // Next Test
-
-			} // End if found entrance edge
-
-			  // Normalize the new vertex normal
-			vec_normal = math::normalize(vec_normal);
+			// Stored vertices may be split below, which appends to the vertex
+			// data, so this part runs sequentially in triangle order.
+			vec_normal = corner_normals_ptr[(i * 3) + j];
 
 			// If the normal we are about to store is significantly different from any normal
 			// already stored in this vertex (excepting the case where it is <0,0,0>), we need
@@ -3756,6 +4438,7 @@ bool Mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr, UInt32Array* re
 
 	// We're done with the surface normals
 	checked_array_delete(normals_ptr);
+	checked_array_delete(corner_normals_ptr);
 
 	// If no new vertices were introduced, then it is not necessary
 	// for the caller to remap anything.
@@ -3776,9 +4459,9 @@ bool Mesh::generate_vertex_barycentrics(std::uint32_t* adjacency)
 bool Mesh::generate_vertex_tangents()
 {
 	math::vec3* tangents = nullptr, *bitangents = nullptr;
-	std::uint32_t i, i1, i2, i3, num_faces, num_verts;
-	math::vec3 P, Q, T, B, cross_vec, normal_vec;
-	float s1, t1, s2, t2, r;
+	math::vec3* face_vectors = nullptr;
+	std::uint8_t* face_valid = nullptr;
+	std::uint32_t i, num_faces, num_verts;
 
 	// Get access to useful data offset information.
 	std::uint16_t vertex_stride = _vertex_format.getStride();
@@ -3803,143 +4486,173 @@ bool Mesh::generate_vertex_tangents()
 	memset(tangents, 0, sizeof(math::vec3) * num_verts);
 	memset(bitangents, 0, sizeof(math::vec3) * num_verts);
 
-	// Iterate through each triangle in the mesh
+	// Per triangle tangent (even entries) and bitangent (odd entries), and
+	// whether the triangle has usable texture coordinates.
+	face_vectors = new math::vec3[num_faces * 2];
+	face_valid = new std::uint8_t[num_faces];
+
+	// Compute the vectors of each triangle in the mesh. Triangles are
+	// independent, so ranges of them are processed in parallel.
 	std::uint8_t * src_vertices_ptr = &_preparation_data.vertex_data[0];
-	for (i = 0; i < num_faces; ++i)
+	parallel_for("Generate Face Tangents", num_faces, TrianglesPerTask, [&](std::uint32_t begin, std::uint32_t end)
 	{
-		Triangle& tri = _preparation_data.triangle_data[i];
+		math::vec3 P, Q;
+		float s1, t1, s2, t2, r;
+		for (std::uint32_t face = begin; face < end; ++face)
+		{
+			const Triangle& tri = _preparation_data.triangle_data[face];
+			face_valid[face] = 0;
+
+			// Compute the three indices for the triangle
+			std::uint32_t i1 = tri.indices[0];
+			std::uint32_t i2 = tri.indices[1];
+			std::uint32_t i3 = tri.indices[2];
+
+			// Retrieve references to the positions of the three vertices in the triangle.
+			math::vec3 E;
+			float fE[4];
+			gfx::vertexUnpack(fE, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i1);
+			math::vec3 F;
+			float fF[4];
+			gfx::vertexUnpack(fF, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i2);
+			math::vec3 G;
+			float fG[4];
+			gfx::vertexUnpack(fG, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i3);
+			memcpy(&E[0], fE, 3 * sizeof(float));
+			memcpy(&F[0], fF, 3 * sizeof(float));
+			memcpy(&G[0], fG, 3 * sizeof(float));
+
+			// Retrieve references to the base texture coordinates of the three vertices in the triangle.
+			// TODO: Allow customization of which tex coordinates to generate from.
+			math::vec2 Et;
+			float fEt[4];
+			gfx::vertexUnpack(&fEt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i1);
+			math::vec2 Ft;
+			float fFt[4];
+			gfx::vertexUnpack(&fFt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i2);
+			math::vec2 Gt;
+			float fGt[4];
+			gfx::vertexUnpack(&fGt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i3);
+			memcpy(&Et[0], fEt, 2 * sizeof(float));
+			memcpy(&Ft[0], fFt, 2 * sizeof(float));
+			memcpy(&Gt[0], fGt, 2 * sizeof(float));
+
+			// Compute the known variables P & Q, where "P = F-E" and "Q = G-E"
+			// based on our original discussion of the tangent vector
+			// calculation.
+			P = F - E;
+			Q = G - E;
+
+			// Also compute the know variables <s1,t1> and <s2,t2>. Recall that
+			// these are the texture coordinate deltas similarly for "F-E"
+			// and "G-E".
+			s1 = Ft.x - Et.x;
+			t1 = Ft.y - Et.y;
+			s2 = Gt.x - Et.x;
+			t2 = Gt.y - Et.y;
+
+			// Next we can pre-compute part of the equation we developed
+			// earlier: "1/(s1 * t2 - s2 * t1)". We do this in two separate
+			// stages here in order to ensure that the texture coordinates
+			// are not invalid.
+			r = (s1 * t2 - s2 * t1);
+			if (math::abs(r) < math::epsilon<float>())
+				continue;
+			r = 1.0f / r;
+
+			// All that's left for us to do now is to run the matrix
+			// multiplication and multiply the result by the scalar portion
+			// we precomputed earlier.
+			math::vec3& T = face_vectors[face * 2];
+			math::vec3& B = face_vectors[face * 2 + 1];
+			T.x = r * (t2 * P.x - t1 * Q.x);
+			T.y = r * (t2 * P.y - t1 * Q.y);
+			T.z = r * (t2 * P.z - t1 * Q.z);
+			B.x = r * (s1 * Q.x - s2 * P.x);
+			B.y = r * (s1 * Q.y - s2 * P.y);
+			B.z = r * (s1 * Q.z - s2 * P.z);
+			face_valid[face] = 1;
 
-		// Compute the three indices for the triangle
-		i1 = tri.indices[0];
-		i2 = tri.indices[1];
-		i3 = tri.indices[2];
-
-		// Retrieve references to the positions of the three vertices in the triangle.
-		math::vec3 E;
-		float fE[4];
-		gfx::vertexUnpack(fE, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i1);
-		math::vec3 F;
-		float fF[4];
-		gfx::vertexUnpack(fF, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i2);
-		math::vec3 G;
-		float fG[4];
-		gfx::vertexUnpack(fG, gfx::Attrib::Position, _vertex_format, src_vertices_ptr, i3);
-		memcpy(&E[0], fE, 3 * sizeof(float));
-		memcpy(&F[0], fF, 3 * sizeof(float));
-		memcpy(&G[0], fG, 3 * sizeof(float));
-
-		// Retrieve references to the base texture coordinates of the three vertices in the triangle.
-		// TODO: Allow customization of which tex coordinates to generate from.
-		math::vec2 Et;
-		float fEt[4];
-		gfx::vertexUnpack(&fEt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i1);
-		math::vec2 Ft;
-		float fFt[4];
-		gfx::vertexUnpack(&fFt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i2);
-		math::vec2 Gt;
-		float fGt[4];
-		gfx::vertexUnpack(&fGt[0], gfx::Attrib::TexCoord0, _vertex_format, src_vertices_ptr, i3);
-		memcpy(&Et[0], fEt, 2 * sizeof(float));
-		memcpy(&Ft[0], fFt, 2 * sizeof(float));
-		memcpy(&Gt[0], fGt, 2 * sizeof(float));
-
-		// Compute the known variables P & Q, where "P = F-E" and "Q = G-E"
-		// based on our original discussion of the tangent vector
-		// calculation.
-		P = F - E;
-		Q = G - E;
-
-		// Also compute the know variables <s1,t1> and <s2,t2>. Recall that
-		// these are the texture coordinate deltas similarly for "F-E"
-		// and "G-E".
-		s1 = Ft.x - Et.x;
-		t1 = Ft.y - Et.y;
-		s2 = Gt.x - Et.x;
-		t2 = Gt.y - Et.y;
-
-		// Next we can pre-compute part of the equation we developed
-		// earlier: "1/(s1 * t2 - s2 * t1)". We do this in two separate
-		// stages here in order to ensure that the texture coordinates
-		// are not invalid.
-		r = (s1 * t2 - s2 * t1);
-		if (math::abs(r) < math::epsilon<float>())
-			continue;
-		r = 1.0f / r;
-
-		// All that's left for us to do now is to run the matrix
-		// multiplication and multiply the result by the scalar portion
-		// we precomputed earlier.
-		T.x = r * (t2 * P.x - t1 * Q.x);
-		T.y = r * (t2 * P.y - t1 * Q.y);
-		T.z = r * (t2 * P.z - t1 * Q.z);
-		B.x = r * (s1 * Q.x - s2 * P.x);
-		B.y = r * (s1 * Q.y - s2 * P.y);
-		B.z = r * (s1 * Q.z - s2 * P.z);
-
-		// Add the tangent and bitangent vectors (summed average) to
-		// any previous values computed for each vertex.
-		tangents[i1] += T;
-		tangents[i2] += T;
-		tangents[i3] += T;
-		bitangents[i1] += B;
-		bitangents[i2] += B;
-		bitangents[i3] += B;
-
-	} // Next Triangle 
-
-	  // Generate final tangent vectors 
-	for (i = 0; i < num_verts; i++, src_vertices_ptr += vertex_stride)
-	{
-		// Skip if the original imported data already provided a bitangent / tangent.
-		bool has_bitangent = ((_preparation_data.vertex_flags[i] & PreparationData::SourceContainsBinormal) != 0);
-		bool has_tangent = ((_preparation_data.vertex_flags[i] & PreparationData::SourceContainsTangent) != 0);
-		if (!_force_tangent_generation && has_bitangent && has_tangent)
+		} // Next Triangle
+	});
+
+	// Add the tangent and bitangent vectors (summed average) to any previous
+	// values computed for each vertex. This reduction stays in triangle order
+	// so that the sums do not depend on how the triangles were scheduled.
+	for (i = 0; i < num_faces; ++i)
+	{
+		if (!face_valid[i])
 			continue;
 
-		// Retrieve the normal vector from the vertex and the computed
-		// tangent vector.
-		float normal[4];
-		gfx::vertexUnpack(normal, gfx::Attrib::Normal, _vertex_format, src_vertices_ptr);
-		memcpy(&normal_vec[0], normal, 3 * sizeof(float));
+		const Triangle& tri = _preparation_data.triangle_data[i];
+		const math::vec3& T = face_vectors[i * 2];
+		const math::vec3& B = face_vectors[i * 2 + 1];
+		tangents[tri.indices[0]] += T;
+		tangents[tri.indices[1]] += T;
+		tangents[tri.indices[2]] += T;
+		bitangents[tri.indices[0]] += B;
+		bitangents[tri.indices[1]] += B;
+		bitangents[tri.indices[2]] += B;
+
+	} // Next Triangle
+
+	  // Generate final tangent vectors, every vertex is written independently.
+	parallel_for("Generate Vertex Tangents", num_verts, VerticesPerTask, [&](std::uint32_t begin, std::uint32_t end)
+	{
+		math::vec3 T, B, cross_vec, normal_vec;
+		for (std::uint32_t vertex = begin; vertex < end; ++vertex)
+		{
+			std::uint8_t * vertex_ptr = src_vertices_ptr + (vertex * vertex_stride);
 
-		T = tangents[i];
+			// Skip if the original imported data already provided a bitangent / tangent.
+			bool has_bitangent = ((_preparation_data.vertex_flags[vertex] & PreparationData::SourceContainsBinormal) != 0);
+			bool has_tangent = ((_preparation_data.vertex_flags[vertex] & PreparationData::SourceContainsTangent) != 0);
+			if (!_force_tangent_generation && has_bitangent && has_tangent)
+				continue;
 
-		// GramSchmidt orthogonalize
-		T = T - (normal_vec * math::dot(normal_vec, T));
-		T = math::normalize(T);
+			// Retrieve the normal vector from the vertex and the computed
+			// tangent vector.
+			float normal[4];
+			gfx::vertexUnpack(normal, gfx::Attrib::Normal, _vertex_format, vertex_ptr);
+			memcpy(&normal_vec[0], normal, 3 * sizeof(float));
 
-		// Store tangent if required
-		if (_force_tangent_generation || (!has_tangent && requires_tangents))
-			gfx::vertexPack(&math::vec4(T, 1.0f)[0], true, gfx::Attrib::Tangent, _vertex_format, src_vertices_ptr);
+			T = tangents[vertex];
 
-		// Compute and store bitangent if required
-		if (_force_tangent_generation || (!has_bitangent && requires_bitangents))
-		{
-			// Calculate the new orthogonal bitangent
-			B = math::cross(normal_vec, T);
-			B = math::normalize(B);
+			// GramSchmidt orthogonalize
+			T = T - (normal_vec * math::dot(normal_vec, T));
+			T = math::normalize(T);
 
 			// Compute the "handedness" of the tangent and bitangent. This
 			// ensures the inverted / mirrored texture coordinates still have
 			// an accurate matrix.
 			cross_vec = math::cross(normal_vec, T);
-			if (math::dot(cross_vec, bitangents[i]) < 0.0f)
-			{
-				// Flip the bitangent
-				B = -B;
+			const float handedness = (math::dot(cross_vec, bitangents[vertex]) < 0.0f) ? -1.0f : 1.0f;
 
-			} // End if coordinates inverted
+			// Store tangent if required. The handedness is kept in w so that
+			// formats without a bitangent can rebuild it in the shader.
+			if (_force_tangent_generation || (!has_tangent && requires_tangents))
+				gfx::vertexPack(&math::vec4(T, handedness)[0], true, gfx::Attrib::Tangent, _vertex_format, vertex_ptr);
 
-			  // Store.
-			gfx::vertexPack(&math::vec4(B, 1.0f)[0], true, gfx::Attrib::Bitangent, _vertex_format, src_vertices_ptr);
+			// Compute and store bitangent if required
+			if (_force_tangent_generation || (!has_bitangent && requires_bitangents))
+			{
+				// Calculate the new orthogonal bitangent
+				B = math::cross(normal_vec, T);
+				B = math::normalize(B) * handedness;
 
-		} // End if requires bitangent   
+				// Store.
+				gfx::vertexPack(&math::vec4(B, 1.0f)[0], true, gfx::Attrib::Bitangent, _vertex_format, vertex_ptr);
 
-	} // Next vertex
+			} // End if requires bitangent   
+
+		} // Next vertex
+	});
 
 	  // Cleanup 
 	checked_array_delete(tangents);
 	checked_array_delete(bitangents);
+	checked_array_delete(face_vectors);
+	checked_array_delete(face_valid);
 
 	// Return success 
 	return true;
@@ -3947,9 +4660,6 @@ bool Mesh::generate_vertex_tangents()
 
 bool Mesh::generate_adjacency(UInt32Array& adjacency)
 {
-	std::map< AdjacentEdgeKey, std::uint32_t > edge_tree;
-	std::map< AdjacentEdgeKey, std::uint32_t >::iterator it_edge;
-
 	// What is the status of the mesh?
 	if (_prepare_status != MeshStatus::Prepared)
 	{
@@ -3961,36 +4671,19 @@ bool Mesh::generate_adjacency(UInt32Array& adjacency)
 		std::uint16_t position_offset = _vertex_format.getOffset(gfx::Attrib::Position);
 		std::uint16_t vertex_stride = _vertex_format.getStride();
 
-		// Insert all edges into the edge tree
+		// Insert all edges into the edge hash
 		std::uint8_t * src_vertices_ptr = &_preparation_data.vertex_data[0] + position_offset;
+		AdjacentEdgeHash edge_hash(src_vertices_ptr, vertex_stride, _preparation_data.vertex_count, _preparation_data.triangle_count * 3);
 		for (std::uint32_t i = 0; i < _preparation_data.triangle_count; ++i)
 		{
-			AdjacentEdgeKey edge;
-
 			// Degenerate triangles cannot participate.
 			const Triangle & tri = _preparation_data.triangle_data[i];
 			if (tri.flags & TriangleFlags::Degenerate)
 				continue;
 
-			// Retrieve positions of each referenced vertex.
-			const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (tri.indices[0] * vertex_stride));
-			const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (tri.indices[1] * vertex_stride));
-			const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (tri.indices[2] * vertex_stride));
-
-			// edge 1
-			edge.vertex1 = v1;
-			edge.vertex2 = v2;
-			edge_tree[edge] = i;
-
-			// edge 2
-			edge.vertex1 = v2;
-			edge.vertex2 = v3;
-			edge_tree[edge] = i;
-
-			// edge 3
-			edge.vertex1 = v3;
-			edge.vertex2 = v1;
-			edge_tree[edge] = i;
+			edge_hash.insert(tri.indices[0], tri.indices[1], i);
+			edge_hash.insert(tri.indices[1], tri.indices[2], i);
+			edge_hash.insert(tri.indices[2], tri.indices[0], i);
 
 		} // Next Face
 
@@ -4000,49 +4693,20 @@ bool Mesh::generate_adjacency(UInt32Array& adjacency)
 		// Now, find any adjacent edges for each triangle edge
 		for (std::uint32_t i = 0; i < _preparation_data.triangle_count; ++i)
 		{
-			AdjacentEdgeKey edge;
-
 			// Degenerate triangles cannot participate.
 			const Triangle & tri = _preparation_data.triangle_data[i];
 			if (tri.flags & TriangleFlags::Degenerate)
 				continue;
 
-			// Retrieve positions of each referenced vertex.
-			const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (tri.indices[0] * vertex_stride));
-			const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (tri.indices[1] * vertex_stride));
-			const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (tri.indices[2] * vertex_stride));
-
 			// Note: Notice below that the order of the edge vertices
 			//       is swapped. This is because we want to find the 
 			//       matching ADJACENT edge, rather than simply finding
 			//       the same edge that we're currently processing.
 
-			// edge 1
-			edge.vertex2 = v1;
-			edge.vertex1 = v2;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3)] = it_edge->second;
-
-			// edge 2
-			edge.vertex2 = v2;
-			edge.vertex1 = v3;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3) + 1] = it_edge->second;
-
-			// edge 3
-			edge.vertex2 = v3;
-			edge.vertex1 = v1;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3) + 2] = it_edge->second;
+			// Find the matching adjacent edges
+			adjacency[(i * 3)] = edge_hash.find(tri.indices[1], tri.indices[0]);
+			adjacency[(i * 3) + 1] = edge_hash.find(tri.indices[2], tri.indices[1]);
+			adjacency[(i * 3) + 2] = edge_hash.find(tri.indices[0], tri.indices[2]);
 
 		} // Next Face
 
@@ -4057,32 +4721,15 @@ bool Mesh::generate_adjacency(UInt32Array& adjacency)
 		std::uint16_t position_offset = _vertex_format.getOffset(gfx::Attrib::Position);
 		std::uint16_t vertex_stride = _vertex_format.getStride();
 
-		// Insert all edges into the edge tree
+		// Insert all edges into the edge hash
 		std::uint8_t * src_vertices_ptr = _system_vb + position_offset;
 		std::uint32_t * src_indices_ptr = _system_ib;
+		AdjacentEdgeHash edge_hash(src_vertices_ptr, vertex_stride, _vertex_count, _face_count * 3);
 		for (std::uint32_t i = 0; i < _face_count; ++i, src_indices_ptr += 3)
 		{
-			AdjacentEdgeKey edge;
-
-			// Retrieve positions of each referenced vertex.
-			const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[0] * vertex_stride));
-			const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[1] * vertex_stride));
-			const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[2] * vertex_stride));
-
-			// edge 1
-			edge.vertex1 = v1;
-			edge.vertex2 = v2;
-			edge_tree[edge] = i;
-
-			// edge 2
-			edge.vertex1 = v2;
-			edge.vertex2 = v3;
-			edge_tree[edge] = i;
-
-			// edge 3
-			edge.vertex1 = v3;
-			edge.vertex2 = v1;
-			edge_tree[edge] = i;
+			edge_hash.insert(src_indices_ptr[0], src_indices_ptr[1], i);
+			edge_hash.insert(src_indices_ptr[1], src_indices_ptr[2], i);
+			edge_hash.insert(src_indices_ptr[2], src_indices_ptr[0], i);
 
 		} // Next Face
 
@@ -4093,44 +4740,15 @@ bool Mesh::generate_adjacency(UInt32Array& adjacency)
 		src_indices_ptr = _system_ib;
 		for (std::uint32_t i = 0; i < _face_count; ++i, src_indices_ptr += 3)
 		{
-			AdjacentEdgeKey edge;
-
-			// Retrieve positions of each referenced vertex.
-			const math::vec3 * v1 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[0] * vertex_stride));
-			const math::vec3 * v2 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[1] * vertex_stride));
-			const math::vec3 * v3 = (math::vec3*)(src_vertices_ptr + (src_indices_ptr[2] * vertex_stride));
-
 			// Note: Notice below that the order of the edge vertices
 			//       is swapped. This is because we want to find the 
 			//       matching ADJACENT edge, rather than simply finding
 			//       the same edge that we're currently processing.
 
-			// edge 1
-			edge.vertex2 = v1;
-			edge.vertex1 = v2;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3)] = it_edge->second;
-
-			// edge 2
-			edge.vertex2 = v2;
-			edge.vertex1 = v3;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3) + 1] = it_edge->second;
-
-			// edge 3
-			edge.vertex2 = v3;
-			edge.vertex1 = v1;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if (it_edge != edge_tree.end())
-				adjacency[(i * 3) + 2] = it_edge->second;
+			// Find the matching adjacent edges
+			adjacency[(i * 3)] = edge_hash.find(src_indices_ptr[1], src_indices_ptr[0]);
+			adjacency[(i * 3) + 1] = edge_hash.find(src_indices_ptr[2], src_indices_ptr[1]);
+			adjacency[(i * 3) + 2] = edge_hash.find(src_indices_ptr[0], src_indices_ptr[2]);
 
 		} // Next Face
 
@@ -4143,9 +4761,6 @@ bool Mesh::generate_adjacency(UInt32Array& adjacency)
 
 bool Mesh::weld_vertices(float tolerance, UInt32Array* vertex_remap_ptr /* = nullptr */)
 {
-	WeldKey key;
-	std::map< WeldKey, std::uint32_t > vertex_tree;
-	std::map< WeldKey, std::uint32_t >::const_iterator it_key;
 	ByteArray new_vertex_data, new_vertex_flags;
 	std::uint32_t new_vertex_count = 0;
 
@@ -4156,28 +4771,25 @@ bool Mesh::weld_vertices(float tolerance, UInt32Array* vertex_remap_ptr /* = nul
 
 	// Retrieve useful data offset information.
 	std::uint16_t vertex_stride = _vertex_format.getStride();
+	new_vertex_data.reserve(_preparation_data.vertex_data.size());
+	new_vertex_flags.reserve(_preparation_data.vertex_count);
 
 	// For each vertex to be welded.
+	VertexWeldGrid grid(_vertex_format, tolerance, _preparation_data.vertex_count);
 	for (std::uint32_t i = 0; i < _preparation_data.vertex_count; ++i)
 	{
-		// Build a new key structure for inserting
-		key.vertex = (&_preparation_data.vertex_data[0]) + (i * vertex_stride);
-		key.format = _vertex_format;
-		key.tolerance = tolerance;
-
-		// Does a vertex with matching details already exist in the tree.
-		it_key = vertex_tree.find(key);
-		if (it_key == vertex_tree.end())
+		// Does a vertex with matching details already exist in the grid.
+		const std::uint8_t* vertex = (&_preparation_data.vertex_data[0]) + (i * vertex_stride);
+		const std::uint32_t welded = grid.weld(vertex, new_vertex_count);
+		if (welded == new_vertex_count)
 		{
-			// No matching vertex. Insert into the tree (value = NEW index of vertex).
-			vertex_tree[key] = new_vertex_count;
+			// No matching vertex. It was inserted into the grid (value = NEW index of vertex).
 			collapse_map[i] = new_vertex_count;
 			if (vertex_remap_ptr)
 				(*vertex_remap_ptr)[i] = new_vertex_count;
 
 			// Store the vertex in the new buffer
-			new_vertex_data.resize((new_vertex_count + 1) * vertex_stride);
-			memcpy(&new_vertex_data[new_vertex_count * vertex_stride], key.vertex, vertex_stride);
+			new_vertex_data.insert(new_vertex_data.end(), vertex, vertex + vertex_stride);
 			new_vertex_flags.push_back(_preparation_data.vertex_flags[i]);
 			new_vertex_count++;
 
@@ -4186,7 +4798,7 @@ bool Mesh::weld_vertices(float tolerance, UInt32Array* vertex_remap_ptr /* = nul
 		{
 			// A vertex already existed at this location.
 			// Just mark the 'collapsed' index for this vertex in the remap array.
-			collapse_map[i] = it_key->second;
+			collapse_map[i] = welded;
 			if (vertex_remap_ptr)
 				(*vertex_remap_ptr)[i] = 0xFFFFFFFF;
 
@@ -4269,6 +4881,11 @@ const gfx::VertexDecl& Mesh::get_vertex_format() const
 	return _vertex_format;
 }
 
+void Mesh::set_position_decode(const math::vec4& decode)
+{
+	_position_decode = decode;
+}
+
 
 const Mesh::Subset* Mesh::get_subset(std::uint32_t data_group_id /* = 0 */) const
 {
@@ -4476,56 +5093,42 @@ BonePalette::~BonePalette()
 {
 }
 
-std::vector<math::transform_t> BonePalette::get_skinning_matrices(const math::transform_t& root_transform, const std::vector<math::transform_t>& node_transforms, const SkinBindData& bind_data, bool compute_inverse_transpose) const
+core::frame_vector<math::mat4> BonePalette::get_skinning_matrices(const math::transform_t& root_transform, const core::frame_vector<math::transform_t>& node_transforms, const SkinBindData& bind_data, bool compute_inverse_transpose) const
 {
 	// Retrieve the main list of bones from the skin bind data that will
 	// be referenced by the palette's bone index list.
 	const auto& bind_list = bind_data.get_bones();
+	const std::uint32_t max_blend_transforms = gfx::get_max_blend_transforms();
+	core::frame_vector<math::mat4> transforms(max_blend_transforms);
 	if (node_transforms.empty())
-		return node_transforms;
+		return transforms;
 
-	const std::uint32_t max_blend_transforms = gfx::get_max_blend_transforms();
-	std::vector<math::transform_t> transforms;
-	transforms.resize(max_blend_transforms);
-	// Compute transformation matrix for each bone in the palette
-	if (compute_inverse_transpose)
+	// Gather the node and bind pose matrices of the bones in the palette and
+	// compute root * node * bind_pose for all of them in one go.
+	const std::size_t bone_count = std::min<std::size_t>(_bones.size(), max_blend_transforms);
+	core::frame_vector<math::mat4> bind_poses(bone_count);
+	for (size_t i = 0; i < bone_count; ++i)
 	{
-		std::vector<math::transform_t> inverse_transpospose_transforms;
-		inverse_transpospose_transforms.resize(max_blend_transforms);
-
-		for (size_t i = 0; i < _bones.size(); ++i)
-		{
-			auto& bone_transform = node_transforms[_bones[i]];
-			const auto& bone_data = bind_list[_bones[i]];
-
-			transforms[i] = root_transform * bone_transform * bone_data.bind_pose_transform;
-
-			// Compute inverse transpose
-			inverse_transpospose_transforms[i] = transforms[i];
-			inverse_transpospose_transforms[i] = math::inverse(inverse_transpospose_transforms[i]);
-			inverse_transpospose_transforms[i] = math::transpose(inverse_transpospose_transforms[i]);
+		transforms[i] = node_transforms[_bones[i]].matrix();
+		bind_poses[i] = bind_list[_bones[i]].bind_pose_transform.matrix();
 
-		} // Next Bone
-
-		return inverse_transpospose_transforms;
+	} // Next Bone
+	math::batch::mul(transforms.data(), bind_poses.data(), transforms.data(), bone_count);
+	math::batch::mul(root_transform.matrix(), transforms.data(), transforms.data(), bone_count);
 
-	} // End if compute_inverse_transpose
-	else
+	// Compute inverse transpose
+	if (compute_inverse_transpose)
 	{
-
-		for (size_t i = 0; i < _bones.size(); ++i)
+		for (size_t i = 0; i < bone_count; ++i)
 		{
-			auto& bone_transform = node_transforms[_bones[i]];
-			const auto& bone_data = bind_list[_bones[i]];
-
-			transforms[i] = root_transform * bone_transform * bone_data.bind_pose_transform;
+			math::transform_t::affine_inverse(transforms[i], transforms[i]);
+			transforms[i] = glm::transpose(transforms[i]);
 
 		} // Next Bone
 
-		return transforms;
-
-	} // End if !compute_inverse_transpose
+	} // End if compute_inverse_transpose
 
+	return transforms;
 }
 
 
@@ -4667,28 +5270,6 @@ const UInt32Array & BonePalette::get_bones() const
 ///////////////////////////////////////////////////////////////////////////////
 // Global Operator Definitions
 ///////////////////////////////////////////////////////////////////////////////
-bool operator < (const Mesh::AdjacentEdgeKey& key1, const Mesh::AdjacentEdgeKey& key2)
-{
-	// Test vertex positions.
-	if (math::epsilonNotEqual(key1.vertex1->x, key2.vertex1->x, math::epsilon<float>()))
-		return (key2.vertex1->x < key1.vertex1->x);
-	if (math::epsilonNotEqual(key1.vertex1->y, key2.vertex1->y, math::epsilon<float>()))
-		return (key2.vertex1->y < key1.vertex1->y);
-	if (math::epsilonNotEqual(key1.vertex1->z, key2.vertex1->z, math::epsilon<float>()))
-		return (key2.vertex1->z < key1.vertex1->z);
-
-	if (math::epsilonNotEqual(key1.vertex2->x, key2.vertex2->x, math::epsilon<float>()))
-		return (key2.vertex2->x < key1.vertex2->x);
-	if (math::epsilonNotEqual(key1.vertex2->y, key2.vertex2->y, math::epsilon<float>()))
-		return (key2.vertex2->y < key1.vertex2->y);
-	if (math::epsilonNotEqual(key1.vertex2->z, key2.vertex2->z, math::epsilon<float>()))
-		return (key2.vertex2->z < key1.vertex2->z);
-
-	// Exactly equal
-	return false;
-}
-
-
 bool operator < (const Mesh::MeshSubsetKey& key1, const Mesh::MeshSubsetKey& key2)
 {
 	std::int32_t difference = (std::int32_t)key1.data_group_id - (std::int32_t)key2.data_group_id;
@@ -4699,20 +5280,6 @@ bool operator < (const Mesh::MeshSubsetKey& key1, const Mesh::MeshSubsetKey& key
 	return false;
 }
 
-bool operator < (const Mesh::WeldKey& key1, const Mesh::WeldKey& key2)
-{
-	float pos1[4];
-	gfx::vertexUnpack(pos1, gfx::Attrib::Position, key1.format, key1.vertex);
-	math::vec3 v1(pos1[0], pos1[1], pos1[2]);
-
-	float pos2[4];
-	gfx::vertexUnpack(pos1, gfx::Attrib::Position, key2.format, key2.vertex);
-	math::vec3 v2(pos2[0], pos2[1], pos2[2]);
-	float tolerance = key1.tolerance * key2.tolerance;
-
-	return math::distance2(v1, v2) > tolerance;
-}
-
 bool operator < (const Mesh::BoneCombinationKey& key1, const Mesh::BoneCombinationKey& key2)
 {
 	const Mesh::FaceInfluences* p1 = key1.influences;
@@ -4,6 +4,7 @@
 #include "core/math/math_includes.h"
 #include "core/reflection/reflection.h"
 #include "core/serialization/serialization.h"
+#include "core/memory/frame_allocator.hpp"
 #include <vector>
 #include <map>
 #include <memory>
@@ -230,12 +231,15 @@ public:
 	//  Name : get_skinning_matrices()
 	/// <summary>
 	/// Gather the bone / palette information and matrices ready for
-	/// drawing the skinned mesh.
+	/// drawing the skinned mesh. The result always holds
+	/// gfx::get_max_blend_transforms() matrices, laid out as expected by
+	/// the transform upload. The matrices live in frame memory, they are
+	/// valid until the end of the frame.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::vector<math::transform_t> get_skinning_matrices(
+	core::frame_vector<math::mat4> get_skinning_matrices(
 		const math::transform_t& root_transform, 
-		const std::vector<math::transform_t>& node_transforms,
+		const core::frame_vector<math::transform_t>& node_transforms,
 		const SkinBindData& bind_data,
 		bool compute_inverse_transpose) const;
 
@@ -455,6 +459,37 @@ public:
 		std::unique_ptr<ArmatureNode> root_node = nullptr;
 		/// Use TextureType as index
 		std::vector<Mat> materials;
+		/// Decodes quantized positions (position = stored * w + xyz). Identity
+		/// unless the positions were quantized by compress_load_data.
+		math::vec4 position_decode = { 0.0f, 0.0f, 0.0f, 1.0f };
+	};
+
+	// Result of compressing the vertex data of load data.
+	struct CompressionReport
+	{
+		/// Size of the vertex data before compression.
+		std::size_t source_bytes = 0;
+		/// Size of the vertex data after compression.
+		std::size_t compressed_bytes = 0;
+		/// Stride of a vertex before compression.
+		std::uint16_t source_stride = 0;
+		/// Stride of a vertex after compression.
+		std::uint16_t compressed_stride = 0;
+	};
+
+	// Result of generating a level of detail from load data.
+	struct LodReport
+	{
+		/// Number of triangles in the source data.
+		std::uint32_t source_triangles = 0;
+		/// Number of triangles in the generated level of detail.
+		std::uint32_t triangles = 0;
+		/// Number of vertices in the source data.
+		std::uint32_t source_vertices = 0;
+		/// Number of vertices in the generated level of detail.
+		std::uint32_t vertices = 0;
+		/// Largest deviation introduced, relative to the extent of the mesh.
+		float error = 0.0f;
 	};
 
 	//-------------------------------------------------------------------------
@@ -731,7 +766,9 @@ public:
 	//  Name : end_prepare ()
 	/// <summary>
 	/// All data has been added to the mesh and we should now build the
-	/// render data for the mesh.
+	/// render data for the mesh. Per triangle, per vertex and per subset
+	/// stages are split across the task system when it is running; the
+	/// result does not depend on how they were scheduled.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	bool end_prepare(bool hardware_copy = true, bool weld = true, bool optimize = true, bool build_buffers = true);
@@ -756,6 +793,53 @@ public:
 	//-----------------------------------------------------------------------------
 	void build_ib(bool hardware_copy = true);
 
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_load_data () (Static)
+	/// <summary>
+	/// Reorders the triangles and vertices of imported mesh data the same way
+	/// end_prepare does when asked to optimize, so that the work can be done
+	/// once offline. Triangles are grouped by data group in the order the mesh
+	/// sorts them into subsets.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void optimize_load_data(LoadData& data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : generate_lod () (Static)
+	/// <summary>
+	/// Builds a simplified copy of imported mesh data with roughly
+	/// triangle_ratio of the source triangles, stopping early when the error
+	/// would exceed max_error (relative to the mesh extent). Every data group
+	/// is simplified on its own, positions shared between data groups never
+	/// move, vertices only collapse onto vertices dominated by the same bone,
+	/// and unreferenced vertices are removed together with their skin
+	/// influences. The result is not optimized, see optimize_load_data.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool generate_lod(const LoadData& source, float triangle_ratio, float max_error, LoadData& lod, LodReport& report);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_compressed_format () (Static)
+	/// <summary>
+	/// Builds the packed counterpart of a vertex format. Texture coordinates are
+	/// stored as half floats and the bitangent is dropped, the shaders rebuild it
+	/// from the normal and the handedness kept in the tangent's w. Positions are
+	/// optionally quantized to 16 bit signed normalized integers. Normals and
+	/// tangents keep their 8:8:8:8 encoding and every other attribute is copied.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static gfx::VertexDecl get_compressed_format(const gfx::VertexDecl& format, bool quantize_positions);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compress_load_data () (Static)
+	/// <summary>
+	/// Converts imported mesh data to the format returned by
+	/// get_compressed_format. Quantized positions are stored relative to the
+	/// bounds of the mesh and position_decode is set to map them back.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void compress_load_data(LoadData& data, bool quantize_positions, CompressionReport& report);
+
 	// Utility functions
 	//-----------------------------------------------------------------------------
 	//  Name : generate_adjacency ()
@@ -817,6 +901,25 @@ public:
 	//-----------------------------------------------------------------------------
 	const gfx::VertexDecl& get_vertex_format() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_position_decode ()
+	/// <summary>
+	/// Sets the transform that maps quantized vertex positions back to object
+	/// space (position = stored * w + xyz). Must be called between prepare_mesh
+	/// and end_prepare so that the bounds are computed in object space.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_position_decode(const math::vec4& decode);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_position_decode ()
+	/// <summary>
+	/// Retrieve the transform that maps the stored vertex positions to object
+	/// space. Passed to the vertex shaders as u_position_decode.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const math::vec4& get_position_decode() const { return _position_decode; }
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_skin_bind_data ()
 	/// <summary>
@@ -835,6 +938,15 @@ public:
 	//-----------------------------------------------------------------------------
 	const BonePaletteArray& get_bone_palettes() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_armature ()
+	/// <summary>
+	/// Retrieve the node tree imported along with the mesh, if any. The bones
+	/// of the skin bind data refer to these nodes by name.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const ArmatureNode* get_armature() const { return _root.get(); }
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_subset ()
 	/// <summary>
@@ -871,6 +983,16 @@ public:
 	//-----------------------------------------------------------------------------
 	inline std::size_t get_subset_count() const { return _mesh_subsets.size(); }
 
+	//-----------------------------------------------------------------------------
+	//  Name : is_hardware_mesh ()
+	/// <summary>
+	/// Returns true if the mesh is drawn from its own vertex and index buffers.
+	/// Software meshes are copied into transient buffers on every draw, which
+	/// has to happen on the main thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline bool is_hardware_mesh() const { return _hardware_mesh; }
+
 protected:
 	//-------------------------------------------------------------------------
 	// Protected Structures, Typedefs and Enumerations
@@ -917,38 +1039,6 @@ protected:
 
 	}; // End Struct PreparationData
 
-	// Mesh Sorting / Optimization structures
-	struct OptimizerVertexInfo
-	{
-		/// The position of the vertex in the pseudo-cache
-		std::int32_t cache_position = -1;
-		/// The score associated with this vertex
-		float vertex_score = 0.0f;
-		/// Total number of triangles that reference this vertex that have not yet been added
-		std::uint32_t unused_triangle_references = 0;
-		/// List of all of the triangles referencing this vertex
-		UInt32Array triangle_references;
-
-	}; // End Struct OptimizerVertexInfo
-
-	struct OptimizerTriangleInfo
-	{
-		/// The sum of all three child vertex scores.
-		float triangle_score = 0.0f;
-		/// Has the triangle been added to the draw list already?
-		bool added = false;
-
-	}; // End Struct OptimizerTriangleInfo
-
-	struct AdjacentEdgeKey
-	{
-		/// Pointer to the first vertex in the edge
-		const math::vec3* vertex1 = nullptr;
-		/// Pointer to the second vertex in the edge
-		const math::vec3* vertex2 = nullptr;
-
-	}; // End Struct AdjacentEdgeKey
-
 	struct MeshSubsetKey
 	{
 		/// The data group identifier for this subset.
@@ -965,18 +1055,6 @@ protected:
 	using SubsetKeyMap = std::map<MeshSubsetKey, Subset*>;
 	using SubsetKeyArray = std::vector<MeshSubsetKey>;
 
-	// Simple structure to allow us to leverage the hierarchical properties of a map
-	// to accelerate the weld operation.
-	struct WeldKey
-	{
-		// Pointer to the vertex for easy access.
-		std::uint8_t* vertex;
-		// Format of the above vertex for easy access.
-		gfx::VertexDecl format;
-		// The tolerance we're using to weld (transport only, these should be the same for every key).
-		float tolerance;
-	};
-
 	struct FaceInfluences
 	{
 		BonePalette::BoneIndexMap bones;          // List of unique bones that influence a given number of faces.
@@ -998,9 +1076,7 @@ protected:
 	//-------------------------------------------------------------------------
 	// Friend List
 	//-------------------------------------------------------------------------
-	friend bool operator < (const AdjacentEdgeKey& key1, const AdjacentEdgeKey& key2);
 	friend bool operator < (const MeshSubsetKey& key1, const MeshSubsetKey& key2);
-	friend bool operator < (const WeldKey& key1, const WeldKey& key2);
 	friend bool operator < (const BoneCombinationKey& key1, const BoneCombinationKey& key2);
 	//-------------------------------------------------------------------------
 	// Protected Methods
@@ -1045,7 +1121,9 @@ protected:
 	//-----------------------------------------------------------------------------
 	//  Name : weld_vertices ()
 	/// <summary>
-	/// Weld all of the vertices together that can be combined.
+	/// Weld all of the vertices together that can be combined. Vertices are
+	/// combined when their positions are within tolerance of each other and
+	/// the rest of their data matches.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	bool weld_vertices(float tolerance = 0.000001f, UInt32Array* vertexRemap = nullptr);
@@ -1067,39 +1145,6 @@ protected:
 	//-----------------------------------------------------------------------------
 	void render_mesh_data(std::uint32_t face_start, std::uint32_t face_count, std::uint32_t vertex_start, std::uint32_t vertex_count);
 
-	//-------------------------------------------------------------------------
-	// Protected Static Functions
-	//-------------------------------------------------------------------------
-	//-----------------------------------------------------------------------------
-	//  Name : build_optimized_index_buffer () (Private, Static)
-	/// <summary>
-	/// Calculate the best order for triangle data, optimizing for efficient
-	/// use of the hardware vertex cache, given an unkown vertex cache size
-	/// and implementation.
-	/// Note : Thanks to Tom Forsyth for the fantastic implementation on which
-	/// this is based.
-	/// URL  : http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
-	/// </summary>
-	//-----------------------------------------------------------------------------
-	static void build_optimized_index_buffer(
-		const Subset* subset,
-		std::uint32_t* source_buffer_ptr, 
-		std::uint32_t* destination_buffer_ptr,
-		std::uint32_t minimum_vertex, 
-		std::uint32_t maximum_vertex);
-
-	//-----------------------------------------------------------------------------
-	//  Name : find_vertex_optimizer_score () (Private, Static)
-	/// <summary>
-	/// During optimization, this method will generate scores used to
-	/// identify important vertices when ordering triangle data.
-	/// Note : Thanks to Tom Forsyth for the fantastic implementation on which
-	/// this is based.
-	/// URL  : http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
-	/// </summary>
-	//-----------------------------------------------------------------------------
-	static float find_vertex_optimizer_score(const OptimizerVertexInfo* vertex_info_ptr);
-
 	//-------------------------------------------------------------------------
 	// Protected Variables
 	//-------------------------------------------------------------------------
@@ -1142,6 +1187,8 @@ protected:
 	bool _optimize_mesh;
 	/// Axis aligned bounding box describing object dimensions (in object space)
 	math::bbox _bbox;
+	/// Maps stored vertex positions to object space (position = stored * w + xyz).
+	math::vec4 _position_decode = { 0.0f, 0.0f, 0.0f, 1.0f };
 	/// Total number of faces in the prepared mesh.
 	std::uint32_t _face_count;
 	/// Total number of vertices in the prepared mesh.
@@ -1165,14 +1212,6 @@ protected:
 //-----------------------------------------------------------------------------
 // Global Operators
 //-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//  Name : operator < () (AdjacentEdgeKey&, AdjacentEdgeKey&)
-/// <summary>
-/// Perform less than comparison on the AdjacentEdgeKey structure.
-/// </summary>
-//-----------------------------------------------------------------------------
-inline bool operator < (const Mesh::AdjacentEdgeKey& key1, const Mesh::AdjacentEdgeKey& key2);
-
 //-----------------------------------------------------------------------------
 //  Name : operator < () (MeshSubsetKey&, MeshSubsetKey&)
 /// <summary>
@@ -1181,14 +1220,6 @@ inline bool operator < (const Mesh::AdjacentEdgeKey& key1, const Mesh::AdjacentE
 //-----------------------------------------------------------------------------
 inline bool operator < (const Mesh::MeshSubsetKey& key1, const Mesh::MeshSubsetKey& key2);
 
-//-----------------------------------------------------------------------------
-//  Name : operator < () (WeldKey&, WeldKey&)
-/// <summary>
-/// Perform less than comparison on the WeldKey structure.
-/// </summary>
-//-----------------------------------------------------------------------------
-inline bool operator < (const Mesh::WeldKey& key1, const Mesh::WeldKey& key2);
-
 //-----------------------------------------------------------------------------
 //  Name : operator < () (BoneCombinationKey&, BoneCombinationKey&)
 /// <summary>
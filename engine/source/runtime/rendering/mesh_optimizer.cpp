@@ -0,0 +1,455 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Local Module Level Namespaces.
+//-----------------------------------------------------------------------------
+namespace
+{
+	// Settings for the vertex cache optimizer.
+	const float CacheDecayPower = 1.5f;
+	const float LastTriScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+	const std::uint32_t MaxVertexCacheSize = 32;
+	const std::uint32_t MaxValence = 64;
+	const std::uint32_t InvalidIndex = 0xFFFFFFFF;
+
+	// Vertex scores only depend on the cache position and on the number of
+	// remaining triangles, so both terms are computed once up front.
+	struct ScoreTables
+	{
+		/// Score by cache position. The last entry is used for vertices not in the cache.
+		float cache[MaxVertexCacheSize + 1];
+		/// Score by number of triangles still referencing the vertex.
+		float valence[MaxValence + 1];
+
+		ScoreTables()
+		{
+			const float scaler = 1.0f / (MaxVertexCacheSize - 3);
+			for (std::uint32_t i = 0; i < MaxVertexCacheSize; ++i)
+			{
+				// The last triangle's vertices get a fixed score so that the
+				// optimizer does not favor the order it was added in.
+				if (i < 3)
+					cache[i] = LastTriScore;
+				else
+					cache[i] = std::pow(1.0f - (i - 3) * scaler, CacheDecayPower);
+			}
+			cache[MaxVertexCacheSize] = 0.0f;
+
+			valence[0] = 0.0f;
+			for (std::uint32_t i = 1; i <= MaxValence; ++i)
+				valence[i] = ValenceBoostScale * std::pow(static_cast<float>(i), -ValenceBoostPower);
+		}
+
+		float get_score(std::int32_t cache_position, std::uint32_t live_triangles) const
+		{
+			// No remaining triangles use this vertex?
+			if (live_triangles == 0)
+				return -1.0f;
+
+			const std::uint32_t position = cache_position < 0 ? MaxVertexCacheSize : static_cast<std::uint32_t>(cache_position);
+			return cache[position] + valence[std::min(live_triangles, MaxValence)];
+		}
+	};
+
+	const ScoreTables& get_score_tables()
+	{
+		static const ScoreTables tables;
+		return tables;
+	}
+
+	// Triangles referencing each vertex, stored in a single array with an
+	// offset per vertex. Emitted triangles are removed by swapping them with
+	// the last live entry of the vertex.
+	struct TriangleAdjacency
+	{
+		/// Live triangles per vertex.
+		std::vector<std::uint32_t> counts;
+		/// Start of the triangles of each vertex.
+		std::vector<std::uint32_t> offsets;
+		/// Triangle indices.
+		std::vector<std::uint32_t> triangles;
+
+		TriangleAdjacency(const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count)
+			: counts(vertex_count, 0)
+			, offsets(vertex_count, 0)
+			, triangles(index_count)
+		{
+			for (std::size_t i = 0; i < index_count; ++i)
+				counts[indices[i]]++;
+
+			std::uint32_t offset = 0;
+			for (std::uint32_t i = 0; i < vertex_count; ++i)
+			{
+				offsets[i] = offset;
+				offset += counts[i];
+				counts[i] = 0;
+			}
+
+			for (std::size_t i = 0; i < index_count; ++i)
+			{
+				const std::uint32_t vertex = indices[i];
+				triangles[offsets[vertex] + counts[vertex]++] = static_cast<std::uint32_t>(i / 3);
+			}
+		}
+
+		void remove(std::uint32_t vertex, std::uint32_t triangle)
+		{
+			std::uint32_t* list = &triangles[offsets[vertex]];
+			std::uint32_t& count = counts[vertex];
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				if (list[i] == triangle)
+				{
+					list[i] = list[count - 1];
+					--count;
+					return;
+				}
+			}
+		}
+	};
+
+	// FIFO cache simulation. A vertex is in the cache if fewer than 'size'
+	// misses happened since it was loaded. Bumping the timestamp by more than
+	// the cache size flushes it in constant time.
+	struct CacheSimulator
+	{
+		std::vector<std::uint32_t> timestamps;
+		std::uint32_t timestamp;
+		std::uint32_t size;
+
+		CacheSimulator(std::uint32_t vertex_count, std::uint32_t cache_size)
+			: timestamps(vertex_count, 0)
+			, timestamp(cache_size + 1)
+			, size(cache_size)
+		{
+		}
+
+		void flush()
+		{
+			timestamp += size + 1;
+		}
+
+		std::uint32_t access(std::uint32_t vertex)
+		{
+			if (timestamp - timestamps[vertex] > size)
+			{
+				timestamps[vertex] = timestamp++;
+				return 1;
+			}
+			return 0;
+		}
+
+		std::uint32_t access_triangle(const std::uint32_t* triangle)
+		{
+			return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+		}
+	};
+
+	struct OverdrawCluster
+	{
+		/// First triangle of the cluster.
+		std::uint32_t start = 0;
+		/// Number of triangles in the cluster.
+		std::uint32_t count = 0;
+		/// Distance of the cluster along its normal from the mesh centroid.
+		float sort_key = 0.0f;
+	};
+
+	const float* get_position(const float* positions, std::size_t stride, std::uint32_t vertex)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const std::uint8_t*>(positions) + vertex * stride);
+	}
+}
+
+const float MeshOptimizer::DefaultOverdrawThreshold = 1.05f;
+
+float MeshOptimizer::VertexCacheStats::get_acmr() const
+{
+	return triangle_count ? static_cast<float>(vertices_transformed) / triangle_count : 0.0f;
+}
+
+float MeshOptimizer::VertexCacheStats::get_atvr() const
+{
+	return vertex_count ? static_cast<float>(vertices_transformed) / vertex_count : 0.0f;
+}
+
+MeshOptimizer::VertexCacheStats& MeshOptimizer::VertexCacheStats::operator+=(const VertexCacheStats& rhs)
+{
+	triangle_count += rhs.triangle_count;
+	vertex_count += rhs.vertex_count;
+	vertices_transformed += rhs.vertices_transformed;
+	return *this;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyze_vertex_cache(const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count, std::uint32_t cache_size /* = DefaultCacheSize */)
+{
+	VertexCacheStats stats;
+	stats.triangle_count = static_cast<std::uint32_t>(index_count / 3);
+
+	CacheSimulator cache(vertex_count, cache_size);
+	std::vector<std::uint8_t> referenced(vertex_count, 0);
+	for (std::size_t i = 0; i < index_count; ++i)
+	{
+		const std::uint32_t vertex = indices[i];
+		stats.vertices_transformed += cache.access(vertex);
+		if (!referenced[vertex])
+		{
+			referenced[vertex] = 1;
+			stats.vertex_count++;
+		}
+	}
+	return stats;
+}
+
+void MeshOptimizer::optimize_vertex_cache(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count)
+{
+	const std::uint32_t face_count = static_cast<std::uint32_t>(index_count / 3);
+	if (face_count == 0)
+		return;
+
+	const ScoreTables& tables = get_score_tables();
+	TriangleAdjacency adjacency(indices, face_count * 3, vertex_count);
+
+	std::vector<float> vertex_scores(vertex_count);
+	std::vector<std::int32_t> cache_positions(vertex_count, -1);
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+		vertex_scores[i] = tables.get_score(-1, adjacency.counts[i]);
+
+	std::vector<std::uint8_t> emitted(face_count, 0);
+
+	// Cache of the optimizer (not the simulated hardware one). The new cache is
+	// built from the emitted triangle followed by the old contents, so it can
+	// temporarily hold three more entries.
+	std::uint32_t cache[MaxVertexCacheSize + 3];
+	std::uint32_t new_cache[MaxVertexCacheSize + 3];
+	std::uint32_t cache_size = 0;
+
+	// Next triangle to take when none of the cached vertices has any left. It
+	// only ever moves forward so these restarts are linear overall.
+	std::uint32_t input_cursor = 0;
+	std::uint32_t current = InvalidIndex;
+
+	for (std::uint32_t output = 0; output < face_count; ++output)
+	{
+		if (current == InvalidIndex)
+		{
+			while (emitted[input_cursor])
+				++input_cursor;
+			current = input_cursor;
+		}
+
+		// Emit the triangle and detach it from its vertices.
+		const std::uint32_t* triangle = indices + current * 3;
+		const std::uint32_t a = triangle[0], b = triangle[1], c = triangle[2];
+		destination[output * 3 + 0] = a;
+		destination[output * 3 + 1] = b;
+		destination[output * 3 + 2] = c;
+		emitted[current] = 1;
+		adjacency.remove(a, current);
+		adjacency.remove(b, current);
+		adjacency.remove(c, current);
+
+		// Move its vertices to the front of the cache.
+		std::uint32_t new_cache_size = 0;
+		new_cache[new_cache_size++] = a;
+		if (b != a)
+			new_cache[new_cache_size++] = b;
+		if (c != a && c != b)
+			new_cache[new_cache_size++] = c;
+		for (std::uint32_t i = 0; i < cache_size; ++i)
+		{
+			const std::uint32_t vertex = cache[i];
+			if (vertex != a && vertex != b && vertex != c)
+				new_cache[new_cache_size++] = vertex;
+		}
+
+		// Rescore everything that moved, including vertices that fell out.
+		for (std::uint32_t i = 0; i < new_cache_size; ++i)
+		{
+			const std::uint32_t vertex = new_cache[i];
+			cache_positions[vertex] = i < MaxVertexCacheSize ? static_cast<std::int32_t>(i) : -1;
+			vertex_scores[vertex] = tables.get_score(cache_positions[vertex], adjacency.counts[vertex]);
+		}
+
+		cache_size = std::min(new_cache_size, MaxVertexCacheSize);
+		std::memcpy(cache, new_cache, cache_size * sizeof(std::uint32_t));
+
+		// Only the triangles of cached vertices had their score changed, so the
+		// best one is searched for among them.
+		current = InvalidIndex;
+		float best_score = -1.0f;
+		for (std::uint32_t i = 0; i < cache_size; ++i)
+		{
+			const std::uint32_t vertex = cache[i];
+			const std::uint32_t* list = &adjacency.triangles[adjacency.offsets[vertex]];
+			const std::uint32_t count = adjacency.counts[vertex];
+			for (std::uint32_t j = 0; j < count; ++j)
+			{
+				const std::uint32_t candidate = list[j];
+				const std::uint32_t* candidate_indices = indices + candidate * 3;
+				const float score = vertex_scores[candidate_indices[0]] + vertex_scores[candidate_indices[1]] + vertex_scores[candidate_indices[2]];
+				if (score > best_score)
+				{
+					best_score = score;
+					current = candidate;
+				}
+			}
+		}
+	}
+}
+
+void MeshOptimizer::optimize_overdraw(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, const float* positions, std::uint32_t vertex_count, std::size_t position_stride, float threshold /* = DefaultOverdrawThreshold */)
+{
+	const std::uint32_t face_count = static_cast<std::uint32_t>(index_count / 3);
+	if (face_count == 0)
+		return;
+
+	// Hard boundaries are where the cache optimizer had to restart, i.e. where
+	// a triangle misses the cache with all three vertices. Reordering clusters
+	// at those points costs nothing.
+	CacheSimulator cache(vertex_count, DefaultCacheSize);
+	std::vector<std::uint32_t> hard_boundaries;
+	for (std::uint32_t i = 0; i < face_count; ++i)
+	{
+		if (cache.access_triangle(indices + i * 3) == 3 || i == 0)
+			hard_boundaries.push_back(i);
+	}
+	hard_boundaries.push_back(face_count);
+
+	// Split further wherever the cluster so far is already within the
+	// threshold of the ACMR of the whole hard cluster.
+	std::vector<OverdrawCluster> clusters;
+	for (std::size_t i = 0; i + 1 < hard_boundaries.size(); ++i)
+	{
+		const std::uint32_t start = hard_boundaries[i];
+		const std::uint32_t end = hard_boundaries[i + 1];
+
+		cache.flush();
+		std::uint32_t misses = 0;
+		for (std::uint32_t j = start; j < end; ++j)
+			misses += cache.access_triangle(indices + j * 3);
+		const float target_acmr = threshold * misses / (end - start);
+
+		cache.flush();
+		std::uint32_t cluster_start = start;
+		std::uint32_t cluster_misses = 0;
+		for (std::uint32_t j = start; j < end; ++j)
+		{
+			cluster_misses += cache.access_triangle(indices + j * 3);
+
+			const std::uint32_t cluster_size = j + 1 - cluster_start;
+			if (j + 1 == end || cluster_misses <= target_acmr * cluster_size)
+			{
+				OverdrawCluster cluster;
+				cluster.start = cluster_start;
+				cluster.count = cluster_size;
+				clusters.push_back(cluster);
+
+				cache.flush();
+				cluster_start = j + 1;
+				cluster_misses = 0;
+			}
+		}
+	}
+
+	// Centroid and area weighted normal of every cluster.
+	std::vector<float> cluster_data(clusters.size() * 6, 0.0f);
+	float mesh_centroid[3] = { 0.0f, 0.0f, 0.0f };
+	for (std::size_t i = 0; i < clusters.size(); ++i)
+	{
+		float* centroid = &cluster_data[i * 6];
+		float* normal = centroid + 3;
+		for (std::uint32_t j = clusters[i].start; j < clusters[i].start + clusters[i].count; ++j)
+		{
+			const float* p0 = get_position(positions, position_stride, indices[j * 3 + 0]);
+			const float* p1 = get_position(positions, position_stride, indices[j * 3 + 1]);
+			const float* p2 = get_position(positions, position_stride, indices[j * 3 + 2]);
+
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			normal[0] += e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] += e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] += e1[0] * e2[1] - e1[1] * e2[0];
+
+			for (std::uint32_t k = 0; k < 3; ++k)
+				centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f;
+		}
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			mesh_centroid[k] += centroid[k];
+			centroid[k] /= clusters[i].count;
+		}
+	}
+	for (std::uint32_t k = 0; k < 3; ++k)
+		mesh_centroid[k] /= face_count;
+
+	// Clusters facing away from the center are likely to occlude the others,
+	// so they are drawn first.
+	for (std::size_t i = 0; i < clusters.size(); ++i)
+	{
+		const float* centroid = &cluster_data[i * 6];
+		const float* normal = centroid + 3;
+		const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length <= 0.0f)
+			continue;
+
+		float dot = 0.0f;
+		for (std::uint32_t k = 0; k < 3; ++k)
+			dot += (centroid[k] - mesh_centroid[k]) * normal[k];
+		clusters[i].sort_key = dot / length;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const OverdrawCluster& lhs, const OverdrawCluster& rhs)
+	{
+		return lhs.sort_key > rhs.sort_key;
+	});
+
+	std::uint32_t* output = destination;
+	for (const auto& cluster : clusters)
+	{
+		std::memcpy(output, indices + cluster.start * 3, cluster.count * 3 * sizeof(std::uint32_t));
+		output += cluster.count * 3;
+	}
+}
+
+std::uint32_t MeshOptimizer::optimize_vertex_fetch(std::uint32_t* remap, const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count)
+{
+	std::fill(remap, remap + vertex_count, InvalidIndex);
+
+	std::uint32_t next_vertex = 0;
+	for (std::size_t i = 0; i < index_count; ++i)
+	{
+		std::uint32_t& new_index = remap[indices[i]];
+		if (new_index == InvalidIndex)
+			new_index = next_vertex++;
+	}
+
+	const std::uint32_t referenced_count = next_vertex;
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		if (remap[i] == InvalidIndex)
+			remap[i] = next_vertex++;
+	}
+	return referenced_count;
+}
+
+void MeshOptimizer::remap_index_buffer(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, const std::uint32_t* remap)
+{
+	for (std::size_t i = 0; i < index_count; ++i)
+		destination[i] = remap[indices[i]];
+}
+
+void MeshOptimizer::remap_vertex_buffer(void* destination, const void* vertices, std::uint32_t vertex_count, std::size_t vertex_stride, const std::uint32_t* remap)
+{
+	auto dst = static_cast<std::uint8_t*>(destination);
+	auto src = static_cast<const std::uint8_t*>(vertices);
+	for (std::uint32_t i = 0; i < vertex_count; ++i)
+		std::memcpy(dst + remap[i] * vertex_stride, src + i * vertex_stride, vertex_stride);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : MeshOptimizer (Struct)
+/// <summary>
+/// Index and vertex reordering passes for triangle lists. Every pass runs in
+/// (near) linear time, works on raw buffers so that it can be used both when
+/// a mesh is prepared and offline by the asset compiler, and none of them
+/// change the rendered result - only the order in which it is produced.
+/// The usual order is optimize_vertex_cache, optimize_overdraw and finally
+/// optimize_vertex_fetch once all the index ranges sharing a vertex buffer
+/// have been processed.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct MeshOptimizer
+{
+	//-----------------------------------------------------------------------------
+	//  Name : VertexCacheStats (Struct)
+	/// <summary>
+	/// Result of simulating a FIFO post transform cache over a triangle list.
+	/// Stats of several index ranges can be accumulated with +=.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct VertexCacheStats
+	{
+		/// Number of triangles in the list.
+		std::uint32_t triangle_count = 0;
+		/// Number of distinct vertices referenced by the list.
+		std::uint32_t vertex_count = 0;
+		/// Number of vertex shader invocations (cache misses).
+		std::uint32_t vertices_transformed = 0;
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_acmr ()
+		/// <summary>
+		/// Average cache miss ratio - transformed vertices per triangle. 0.5 is
+		/// the best possible value for large regular grids, 3 the worst.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		float get_acmr() const;
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_atvr ()
+		/// <summary>
+		/// Average transform to vertex ratio - transformed vertices per referenced
+		/// vertex. 1 means that every vertex is only transformed once.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		float get_atvr() const;
+
+		VertexCacheStats& operator+=(const VertexCacheStats& rhs);
+	};
+
+	/// Cache size used when simulating and scoring. Small enough to be a
+	/// pessimistic estimate for every piece of hardware we target.
+	static const std::uint32_t DefaultCacheSize = 16;
+	/// Default ACMR degradation allowed by the overdraw pass.
+	static const float DefaultOverdrawThreshold;
+
+	//-----------------------------------------------------------------------------
+	//  Name : analyze_vertex_cache () (Static)
+	/// <summary>
+	/// Simulates a FIFO post transform cache of the specified size over the
+	/// triangle list and returns the resulting statistics.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static VertexCacheStats analyze_vertex_cache(const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count, std::uint32_t cache_size = DefaultCacheSize);
+
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_vertex_cache () (Static)
+	/// <summary>
+	/// Reorders the triangles for efficient use of the post transform cache
+	/// without knowing its exact size or implementation. Indices must be in the
+	/// [0, vertex_count) range. The destination must not alias the source.
+	/// Note : The scoring is Tom Forsyth's "Linear-Speed Vertex Cache
+	/// Optimisation". Adjacency is kept in flat arrays and the next triangle is
+	/// only searched for among the triangles of the vertices in the cache, with
+	/// a linear cursor over the input once those run out.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void optimize_vertex_cache(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_overdraw () (Static)
+	/// <summary>
+	/// Reorders the clusters of a cache optimized triangle list so that the
+	/// outward facing ones are drawn first, reducing overdraw. Clusters are
+	/// split so that the ACMR grows by at most the threshold factor (1.05 means
+	/// up to 5% worse). Positions are read as three floats at the start of
+	/// every position_stride bytes. The destination must not alias the source.
+	/// Note : Based on Sander, Nehab and Barczak, "Fast Triangle Reordering for
+	/// Vertex Locality and Reduced Overdraw".
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void optimize_overdraw(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, const float* positions, std::uint32_t vertex_count, std::size_t position_stride, float threshold = DefaultOverdrawThreshold);
+
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_vertex_fetch () (Static)
+	/// <summary>
+	/// Builds a remap table (remap[old vertex] = new vertex) that orders the
+	/// vertices by first use in the index list, so that the vertex buffer is
+	/// fetched sequentially. Vertices that are never referenced are moved to
+	/// the end, in their original order, so no vertex is lost. Returns the
+	/// number of referenced vertices.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint32_t optimize_vertex_fetch(std::uint32_t* remap, const std::uint32_t* indices, std::size_t index_count, std::uint32_t vertex_count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remap_index_buffer () (Static)
+	/// <summary>
+	/// Applies a remap table built by optimize_vertex_fetch to an index list.
+	/// Can be done in place.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void remap_index_buffer(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, const std::uint32_t* remap);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remap_vertex_buffer () (Static)
+	/// <summary>
+	/// Applies a remap table built by optimize_vertex_fetch to a vertex buffer.
+	/// The destination must not alias the source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void remap_vertex_buffer(void* destination, const void* vertices, std::uint32_t vertex_count, std::size_t vertex_stride, const std::uint32_t* remap);
+};
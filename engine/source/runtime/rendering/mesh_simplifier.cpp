@@ -0,0 +1,659 @@
+#include "mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Local Module Level Namespaces.
+//-----------------------------------------------------------------------------
+namespace
+{
+	const std::uint32_t InvalidIndex = 0xFFFFFFFF;
+	/// Weight of the planes that keep borders and seams in place, relative
+	/// to the area weighted planes of the faces.
+	const double EdgeWeight = 10.0;
+	/// A collapse is rejected if it turns a triangle by more than ~90 degrees.
+	const float FlipThreshold = 1e-2f;
+
+	enum class VertexKind : std::uint8_t
+	{
+		/// Interior vertex, can collapse onto any neighbor.
+		Manifold,
+		/// Vertex on an open border, can only collapse along the border.
+		Border,
+		/// One of two vertices sharing a position across an attribute seam,
+		/// both collapse together along the seam.
+		Seam,
+		/// Never moves.
+		Locked
+	};
+
+	struct Vector3
+	{
+		float x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+
+	Vector3 operator-(const Vector3& lhs, const Vector3& rhs)
+	{
+		Vector3 result;
+		result.x = lhs.x - rhs.x;
+		result.y = lhs.y - rhs.y;
+		result.z = lhs.z - rhs.z;
+		return result;
+	}
+
+	Vector3 cross(const Vector3& lhs, const Vector3& rhs)
+	{
+		Vector3 result;
+		result.x = lhs.y * rhs.z - lhs.z * rhs.y;
+		result.y = lhs.z * rhs.x - lhs.x * rhs.z;
+		result.z = lhs.x * rhs.y - lhs.y * rhs.x;
+		return result;
+	}
+
+	float dot(const Vector3& lhs, const Vector3& rhs)
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
+	}
+
+	float length(const Vector3& v)
+	{
+		return std::sqrt(dot(v, v));
+	}
+
+	// Symmetric 4x4 matrix measuring the weighted sum of squared distances to
+	// a set of planes.
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+		double a10 = 0.0, a20 = 0.0, a21 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		void add_plane(const Vector3& normal, double distance, double plane_weight)
+		{
+			const double nx = normal.x, ny = normal.y, nz = normal.z;
+			a00 += plane_weight * nx * nx;
+			a11 += plane_weight * ny * ny;
+			a22 += plane_weight * nz * nz;
+			a10 += plane_weight * ny * nx;
+			a20 += plane_weight * nz * nx;
+			a21 += plane_weight * nz * ny;
+			b0 += plane_weight * nx * distance;
+			b1 += plane_weight * ny * distance;
+			b2 += plane_weight * nz * distance;
+			c += plane_weight * distance * distance;
+			weight += plane_weight;
+		}
+
+		void add(const Quadric& q)
+		{
+			a00 += q.a00; a11 += q.a11; a22 += q.a22;
+			a10 += q.a10; a20 += q.a20; a21 += q.a21;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+
+		// Squared distance, averaged by the weight of the planes.
+		double get_error(const Vector3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double rx = a00 * x + a10 * y + a20 * z;
+			const double ry = a10 * x + a11 * y + a21 * z;
+			const double rz = a20 * x + a21 * y + a22 * z;
+			const double error = rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0.0 ? std::abs(error) / weight : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		std::uint32_t from = 0;
+		std::uint32_t to = 0;
+		double error = 0.0;
+	};
+
+	// Triangles around each vertex of the current index list.
+	struct VertexTriangles
+	{
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> counts;
+		std::vector<std::uint32_t> triangles;
+
+		void build(const std::vector<std::uint32_t>& indices, std::uint32_t vertex_count)
+		{
+			counts.assign(vertex_count, 0);
+			offsets.assign(vertex_count, 0);
+			triangles.resize(indices.size());
+
+			for (auto index : indices)
+				counts[index]++;
+
+			std::uint32_t offset = 0;
+			for (std::uint32_t i = 0; i < vertex_count; ++i)
+			{
+				offsets[i] = offset;
+				offset += counts[i];
+				counts[i] = 0;
+			}
+
+			for (std::size_t i = 0; i < indices.size(); ++i)
+				triangles[offsets[indices[i]] + counts[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::uint32_t* indices, std::size_t index_count, const float* positions, std::uint32_t vertex_count, std::size_t position_stride, const std::uint8_t* vertex_locks, const std::uint32_t* vertex_groups)
+			: _indices(indices, indices + index_count)
+			, _vertex_count(vertex_count)
+			, _vertex_locks(vertex_locks)
+			, _vertex_groups(vertex_groups)
+		{
+			load_positions(positions, position_stride);
+			build_position_ids();
+		}
+
+		std::size_t run(std::size_t target_index_count, float target_error, float* result_error)
+		{
+			const double error_limit = double(target_error) * double(target_error);
+			double max_error = 0.0;
+
+			build_face_quadrics();
+
+			bool first_pass = true;
+			while (_indices.size() > target_index_count)
+			{
+				_adjacency.build(_indices, _vertex_count);
+				classify_vertices();
+
+				if (first_pass)
+					build_edge_quadrics();
+				first_pass = false;
+
+				std::vector<Collapse> collapses;
+				collect_collapses(collapses);
+				std::stable_sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+				{
+					return lhs.error < rhs.error;
+				});
+
+				const std::size_t triangle_goal = (_indices.size() - target_index_count) / 3;
+				if (apply_collapses(collapses, std::max<std::size_t>(triangle_goal, 1), error_limit, max_error) == 0)
+					break;
+
+				remove_degenerate_triangles();
+			}
+
+			if (result_error)
+				*result_error = static_cast<float>(std::sqrt(max_error));
+			return _indices.size();
+		}
+
+		const std::vector<std::uint32_t>& get_indices() const
+		{
+			return _indices;
+		}
+
+	private:
+		void load_positions(const float* positions, std::size_t stride)
+		{
+			// Work in a unit box so that errors are relative to the mesh size.
+			_points.resize(_vertex_count);
+			Vector3 minimum, maximum;
+			for (std::uint32_t i = 0; i < _vertex_count; ++i)
+			{
+				const float* p = reinterpret_cast<const float*>(reinterpret_cast<const std::uint8_t*>(positions) + i * stride);
+				_points[i].x = p[0];
+				_points[i].y = p[1];
+				_points[i].z = p[2];
+				if (i == 0)
+				{
+					minimum = maximum = _points[i];
+					continue;
+				}
+				minimum.x = std::min(minimum.x, p[0]); maximum.x = std::max(maximum.x, p[0]);
+				minimum.y = std::min(minimum.y, p[1]); maximum.y = std::max(maximum.y, p[1]);
+				minimum.z = std::min(minimum.z, p[2]); maximum.z = std::max(maximum.z, p[2]);
+			}
+
+			const float extent = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+			const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+			for (auto& point : _points)
+			{
+				point.x = (point.x - minimum.x) * scale;
+				point.y = (point.y - minimum.y) * scale;
+				point.z = (point.z - minimum.z) * scale;
+			}
+		}
+
+		void build_position_ids()
+		{
+			// Vertices with identical positions are the wedges of one position.
+			// Each gets the id of the first of them, and they are linked in a
+			// ring so that all wedges of a vertex can be visited.
+			std::vector<std::uint32_t> order(_vertex_count);
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [this](std::uint32_t lhs, std::uint32_t rhs)
+			{
+				const Vector3& a = _points[lhs];
+				const Vector3& b = _points[rhs];
+				if (a.x != b.x)
+					return a.x < b.x;
+				if (a.y != b.y)
+					return a.y < b.y;
+				return a.z < b.z;
+			});
+
+			_position_ids.resize(_vertex_count);
+			_wedges.resize(_vertex_count);
+			for (std::size_t i = 0; i < order.size();)
+			{
+				std::size_t end = i + 1;
+				const Vector3& p = _points[order[i]];
+				while (end < order.size() && _points[order[end]].x == p.x && _points[order[end]].y == p.y && _points[order[end]].z == p.z)
+					++end;
+
+				const std::uint32_t id = *std::min_element(order.begin() + i, order.begin() + end);
+				for (std::size_t j = i; j < end; ++j)
+				{
+					_position_ids[order[j]] = id;
+					_wedges[order[j]] = order[j + 1 < end ? j + 1 : i];
+				}
+				i = end;
+			}
+		}
+
+		Vector3 get_face_normal(std::uint32_t triangle, float& area) const
+		{
+			const std::uint32_t* tri = &_indices[triangle * 3];
+			Vector3 normal = cross(_points[tri[1]] - _points[tri[0]], _points[tri[2]] - _points[tri[0]]);
+			const float len = length(normal);
+			area = len * 0.5f;
+			if (len > 0.0f)
+			{
+				normal.x /= len;
+				normal.y /= len;
+				normal.z /= len;
+			}
+			return normal;
+		}
+
+		void build_face_quadrics()
+		{
+			_quadrics.assign(_vertex_count, Quadric());
+			for (std::uint32_t i = 0; i < _indices.size() / 3; ++i)
+			{
+				float area = 0.0f;
+				const Vector3 normal = get_face_normal(i, area);
+				if (area <= 0.0f)
+					continue;
+
+				const double distance = -dot(normal, _points[_indices[i * 3]]);
+				for (std::uint32_t j = 0; j < 3; ++j)
+					_quadrics[_position_ids[_indices[i * 3 + j]]].add_plane(normal, distance, area);
+			}
+		}
+
+		void build_edge_quadrics()
+		{
+			// Planes perpendicular to the faces along borders and seams keep
+			// them from drifting inwards.
+			for (std::uint32_t i = 0; i < _indices.size() / 3; ++i)
+			{
+				for (std::uint32_t j = 0; j < 3; ++j)
+				{
+					const std::uint32_t a = _indices[i * 3 + j];
+					const std::uint32_t b = _indices[i * 3 + (j + 1) % 3];
+					if (has_edge(b, a))
+						continue;
+
+					float area = 0.0f;
+					const Vector3 face_normal = get_face_normal(i, area);
+					const Vector3 edge = _points[b] - _points[a];
+					Vector3 normal = cross(edge, face_normal);
+					const float len = length(normal);
+					if (len <= 0.0f)
+						continue;
+
+					normal.x /= len;
+					normal.y /= len;
+					normal.z /= len;
+					const double distance = -dot(normal, _points[a]);
+					const double weight = dot(edge, edge) * EdgeWeight;
+					_quadrics[_position_ids[a]].add_plane(normal, distance, weight);
+					_quadrics[_position_ids[b]].add_plane(normal, distance, weight);
+				}
+			}
+		}
+
+		bool has_edge(std::uint32_t a, std::uint32_t b) const
+		{
+			const std::uint32_t* list = &_adjacency.triangles[_adjacency.offsets[a]];
+			for (std::uint32_t i = 0; i < _adjacency.counts[a]; ++i)
+			{
+				const std::uint32_t* tri = &_indices[list[i] * 3];
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					if (tri[k] == a && tri[(k + 1) % 3] == b)
+						return true;
+				}
+			}
+			return false;
+		}
+
+		bool has_position_edge(std::uint32_t a, std::uint32_t b) const
+		{
+			std::uint32_t wedge = a;
+			do
+			{
+				const std::uint32_t* list = &_adjacency.triangles[_adjacency.offsets[wedge]];
+				for (std::uint32_t i = 0; i < _adjacency.counts[wedge]; ++i)
+				{
+					const std::uint32_t* tri = &_indices[list[i] * 3];
+					for (std::uint32_t k = 0; k < 3; ++k)
+					{
+						if (tri[k] == wedge && _position_ids[tri[(k + 1) % 3]] == _position_ids[b])
+							return true;
+					}
+				}
+				wedge = _wedges[wedge];
+
+			} while (wedge != a);
+			return false;
+		}
+
+		bool is_open_edge(std::uint32_t a, std::uint32_t b) const
+		{
+			return !has_edge(a, b) || !has_edge(b, a);
+		}
+
+		void classify_vertices()
+		{
+			_kinds.assign(_vertex_count, VertexKind::Locked);
+			for (std::uint32_t v = 0; v < _vertex_count; ++v)
+			{
+				if (_adjacency.counts[v] == 0 || (_vertex_locks && _vertex_locks[v]))
+					continue;
+
+				std::uint32_t wedge_count = 0;
+				std::uint32_t wedge = v;
+				do
+				{
+					if (_adjacency.counts[wedge] > 0)
+						wedge_count++;
+					wedge = _wedges[wedge];
+
+				} while (wedge != v);
+
+				bool open = false, border = false, seam = false;
+				const std::uint32_t* list = &_adjacency.triangles[_adjacency.offsets[v]];
+				for (std::uint32_t i = 0; i < _adjacency.counts[v]; ++i)
+				{
+					const std::uint32_t* tri = &_indices[list[i] * 3];
+					for (std::uint32_t k = 0; k < 3; ++k)
+					{
+						if (tri[k] != v)
+							continue;
+
+						const std::uint32_t next = tri[(k + 1) % 3];
+						const std::uint32_t prev = tri[(k + 2) % 3];
+						if (!has_edge(next, v))
+						{
+							open = true;
+							(has_position_edge(next, v) ? seam : border) = true;
+						}
+						if (!has_edge(v, prev))
+						{
+							open = true;
+							(has_position_edge(v, prev) ? seam : border) = true;
+						}
+					}
+				}
+
+				if (!open)
+					_kinds[v] = wedge_count == 1 ? VertexKind::Manifold : VertexKind::Locked;
+				else if (border && !seam && wedge_count == 1)
+					_kinds[v] = VertexKind::Border;
+				else if (seam && !border && wedge_count == 2)
+					_kinds[v] = VertexKind::Seam;
+			}
+		}
+
+		std::uint32_t get_seam_partner(std::uint32_t v) const
+		{
+			for (std::uint32_t wedge = _wedges[v]; wedge != v; wedge = _wedges[wedge])
+			{
+				if (_adjacency.counts[wedge] > 0)
+					return wedge;
+			}
+			return InvalidIndex;
+		}
+
+		// Vertex of 'to's position that 'from' (the other side of a seam) is
+		// connected to, if any.
+		std::uint32_t find_connected_wedge(std::uint32_t from, std::uint32_t to) const
+		{
+			std::uint32_t wedge = to;
+			do
+			{
+				if (has_edge(from, wedge) || has_edge(wedge, from))
+					return wedge;
+				wedge = _wedges[wedge];
+
+			} while (wedge != to);
+			return InvalidIndex;
+		}
+
+		bool can_collapse(std::uint32_t from, std::uint32_t to) const
+		{
+			const VertexKind kind = _kinds[from];
+			if (kind == VertexKind::Locked || _position_ids[from] == _position_ids[to])
+				return false;
+			if (_vertex_groups && _vertex_groups[from] != _vertex_groups[to])
+				return false;
+			if (kind == VertexKind::Manifold)
+				return true;
+
+			// Borders and seams only slide along themselves.
+			return is_open_edge(from, to) && _kinds[to] != VertexKind::Manifold;
+		}
+
+		void collect_collapses(std::vector<Collapse>& collapses) const
+		{
+			for (std::size_t i = 0; i < _indices.size(); i += 3)
+			{
+				for (std::uint32_t j = 0; j < 3; ++j)
+				{
+					const std::uint32_t a = _indices[i + j];
+					const std::uint32_t b = _indices[i + (j + 1) % 3];
+
+					// Interior edges are seen from both triangles, keep one.
+					if (a > b && has_edge(b, a))
+						continue;
+
+					Collapse best;
+					best.from = InvalidIndex;
+					const std::uint32_t ends[2][2] = { { a, b }, { b, a } };
+					for (const auto& end : ends)
+					{
+						if (!can_collapse(end[0], end[1]))
+							continue;
+
+						Quadric quadric = _quadrics[_position_ids[end[0]]];
+						quadric.add(_quadrics[_position_ids[end[1]]]);
+						const double error = quadric.get_error(_points[end[1]]);
+						if (best.from == InvalidIndex || error < best.error)
+						{
+							best.from = end[0];
+							best.to = end[1];
+							best.error = error;
+						}
+					}
+
+					if (best.from != InvalidIndex)
+						collapses.push_back(best);
+				}
+			}
+		}
+
+		// Would moving the position of 'from' onto 'to' flip any of the
+		// triangles that survive the collapse?
+		bool has_flips(std::uint32_t from, std::uint32_t to) const
+		{
+			const std::uint32_t to_id = _position_ids[to];
+			std::uint32_t wedge = from;
+			do
+			{
+				const std::uint32_t* list = &_adjacency.triangles[_adjacency.offsets[wedge]];
+				for (std::uint32_t i = 0; i < _adjacency.counts[wedge]; ++i)
+				{
+					const std::uint32_t* tri = &_indices[list[i] * 3];
+					if (_position_ids[tri[0]] == to_id || _position_ids[tri[1]] == to_id || _position_ids[tri[2]] == to_id)
+						continue;
+
+					Vector3 moved[3] = { _points[tri[0]], _points[tri[1]], _points[tri[2]] };
+					for (std::uint32_t k = 0; k < 3; ++k)
+					{
+						if (tri[k] == wedge)
+							moved[k] = _points[to];
+					}
+
+					const Vector3 before = cross(_points[tri[1]] - _points[tri[0]], _points[tri[2]] - _points[tri[0]]);
+					const Vector3 after = cross(moved[1] - moved[0], moved[2] - moved[0]);
+					if (dot(before, after) <= FlipThreshold * length(before) * length(after))
+						return true;
+				}
+				wedge = _wedges[wedge];
+
+			} while (wedge != from);
+			return false;
+		}
+
+		std::size_t apply_collapses(const std::vector<Collapse>& collapses, std::size_t triangle_goal, double error_limit, double& max_error)
+		{
+			_remap.resize(_vertex_count);
+			std::iota(_remap.begin(), _remap.end(), 0);
+
+			// Positions whose surroundings changed in this pass. Their
+			// collapses are re-evaluated in the next one.
+			std::vector<std::uint8_t> touched(_vertex_count, 0);
+
+			std::size_t applied = 0;
+			std::size_t removed_triangles = 0;
+			for (const auto& collapse : collapses)
+			{
+				if (collapse.error > error_limit || removed_triangles >= triangle_goal)
+					break;
+
+				const std::uint32_t from_id = _position_ids[collapse.from];
+				const std::uint32_t to_id = _position_ids[collapse.to];
+				if (touched[from_id] || touched[to_id])
+					continue;
+
+				if (has_flips(collapse.from, collapse.to))
+					continue;
+
+				if (_kinds[collapse.from] == VertexKind::Seam)
+				{
+					// The other side of the seam has to follow.
+					const std::uint32_t partner = get_seam_partner(collapse.from);
+					const std::uint32_t partner_to = partner == InvalidIndex ? InvalidIndex : find_connected_wedge(partner, collapse.to);
+					if (partner_to == InvalidIndex)
+						continue;
+					if (_vertex_groups && _vertex_groups[partner] != _vertex_groups[partner_to])
+						continue;
+
+					_remap[partner] = partner_to;
+				}
+				_remap[collapse.from] = collapse.to;
+				_quadrics[to_id].add(_quadrics[from_id]);
+				max_error = std::max(max_error, collapse.error);
+				applied++;
+
+				// Mark the whole one ring, its triangles have changed shape.
+				std::uint32_t wedge = collapse.from;
+				do
+				{
+					const std::uint32_t* list = &_adjacency.triangles[_adjacency.offsets[wedge]];
+					for (std::uint32_t i = 0; i < _adjacency.counts[wedge]; ++i)
+					{
+						const std::uint32_t* tri = &_indices[list[i] * 3];
+						if (_position_ids[tri[0]] == to_id || _position_ids[tri[1]] == to_id || _position_ids[tri[2]] == to_id)
+							removed_triangles++;
+						for (std::uint32_t k = 0; k < 3; ++k)
+							touched[_position_ids[tri[k]]] = 1;
+					}
+					wedge = _wedges[wedge];
+
+				} while (wedge != collapse.from);
+			}
+
+			return applied;
+		}
+
+		void remove_degenerate_triangles()
+		{
+			std::size_t write = 0;
+			for (std::size_t i = 0; i < _indices.size(); i += 3)
+			{
+				const std::uint32_t a = _remap[_indices[i + 0]];
+				const std::uint32_t b = _remap[_indices[i + 1]];
+				const std::uint32_t c = _remap[_indices[i + 2]];
+				if (_position_ids[a] == _position_ids[b] || _position_ids[b] == _position_ids[c] || _position_ids[a] == _position_ids[c])
+					continue;
+
+				_indices[write++] = a;
+				_indices[write++] = b;
+				_indices[write++] = c;
+			}
+			_indices.resize(write);
+		}
+
+		/// Current index list.
+		std::vector<std::uint32_t> _indices;
+		/// Number of vertices in the vertex buffer.
+		std::uint32_t _vertex_count = 0;
+		/// Optional per vertex lock flags.
+		const std::uint8_t* _vertex_locks = nullptr;
+		/// Optional per vertex collapse groups.
+		const std::uint32_t* _vertex_groups = nullptr;
+		/// Positions normalized to the unit box.
+		std::vector<Vector3> _points;
+		/// First vertex with the same position.
+		std::vector<std::uint32_t> _position_ids;
+		/// Next vertex with the same position (a ring).
+		std::vector<std::uint32_t> _wedges;
+		/// Quadric per position id.
+		std::vector<Quadric> _quadrics;
+		/// Classification of the vertices for the current pass.
+		std::vector<VertexKind> _kinds;
+		/// Triangles around the vertices for the current pass.
+		VertexTriangles _adjacency;
+		/// Collapses of the current pass.
+		std::vector<std::uint32_t> _remap;
+	};
+}
+
+std::size_t MeshSimplifier::simplify(std::uint32_t* destination, const std::uint32_t* indices, std::size_t index_count, const float* positions, std::uint32_t vertex_count, std::size_t position_stride, std::size_t target_index_count, float target_error, const std::uint8_t* vertex_locks /* = nullptr */, const std::uint32_t* vertex_groups /* = nullptr */, float* result_error /* = nullptr */)
+{
+	index_count -= index_count % 3;
+	if (result_error)
+		*result_error = 0.0f;
+
+	if (index_count <= target_index_count || vertex_count == 0)
+	{
+		std::memcpy(destination, indices, index_count * sizeof(std::uint32_t));
+		return index_count;
+	}
+
+	Simplifier simplifier(indices, index_count, positions, vertex_count, position_stride, vertex_locks, vertex_groups);
+	const std::size_t result_count = simplifier.run(target_index_count, target_error, result_error);
+	std::memcpy(destination, simplifier.get_indices().data(), result_count * sizeof(std::uint32_t));
+	return result_count;
+}
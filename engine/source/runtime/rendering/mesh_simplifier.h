@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : MeshSimplifier (Struct)
+/// <summary>
+/// Quadric error metric simplification of triangle lists (Garland and
+/// Heckbert, "Surface Simplification Using Quadric Error Metrics"). Edges
+/// are collapsed onto one of their existing vertices, so the vertex buffer
+/// is left untouched and only the index list is rewritten. Vertices sharing
+/// a position with different attributes (UV seams, normal splits) are moved
+/// together along the seam, open borders only collapse along the border,
+/// and vertices can be locked or restricted to collapse within a group.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct MeshSimplifier
+{
+	//-----------------------------------------------------------------------------
+	//  Name : simplify () (Static)
+	/// <summary>
+	/// Reduces the triangle list towards target_index_count and writes the result
+	/// to destination, which must hold index_count entries and may not alias the
+	/// source. Returns the resulting number of indices. Simplification stops
+	/// early once the error of the next collapse exceeds target_error, which is
+	/// a distance relative to the size of the mesh (0.01 is 1% of its extent).
+	/// Positions are read as three floats at the start of every position_stride
+	/// bytes. Vertices flagged in vertex_locks never move and, when given,
+	/// vertices only collapse onto vertices of the same vertex_group. The
+	/// relative error actually reached is stored in result_error.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::size_t simplify(
+		std::uint32_t* destination,
+		const std::uint32_t* indices,
+		std::size_t index_count,
+		const float* positions,
+		std::uint32_t vertex_count,
+		std::size_t position_stride,
+		std::size_t target_index_count,
+		float target_error,
+		const std::uint8_t* vertex_locks = nullptr,
+		const std::uint32_t* vertex_groups = nullptr,
+		float* result_error = nullptr);
+};
@@ -122,32 +122,35 @@ void Model::set_lod_min_distance(float distance)
 	_min_distance = distance;
 }
 
-void Model::render(std::uint8_t id, const math::transform_t& mtx, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, unsigned int lod, Program* user_program, std::function<void(Program&)> setup_params) const
+void Model::render(std::uint8_t id, const math::transform_t& mtx, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, unsigned int lod, Program* user_program, const std::function<void(Program&)>& setup_params, const SkinningPalettes* skinning) const
 {
 	const auto mesh = get_lod(lod);
 	if (!mesh)
 		return;
 
 	AssetHandle<Material> last_set_material;
-	auto render_subset = [this, &mesh, &last_set_material](std::uint8_t id, bool skinned, std::uint32_t group_id, const float* mtx, std::uint32_t count, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, Program* user_program, std::function<void(Program&)> setup_params)
+	auto render_subset = [this, &mesh, &last_set_material](std::uint8_t id, bool skinned, std::uint32_t group_id, const float* mtx, std::uint32_t cache, std::uint32_t count, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, Program* user_program, const std::function<void(Program&)>& setup_params)
 	{
 		bool valid_program = false;
 		Program* program = user_program;
 		AssetHandle<Material> mat = get_material_for_group(group_id);
-		if (mat)
+		if (mat && !user_program)
 		{
-			mat->skinned = skinned;
-			if (!user_program)
-			{
-				program = mat->get_program();
-			}
+			// The material is shared and may be rendered by several threads
+			// at once, so the program is picked here rather than on it.
+			program = mat->get_program(skinned);
 		}
 
 		if (program)
 		{
 			valid_program = program->begin_pass();
 			if (valid_program)
+			{
 				setup_params(*program);
+
+				// Maps quantized vertex positions back to object space.
+				program->set_uniform("u_position_decode", &mesh->get_position_decode());
+			}
 		}
 
 		if (valid_program)
@@ -156,13 +159,16 @@ void Model::render(std::uint8_t id, const math::transform_t& mtx, bool apply_cul
 			{
 				if (!user_program)
 				{	
-					mat->submit();
+					mat->submit(*program);
 				}
 
 				extra_states |= mat->get_render_states(apply_cull, depth_write, depth_test);
 			}
 
-			gfx::setTransform(mtx, count);
+			if (cache != UINT32_MAX)
+				gfx::setTransform(cache, std::uint16_t(count));
+			else
+				gfx::setTransform(mtx, std::uint16_t(count));
 			gfx::setState(extra_states);
 
 			mesh->draw_subset(group_id);
@@ -173,31 +179,29 @@ void Model::render(std::uint8_t id, const math::transform_t& mtx, bool apply_cul
 	};
 
 	const auto& skin_data = mesh->get_skin_bind_data();
+	const auto& palettes = mesh->get_bone_palettes();
 
-	// Has skinning data?
-	if (false)// skin_data.has_bones())
+	// Has skinning data posed for this mesh?
+	if (skinning && skin_data.has_bones() && skinning->mesh == mesh.get() && skinning->offsets.size() == palettes.size() + 1 && skinning->cache != UINT32_MAX)
 	{
-		// Build an array containing all of the bones that are required
-		// by the binding data in the skinned mesh.
-		std::vector<math::transform_t> node_transforms(gfx::get_max_blend_transforms());// (boneEntities.size());
-		// Process each palette in the skin with a matching attribute.
-		const auto& palettes = mesh->get_bone_palettes();
-		for (const auto& palette : palettes)
+		// The palettes were computed and uploaded once for the frame, each
+		// draw only points at the cached transforms of its subset.
+		for (std::size_t i = 0; i < palettes.size(); ++i)
 		{
-			// Apply the bone palette.
-			auto skinning_matrices = palette.get_skinning_matrices(mtx, node_transforms, skin_data, false);
-			auto max_blend_index = palette.get_maximum_blend_index();
-			auto data_group = palette.get_data_group();
+			const std::uint32_t offset = skinning->offsets[i];
+			const std::uint32_t count = skinning->offsets[i + 1] - offset;
+			if (count == 0)
+				continue;
+
+			render_subset(id, true, palettes[i].get_data_group(), nullptr, skinning->cache + offset, count, apply_cull, depth_write, depth_test, extra_states, user_program, setup_params);
 
-			render_subset(id, true, data_group, (float*)&skinning_matrices[0], std::uint32_t(skinning_matrices.size()), apply_cull, depth_write, depth_test, extra_states, user_program, setup_params);
-	
 		} // Next Palette
 	}
 	else
 	{
 		for (std::size_t i = 0; i < mesh->get_subset_count(); ++i)
 		{
-			render_subset(id, false, std::uint32_t(i), mtx, 1, apply_cull, depth_write, depth_test, extra_states, user_program, setup_params);
+			render_subset(id, false, std::uint32_t(i), mtx, UINT32_MAX, 1, apply_cull, depth_write, depth_test, extra_states, user_program, setup_params);
 		}
 	}
 
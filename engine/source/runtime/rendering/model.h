@@ -11,6 +11,27 @@ class Mesh;
 struct Program;
 class Material;
 
+//-----------------------------------------------------------------------------
+//  Name : SkinningPalettes (Struct)
+/// <summary>
+/// Skinning matrices of every bone palette of a skinned mesh for the current
+/// pose, already in world space. The matrices of all palettes are stored back
+/// to back, palette i uses the range [offsets[i], offsets[i + 1]).
+/// </summary>
+//-----------------------------------------------------------------------------
+struct SkinningPalettes
+{
+	/// Mesh the palettes were computed for.
+	const Mesh* mesh = nullptr;
+	/// Skinning matrices of all palettes.
+	std::vector<math::mat4> matrices;
+	/// Start of each palette in matrices, plus the end of the last one.
+	std::vector<std::uint32_t> offsets;
+	/// Index of the matrices in the transform cache of the current frame,
+	/// UINT32_MAX until they are uploaded.
+	std::uint32_t cache = UINT32_MAX;
+};
+
 class Model
 {
 public:
@@ -192,9 +213,13 @@ public:
 	/// <summary>
 	/// Draws a mesh with a given program. If program is nullptr then the
 	/// materials are used instead. Extra states can be added to the material ones.
+	/// Skinned meshes are drawn with the skinning palettes when they were
+	/// computed for the mesh of the lod and uploaded for the frame, a user
+	/// program has to be a skinned one then. Otherwise they are drawn in bind
+	/// pose with mtx.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void render(std::uint8_t id, const math::transform_t& mtx, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, unsigned int lod, Program* user_program, std::function<void(Program&)> setup_params) const;
+	void render(std::uint8_t id, const math::transform_t& mtx, bool apply_cull, bool depth_write, bool depth_test, std::uint64_t extra_states, unsigned int lod, Program* user_program, const std::function<void(Program&)>& setup_params, const SkinningPalettes* skinning = nullptr) const;
 
 private:
 	/// Collection of all materials for this model.
@@ -4,6 +4,20 @@
 #include "uniform.h"
 #include "frame_buffer.h"
 
+namespace
+{
+	// a sampler the shaders do not use has no uniform, the texture is still
+	// bound to its stage
+	gfx::UniformHandle get_sampler_handle(const Program& program, const std::string& name)
+	{
+		auto hUniform = program.get_uniform(name);
+		if (!hUniform)
+			return { gfx::invalidHandle };
+
+		return hUniform->handle;
+	}
+}
+
 Program::Program(AssetHandle<Shader> computeShader)
 {
 	add_shader(computeShader);
@@ -40,23 +54,23 @@ void Program::set_texture(std::uint8_t _stage, const std::string& _sampler, Fram
 	if (!frameBuffer)
 		return;
 
-	gfx::setTexture(_stage, get_uniform(_sampler, true)->handle, gfx::getTexture(frameBuffer->handle, _attachment), _flags);
+	gfx::setTexture(_stage, get_sampler_handle(*this, _sampler), gfx::getTexture(frameBuffer->handle, _attachment), _flags);
 }
 void Program::set_texture(std::uint8_t _stage, const std::string& _sampler, gfx::FrameBufferHandle frameBuffer, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
-	gfx::setTexture(_stage, get_uniform(_sampler, true)->handle, gfx::getTexture(frameBuffer, _attachment), _flags);
+	gfx::setTexture(_stage, get_sampler_handle(*this, _sampler), gfx::getTexture(frameBuffer, _attachment), _flags);
 }
 void Program::set_texture(std::uint8_t _stage, const std::string& _sampler, Texture* _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	if (!_texture)
 		return;
 
-	gfx::setTexture(_stage, get_uniform(_sampler, true)->handle, _texture->handle, _flags);
+	gfx::setTexture(_stage, get_sampler_handle(*this, _sampler), _texture->handle, _flags);
 }
 
 void Program::set_texture(std::uint8_t _stage, const std::string& _sampler, gfx::TextureHandle _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
-	gfx::setTexture(_stage, get_uniform(_sampler, true)->handle, _texture, _flags);
+	gfx::setTexture(_stage, get_sampler_handle(*this, _sampler), _texture, _flags);
 }
 
 void Program::set_uniform(const std::string& _name, const void* _value, uint16_t _num)
@@ -67,25 +81,23 @@ void Program::set_uniform(const std::string& _name, const void* _value, uint16_t
 		gfx::setUniform(hUniform->handle, _value, _num);
 }
 
-std::shared_ptr<Uniform> Program::get_uniform(const std::string& _name, bool texture)
+std::shared_ptr<Uniform> Program::get_uniform(const std::string& _name) const
 {
-	std::shared_ptr<Uniform> hUniform;
 	auto it = uniforms.find(_name);
-	if (it != uniforms.end())
-	{
-		hUniform = it->second;
-	}
-	else
-	{
-		if (texture)
-		{
-			hUniform = std::make_shared<Uniform>();
-			hUniform->populate(_name, gfx::UniformType::Int1, 1);
-			uniforms[_name] = hUniform;
-		}
-	}
+	if (it == uniforms.end())
+		return nullptr;
+
+	return it->second;
+}
+
+void Program::add_sampler(const std::string& _name)
+{
+	if (uniforms.find(_name) != uniforms.end())
+		return;
 
-	return hUniform;
+	auto hUniform = std::make_shared<Uniform>();
+	hUniform->populate(_name, gfx::UniformType::Int1, 1);
+	uniforms[_name] = hUniform;
 }
 
 void Program::add_shader(AssetHandle<Shader> shader)
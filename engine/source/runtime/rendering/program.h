@@ -140,12 +140,20 @@ struct Program
 	//-----------------------------------------------------------------------------
 	//  Name : get_uniform ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Looks a uniform up, never creates one. Safe to call while recording on
+	/// several threads at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<Uniform> get_uniform(const std::string& _name) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_sampler ()
+	/// <summary>
+	/// Creates the uniform of a sampler that the shaders do not declare, for
+	/// example because the compiler stripped it. Main thread only.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	std::shared_ptr<Uniform> get_uniform(const std::string& _name, bool texture = false);
+	void add_sampler(const std::string& _name);
 
 	//-----------------------------------------------------------------------------
 	//  Name : add_shader ()
@@ -23,6 +23,7 @@ std::uint8_t generate_id()
 
 
 RenderPass::RenderPass(const std::string& n)
+	: _zone(n)
 {
 	id = generate_id();
 	gfx::setViewName(id, n.c_str());
@@ -2,6 +2,7 @@
 #include "frame_buffer.h"
 #include "core/common/basetypes.hpp"
 #include "core/math/math_includes.h"
+#include "core/profiling/profiler.h"
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -83,4 +84,8 @@ struct RenderPass
 
 	///
 	std::uint8_t id;
+
+private:
+	/// Times the recording of the pass, from its creation until it goes out of scope.
+	core::profiler::ScopedZone _zone;
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <cstdarg>
 #include "rendering/render_pass.h"
 #include "../system/engine.h"
+#include "core/profiling/profiler.h"
 
 struct GfxCallback : public gfx::CallbackI
 {
@@ -101,6 +102,7 @@ namespace runtime
 
 	void Renderer::frame_end(std::chrono::duration<float>)
 	{
+		PROFILE_SCOPE("Renderer Frame");
 		_render_frame = gfx::frame();
 		RenderPass::reset();
 	}
@@ -0,0 +1,308 @@
+#include "shadow_maps.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace shadow_maps
+{
+	namespace
+	{
+		math::vec3 unproject(const math::mat4& inv_proj, float x, float y, float z)
+		{
+			const math::vec4 p = inv_proj * math::vec4(x, y, z, 1.0f);
+			return math::vec3(p) / p.w;
+		}
+
+		// Any up vector works as long as it is not parallel to the direction.
+		math::vec3 get_up_vector(const math::vec3& direction)
+		{
+			return std::abs(direction.y) > 0.99f ? math::vec3(0.0f, 0.0f, 1.0f) : math::vec3(0.0f, 1.0f, 0.0f);
+		}
+
+		std::uint32_t get_level(std::uint32_t size, std::uint32_t tile_size)
+		{
+			std::uint32_t level = 0;
+			while ((size >> level) > tile_size)
+				++level;
+			return level;
+		}
+	}
+
+	void compute_cascade_splits(float near_clip, float far_clip, std::uint32_t count, float distribution, float* splits)
+	{
+		count = std::max(count, 1u);
+		distribution = math::clamp(distribution, 0.0f, 1.0f);
+
+		splits[0] = near_clip;
+		for (std::uint32_t i = 1; i < count; ++i)
+		{
+			const float f = float(i) / float(count);
+			const float uniform_split = near_clip + (far_clip - near_clip) * f;
+			const float log_split = near_clip * std::pow(far_clip / near_clip, f);
+			splits[i] = math::lerp(uniform_split, log_split, distribution);
+		}
+		splits[count] = far_clip;
+	}
+
+	void get_frustum_corners(const math::transform_t& proj, float near_clip, float far_clip, float slice_near, float slice_far, bool homogeneous_depth, math::vec3* corners)
+	{
+		const math::mat4 inv_proj = glm::inverse(proj.matrix());
+		const float near_z = homogeneous_depth ? -1.0f : 0.0f;
+		const float xs[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+		const float ys[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+
+		// View depth changes linearly along the edges of the frustum, for
+		// perspective and orthographic projections alike.
+		const float t_near = (slice_near - near_clip) / (far_clip - near_clip);
+		const float t_far = (slice_far - near_clip) / (far_clip - near_clip);
+		for (std::uint32_t i = 0; i < 4; ++i)
+		{
+			const auto near_corner = unproject(inv_proj, xs[i], ys[i], near_z);
+			const auto far_corner = unproject(inv_proj, xs[i], ys[i], 1.0f);
+			corners[i] = math::mix(near_corner, far_corner, t_near);
+			corners[i + 4] = math::mix(near_corner, far_corner, t_far);
+		}
+	}
+
+	ShadowView compute_directional_view(const math::vec3& direction, const math::transform_t& camera_view, const math::vec3* corners, std::uint32_t resolution, bool stabilize, float caster_distance, bool homogeneous_depth)
+	{
+		const auto dir = math::normalize(direction);
+		const math::transform_t inv_camera_view = glm::inverse(camera_view.matrix());
+
+		// The view only depends on the direction of the light, the fitting is
+		// done by the projection.
+		ShadowView result;
+		result.view.look_at(math::vec3(0.0f, 0.0f, 0.0f), dir, get_up_vector(dir));
+
+		math::vec3 min_bounds, max_bounds;
+		if (stabilize)
+		{
+			math::vec3 center(0.0f, 0.0f, 0.0f);
+			for (std::uint32_t i = 0; i < 8; ++i)
+				center += corners[i];
+			center /= 8.0f;
+
+			// The sphere is found in view space where it does not depend on
+			// the orientation of the camera, so the radius stays the same to
+			// the last bit as the camera rotates.
+			float radius = 0.0f;
+			for (std::uint32_t i = 0; i < 8; ++i)
+				radius = std::max(radius, math::length(corners[i] - center));
+			radius = std::ceil(radius * 16.0f) / 16.0f;
+
+			// One texel is kept spare so that the sphere still fits once the
+			// bounds are snapped, which makes them exactly resolution texels.
+			resolution = std::max(resolution, 2u);
+			const float texel = 2.0f * radius / float(resolution - 1);
+			const float extent = texel * float(resolution);
+			const auto light_center = result.view.transform_coord(inv_camera_view.transform_coord(center));
+			min_bounds = math::floor((light_center - radius) / texel) * texel;
+			max_bounds = min_bounds + extent;
+		}
+		else
+		{
+			min_bounds = math::vec3(std::numeric_limits<float>::max());
+			max_bounds = math::vec3(-std::numeric_limits<float>::max());
+			for (std::uint32_t i = 0; i < 8; ++i)
+			{
+				const auto p = result.view.transform_coord(inv_camera_view.transform_coord(corners[i]));
+				min_bounds = math::min(min_bounds, p);
+				max_bounds = math::max(max_bounds, p);
+			}
+		}
+
+		result.proj = math::ortho(min_bounds.x, max_bounds.x, min_bounds.y, max_bounds.y, min_bounds.z - caster_distance, max_bounds.z, homogeneous_depth);
+		return result;
+	}
+
+	ShadowView compute_spot_view(const math::vec3& position, const math::vec3& direction, float outer_angle, float range, bool homogeneous_depth)
+	{
+		const auto dir = math::normalize(direction);
+		const float near_clip = std::max(range * 0.01f, 0.01f);
+
+		ShadowView result;
+		result.view.look_at(position, position + dir, get_up_vector(dir));
+		result.proj = math::perspective(math::radians(math::clamp(outer_angle, 1.0f, 179.0f)), 1.0f, near_clip, std::max(range, near_clip * 2.0f), homogeneous_depth);
+		return result;
+	}
+
+	ShadowView compute_point_view(const math::vec3& position, std::uint32_t face, float range, std::uint32_t resolution, std::uint32_t border, bool homogeneous_depth)
+	{
+		static const math::vec3 directions[6] =
+		{
+			{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+		};
+		static const math::vec3 ups[6] =
+		{
+			{ 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+			{ 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f },
+			{ 0.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }
+		};
+
+		face = std::min(face, 5u);
+		const float near_clip = std::max(range * 0.01f, 0.01f);
+		// The face spans resolution - 2 * border texels of the map, the rest
+		// overlaps the neighbouring faces.
+		const float inner = float(std::max(resolution, 2 * border + 1) - 2 * border);
+		const float fov = 2.0f * std::atan(float(resolution) / inner);
+
+		ShadowView result;
+		result.view.look_at(position, position + directions[face], ups[face]);
+		result.proj = math::perspective(fov, 1.0f, near_clip, std::max(range, near_clip * 2.0f), homogeneous_depth);
+		return result;
+	}
+
+	std::uint32_t get_point_face(const math::vec3& direction)
+	{
+		const auto a = math::abs(direction);
+		if (a.x >= a.y && a.x >= a.z)
+			return direction.x >= 0.0f ? 0 : 1;
+		if (a.y >= a.z)
+			return direction.y >= 0.0f ? 2 : 3;
+		return direction.z >= 0.0f ? 4 : 5;
+	}
+
+	math::mat4 get_atlas_matrix(const ShadowView& view, const uRect& rect, std::uint32_t atlas_size, bool homogeneous_depth, bool origin_bottom_left)
+	{
+		const float size = float(atlas_size);
+		const float width = float(rect.width());
+		const float height = float(rect.height());
+
+		// Maps clip space to the tile, applied before the divide by w so that
+		// it works for perspective projections too.
+		math::mat4 bias(1.0f);
+		bias[0][0] = 0.5f * width / size;
+		bias[3][0] = (float(rect.left) + 0.5f * width) / size;
+		if (origin_bottom_left)
+		{
+			// Render target rows are stored bottom up and the view rect is
+			// flipped accordingly.
+			bias[1][1] = 0.5f * height / size;
+			bias[3][1] = (size - float(rect.bottom) + 0.5f * height) / size;
+		}
+		else
+		{
+			bias[1][1] = -0.5f * height / size;
+			bias[3][1] = (float(rect.top) + 0.5f * height) / size;
+		}
+		if (homogeneous_depth)
+		{
+			bias[2][2] = 0.5f;
+			bias[3][2] = 0.5f;
+		}
+
+		return bias * view.proj.matrix() * view.view.matrix();
+	}
+
+	void ShadowAtlas::reset(std::uint32_t size, std::uint32_t min_tile_size)
+	{
+		_size = std::max(size, 1u);
+		_min_tile_size = math::clamp(min_tile_size, 1u, _size);
+		_free.clear();
+		_free.resize(get_level(_size, _min_tile_size) + 1);
+		_free[0].push_back(Tile());
+	}
+
+	bool ShadowAtlas::allocate(std::uint32_t size, uRect& rect)
+	{
+		if (_free.empty())
+			return false;
+
+		for (std::uint32_t level = get_level(_size, std::max(size, _min_tile_size)); level < _free.size(); ++level)
+		{
+			Tile tile;
+			if (allocate_level(level, tile))
+			{
+				const std::uint32_t tile_size = _size >> level;
+				rect = uRect(tile.x, tile.y, tile.x + tile_size, tile.y + tile_size);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void ShadowAtlas::free(const uRect& rect)
+	{
+		if (_free.empty() || rect.width() == 0)
+			return;
+
+		Tile tile;
+		tile.x = rect.left;
+		tile.y = rect.top;
+		free_level(get_level(_size, rect.width()), tile);
+	}
+
+	std::uint64_t ShadowAtlas::get_free_area() const
+	{
+		std::uint64_t area = 0;
+		for (std::size_t level = 0; level < _free.size(); ++level)
+		{
+			const std::uint64_t tile_size = _size >> level;
+			area += _free[level].size() * tile_size * tile_size;
+		}
+		return area;
+	}
+
+	bool ShadowAtlas::allocate_level(std::uint32_t level, Tile& tile)
+	{
+		auto& free_tiles = _free[level];
+		if (!free_tiles.empty())
+		{
+			tile = free_tiles.back();
+			free_tiles.pop_back();
+			return true;
+		}
+
+		if (level == 0)
+			return false;
+
+		Tile parent;
+		if (!allocate_level(level - 1, parent))
+			return false;
+
+		// Keep the first quarter, the other three become free.
+		const std::uint32_t tile_size = _size >> level;
+		Tile quarter;
+		quarter.x = parent.x + tile_size; quarter.y = parent.y + tile_size;
+		free_tiles.push_back(quarter);
+		quarter.x = parent.x; quarter.y = parent.y + tile_size;
+		free_tiles.push_back(quarter);
+		quarter.x = parent.x + tile_size; quarter.y = parent.y;
+		free_tiles.push_back(quarter);
+		tile = parent;
+		return true;
+	}
+
+	void ShadowAtlas::free_level(std::uint32_t level, Tile tile)
+	{
+		auto& free_tiles = _free[level];
+		if (level > 0)
+		{
+			const std::uint32_t tile_size = _size >> level;
+			Tile parent;
+			parent.x = tile.x - tile.x % (tile_size * 2);
+			parent.y = tile.y - tile.y % (tile_size * 2);
+
+			// Merge back into the parent once the other three quarters are free.
+			std::size_t found = 0;
+			for (const auto& t : free_tiles)
+			{
+				if (t.x - parent.x < tile_size * 2 && t.y - parent.y < tile_size * 2 && !(t.x == tile.x && t.y == tile.y))
+					++found;
+			}
+			if (found == 3)
+			{
+				free_tiles.erase(std::remove_if(free_tiles.begin(), free_tiles.end(), [&parent, tile_size](const Tile& t)
+				{
+					return t.x - parent.x < tile_size * 2 && t.y - parent.y < tile_size * 2;
+				}), free_tiles.end());
+				free_level(level - 1, parent);
+				return;
+			}
+		}
+
+		free_tiles.push_back(tile);
+	}
+}
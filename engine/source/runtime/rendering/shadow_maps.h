@@ -0,0 +1,166 @@
+#pragma once
+#include "core/math/math_includes.h"
+#include "core/common/basetypes.hpp"
+#include <cstdint>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Shadow map math
+//-----------------------------------------------------------------------------
+// Computes the views shadow maps are rendered from and where they go in the
+// shadow atlas. None of this touches the renderer, so it can be validated
+// without a device.
+//-----------------------------------------------------------------------------
+namespace shadow_maps
+{
+	/// Maximum number of cascades of a directional light.
+	const std::uint32_t MaxCascades = 4;
+
+	//-----------------------------------------------------------------------------
+	//  Name : ShadowView (Struct)
+	/// <summary>
+	/// View and projection a shadow map is rendered with.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	struct ShadowView
+	{
+		math::transform_t view;
+		math::transform_t proj;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_cascade_splits ()
+	/// <summary>
+	/// Splits the depth range of a camera into count cascades. Writes count + 1
+	/// distances, the first one is near_clip and the last one far_clip.
+	/// Distribution blends between uniform (0) and logarithmic (1) splits.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void compute_cascade_splits(float near_clip, float far_clip, std::uint32_t count, float distribution, float* splits);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frustum_corners ()
+	/// <summary>
+	/// Computes the view space corners of the part of a camera frustum between
+	/// the view depths slice_near and slice_far. The first four corners lie on
+	/// the near side. Near and far clip are the ones the projection was built
+	/// with.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void get_frustum_corners(const math::transform_t& proj, float near_clip, float far_clip, float slice_near, float slice_far, bool homogeneous_depth, math::vec3* corners);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_directional_view ()
+	/// <summary>
+	/// Fits an orthographic light view around the view space frustum corners
+	/// of a camera. With stabilize the view is fitted around their bounding
+	/// sphere and snapped to whole texels, so that it does not change as the
+	/// camera rotates and only moves in texel steps as it moves, which keeps
+	/// shadow edges from shimmering. Caster distance extends the view towards
+	/// the light to catch casters outside of the frustum.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	ShadowView compute_directional_view(const math::vec3& direction, const math::transform_t& camera_view, const math::vec3* corners, std::uint32_t resolution, bool stabilize, float caster_distance, bool homogeneous_depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_spot_view ()
+	/// <summary>
+	/// Perspective view covering the cone of a spot light. Outer angle is the
+	/// full angle of the cone in degrees.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	ShadowView compute_spot_view(const math::vec3& position, const math::vec3& direction, float outer_angle, float range, bool homogeneous_depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_point_view ()
+	/// <summary>
+	/// Perspective view of one of the six faces of a point light, in the order
+	/// +x, -x, +y, -y, +z, -z. The field of view is widened by border texels
+	/// so that filtering near the edge of a face stays inside of it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	ShadowView compute_point_view(const math::vec3& position, std::uint32_t face, float range, std::uint32_t resolution, std::uint32_t border, bool homogeneous_depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_point_face ()
+	/// <summary>
+	/// Returns the face of a point light a direction from the light falls in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_point_face(const math::vec3& direction);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_atlas_matrix ()
+	/// <summary>
+	/// Returns the matrix that takes a world position to the texture
+	/// coordinates of its shadow map within the atlas and to its depth, both in
+	/// [0, 1] after the divide by w.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	math::mat4 get_atlas_matrix(const ShadowView& view, const uRect& rect, std::uint32_t atlas_size, bool homogeneous_depth, bool origin_bottom_left);
+
+	//-----------------------------------------------------------------------------
+	//  Name : ShadowAtlas (Class)
+	/// <summary>
+	/// Packs square power of two shadow maps into one square texture. The
+	/// atlas is a quadtree, a tile is split into four when a smaller one is
+	/// needed and merged back once all four quarters are free again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class ShadowAtlas
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : reset ()
+		/// <summary>
+		/// Frees everything and sets the size of the atlas and of its smallest
+		/// tile, both powers of two.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void reset(std::uint32_t size, std::uint32_t min_tile_size);
+
+		//-----------------------------------------------------------------------------
+		//  Name : allocate ()
+		/// <summary>
+		/// Finds room for a tile of the given size. Tries smaller tiles, down to
+		/// the minimum tile size, when there is no room. Returns false if
+		/// nothing fits.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool allocate(std::uint32_t size, uRect& rect);
+
+		//-----------------------------------------------------------------------------
+		//  Name : free ()
+		/// <summary>
+		/// Gives back a tile returned by allocate.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void free(const uRect& rect);
+
+		//-----------------------------------------------------------------------------
+		//  Name : get_free_area ()
+		/// <summary>
+		/// Returns the number of free texels.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		std::uint64_t get_free_area() const;
+
+		inline std::uint32_t get_size() const { return _size; }
+		inline std::uint32_t get_min_tile_size() const { return _min_tile_size; }
+
+	private:
+		struct Tile
+		{
+			std::uint32_t x = 0;
+			std::uint32_t y = 0;
+		};
+
+		bool allocate_level(std::uint32_t level, Tile& tile);
+		void free_level(std::uint32_t level, Tile tile);
+
+		std::uint32_t _size = 0;
+		std::uint32_t _min_tile_size = 0;
+		/// Free tiles per level, level 0 is the whole atlas.
+		std::vector<std::vector<Tile>> _free;
+	};
+}
@@ -9,6 +9,8 @@
 #include "ecs/systems/deferred_rendering.h"
 #include "rendering/render_window.h"
 #include "assets/asset_manager.h"
+#include "core/memory/frame_allocator.hpp"
+#include "core/profiling/profiler.h"
 
 namespace runtime
 {
@@ -19,11 +21,20 @@ namespace runtime
 
 	bool Engine::initialize()
 	{
+		// Sinks run on a background thread fed through a lock-free queue. The
+		// message text is still formatted by the thread that logs it. When the
+		// queue is full the caller waits rather than losing messages.
+		logging::set_async_mode(8192, logging::async_overflow_policy::block_retry, nullptr, std::chrono::milliseconds(1000));
+
 		auto logger = logging::create(APPLOG,
 		{
 			std::make_shared<logging::sinks::platform_sink_mt>(),
 			std::make_shared<logging::sinks::daily_file_sink_mt>("Log", "log", 23, 59),
 		});
+		// errors reach the sinks right away in case the application goes down
+		logger->flush_on(logging::level::err);
+
+		core::profiler::set_thread_name("Main");
 		
 		// fire engine
 		_running = true;
@@ -33,7 +44,8 @@ namespace runtime
 
 	void Engine::dispose()
 	{
-
+		// the worker thread writes out everything queued before the flush
+		logging::get(APPLOG)->flush();
 	}
 
 
@@ -68,7 +80,10 @@ namespace runtime
 		auto sim = core::get_subsystem<core::Simulation>();
 		auto input = core::get_subsystem<Input>();
 
-		sim->run_one_frame();
+		{
+			PROFILE_SCOPE("Simulation");
+			sim->run_one_frame();
+		}
 		auto dt = sim->get_delta_time();
 
 		_focused_window = nullptr;
@@ -83,10 +98,14 @@ namespace runtime
 			}
 		}
 
-		on_frame_begin(dt);
+		{
+			PROFILE_SCOPE("Frame Begin");
+			on_frame_begin(dt);
+		}
 
 		for (auto window : windows)
 		{
+			PROFILE_SCOPE("Window Events");
 			window->frame_begin();
 
 			bool has_focus = window->hasFocus();
@@ -103,12 +122,19 @@ namespace runtime
 			window->frame_update(dt);
 		}
 
-		on_frame_update(dt);
+		{
+			PROFILE_SCOPE("Frame Update");
+			on_frame_update(dt);
+		}
 
-		on_frame_render(dt);
+		{
+			PROFILE_SCOPE("Frame Render");
+			on_frame_render(dt);
+		}
 
 		for (auto window : windows)
 		{
+			PROFILE_SCOPE("Window Render");
 			window->frame_render(dt);
 			window->frame_end();
 
@@ -116,7 +142,16 @@ namespace runtime
 				_running = window->isOpen();
 		}
 
-		on_frame_end(dt);
+		{
+			PROFILE_SCOPE("Frame End");
+			on_frame_end(dt);
+		}
+
+		// scratch memory handed out during the frame is released all at once
+		core::frame_memory::reset();
+
+		// zones that ended during the frame, on any thread, make up its record
+		core::profiler::next_frame();
 	}
 	
 	void Engine::register_window(std::shared_ptr<RenderWindow> window)
@@ -7,10 +7,21 @@
 #include <memory>
 #include <atomic>
 #include <mutex>
+#include <set>
+#include <chrono>
 
 #include "filesystem.h"
 #include "core/logging/logging.h"
 
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#define FS_WATCHER_INOTIFY 1
+#else
+#define FS_WATCHER_INOTIFY 0
+#endif
+
 //-----------------------------------------------------------------------------
 //  Name : log_path ()
 /// <summary>
@@ -138,6 +149,9 @@ namespace fs
 		FSWatcher()
 			: _watching(false)
 		{
+#if FS_WATCHER_INOTIFY
+			_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
 		}
 
 
@@ -159,6 +173,14 @@ namespace fs
 
 			if (_thread.joinable())
 				_thread.join();
+
+#if FS_WATCHER_INOTIFY
+			if (_inotify >= 0)
+			{
+				::close(_inotify);
+				_inotify = -1;
+			}
+#endif
 		}
 
 		//-----------------------------------------------------------------------------
@@ -174,26 +196,200 @@ namespace fs
 			_watching = true;
 			_thread = std::thread([this]()
 			{
-				// keep watching for modifications every ms milliseconds
-				auto ms = std::chrono::milliseconds(500);
-				while (_watching)
+#if FS_WATCHER_INOTIFY
+				if (_inotify >= 0)
+				{
+					run_native();
+					return;
+				}
+#endif
+				run_polling();
+			});
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : run_polling ()
+		/// <summary>
+		/// Fallback watching loop. Re-checks every watcher every 500 milliseconds.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void run_polling()
+		{
+			// keep watching for modifications every ms milliseconds
+			auto ms = std::chrono::milliseconds(500);
+			while (_watching)
+			{
+				poll_watchers(false);
+
+				// make this thread sleep for a while
+				std::this_thread::sleep_for(ms);
+			}
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : poll_watchers ()
+		/// <summary>
+		/// Checks the watchers for modification. If non_native_only is set only the
+		/// watchers whose directory has no native watch are checked.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void poll_watchers(bool non_native_only)
+		{
+			// iterate through each watcher and check for modification
+			std::lock_guard<std::recursive_mutex> lock(_mutex);
+			auto end = _watchers.end();
+			for (auto it = _watchers.begin(); it != end; ++it)
+			{
+				if (!non_native_only || _native_watches.find(it->second.get_directory().string()) == _native_watches.end())
+					it->second.watch();
+			}
+		}
+
+#if FS_WATCHER_INOTIFY
+		//-----------------------------------------------------------------------------
+		//  Name : run_native ()
+		/// <summary>
+		/// Watching loop backed by inotify. Sleeps until a watched directory changes
+		/// and then checks only the watchers of the changed directories. Events are
+		/// coalesced until the directories are quiet for a moment, so a burst of
+		/// writes results in a single callback per watcher.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void run_native()
+		{
+			using clock = std::chrono::steady_clock;
+			// how long to wait for more events before reporting the changes
+			const int coalesce_ms = 50;
+			// never hold back changes longer than this while events keep coming
+			const auto max_delay = std::chrono::milliseconds(250);
+			// directories without a native watch are still polled
+			const auto poll_interval = std::chrono::milliseconds(500);
+
+			alignas(inotify_event) char buffer[16 * 1024];
+			std::set<std::string> dirty;
+			auto dirty_since = clock::now();
+			auto last_poll = clock::now();
+			while (_watching)
+			{
+				pollfd pfd = { _inotify, POLLIN, 0 };
+				const int ready = ::poll(&pfd, 1, dirty.empty() ? 250 : coalesce_ms);
+				if (ready > 0)
 				{
-					do
+					ssize_t length = 0;
+					while ((length = ::read(_inotify, buffer, sizeof(buffer))) > 0)
 					{
-						// iterate through each watcher and check for modification
 						std::lock_guard<std::recursive_mutex> lock(_mutex);
-						auto end = _watchers.end();
-						for (auto it = _watchers.begin(); it != end; ++it)
+						for (char* ptr = buffer; ptr < buffer + length;)
 						{
-							it->second.watch();
+							const auto event = reinterpret_cast<const inotify_event*>(ptr);
+							ptr += sizeof(inotify_event) + event->len;
+
+							// the kernel queue overflowed and events were lost, the
+							// overflow itself carries no watch so every directory is
+							// checked again
+							if (event->mask & IN_Q_OVERFLOW)
+							{
+								if (dirty.empty())
+									dirty_since = clock::now();
+								for (const auto& native : _native_dirs)
+									dirty.insert(native.second);
+								continue;
+							}
+
+							auto it = _native_dirs.find(event->wd);
+							if (it == _native_dirs.end())
+								continue;
+
+							if (dirty.empty())
+								dirty_since = clock::now();
+							dirty.insert(it->second);
+
+							// the directory was removed, its watchers fall back to polling
+							if (event->mask & IN_IGNORED)
+							{
+								_native_watches.erase(it->second);
+								_native_dirs.erase(it);
+							}
 						}
-						// lock will be released before this thread goes to sleep
-					} while (false);
+					}
 
-					// make this thread sleep for a while
-					std::this_thread::sleep_for(ms);
+					if (clock::now() - dirty_since < max_delay)
+						continue;
 				}
-			});
+
+				if (!dirty.empty())
+				{
+					std::lock_guard<std::recursive_mutex> lock(_mutex);
+					auto end = _watchers.end();
+					for (auto it = _watchers.begin(); it != end; ++it)
+					{
+						if (dirty.find(it->second.get_directory().string()) != dirty.end())
+							it->second.watch();
+					}
+					dirty.clear();
+				}
+
+				if (clock::now() - last_poll >= poll_interval)
+				{
+					poll_watchers(true);
+					last_poll = clock::now();
+				}
+			}
+		}
+#endif
+
+		//-----------------------------------------------------------------------------
+		//  Name : add_native_watch ()
+		/// <summary>
+		/// Starts watching a directory natively if the platform supports it. Watches
+		/// are reference counted, as many watchers may share a directory. If the watch
+		/// can't be added the directory is polled instead.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void add_native_watch(const fs::path& dir)
+		{
+#if FS_WATCHER_INOTIFY
+			if (_inotify < 0)
+				return;
+
+			const std::string key = dir.string();
+			auto it = _native_watches.find(key);
+			if (it != _native_watches.end())
+			{
+				it->second.refs++;
+				return;
+			}
+
+			const std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+				| IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+			const int wd = inotify_add_watch(_inotify, key.c_str(), mask);
+			if (wd < 0)
+				return;
+
+			auto& native = _native_watches[key];
+			native.wd = wd;
+			native.refs = 1;
+			_native_dirs[wd] = key;
+#endif
+		}
+
+		//-----------------------------------------------------------------------------
+		//  Name : release_native_watch ()
+		/// <summary>
+		/// Releases a reference to a native directory watch.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void release_native_watch(const fs::path& dir)
+		{
+#if FS_WATCHER_INOTIFY
+			auto it = _native_watches.find(dir.string());
+			if (it == _native_watches.end() || --it->second.refs > 0)
+				return;
+
+			inotify_rm_watch(_inotify, it->second.wd);
+			_native_dirs.erase(it->second.wd);
+			_native_watches.erase(it);
+#endif
 		}
 
 		static FSWatcher& get_watcher()
@@ -251,7 +447,8 @@ namespace fs
 				std::lock_guard<std::recursive_mutex> lock(wd._mutex);
 				if (wd._watchers.find(key) == wd._watchers.end())
 				{
-					wd._watchers.emplace(make_pair(key, Watcher(p, filter, initialList, listCallback)));
+					auto it = wd._watchers.emplace(make_pair(key, Watcher(p, filter, initialList, listCallback))).first;
+					wd.add_native_watch(it->second.get_directory());
 				}
 			}
 			
@@ -267,6 +464,10 @@ namespace fs
 			if (path.empty())
 			{
 				std::lock_guard<std::recursive_mutex> lock(wd._mutex);
+				for (auto& watcher : wd._watchers)
+				{
+					wd.release_native_watch(watcher.second.get_directory());
+				}
 				wd._watchers.clear();
 			}
 			// or the specified file or directory
@@ -282,6 +483,7 @@ namespace fs
 						if (watcher_key == dir)
 						{
 							it->second.watch();
+							wd.release_native_watch(it->second.get_directory());
 							it = wd._watchers.erase(it);
 						}
 						else
@@ -294,6 +496,7 @@ namespace fs
 					if (watcher != wd._watchers.end())
 					{
 						watcher->second.watch();
+						wd.release_native_watch(watcher->second.get_directory());
 						wd._watchers.erase(watcher);
 					}
 				}
@@ -420,6 +623,7 @@ namespace fs
 				: _filter(filter), _callback(listCallback)
 			{
 				_root = path;
+				_directory = (!_filter.empty() || fs::is_directory(_root, std::error_code{})) ? _root : _root.parent_path();
 				std::vector<Entry> entries;
 				// make sure we store all initial write time
 				if (!_filter.empty())
@@ -540,6 +744,17 @@ namespace fs
 				}
 			}
 
+			//-----------------------------------------------------------------------------
+			//  Name : get_directory ()
+			/// <summary>
+			/// Returns the directory whose changes can affect this watcher.
+			/// </summary>
+			//-----------------------------------------------------------------------------
+			const fs::path& get_directory() const
+			{
+				return _directory;
+			}
+
 			//-----------------------------------------------------------------------------
 			//  Name : poll_entry ()
 			/// <summary>
@@ -601,6 +816,8 @@ namespace fs
 		protected:
 			/// Path to watch
 			fs::path _root;
+			/// Directory whose changes can affect the watched path
+			fs::path _directory;
 			/// Filter applied
 			std::string _filter;
 			/// Callback for list of modifications
@@ -618,6 +835,22 @@ namespace fs
 		std::thread _thread;
 		/// Registered file watchers
 		std::map<std::string, Watcher> _watchers;
+
+		struct NativeWatch
+		{
+			/// Watch descriptor
+			int wd = -1;
+			/// Watchers sharing the directory
+			std::size_t refs = 0;
+		};
+		/// Natively watched directories
+		std::map<std::string, NativeWatch> _native_watches;
+		/// Watch descriptor to directory
+		std::map<int, std::string> _native_dirs;
+#if FS_WATCHER_INOTIFY
+		/// inotify instance, negative if unavailable
+		int _inotify = -1;
+#endif
 	};
 
 	using watcher = FSWatcher;
@@ -1,6 +1,7 @@
 #include "task.h"
 #include "engine.h"
 #include "core/common/assert.hpp"
+#include "core/profiling/profiler.h"
 
 namespace runtime
 {
@@ -135,6 +136,7 @@ namespace runtime
 
 	void TaskSystem::execute_tasks_on_main(std::chrono::duration<float>)
 	{
+		PROFILE_SCOPE("Main Thread Tasks");
 		unsigned index = get_thread_index();
 		while (!_main_thread_tasks.tasks.empty())
 		{
@@ -224,7 +226,10 @@ namespace runtime
 				on_task_start(index, task->name);
 
 			if (task->closure)
+			{
+				PROFILE_SCOPE(task->name);
 				task->closure();
+			}
 
 			finish(handle);
 
@@ -265,7 +270,10 @@ namespace runtime
 				on_task_start(index, task->name);
 
 			if (task->closure)
+			{
+				PROFILE_SCOPE(task->name);
 				task->closure();
+			}
 
 			finish(handle);
 
@@ -285,6 +293,8 @@ namespace runtime
 
 	void TaskSystem::thread_run(TaskSystem& scheduler, unsigned index)
 	{
+		core::profiler::set_thread_name("Worker " + std::to_string(index));
+
 		if (scheduler.on_thread_start)
 			scheduler.on_thread_start(index);
 
@@ -0,0 +1,129 @@
+#include "../test.h"
+#include "editor/assets/asset_compiler_cache.h"
+#include "runtime/ecs/utils.h"
+#include <fstream>
+#include <string>
+
+namespace
+{
+	// a directory of its own below the system temporary directory, emptied
+	// before every test
+	fs::path make_directory(const std::string& name)
+	{
+		const fs::path dir = fs::temp_directory_path() / "ethereal_tests" / name;
+		fs::remove_all(dir, std::error_code{});
+		fs::create_directories(dir, std::error_code{});
+		return dir;
+	}
+
+	void write_file(const fs::path& path, const std::string& contents)
+	{
+		std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		stream << contents;
+	}
+
+	std::string read_file(const fs::path& path)
+	{
+		std::ifstream stream(path, std::ios::in | std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+
+	std::uint64_t get_file_key(const fs::path& path, const std::string& option)
+	{
+		AssetCompilerCache::KeyBuilder key;
+		key.add("compiler-1");
+		key.add(option);
+		key.add_file(path);
+		return key.get();
+	}
+}
+
+TEST_CASE(asset_compiler_cache_key)
+{
+	const auto dir = make_directory("cache_key");
+	write_file(dir / "a.obj", "source");
+	write_file(dir / "b.obj", "source");
+
+	// the key depends on the contents, the options and the file name, but
+	// not on where the file is
+	const auto key = get_file_key(dir / "a.obj", "compress");
+	CHECK(key == get_file_key(dir / "a.obj", "compress"));
+	CHECK(key != get_file_key(dir / "a.obj", "float"));
+	CHECK(key != get_file_key(dir / "b.obj", "compress"));
+
+	fs::create_directories(dir / "moved", std::error_code{});
+	write_file(dir / "moved" / "a.obj", "source");
+	CHECK(key == get_file_key(dir / "moved" / "a.obj", "compress"));
+
+	write_file(dir / "a.obj", "changed source");
+	CHECK(key != get_file_key(dir / "a.obj", "compress"));
+
+	// strings are delimited, moving characters between them changes the key
+	AssetCompilerCache::KeyBuilder key1;
+	key1.add("ab").add("c");
+	AssetCompilerCache::KeyBuilder key2;
+	key2.add("a").add("bc");
+	CHECK(key1.get() != key2.get());
+
+	// a missing file still adds its name
+	AssetCompilerCache::KeyBuilder missing;
+	CHECK(!missing.add_file(dir / "missing.obj"));
+	CHECK(missing.get() != AssetCompilerCache::KeyBuilder().get());
+}
+
+TEST_CASE(asset_compiler_cache_reuse)
+{
+	const auto dir = make_directory("cache_reuse");
+	const auto output = dir / "mesh.msc";
+	AssetCompilerCache::open(dir / "cache");
+
+	// nothing is reused before it was stored
+	CHECK(!AssetCompilerCache::try_reuse(1, output));
+	write_file(output, "compiled 1");
+	AssetCompilerCache::store(1, output, AssetCompilerCache::duration::zero());
+	CHECK(AssetCompilerCache::try_reuse(1, output));
+
+	// another key compiles again, after which both are in the cache
+	CHECK(!AssetCompilerCache::try_reuse(2, output));
+	write_file(output, "compiled 2");
+	AssetCompilerCache::store(2, output, AssetCompilerCache::duration::zero());
+
+	// switching back restores the earlier output instead of compiling it
+	CHECK(AssetCompilerCache::try_reuse(1, output));
+	CHECK(read_file(output) == "compiled 1");
+
+	// the manifest survives closing the cache, an up to date output is left
+	// alone, a deleted one is restored
+	AssetCompilerCache::close();
+	AssetCompilerCache::open(dir / "cache");
+	const auto write_time = fs::last_write_time(output);
+	CHECK(AssetCompilerCache::try_reuse(1, output));
+	CHECK(fs::last_write_time(output) == write_time);
+
+	fs::remove(output, std::error_code{});
+	CHECK(AssetCompilerCache::try_reuse(2, output));
+	CHECK(read_file(output) == "compiled 2");
+
+	const auto stats = AssetCompilerCache::get_stats();
+	CHECK(stats.hits == 2 && stats.misses == 0);
+	AssetCompilerCache::close();
+
+	// without an opened cache nothing is reused
+	CHECK(!AssetCompilerCache::try_reuse(2, output));
+}
+
+TEST_CASE(asset_compiler_mesh_lods_manifest)
+{
+	const auto dir = make_directory("mesh_lods");
+	const auto manifest = dir / "mesh.lods";
+
+	std::vector<std::string> lods;
+	CHECK(!ecs::utils::load_mesh_lods(manifest, lods));
+
+	ecs::utils::save_mesh_lods(manifest, { "mesh_lod1", "mesh_lod3" });
+	CHECK(ecs::utils::load_mesh_lods(manifest, lods));
+	CHECK(lods == std::vector<std::string>({ "mesh_lod1", "mesh_lod3" }));
+
+	ecs::utils::save_mesh_lods(manifest, {});
+	CHECK(ecs::utils::load_mesh_lods(manifest, lods) && lods.empty());
+}
@@ -0,0 +1,99 @@
+#include "../test.h"
+#include "runtime/ecs/ecs.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	class Position : public runtime::Component
+	{
+		COMPONENT(Position)
+	public:
+		void set(float value) { x = value; touch(); }
+		float x = 0.0f;
+	};
+
+	class Velocity : public runtime::Component
+	{
+		COMPONENT(Velocity)
+	public:
+		void set(float value) { x = value; touch(); }
+		float x = 0.0f;
+	};
+
+	std::size_t count(runtime::EntityComponentSystem::View<Position> view)
+	{
+		return std::size_t(std::distance(view.begin(), view.end()));
+	}
+}
+
+TEST_CASE(ecs_change_tracking)
+{
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+
+	// a component is only dirty once it is assigned
+	Position unassigned;
+	CHECK(!unassigned.is_dirty());
+
+	std::vector<runtime::Entity> entities;
+	for (std::uint32_t i = 0; i < 10; ++i)
+	{
+		entities.push_back(ecs->create());
+		entities.back().assign<Position>();
+		entities.back().assign<Velocity>();
+	}
+	CHECK(entities[0].component<Position>().lock()->is_dirty());
+
+	// a query only sees changes of the types it asks for
+	const auto version = ecs->get_change_version();
+	CHECK(count(ecs->entities_changed_since<Position>(version)) == 0);
+	for (std::uint32_t i = 0; i < 10; i += 2)
+		entities[i].component<Velocity>().lock()->set(1.0f);
+	CHECK(count(ecs->entities_changed_since<Position>(version)) == 0);
+	CHECK(ecs->changed_since<Velocity>(entities[0].id(), version));
+	CHECK(!ecs->changed_since<Position>(entities[0].id(), version));
+
+	entities[3].component<Position>().lock()->set(1.0f);
+	CHECK(count(ecs->entities_changed_since<Position>(version)) == 1);
+	CHECK(ecs->changed_since<Position>(entities[3].id(), version));
+
+	ecs->dispose();
+}
+
+TEST_CASE(ecs_change_versions_from_tasks)
+{
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+
+	std::vector<runtime::Entity> entities;
+	for (std::uint32_t i = 0; i < 4000; ++i)
+	{
+		entities.push_back(ecs->create());
+		entities.back().assign<Position>();
+	}
+
+	// touching different components from several threads hands out every
+	// version exactly once
+	const auto version = ecs->get_change_version();
+	std::vector<std::thread> threads;
+	for (std::uint32_t thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([&entities, thread]()
+		{
+			for (std::size_t i = thread; i < entities.size(); i += 4)
+				entities[i].component<Position>().lock()->set(float(i));
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK(ecs->get_change_version() == version + entities.size());
+	std::vector<std::uint64_t> versions;
+	for (auto entity : entities)
+		versions.push_back(entity.component<Position>().lock()->get_version());
+	std::sort(versions.begin(), versions.end());
+	CHECK(std::unique(versions.begin(), versions.end()) == versions.end());
+	CHECK(versions.front() > version);
+
+	ecs->dispose();
+}
@@ -0,0 +1,132 @@
+#include "../test.h"
+#include "runtime/ecs/utils.h"
+#include "runtime/meta/ecs/entity.hpp"
+#include "runtime/meta/ecs/components/transform_component.hpp"
+#include "runtime/meta/math/transform.hpp"
+#include "core/subsystem/subsystem.h"
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace
+{
+	// a scene of root entities with a transform, each with a few levels of
+	// children below them
+	std::vector<runtime::Entity> make_scene(runtime::EntityComponentSystem& ecs, std::uint32_t roots, std::uint32_t children)
+	{
+		std::vector<runtime::Entity> scene;
+		for (std::uint32_t i = 0; i < roots; ++i)
+		{
+			auto root = ecs.create();
+			root.set_name("root" + std::to_string(i));
+			auto parent = root.assign<TransformComponent>();
+			parent.lock()->set_local_transform(math::transform_t(math::vec3(float(i), 0.0f, 0.0f)));
+			scene.push_back(root);
+
+			for (std::uint32_t j = 0; j < children; ++j)
+			{
+				auto child = ecs.create();
+				child.set_name("child" + std::to_string(j));
+				auto transform = child.assign<TransformComponent>();
+				transform.lock()->set_local_transform(math::transform_t(math::vec3(0.0f, float(j), 0.0f)));
+				transform.lock()->set_parent(parent, false, true);
+				parent = transform;
+			}
+		}
+		return scene;
+	}
+
+	std::size_t count_entities(const std::vector<runtime::Entity>& entities)
+	{
+		std::size_t count = 0;
+		for (auto entity : entities)
+		{
+			std::vector<runtime::Entity> children;
+			for (const auto& child : entity.component<TransformComponent>().lock()->get_children())
+				children.push_back(child.lock()->get_entity());
+			count += 1 + count_entities(children);
+		}
+		return count;
+	}
+
+	double get_elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TEST_CASE(scene_serialization_round_trip)
+{
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+	const auto scene = make_scene(*ecs, 10, 5);
+
+	for (int binary = 0; binary < 2; ++binary)
+	{
+		const auto format = binary == 1 ? ecs::utils::DataFormat::Binary : ecs::utils::DataFormat::Json;
+		std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+		ecs::utils::serialize_data(stream, scene, format);
+
+		// the binary header is little endian on every platform
+		if (binary == 1)
+			CHECK(stream.str().compare(0, 4, "ECSB") == 0 && stream.str()[4] == 2 && stream.str()[8] == 60);
+
+		std::vector<runtime::Entity> loaded;
+		CHECK(ecs::utils::deserialize_data(stream, loaded));
+		CHECK(loaded.size() == scene.size() && count_entities(loaded) == 60);
+		for (std::size_t i = 0; i < loaded.size() && i < scene.size(); ++i)
+		{
+			auto original = scene[i];
+			CHECK(loaded[i].get_name() == original.get_name());
+			CHECK(loaded[i].component<TransformComponent>().lock()->get_local_transform() ==
+				original.component<TransformComponent>().lock()->get_local_transform());
+		}
+	}
+
+	ecs->dispose();
+}
+
+TEST_CASE(scene_serialization_rejects_newer_versions)
+{
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+	const auto scene = make_scene(*ecs, 2, 2);
+
+	std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+	ecs::utils::serialize_data(stream, scene, ecs::utils::DataFormat::Binary);
+	auto data = stream.str();
+	data[4] = 100;
+
+	std::stringstream newer(data, std::ios::in | std::ios::binary);
+	std::vector<runtime::Entity> loaded;
+	CHECK(!ecs::utils::deserialize_data(newer, loaded));
+	CHECK(loaded.empty());
+
+	ecs->dispose();
+}
+
+BENCHMARK_CASE(scene_serialization_10000_entities)
+{
+	auto ecs = core::get_subsystem<runtime::EntityComponentSystem>();
+	const auto scene = make_scene(*ecs, 1000, 9);
+
+	for (int binary = 0; binary < 2; ++binary)
+	{
+		const auto format = binary == 1 ? ecs::utils::DataFormat::Binary : ecs::utils::DataFormat::Json;
+		std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+
+		const auto save_start = std::chrono::high_resolution_clock::now();
+		ecs::utils::serialize_data(stream, scene, format);
+		const double save = get_elapsed_ms(save_start);
+
+		const auto load_start = std::chrono::high_resolution_clock::now();
+		std::vector<runtime::Entity> loaded;
+		CHECK(ecs::utils::deserialize_data(stream, loaded));
+		const double load = get_elapsed_ms(load_start);
+
+		CHECK(count_entities(loaded) == 10000);
+		std::printf("%s: save %.3f ms, load %.3f ms, %u bytes\n", binary == 1 ? "binary" : "json", save, load,
+			std::uint32_t(stream.str().size()));
+	}
+
+	ecs->dispose();
+}
@@ -0,0 +1,75 @@
+#include "test.h"
+#include "core/subsystem/subsystem.h"
+#include "runtime/system/task.h"
+#include "runtime/ecs/ecs.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	const char* current_test = nullptr;
+	std::uint32_t current_failures = 0;
+}
+
+namespace tests
+{
+	std::vector<TestCase>& get_test_cases()
+	{
+		static std::vector<TestCase> test_cases;
+		return test_cases;
+	}
+
+	void report_failure(const char* file, int line, const char* expression)
+	{
+		// a check in a loop may fail many times, report the first few only
+		if (++current_failures <= 10)
+			std::printf("%s:%d: %s: check failed: %s\n", file, line, current_test, expression);
+	}
+}
+
+// Runs every test case, or every benchmark when started with --bench. A name
+// given on the command line restricts the run to the cases containing it.
+// Returns the number of failed test cases.
+int main(int argc, char* argv[])
+{
+	bool benchmarks = false;
+	std::string filter;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	// the code under test splits its work over the task system when it runs,
+	// and loads entities into the entity component system
+	core::details::initialize();
+	core::add_subsystem<runtime::TaskSystem>();
+	core::add_subsystem<runtime::EntityComponentSystem>();
+
+	int failed = 0;
+	int run = 0;
+	for (const auto& test_case : tests::get_test_cases())
+	{
+		if (test_case.benchmark != benchmarks)
+			continue;
+		if (!filter.empty() && std::string(test_case.name).find(filter) == std::string::npos)
+			continue;
+
+		current_test = test_case.name;
+		current_failures = 0;
+		test_case.function();
+		run++;
+
+		if (current_failures > 0)
+			failed++;
+		std::printf("%s %s\n", current_failures > 0 ? "FAILED" : "passed", test_case.name);
+	}
+
+	core::details::dispose();
+
+	std::printf("%d of %d %s passed\n", run - failed, run, benchmarks ? "benchmarks" : "test cases");
+	return failed;
+}
@@ -0,0 +1,254 @@
+#include "../test.h"
+#include "core/math/transform.h"
+#include "core/math/transform_batch.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace math;
+
+namespace
+{
+	// a transform with a random rotation, translation and a positive scale of
+	// up to four along each axis
+	transform_t make_transform(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		const quat rotation = normalize(quat(unit(random), unit(random), unit(random), unit(random)));
+		const vec3 scale(2.0f + unit(random) * 1.9f, 2.0f + unit(random) * 1.9f, 2.0f + unit(random) * 1.9f);
+		const vec3 position(unit(random) * 100.0f, unit(random) * 100.0f, unit(random) * 100.0f);
+		transform_t t;
+		t.compose(scale, rotation, position);
+		return t;
+	}
+
+	bool is_near(const mat4& a, const mat4& b, float tolerance)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			for (int r = 0; r < 4; ++r)
+			{
+				if (std::abs(a[c][r] - b[c][r]) > tolerance)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// two rotations are the same when their quaternions are, up to the sign
+	bool is_same_rotation(const quat& a, const quat& b)
+	{
+		return std::abs(std::abs(dot(a, b)) - 1.0f) < 1e-4f;
+	}
+
+	double get_elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TEST_CASE(transform_cached_decomposition)
+{
+	std::mt19937 random(1);
+	for (std::uint32_t i = 0; i < 1000; ++i)
+	{
+		auto t = make_transform(random);
+		vec3 scale, shear, position;
+		quat rotation;
+		CHECK(t.decompose(scale, shear, rotation, position));
+		CHECK(is_same_rotation(t.get_rotation(), rotation));
+		CHECK(all(epsilonEqual(t.get_scale(), scale, 1e-4f)));
+		CHECK(all(epsilonEqual(t.x_unit_axis() * scale.x, t.x_axis(), 1e-4f)));
+
+		// a copy keeps the cache, a mutation drops it
+		const auto copy = t;
+		CHECK(copy.get_rotation() == t.get_rotation());
+		t.rotate(0.5f, 0.0f, 0.0f);
+		CHECK(t.decompose(scale, shear, rotation, position));
+		CHECK(is_same_rotation(t.get_rotation(), rotation));
+		t.matrix() = copy.matrix();
+		CHECK(t.get_rotation() == copy.get_rotation());
+
+		// scaling keeps the rotation
+		t.set_scale(1.0f, 2.0f, 3.0f);
+		CHECK(is_same_rotation(t.get_rotation(), copy.get_rotation()));
+		CHECK(all(epsilonEqual(t.get_scale(), vec3(1.0f, 2.0f, 3.0f), 1e-4f)));
+		CHECK(std::abs(length(t.y_axis()) - 2.0f) < 1e-4f);
+
+		mat4 inverse;
+		CHECK(transform_t::affine_inverse(t.matrix(), inverse));
+		CHECK(is_near(inverse, glm::inverse(t.matrix()), 1e-4f));
+	}
+}
+
+TEST_CASE(transform_negative_scale)
+{
+	std::mt19937 random(2);
+	for (std::uint32_t i = 0; i < 1000; ++i)
+	{
+		const auto t = make_transform(random);
+
+		// a negative scale mirrors its axis only
+		auto mirrored = t;
+		mirrored.set_scale(-2.0f, 1.0f, 1.0f);
+		CHECK(all(epsilonEqual(mirrored.x_axis(), -2.0f * t.x_unit_axis(), 1e-4f)));
+		CHECK(all(epsilonEqual(mirrored.y_axis(), t.y_unit_axis(), 1e-4f)));
+		CHECK(all(epsilonEqual(mirrored.get_scale(), vec3(-2.0f, 1.0f, 1.0f), 1e-4f)));
+		CHECK(determinant(mat3(mirrored.matrix())) < 0.0f);
+
+		// the scale and rotation of a mirrored matrix compose back into it,
+		// setting the scale it reports leaves it unchanged
+		transform_t mirrored_matrix = t.matrix() * glm::scale(vec3(1.0f, -1.0f, 1.0f));
+		transform_t composed;
+		composed.compose(mirrored_matrix.get_scale(), mirrored_matrix.get_rotation(), mirrored_matrix.get_position());
+		CHECK(is_near(composed.matrix(), mirrored_matrix.matrix(), 1e-3f));
+
+		auto rescaled = mirrored_matrix;
+		rescaled.set_scale(mirrored_matrix.get_scale());
+		CHECK(is_near(rescaled.matrix(), mirrored_matrix.matrix(), 1e-3f));
+		CHECK(all(epsilonEqual(mirrored_matrix.y_unit_axis() * length(mirrored_matrix.y_axis()), mirrored_matrix.y_axis(), 1e-4f)));
+	}
+}
+
+TEST_CASE(transform_concurrent_getters)
+{
+	// threads reading the same transforms agree on the decomposition, whichever
+	// of them fills the cache
+	std::mt19937 random(3);
+	std::vector<transform_t> transforms;
+	std::vector<quat> rotations;
+	for (std::uint32_t i = 0; i < 10000; ++i)
+	{
+		transforms.push_back(make_transform(random));
+		vec3 scale, shear, position;
+		quat rotation;
+		transforms.back().decompose(scale, shear, rotation, position);
+		rotations.push_back(rotation);
+	}
+
+	std::vector<std::uint32_t> mismatches(4, 0);
+	std::vector<std::thread> threads;
+	for (std::uint32_t thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([&, thread]()
+		{
+			for (std::size_t i = 0; i < transforms.size(); ++i)
+			{
+				if (!is_same_rotation(transforms[i].get_rotation(), rotations[i]))
+					mismatches[thread]++;
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	for (auto count : mismatches)
+		CHECK(count == 0);
+}
+
+TEST_CASE(transform_batch_kernels)
+{
+	std::mt19937 random(4);
+	std::vector<mat4> lhs, rhs, result(100);
+	std::vector<vec3> points, transformed(100);
+	std::vector<bbox> bounds, transformed_bounds(100);
+	for (std::uint32_t i = 0; i < 100; ++i)
+	{
+		lhs.push_back(make_transform(random).matrix());
+		rhs.push_back(make_transform(random).matrix());
+		points.push_back(make_transform(random).get_position());
+		bounds.push_back(bbox(points.back() - 1.0f, points.back() + 2.0f));
+	}
+
+	batch::mul(lhs.data(), rhs.data(), result.data(), result.size());
+	for (std::size_t i = 0; i < result.size(); ++i)
+		CHECK(is_near(result[i], lhs[i] * rhs[i], 1e-2f));
+
+	batch::mul(lhs[0], rhs.data(), result.data(), result.size());
+	for (std::size_t i = 0; i < result.size(); ++i)
+		CHECK(is_near(result[i], lhs[0] * rhs[i], 1e-2f));
+
+	batch::transform_coords(lhs[0], points.data(), transformed.data(), points.size());
+	for (std::size_t i = 0; i < points.size(); ++i)
+		CHECK(all(epsilonEqual(transformed[i], vec3(lhs[0] * vec4(points[i], 1.0f)), 1e-2f)));
+
+	batch::transform_bounds(lhs.data(), bounds.data(), transformed_bounds.data(), bounds.size());
+	for (std::size_t i = 0; i < bounds.size(); ++i)
+	{
+		const auto expected = bbox::mul(bounds[i], lhs[i]);
+		CHECK(all(epsilonEqual(transformed_bounds[i].min, expected.min, 1e-2f)));
+		CHECK(all(epsilonEqual(transformed_bounds[i].max, expected.max, 1e-2f)));
+	}
+}
+
+BENCHMARK_CASE(transform_1m)
+{
+	const std::size_t count = 1000000;
+	std::mt19937 random(5);
+	std::vector<transform_t> transforms;
+	transforms.reserve(count);
+	for (std::size_t i = 0; i < count; ++i)
+		transforms.push_back(make_transform(random));
+
+	// the first pass fills the caches, the second reads them
+	float sum = 0.0f;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& t : transforms)
+		sum += t.get_rotation().w + t.get_scale().x;
+	const double first_ms = get_elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& t : transforms)
+		sum += t.get_rotation().w + t.get_scale().x;
+	const double cached_ms = get_elapsed_ms(start);
+	std::printf("get_rotation + get_scale: %.1f ms decomposing, %.1f ms cached\n", first_ms, cached_ms);
+
+	std::vector<mat4> matrices(count), inverses(count);
+	for (std::size_t i = 0; i < count; ++i)
+		matrices[i] = transforms[i].matrix();
+	start = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		inverses[i] = glm::inverse(matrices[i]);
+	const double inverse_ms = get_elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		transform_t::affine_inverse(matrices[i], inverses[i]);
+	const double affine_inverse_ms = get_elapsed_ms(start);
+	std::printf("inverse: %.1f ms glm::inverse, %.1f ms affine_inverse\n", inverse_ms, affine_inverse_ms);
+
+	std::vector<mat4> products(count);
+	start = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		products[i] = matrices[i] * inverses[i];
+	const double mul_ms = get_elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	batch::mul(matrices.data(), inverses.data(), products.data(), count);
+	const double batch_mul_ms = get_elapsed_ms(start);
+	std::printf("multiply: %.1f ms glm, %.1f ms batch\n", mul_ms, batch_mul_ms);
+
+	std::vector<vec3> points(count), transformed(count);
+	for (std::size_t i = 0; i < count; ++i)
+		points[i] = transforms[i].get_position();
+	start = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		transformed[i] = vec3(matrices[0] * vec4(points[i], 1.0f));
+	const double coords_ms = get_elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	batch::transform_coords(matrices[0], points.data(), transformed.data(), count);
+	const double batch_coords_ms = get_elapsed_ms(start);
+	std::printf("point transform: %.1f ms glm, %.1f ms batch\n", coords_ms, batch_coords_ms);
+
+	std::vector<bbox> bounds(count), transformed_bounds(count);
+	for (std::size_t i = 0; i < count; ++i)
+		bounds[i] = bbox(points[i] - 1.0f, points[i] + 1.0f);
+	start = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < count; ++i)
+		transformed_bounds[i] = bbox::mul(bounds[i], transforms[i]);
+	const double bounds_ms = get_elapsed_ms(start);
+	start = std::chrono::high_resolution_clock::now();
+	batch::transform_bounds(matrices.data(), bounds.data(), transformed_bounds.data(), count);
+	const double batch_bounds_ms = get_elapsed_ms(start);
+	std::printf("bounds transform: %.1f ms bbox::mul, %.1f ms batch\n", bounds_ms, batch_bounds_ms);
+
+	CHECK(sum != 0.0f && products[0][0][0] != 0.0f && transformed[0] != transformed[1]);
+}
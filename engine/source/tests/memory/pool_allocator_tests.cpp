@@ -0,0 +1,154 @@
+#include "../test.h"
+#include "core/memory/pool_allocator.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct Payload
+	{
+		std::uint8_t data[96];
+	};
+
+	// runs a function on a thread and keeps the thread alive until it is
+	// told to exit, so that its caches outlive whatever the test destroys
+	struct Worker
+	{
+		template<typename F>
+		explicit Worker(F function)
+			: thread([this, function]()
+			{
+				function();
+				std::unique_lock<std::mutex> lock(mutex);
+				ran = true;
+				condition.notify_one();
+				condition.wait(lock, [this]() { return done; });
+			})
+		{}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return ran; });
+		}
+
+		void join()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done = true;
+			}
+			condition.notify_all();
+			thread.join();
+		}
+
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool ran = false;
+		bool done = false;
+		std::thread thread;
+	};
+
+	// creates and destroys count shared objects on threads threads at once
+	template<typename Make>
+	double churn(std::uint32_t threads, std::size_t count, Make make)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> workers;
+		for (std::uint32_t thread = 0; thread < threads; ++thread)
+		{
+			workers.emplace_back([count, make]()
+			{
+				std::vector<std::shared_ptr<Payload>> objects;
+				objects.reserve(1024);
+				for (std::size_t i = 0; i < count; i += objects.capacity())
+				{
+					for (std::size_t j = 0; j < objects.capacity(); ++j)
+						objects.push_back(make());
+					objects.clear();
+				}
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TEST_CASE(pool_allocator_free_on_other_threads)
+{
+	// blocks freed on other threads come back to the pool once those threads
+	// exit, so allocating them again does not grow it
+	core::ConcurrentMemoryPool pool(sizeof(Payload), 256);
+	std::vector<void*> blocks;
+	for (std::uint32_t i = 0; i < 4096; ++i)
+		blocks.push_back(pool.malloc());
+	const auto capacity = pool.capacity();
+
+	std::vector<std::thread> threads;
+	for (std::uint32_t thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([&pool, &blocks, thread]()
+		{
+			for (std::size_t i = thread; i < blocks.size(); i += 4)
+				pool.free(blocks[i]);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	for (auto& block : blocks)
+	{
+		block = pool.malloc();
+		CHECK(block != nullptr);
+	}
+	CHECK(pool.capacity() == capacity);
+	for (auto block : blocks)
+		pool.free(block);
+}
+
+TEST_CASE(pool_allocator_pool_destroyed_before_threads)
+{
+	// a thread that still caches blocks of a destroyed pool drops them
+	// instead of giving them back when it exits
+	auto pool = new core::ConcurrentMemoryPool(sizeof(Payload), 256);
+	Worker worker([pool]()
+	{
+		std::vector<void*> blocks;
+		for (std::uint32_t i = 0; i < 16; ++i)
+			blocks.push_back(pool->malloc());
+		for (auto block : blocks)
+			pool->free(block);
+	});
+	for (std::uint32_t i = 0; i < 16; ++i)
+		pool->free(pool->malloc());
+	worker.wait();
+	delete pool;
+	worker.join();
+
+	// the threads keep working with the pools created after that
+	core::ConcurrentMemoryPool next(sizeof(Payload), 256);
+	Worker next_worker([&next]()
+	{
+		next.free(next.malloc());
+	});
+	next_worker.join();
+	CHECK(next.capacity() == 256);
+}
+
+BENCHMARK_CASE(pool_allocator_shared_objects)
+{
+	const std::size_t count = 1 << 20;
+	for (std::uint32_t threads : { 1u, 4u, 8u })
+	{
+		const double heap_ms = churn(threads, count, []() { return std::make_shared<Payload>(); });
+		const double pool_ms = churn(threads, count, []() { return std::allocate_shared<Payload>(core::PoolAllocator<Payload>()); });
+		std::printf("%u thread(s), %u shared objects each: %.1f ms make_shared, %.1f ms pooled\n",
+			threads, std::uint32_t(count), heap_ms, pool_ms);
+	}
+}
@@ -0,0 +1,138 @@
+#include "../test.h"
+#include "graphics/graphics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	double get_elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// the state of a typical g-buffer draw, one matrix and one submit each
+	void draw(gfx::VertexBufferHandle vertices, gfx::IndexBufferHandle indices, std::uint32_t index)
+	{
+		float matrix[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, float(index), 0.0f, 0.0f, 1.0f };
+		gfx::setTransform(matrix);
+		gfx::setVertexBuffer(vertices);
+		gfx::setIndexBuffer(indices);
+		gfx::setState(BGFX_STATE_DEFAULT);
+		gfx::submit(0, gfx::ProgramHandle{ gfx::invalidHandle }, std::int32_t(index));
+	}
+}
+
+TEST_CASE(encoder_return_values)
+{
+	// nothing reaches bgfx while recording, so no renderer is needed
+	gfx::Encoder encoder;
+	gfx::Encoder other;
+	{
+		gfx::EncoderScope scope(encoder);
+		CHECK(gfx::get_encoder() == &encoder);
+
+		const float matrices[32] = {};
+		const auto first = gfx::setTransform(matrices, 2);
+		const auto second = gfx::setTransform(matrices);
+		CHECK(first != UINT32_MAX && second != UINT32_MAX);
+		CHECK(second == first + 2);
+
+		const auto scissor = gfx::setScissor(0, 0, 16, 16);
+		CHECK(scissor != UINT16_MAX);
+		CHECK(gfx::setScissor(0, 0, 32, 32) == scissor + 1);
+
+		// a nested scope records into its own encoder and numbers its
+		// caches and draws from zero
+		{
+			gfx::EncoderScope nested(other);
+			CHECK(gfx::setTransform(matrices) == first);
+			CHECK(gfx::submit(0, gfx::ProgramHandle{ gfx::invalidHandle }) == 1);
+		}
+		CHECK(gfx::get_encoder() == &encoder);
+
+		gfx::setTransform(first, 2);
+		gfx::setScissor(scissor);
+		CHECK(gfx::touch(0) == 0);
+		CHECK(gfx::submit(0, gfx::ProgramHandle{ gfx::invalidHandle }) == 1);
+		CHECK(gfx::submit(0, gfx::ProgramHandle{ gfx::invalidHandle }) == 2);
+	}
+	CHECK(gfx::get_encoder() == nullptr);
+	CHECK(encoder.get_submit_count() == 2);
+	CHECK(other.get_submit_count() == 1);
+
+	// cleared encoders hand out the same caches again
+	encoder.clear();
+	CHECK(encoder.empty() && encoder.get_submit_count() == 0);
+	{
+		gfx::EncoderScope scope(encoder);
+		const float matrix[16] = {};
+		CHECK(gfx::setTransform(matrix) == 0x80000000u);
+	}
+	encoder.clear();
+	other.clear();
+}
+
+BENCHMARK_CASE(encoder_submission_noop)
+{
+	// submission throughput on the noop renderer, the same draws issued
+	// straight to bgfx on the main thread and recorded on several threads
+	// then replayed
+	if (!gfx::init(gfx::RendererType::Noop))
+	{
+		std::printf("the noop renderer is not available\n");
+		return;
+	}
+
+	const float positions[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+	const std::uint16_t triangle[] = { 0, 1, 2 };
+	gfx::VertexDecl decl;
+	decl.begin().add(gfx::Attrib::Position, 3, gfx::AttribType::Float).end();
+	const auto vertices = gfx::createVertexBuffer(gfx::copy(positions, sizeof(positions)), decl);
+	const auto indices = gfx::createIndexBuffer(gfx::copy(triangle, sizeof(triangle)));
+
+	const std::uint32_t draws = 32768;
+	const std::uint32_t frames = 16;
+	const std::uint32_t threads = std::max(2u, std::thread::hardware_concurrency());
+	std::vector<gfx::Encoder> encoders(threads);
+
+	double direct_ms = 0.0, record_ms = 0.0, replay_ms = 0.0;
+	for (std::uint32_t frame = 0; frame < frames; ++frame)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (std::uint32_t i = 0; i < draws; ++i)
+			draw(vertices, indices, i);
+		direct_ms += get_elapsed_ms(start);
+		gfx::frame();
+
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<std::thread> workers;
+		for (std::uint32_t thread = 0; thread < threads; ++thread)
+		{
+			workers.emplace_back([&, thread]()
+			{
+				gfx::EncoderScope scope(encoders[thread]);
+				for (std::uint32_t i = thread * draws / threads; i < (thread + 1) * draws / threads; ++i)
+					draw(vertices, indices, i);
+			});
+		}
+		for (auto& worker : workers)
+			worker.join();
+		record_ms += get_elapsed_ms(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (auto& encoder : encoders)
+			encoder.replay();
+		replay_ms += get_elapsed_ms(start);
+		gfx::frame();
+	}
+
+	std::printf("%u draws per frame: %.2f ms direct, %.2f ms recorded on %u threads + %.2f ms replayed (%.1f Mdraws/s recorded)\n",
+		draws, direct_ms / frames, record_ms / frames, threads, replay_ms / frames, draws * frames / record_ms / 1000.0);
+
+	gfx::destroyIndexBuffer(indices);
+	gfx::destroyVertexBuffer(vertices);
+	gfx::shutdown();
+}
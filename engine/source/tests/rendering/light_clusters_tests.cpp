@@ -0,0 +1,186 @@
+#include "../test.h"
+#include "runtime/rendering/light_clusters.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// a projection for every combination the renderer uses: perspective and
+	// orthographic, with the depth range of gl and of d3d
+	math::mat4 make_projection(std::uint32_t index, float near_clip, float far_clip, bool homogeneous_depth)
+	{
+		if (index % 7 == 3)
+			return math::ortho(-20.0f, 20.0f, -10.0f, 10.0f, near_clip, far_clip, homogeneous_depth);
+
+		return math::perspective(math::radians(60.0f + index), 16.0f / 9.0f, near_clip, far_clip, homogeneous_depth);
+	}
+
+	// point lights and spot lights spread over the view space in front of
+	// the camera, some of them partly or fully outside of the frustum
+	std::vector<LightClusters::Light> make_lights(std::size_t count, float far_clip, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<LightClusters::Light> lights(count);
+		for (auto& light : lights)
+		{
+			light.position = math::vec3(unit(random) * 60.0f, unit(random) * 40.0f, (unit(random) + 1.0f) * far_clip * 0.5f - 5.0f);
+			light.range = 0.5f + (unit(random) + 1.0f) * 10.0f;
+			if (unit(random) > 0.0f)
+			{
+				light.direction = math::normalize(math::vec3(unit(random), unit(random), unit(random)));
+				const float half_angle = 0.1f + (unit(random) + 1.0f) * 0.7f;
+				light.cos_half_angle = std::cos(half_angle);
+				light.sin_half_angle = std::sin(half_angle);
+			}
+		}
+		return lights;
+	}
+
+	bool equal_clusters(const LightClusters& clusters1, const LightClusters& clusters2)
+	{
+		const auto& list1 = clusters1.get_clusters();
+		const auto& list2 = clusters2.get_clusters();
+		if (list1.size() != list2.size() || clusters1.get_light_indices() != clusters2.get_light_indices())
+			return false;
+
+		for (std::size_t i = 0; i < list1.size(); ++i)
+		{
+			if (list1[i].offset != list2[i].offset || list1[i].count != list2[i].count)
+				return false;
+		}
+		return true;
+	}
+
+	double get_elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TEST_CASE(light_clusters_assign_matches_reference)
+{
+	std::mt19937 random(7);
+	LightClusters clusters;
+	LightClusters reference;
+	for (std::uint32_t i = 0; i < 40; ++i)
+	{
+		const bool homogeneous_depth = (i & 1) != 0;
+		const float near_clip = 0.1f + (i % 5) * 0.2f;
+		const float far_clip = 100.0f + i * 10.0f;
+		const auto proj = make_projection(i, near_clip, far_clip, homogeneous_depth);
+		clusters.build(proj, near_clip, far_clip, homogeneous_depth);
+		reference.build(proj, near_clip, far_clip, homogeneous_depth);
+
+		const auto lights = make_lights(i * 25 + 1, far_clip, random);
+		clusters.assign(lights.data(), lights.size());
+		reference.assign_reference(lights.data(), lights.size());
+		CHECK(equal_clusters(clusters, reference));
+	}
+}
+
+TEST_CASE(light_clusters_light_in_own_cluster)
+{
+	std::mt19937 random(11);
+	LightClusters clusters;
+	for (std::uint32_t i = 0; i < 40; ++i)
+	{
+		const bool homogeneous_depth = (i & 1) != 0;
+		const float near_clip = 0.1f + (i % 5) * 0.2f;
+		const float far_clip = 100.0f + i * 10.0f;
+		const auto proj = make_projection(i, near_clip, far_clip, homogeneous_depth);
+		clusters.build(proj, near_clip, far_clip, homogeneous_depth);
+
+		const auto lights = make_lights(i * 25 + 1, far_clip, random);
+		clusters.assign(lights.data(), lights.size());
+
+		// a light is always listed in the cluster its center is in, as long
+		// as the center is well inside of the frustum
+		const auto& indices = clusters.get_light_indices();
+		for (std::uint32_t light = 0; light < lights.size(); ++light)
+		{
+			const auto& position = lights[light].position;
+			if (position.z < near_clip * 2.0f || position.z > far_clip * 0.9f)
+				continue;
+
+			const auto clip = proj * math::vec4(position, 1.0f);
+			if (std::abs(clip.x / clip.w) > 0.99f || std::abs(clip.y / clip.w) > 0.99f)
+				continue;
+
+			const auto& cluster = clusters.get_clusters()[clusters.get_cluster_index(position)];
+			bool found = false;
+			for (auto index = cluster.offset; index < cluster.offset + cluster.count; ++index)
+				found |= indices[index] == light;
+			CHECK(found);
+		}
+	}
+}
+
+TEST_CASE(light_clusters_capped_per_cluster)
+{
+	// more lights than a cluster lists overlap in the middle of the view,
+	// the clusters keep the first ones and count the others
+	const auto proj = math::perspective(math::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f, false);
+	LightClusters clusters;
+	LightClusters reference;
+	clusters.build(proj, 0.1f, 200.0f, false);
+	reference.build(proj, 0.1f, 200.0f, false);
+
+	std::vector<LightClusters::Light> lights(LightClusters::MaxClusterLights + 44);
+	for (std::size_t i = 0; i < lights.size(); ++i)
+	{
+		lights[i].position = math::vec3(0.0f, 0.0f, 20.0f);
+		lights[i].range = 1.0f + float(i % 4);
+	}
+	clusters.assign(lights.data(), lights.size());
+	reference.assign_reference(lights.data(), lights.size());
+	CHECK(equal_clusters(clusters, reference));
+	CHECK(clusters.get_dropped_count() > 0);
+	CHECK(clusters.get_dropped_count() == reference.get_dropped_count());
+
+	const auto& indices = clusters.get_light_indices();
+	const auto& cluster = clusters.get_clusters()[clusters.get_cluster_index(lights[0].position)];
+	CHECK(cluster.count == LightClusters::MaxClusterLights);
+	for (std::uint32_t i = 0; i < cluster.count; ++i)
+		CHECK(indices[cluster.offset + i] == i);
+	for (const auto& c : clusters.get_clusters())
+		CHECK(c.count <= LightClusters::MaxClusterLights);
+
+	// fewer lights fit and nothing is dropped
+	clusters.assign(lights.data(), 100);
+	CHECK(clusters.get_dropped_count() == 0);
+}
+
+BENCHMARK_CASE(light_clusters_assign_1000_lights)
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<LightClusters::Light> lights(1000);
+	for (auto& light : lights)
+	{
+		light.position = math::vec3(unit(random) * 60.0f, unit(random) * 30.0f, (unit(random) + 1.0f) * 50.0f);
+		light.range = 2.0f + (unit(random) + 1.0f) * 4.0f;
+	}
+
+	const auto proj = math::perspective(math::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f, false);
+	LightClusters clusters;
+	LightClusters reference;
+	clusters.build(proj, 0.1f, 200.0f, false);
+	reference.build(proj, 0.1f, 200.0f, false);
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < 20; ++i)
+		clusters.assign(lights.data(), lights.size());
+	const double assign = get_elapsed_ms(start) / 20.0;
+
+	const auto reference_start = std::chrono::high_resolution_clock::now();
+	reference.assign_reference(lights.data(), lights.size());
+	const double assign_reference = get_elapsed_ms(reference_start);
+
+	CHECK(equal_clusters(clusters, reference));
+	std::printf("assign: %.3f ms, reference: %.3f ms, %u light indices\n", assign, assign_reference, std::uint32_t(clusters.get_light_indices().size()));
+}
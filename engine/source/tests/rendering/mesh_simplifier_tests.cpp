@@ -0,0 +1,172 @@
+#include "../test.h"
+#include "runtime/rendering/mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	struct TestMesh
+	{
+		std::vector<float> positions;
+		std::vector<std::uint32_t> indices;
+
+		std::uint32_t get_vertex_count() const { return std::uint32_t(positions.size() / 3); }
+	};
+
+	// a closed uv sphere of radius one, with the rows and columns of vertices
+	// welded so that the surface has no seams
+	TestMesh make_sphere(std::uint32_t rings, std::uint32_t segments)
+	{
+		const float pi = 3.14159265f;
+		TestMesh mesh;
+		mesh.positions.insert(mesh.positions.end(), { 0.0f, 1.0f, 0.0f });
+		for (std::uint32_t ring = 1; ring < rings; ++ring)
+		{
+			const float theta = pi * ring / rings;
+			for (std::uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const float phi = 2.0f * pi * segment / segments;
+				mesh.positions.insert(mesh.positions.end(), { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+			}
+		}
+		mesh.positions.insert(mesh.positions.end(), { 0.0f, -1.0f, 0.0f });
+
+		const std::uint32_t bottom = mesh.get_vertex_count() - 1;
+		auto get_vertex = [segments](std::uint32_t ring, std::uint32_t segment)
+		{
+			return 1 + (ring - 1) * segments + segment % segments;
+		};
+		for (std::uint32_t segment = 0; segment < segments; ++segment)
+		{
+			mesh.indices.insert(mesh.indices.end(), { 0, get_vertex(1, segment + 1), get_vertex(1, segment) });
+			mesh.indices.insert(mesh.indices.end(), { bottom, get_vertex(rings - 1, segment), get_vertex(rings - 1, segment + 1) });
+			for (std::uint32_t ring = 1; ring + 1 < rings; ++ring)
+			{
+				const std::uint32_t a = get_vertex(ring, segment), b = get_vertex(ring, segment + 1);
+				const std::uint32_t c = get_vertex(ring + 1, segment), d = get_vertex(ring + 1, segment + 1);
+				mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+			}
+		}
+		return mesh;
+	}
+
+	// a flat size x size grid of quads in the xz plane, with an open border
+	TestMesh make_plane(std::uint32_t size)
+	{
+		TestMesh mesh;
+		for (std::uint32_t z = 0; z <= size; ++z)
+		{
+			for (std::uint32_t x = 0; x <= size; ++x)
+				mesh.positions.insert(mesh.positions.end(), { float(x), 0.0f, float(z) });
+		}
+		for (std::uint32_t z = 0; z < size; ++z)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				const std::uint32_t a = z * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+			}
+		}
+		return mesh;
+	}
+
+	std::vector<std::uint32_t> simplify(const TestMesh& mesh, std::size_t target_index_count, float target_error, float& result_error)
+	{
+		std::vector<std::uint32_t> result(mesh.indices.size());
+		const std::size_t count = MeshSimplifier::simplify(result.data(), mesh.indices.data(), mesh.indices.size(), mesh.positions.data(),
+			mesh.get_vertex_count(), sizeof(float) * 3, target_index_count, target_error, nullptr, nullptr, &result_error);
+		result.resize(count);
+		return result;
+	}
+
+	// twice the signed area of a triangle list, projected along an axis. it
+	// is zero for a closed surface.
+	float get_area(const TestMesh& mesh, const std::vector<std::uint32_t>& indices, int axis)
+	{
+		float area = 0.0f;
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			const float* p0 = &mesh.positions[indices[i] * 3];
+			const float* p1 = &mesh.positions[indices[i + 1] * 3];
+			const float* p2 = &mesh.positions[indices[i + 2] * 3];
+			const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+			area += (p1[u] - p0[u]) * (p2[v] - p0[v]) - (p1[v] - p0[v]) * (p2[u] - p0[u]);
+		}
+		return area;
+	}
+
+	// the distance of the surface of a simplified sphere from the sphere,
+	// sampled at the centers and edge midpoints of its triangles, relative to
+	// the extent of the sphere
+	float get_sphere_deviation(const TestMesh& mesh, const std::vector<std::uint32_t>& indices)
+	{
+		float deviation = 0.0f;
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			const float weights[4][3] = { { 1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f }, { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.5f, 0.5f }, { 0.5f, 0.0f, 0.5f } };
+			for (const auto& weight : weights)
+			{
+				float point[3] = { 0.0f, 0.0f, 0.0f };
+				for (std::uint32_t j = 0; j < 3; ++j)
+				{
+					for (std::uint32_t c = 0; c < 3; ++c)
+						point[c] += mesh.positions[indices[i + j] * 3 + c] * weight[j];
+				}
+				const float radius = std::sqrt(point[0] * point[0] + point[1] * point[1] + point[2] * point[2]);
+				deviation = std::max(deviation, std::abs(1.0f - radius) / 2.0f);
+			}
+		}
+		return deviation;
+	}
+}
+
+TEST_CASE(mesh_simplifier_triangle_targets)
+{
+	// without an error limit, a closed mesh reaches the target triangle count
+	const auto sphere = make_sphere(32, 64);
+	const std::size_t index_count = sphere.indices.size();
+	std::size_t previous_count = index_count;
+	for (float ratio : { 0.75f, 0.5f, 0.25f, 0.1f })
+	{
+		const std::size_t target = std::size_t(index_count / 3 * ratio) * 3;
+		float error = 0.0f;
+		const auto result = simplify(sphere, target, 1.0f, error);
+		CHECK(result.size() % 3 == 0);
+		CHECK(result.size() <= target && result.size() + 12 >= target);
+		CHECK(result.size() < previous_count);
+		previous_count = result.size();
+
+		// the surface stays closed, no triangle is degenerate, and the error
+		// grows with the reduction but stays far from the limit
+		CHECK(std::abs(get_area(sphere, result, 1)) < 1e-3f);
+		for (std::size_t i = 0; i < result.size(); i += 3)
+			CHECK(result[i] != result[i + 1] && result[i + 1] != result[i + 2] && result[i] != result[i + 2]);
+		CHECK(error > 0.0f && error < 0.1f);
+	}
+}
+
+TEST_CASE(mesh_simplifier_error_bounded)
+{
+	// asking for a single triangle stops at the error limit, and the surface
+	// stays within a few times that error of the sphere, as the error is
+	// measured against the planes of the removed triangles
+	const auto sphere = make_sphere(32, 64);
+	const float original_deviation = get_sphere_deviation(sphere, sphere.indices);
+	for (float limit : { 0.002f, 0.005f, 0.02f })
+	{
+		float error = 0.0f;
+		const auto result = simplify(sphere, 3, limit, error);
+		CHECK(result.size() > 3 && result.size() < sphere.indices.size());
+		CHECK(error <= limit);
+		CHECK(get_sphere_deviation(sphere, result) <= original_deviation + limit * 3.0f);
+	}
+
+	// a flat plane simplifies without any error, keeping its area and border
+	const auto plane = make_plane(32);
+	float error = 1.0f;
+	const auto result = simplify(plane, 3, 1e-4f, error);
+	CHECK(error < 1e-5f);
+	CHECK(result.size() < plane.indices.size() / 4);
+	CHECK(std::abs(get_area(plane, result, 1) - get_area(plane, plane.indices, 1)) < 1e-2f);
+}
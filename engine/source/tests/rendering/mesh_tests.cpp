@@ -0,0 +1,310 @@
+#include "../test.h"
+#include "runtime/rendering/mesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Vertex
+	{
+		float position[3];
+		float uv[2];
+	};
+
+	const gfx::VertexDecl& get_vertex_format()
+	{
+		static gfx::VertexDecl format;
+		if (format.getStride() == 0)
+		{
+			format
+				.begin()
+				.add(gfx::Attrib::Position, 3, gfx::AttribType::Float)
+				.add(gfx::Attrib::TexCoord0, 2, gfx::AttribType::Float)
+				.end();
+		}
+		return format;
+	}
+
+	// opens up the preparation steps that are not public
+	struct TestMesh : public Mesh
+	{
+		using Mesh::weld_vertices;
+
+		// prepares the vertices with one triangle for every three of them, in
+		// order, so that the preparation data keeps the vertex order
+		bool prepare_soup(std::vector<Vertex>& vertices)
+		{
+			const auto& format = get_vertex_format();
+			if (!prepare_mesh(format) || !set_vertex_source(vertices.data(), std::uint32_t(vertices.size()), format))
+				return false;
+
+			TriangleArray triangles(vertices.size() / 3);
+			for (std::uint32_t i = 0; i < triangles.size(); ++i)
+			{
+				for (std::uint32_t j = 0; j < 3; ++j)
+					triangles[i].indices[j] = i * 3 + j;
+			}
+			return add_primitives(triangles);
+		}
+	};
+
+	// a grid of quads in the xy plane as a triangle soup, so that triangles
+	// only share positions, never vertices. the triangles are shuffled.
+	std::vector<Vertex> make_grid_soup(std::uint32_t size, std::uint32_t seed)
+	{
+		std::vector<std::uint32_t> quads(size * size);
+		for (std::uint32_t i = 0; i < quads.size(); ++i)
+			quads[i] = i;
+		std::shuffle(quads.begin(), quads.end(), std::mt19937(seed));
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(quads.size() * 6);
+		auto add = [&vertices](std::uint32_t x, std::uint32_t y)
+		{
+			Vertex vertex = { { x * 0.37f - 3.0f, y * 0.11f, 0.5f }, { float(x), float(y) } };
+			vertices.push_back(vertex);
+		};
+		for (auto quad : quads)
+		{
+			const std::uint32_t x = quad % size, y = quad / size;
+			add(x, y); add(x, y + 1); add(x + 1, y);
+			add(x + 1, y); add(x, y + 1); add(x + 1, y + 1);
+		}
+		return vertices;
+	}
+
+	// the position map the adjacency was built with before it was hashed
+	struct EdgeKey
+	{
+		const float* position1;
+		const float* position2;
+	};
+
+	bool operator<(const EdgeKey& key1, const EdgeKey& key2)
+	{
+		const float epsilon = std::numeric_limits<float>::epsilon();
+		for (int i = 0; i < 3; ++i)
+		{
+			if (std::abs(key1.position1[i] - key2.position1[i]) >= epsilon)
+				return key2.position1[i] < key1.position1[i];
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			if (std::abs(key1.position2[i] - key2.position2[i]) >= epsilon)
+				return key2.position2[i] < key1.position2[i];
+		}
+		return false;
+	}
+
+	std::vector<std::uint32_t> get_reference_adjacency(const std::vector<Vertex>& vertices)
+	{
+		const std::uint32_t triangle_count = std::uint32_t(vertices.size() / 3);
+		auto get_edge = [&vertices](std::uint32_t index1, std::uint32_t index2)
+		{
+			return EdgeKey{ vertices[index1].position, vertices[index2].position };
+		};
+
+		std::map<EdgeKey, std::uint32_t> edges;
+		for (std::uint32_t i = 0; i < triangle_count; ++i)
+		{
+			edges[get_edge(i * 3, i * 3 + 1)] = i;
+			edges[get_edge(i * 3 + 1, i * 3 + 2)] = i;
+			edges[get_edge(i * 3 + 2, i * 3)] = i;
+		}
+
+		std::vector<std::uint32_t> adjacency(triangle_count * 3, 0xFFFFFFFF);
+		auto find = [&edges](const EdgeKey& key)
+		{
+			auto it = edges.find(key);
+			return it == edges.end() ? 0xFFFFFFFF : it->second;
+		};
+		for (std::uint32_t i = 0; i < triangle_count; ++i)
+		{
+			adjacency[i * 3] = find(get_edge(i * 3 + 1, i * 3));
+			adjacency[i * 3 + 1] = find(get_edge(i * 3 + 2, i * 3 + 1));
+			adjacency[i * 3 + 2] = find(get_edge(i * 3, i * 3 + 2));
+		}
+		return adjacency;
+	}
+
+	// every vertex welds onto the first earlier kept vertex within tolerance
+	// whose other attributes match exactly
+	std::vector<std::uint32_t> get_reference_weld(const std::vector<Vertex>& vertices, float tolerance)
+	{
+		std::vector<std::uint32_t> remap(vertices.size(), 0xFFFFFFFF);
+		std::vector<std::uint32_t> kept;
+		for (std::uint32_t i = 0; i < vertices.size(); ++i)
+		{
+			const auto& vertex = vertices[i];
+			bool welded = false;
+			for (auto k : kept)
+			{
+				const auto& other = vertices[k];
+				float distance2 = 0.0f;
+				for (int c = 0; c < 3; ++c)
+					distance2 += (vertex.position[c] - other.position[c]) * (vertex.position[c] - other.position[c]);
+				if (distance2 <= tolerance * tolerance && std::memcmp(vertex.uv, other.uv, sizeof(vertex.uv)) == 0)
+				{
+					welded = true;
+					break;
+				}
+			}
+
+			if (!welded)
+			{
+				remap[i] = std::uint32_t(kept.size());
+				kept.push_back(i);
+			}
+		}
+		return remap;
+	}
+
+	double get_elapsed_ms(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TEST_CASE(mesh_weld_matches_reference)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(0.0f, 0.3f);
+	std::uniform_int_distribution<int> uv(0, 1);
+
+	const float tolerance = 0.01f;
+	std::vector<Vertex> vertices(3000);
+	for (auto& vertex : vertices)
+	{
+		for (auto& c : vertex.position)
+			c = coordinate(random);
+		for (auto& c : vertex.uv)
+			c = float(uv(random));
+	}
+
+	TestMesh mesh;
+	CHECK(mesh.prepare_soup(vertices));
+	UInt32Array remap;
+	CHECK(mesh.weld_vertices(tolerance, &remap));
+	CHECK(remap == get_reference_weld(vertices, tolerance));
+}
+
+TEST_CASE(mesh_weld_across_cells)
+{
+	// pairs of vertices on either side of the cell boundaries of the weld
+	// grid (four times the tolerance apart), just within and just outside
+	// of the tolerance, along every axis and diagonally, on both sides of
+	// the origin
+	const float tolerance = 0.01f;
+	const float cell = tolerance * 4.0f;
+	std::vector<Vertex> vertices;
+	for (int boundary = -3; boundary <= 3; ++boundary)
+	{
+		for (int axes = 1; axes < 8; ++axes)
+		{
+			for (int outside = 0; outside < 2; ++outside)
+			{
+				const float distance = tolerance * (outside == 1 ? 1.1f : 0.9f);
+				const float offset = distance / std::sqrt(float((axes & 1) + ((axes >> 1) & 1) + ((axes >> 2) & 1)));
+				Vertex vertex1 = { { 0.5f, 0.5f, 0.5f }, { float(boundary), float(axes * 2 + outside) } };
+				Vertex vertex2 = vertex1;
+				for (int c = 0; c < 3; ++c)
+				{
+					if ((axes & (1 << c)) == 0)
+						continue;
+					vertex1.position[c] = boundary * cell - offset * 0.5f;
+					vertex2.position[c] = boundary * cell + offset * 0.5f;
+				}
+				vertices.push_back(vertex1);
+				vertices.push_back(vertex2);
+				vertices.push_back(vertex1);
+			}
+		}
+	}
+
+	TestMesh mesh;
+	CHECK(mesh.prepare_soup(vertices));
+	UInt32Array remap;
+	CHECK(mesh.weld_vertices(tolerance, &remap));
+	CHECK(remap == get_reference_weld(vertices, tolerance));
+}
+
+TEST_CASE(mesh_adjacency_matches_reference)
+{
+	auto vertices = make_grid_soup(40, 2);
+
+	TestMesh mesh;
+	CHECK(mesh.prepare_soup(vertices));
+	UInt32Array adjacency;
+	CHECK(mesh.generate_adjacency(adjacency));
+	CHECK(adjacency == get_reference_adjacency(vertices));
+}
+
+TEST_CASE(mesh_adjacency_non_finite_positions)
+{
+	// two triangles sharing the edge between a nan and an infinite position,
+	// each with its own copy of the vertices
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float inf = std::numeric_limits<float>::infinity();
+	std::vector<Vertex> vertices =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { nan, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { 0.0f, inf, 0.0f }, { 0.0f, 0.0f } },
+		{ { 0.0f, inf, 0.0f }, { 0.0f, 0.0f } },
+		{ { nan, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { 1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
+		// a nan with another payload is just another position
+		{ { 2.0f, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { -nan, 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { 2.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
+	};
+
+	TestMesh mesh;
+	CHECK(mesh.prepare_soup(vertices));
+	UInt32Array adjacency;
+	CHECK(mesh.generate_adjacency(adjacency));
+	CHECK(adjacency.size() == 9);
+	if (adjacency.size() == 9)
+	{
+		CHECK(adjacency[1] == 1);
+		CHECK(adjacency[3] == 0);
+		CHECK(adjacency[0] == 0xFFFFFFFF && adjacency[2] == 0xFFFFFFFF);
+		CHECK(adjacency[6] == 0xFFFFFFFF && adjacency[7] == 0xFFFFFFFF && adjacency[8] == 0xFFFFFFFF);
+	}
+}
+
+BENCHMARK_CASE(mesh_preparation_2m_vertices)
+{
+	// 578 x 578 quads as a triangle soup are just over two million vertices
+	auto vertices = make_grid_soup(578, 3);
+	std::printf("%u vertices, %u triangles\n", std::uint32_t(vertices.size()), std::uint32_t(vertices.size() / 3));
+
+	{
+		TestMesh mesh;
+		CHECK(mesh.prepare_soup(vertices));
+		const auto start = std::chrono::high_resolution_clock::now();
+		UInt32Array adjacency;
+		CHECK(mesh.generate_adjacency(adjacency));
+		const double hashed = get_elapsed_ms(start);
+
+		const auto reference_start = std::chrono::high_resolution_clock::now();
+		CHECK(adjacency == get_reference_adjacency(vertices));
+		std::printf("adjacency: %.1f ms hashed, %.1f ms with the position map\n", hashed, get_elapsed_ms(reference_start));
+	}
+
+	{
+		TestMesh mesh;
+		CHECK(mesh.prepare_soup(vertices));
+		const auto start = std::chrono::high_resolution_clock::now();
+		CHECK(mesh.weld_vertices());
+		std::printf("weld: %.1f ms, %u vertices left\n", get_elapsed_ms(start), mesh.get_vertex_count());
+		CHECK(mesh.get_vertex_count() == 579 * 579);
+	}
+}
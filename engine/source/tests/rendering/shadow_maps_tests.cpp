@@ -0,0 +1,216 @@
+#include "../test.h"
+#include "runtime/rendering/shadow_maps.h"
+#include "core/math/frustum.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace shadow_maps;
+
+namespace
+{
+	math::vec3 to_ndc(const ShadowView& view, const math::vec3& position)
+	{
+		const auto clip = view.proj.matrix() * view.view.matrix() * math::vec4(position, 1.0f);
+		return math::vec3(clip) / clip.w;
+	}
+
+	bool is_inside_ndc(const math::vec3& position, bool homogeneous_depth)
+	{
+		const float epsilon = 1e-4f;
+		return std::abs(position.x) <= 1.0f + epsilon && std::abs(position.y) <= 1.0f + epsilon &&
+			position.z >= (homogeneous_depth ? -1.0f : 0.0f) - epsilon && position.z <= 1.0f + epsilon;
+	}
+
+	math::transform_t make_camera_view(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		const math::vec3 eye(unit(random) * 50.0f, unit(random) * 10.0f, unit(random) * 50.0f);
+		math::transform_t view;
+		view.look_at(eye, eye + math::normalize(math::vec3(unit(random), unit(random) * 0.5f, unit(random))));
+		return view;
+	}
+}
+
+TEST_CASE(shadow_maps_cascade_splits)
+{
+	float splits[5];
+	compute_cascade_splits(0.1f, 100.0f, 4, 0.0f, splits);
+	CHECK(std::abs(splits[2] - 50.05f) < 1e-3f);
+
+	compute_cascade_splits(0.1f, 100.0f, 4, 1.0f, splits);
+	CHECK(std::abs(splits[2] - std::sqrt(0.1f * 100.0f)) < 1e-3f);
+
+	compute_cascade_splits(0.1f, 100.0f, 4, 0.6f, splits);
+	CHECK(splits[0] == 0.1f && splits[4] == 100.0f);
+	for (int i = 0; i < 4; ++i)
+		CHECK(splits[i] < splits[i + 1]);
+}
+
+TEST_CASE(shadow_maps_directional_view_covers_cascade)
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (std::uint32_t i = 0; i < 100; ++i)
+	{
+		const bool homogeneous_depth = (i & 1) != 0;
+		const float near_clip = 0.1f + (i % 5) * 0.3f;
+		const float far_clip = 50.0f + i;
+		const auto view = make_camera_view(random);
+		const math::transform_t inv_view = math::inverse(view.matrix());
+		const math::transform_t proj = math::perspective(math::radians(50.0f + i % 40), 16.0f / 9.0f, near_clip, far_clip, homogeneous_depth);
+		const auto light_direction = math::normalize(math::vec3(unit(random), -1.0f, unit(random)));
+
+		float splits[5];
+		compute_cascade_splits(near_clip, far_clip, 4, 0.6f, splits);
+		for (std::uint32_t cascade = 0; cascade < 4; ++cascade)
+		{
+			// the corners are in view space, at the depth of their split
+			math::vec3 corners[8];
+			get_frustum_corners(proj, near_clip, far_clip, splits[cascade], splits[cascade + 1], homogeneous_depth, corners);
+			math::vec3 world_corners[8];
+			for (int c = 0; c < 8; ++c)
+			{
+				const float split = splits[cascade + (c >= 4 ? 1 : 0)];
+				CHECK(std::abs(corners[c].z - split) < 1e-2f * split);
+				world_corners[c] = inv_view.transform_coord(corners[c]);
+			}
+
+			for (int stabilize = 0; stabilize < 2; ++stabilize)
+			{
+				const auto shadow_view = compute_directional_view(light_direction, view, corners, 1024, stabilize == 1, 100.0f, homogeneous_depth);
+				for (int c = 0; c < 8; ++c)
+					CHECK(is_inside_ndc(to_ndc(shadow_view, world_corners[c]), homogeneous_depth));
+
+				// casters up to the caster distance towards the light are kept
+				math::frustum frustum(shadow_view.view, shadow_view.proj, homogeneous_depth);
+				const auto caster = world_corners[0] - light_direction * 50.0f;
+				CHECK(frustum.classify_aabb(math::bbox(caster - 0.1f, caster + 0.1f)) != math::VolumeQuery::Outside);
+				const auto far_away = world_corners[0] + math::vec3(1000.0f);
+				CHECK(frustum.classify_aabb(math::bbox(far_away, far_away + 1.0f)) == math::VolumeQuery::Outside);
+			}
+		}
+	}
+}
+
+TEST_CASE(shadow_maps_stabilized_view_snaps_to_texels)
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (std::uint32_t i = 0; i < 100; ++i)
+	{
+		const bool homogeneous_depth = (i & 1) != 0;
+		const float near_clip = 0.1f;
+		const float far_clip = 50.0f + i;
+		const math::transform_t proj = math::perspective(math::radians(60.0f), 16.0f / 9.0f, near_clip, far_clip, homogeneous_depth);
+		const auto light_direction = math::normalize(math::vec3(unit(random), -1.0f, unit(random)));
+
+		math::vec3 corners[8];
+		get_frustum_corners(proj, near_clip, far_clip, near_clip, far_clip * 0.5f, homogeneous_depth, corners);
+
+		// rotating the camera in place keeps the size of the view, moving
+		// the projection by whole texels only
+		const auto view1 = make_camera_view(random);
+		auto view2 = view1;
+		const auto eye = view1.get_position();
+		view2.look_at(eye, eye + math::normalize(math::vec3(unit(random), unit(random) * 0.5f, unit(random))));
+
+		const auto shadow_view1 = compute_directional_view(light_direction, view1, corners, 1024, true, 100.0f, homogeneous_depth);
+		const auto shadow_view2 = compute_directional_view(light_direction, view2, corners, 1024, true, 100.0f, homogeneous_depth);
+		CHECK(shadow_view1.view.matrix() == shadow_view2.view.matrix());
+
+		const float width1 = 2.0f / shadow_view1.proj.matrix()[0][0];
+		const float width2 = 2.0f / shadow_view2.proj.matrix()[0][0];
+		CHECK(std::abs(width1 - width2) < 1e-4f * width1);
+
+		const float texel = width1 / 1024.0f;
+		const float offset1 = -shadow_view1.proj.matrix()[3][0] * width1 * 0.5f;
+		const float offset2 = -shadow_view2.proj.matrix()[3][0] * width2 * 0.5f;
+		const float texels = (offset1 - offset2) / texel;
+		CHECK(std::abs(texels - std::round(texels)) < 2e-2f);
+	}
+}
+
+TEST_CASE(shadow_maps_spot_and_point_views)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for (std::uint32_t i = 0; i < 200; ++i)
+	{
+		const bool homogeneous_depth = (i & 1) != 0;
+		const math::vec3 position(unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f);
+
+		// the spot direction maps to the center of the view
+		const auto spot_direction = math::normalize(math::vec3(unit(random), unit(random), unit(random)));
+		const auto spot_view = compute_spot_view(position, spot_direction, 60.0f, 20.0f, homogeneous_depth);
+		const auto center = to_ndc(spot_view, position + spot_direction * 10.0f);
+		CHECK(std::abs(center.x) < 1e-4f && std::abs(center.y) < 1e-4f);
+
+		// a point lands on the face picked for its direction, inside of the
+		// border that keeps filtering from reading the neighbouring tiles
+		const auto direction = math::normalize(math::vec3(unit(random), unit(random), unit(random)));
+		const auto point_view = compute_point_view(position, get_point_face(direction), 20.0f, 256, 2, homogeneous_depth);
+		const auto ndc = to_ndc(point_view, position + direction * 5.0f);
+		CHECK(std::abs(ndc.x) <= 1.0f - 3.9f / 256.0f && std::abs(ndc.y) <= 1.0f - 3.9f / 256.0f);
+
+		// the atlas matrix maps into the tile, for either texture origin
+		for (int bottom_left = 0; bottom_left < 2; ++bottom_left)
+		{
+			const uRect rect(512, 1024, 768, 1280);
+			const auto atlas = get_atlas_matrix(point_view, rect, 4096, homogeneous_depth, bottom_left == 1);
+			const auto clip = atlas * math::vec4(position + direction * 5.0f, 1.0f);
+			const auto uv = math::vec3(clip) / clip.w;
+
+			const float x = (512.0f + (ndc.x * 0.5f + 0.5f) * 256.0f) / 4096.0f;
+			const float y = bottom_left == 1
+				? (4096.0f - 1280.0f + (ndc.y * 0.5f + 0.5f) * 256.0f) / 4096.0f
+				: (1024.0f + (0.5f - ndc.y * 0.5f) * 256.0f) / 4096.0f;
+			CHECK(std::abs(uv.x - x) < 1e-5f && std::abs(uv.y - y) < 1e-5f);
+			CHECK(std::abs(uv.z - (homogeneous_depth ? ndc.z * 0.5f + 0.5f : ndc.z)) < 1e-5f);
+		}
+	}
+}
+
+TEST_CASE(shadow_maps_atlas_allocation)
+{
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	ShadowAtlas atlas;
+	atlas.reset(4096, 128);
+	std::vector<uRect> tiles;
+	for (std::uint32_t i = 0; i < 20000; ++i)
+	{
+		if (unit(random) > -0.2f || tiles.empty())
+		{
+			const std::uint32_t size = 128u << (random() % 5);
+			uRect rect;
+			if (!atlas.allocate(size, rect))
+				continue;
+
+			// tiles are square, aligned to their size and never overlap
+			CHECK(rect.width() == rect.height() && rect.width() <= size && rect.width() >= 128);
+			CHECK(rect.right <= 4096 && rect.bottom <= 4096 && rect.left % rect.width() == 0 && rect.top % rect.width() == 0);
+			for (const auto& other : tiles)
+				CHECK(rect.right <= other.left || other.right <= rect.left || rect.bottom <= other.top || other.bottom <= rect.top);
+			tiles.push_back(rect);
+		}
+		else
+		{
+			const std::size_t index = random() % tiles.size();
+			atlas.free(tiles[index]);
+			tiles.erase(tiles.begin() + index);
+		}
+
+		std::uint64_t used = 0;
+		for (const auto& tile : tiles)
+			used += std::uint64_t(tile.width()) * tile.height();
+		CHECK(used + atlas.get_free_area() == 4096ull * 4096ull);
+	}
+
+	// freed tiles merge back into the whole atlas
+	for (const auto& tile : tiles)
+		atlas.free(tile);
+	uRect whole;
+	CHECK(atlas.allocate(4096, whole) && whole.width() == 4096);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : tests (Namespace)
+/// <summary>
+/// A minimal registry for headless tests of the engine code that does not
+/// need a renderer. Test cases register themselves at static initialization
+/// and report failed checks instead of stopping, so one run lists every
+/// failure. Benchmarks are registered the same way but only run on request.
+/// </summary>
+//-----------------------------------------------------------------------------
+namespace tests
+{
+	struct TestCase
+	{
+		const char* name = nullptr;
+		void(*function)() = nullptr;
+		bool benchmark = false;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_test_cases ()
+	/// <summary>
+	/// Returns the registered test cases and benchmarks.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<TestCase>& get_test_cases();
+
+	//-----------------------------------------------------------------------------
+	//  Name : report_failure ()
+	/// <summary>
+	/// Records a failed check of the running test case.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void report_failure(const char* file, int line, const char* expression);
+
+	struct Registrar
+	{
+		Registrar(const char* name, void(*function)(), bool benchmark)
+		{
+			get_test_cases().push_back({ name, function, benchmark });
+		}
+	};
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static tests::Registrar name##_registrar(#name, &name, false); \
+	static void name()
+
+#define BENCHMARK_CASE(name) \
+	static void name(); \
+	static tests::Registrar name##_registrar(#name, &name, true); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) tests::report_failure(__FILE__, __LINE__, #expression); } while (false)
@@ -0,0 +1,70 @@
+$input v_texcoord0
+
+#include "fs_pbr_lighting.sh"
+
+SAMPLER2D(s_tex6, 6); // cluster offset and light count
+SAMPLER2D(s_tex7, 7); // light indices
+SAMPLER2D(s_tex8, 8); // light data
+
+uniform vec4 u_cluster_grid; // tiles x, tiles y, slices
+uniform vec4 u_cluster_slicing; // slice = log(depth) * x + y
+uniform vec4 u_cluster_textures; // size of the light index and light data textures
+
+vec4 fetch_texel(sampler2D s, float index, vec2 size)
+{
+	float y = floor(index / size.x);
+	float x = index - y * size.x;
+	return texture2DLod(s, (vec2(x, y) + 0.5) / size, 0.0);
+}
+
+void main()
+{
+	vec2 texcoord0 = v_texcoord0;
+	GBufferData data = decodeGBuffer(texcoord0, s_tex0, s_tex1, s_tex2, s_tex3, s_tex4);
+	vec3 indirect_specular = texture2D(s_tex5, texcoord0).xyz;
+	vec3 clip = vec3(texcoord0 * 2.0 - 1.0, data.depth);
+	clip = clipTransform(clip);
+	vec3 world_position = clipToWorld(u_invViewProj, clip);
+	vec3 indirect_diffuse = vec3(0.0f, 0.0f, 0.0f);
+
+	// Find the cluster of the pixel, the same way LightClusters lays them out.
+	float depth = abs(mul(u_view, vec4(world_position, 1.0)).z);
+	float slice = clamp(floor(log(depth) * u_cluster_slicing.x + u_cluster_slicing.y), 0.0, u_cluster_grid.z - 1.0);
+	vec2 tile = clamp(floor((clip.xy * 0.5 + 0.5) * u_cluster_grid.xy), vec2(0.0, 0.0), u_cluster_grid.xy - 1.0);
+	vec2 cluster_size = vec2(u_cluster_grid.x * u_cluster_grid.y, u_cluster_grid.z);
+	vec2 cluster_uv = (vec2(tile.y * u_cluster_grid.x + tile.x, slice) + 0.5) / cluster_size;
+	vec2 cluster = texture2DLod(s_tex6, cluster_uv, 0.0).xy;
+
+	// LightClusters lists at most MaxClusterLights lights per cluster.
+	vec3 lighting = data.emissive_color;
+	for (int i = 0; i < 256; ++i)
+	{
+		if (float(i) >= cluster.y)
+			break;
+
+		float light_index = fetch_texel(s_tex7, cluster.x + float(i), u_cluster_textures.xy).x;
+		vec4 position_range = fetch_texel(s_tex8, light_index * 4.0, u_cluster_textures.zw);
+		vec4 direction_type = fetch_texel(s_tex8, light_index * 4.0 + 1.0, u_cluster_textures.zw);
+		vec4 color_intensity = fetch_texel(s_tex8, light_index * 4.0 + 2.0, u_cluster_textures.zw);
+		vec4 light_data = fetch_texel(s_tex8, light_index * 4.0 + 3.0, u_cluster_textures.zw);
+
+		vec3 vector_to_light = position_range.xyz - world_position;
+		vec3 vector_to_light_over_radius = vector_to_light / light_data.x;
+		float light_radius_mask;
+		float spot_falloff;
+		if (direction_type.w > 0.5)
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, 1.0f);
+			spot_falloff = SpotAttenuation( vector_to_light_over_radius, normalize(direction_type.xyz), vec2(light_data.z, 1.0f / (light_data.y - light_data.z )));
+		}
+		else
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, light_data.y);
+			spot_falloff = 1.0f;
+		}
+
+		lighting += pbr_light_contribution(data, world_position, indirect_specular, indirect_diffuse, color_intensity.xyz, color_intensity.w, vector_to_light, light_radius_mask, spot_falloff, 1.0f);
+	}
+
+	gl_FragColor = vec4(lighting, 1.0f);
+}
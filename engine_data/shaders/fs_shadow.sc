@@ -0,0 +1,7 @@
+#include "common.sh"
+
+// Only depth is written, the color is ignored.
+void main()
+{
+	gl_FragColor = vec4_splat(0.0);
+}
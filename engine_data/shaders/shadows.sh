@@ -0,0 +1,92 @@
+#ifndef __SHADOWS_SH__
+#define __SHADOWS_SH__
+
+SAMPLER2DSHADOW(s_tex6, 6); // shadow atlas
+
+uniform mat4 u_shadow_matrix[6]; // world to atlas, per cascade or cube face
+uniform vec4 u_shadow_splits; // far distance of every cascade
+uniform vec4 u_shadow_params; // filter (0 off, 1 hard, 2 pcf), depth bias, normal offset, map count
+uniform vec4 u_shadow_atlas; // texel size, size
+
+float sample_shadow_map(vec4 shadow_coord)
+{
+	vec3 coord = shadow_coord.xyz / shadow_coord.w;
+	coord.z -= u_shadow_params.y;
+	if (u_shadow_params.x < 1.5)
+		return shadow2D(s_tex6, coord);
+
+	// Four bilinear compares, covering 3x3 texels.
+	float texel = u_shadow_atlas.x;
+	float result = 0.0;
+	result += shadow2D(s_tex6, vec3(coord.xy + vec2(-0.5, -0.5) * texel, coord.z));
+	result += shadow2D(s_tex6, vec3(coord.xy + vec2( 0.5, -0.5) * texel, coord.z));
+	result += shadow2D(s_tex6, vec3(coord.xy + vec2(-0.5,  0.5) * texel, coord.z));
+	result += shadow2D(s_tex6, vec3(coord.xy + vec2( 0.5,  0.5) * texel, coord.z));
+	return result * 0.25;
+}
+
+float directional_shadow(vec3 world_position, vec3 world_normal, float view_depth)
+{
+	if (u_shadow_params.x < 0.5)
+		return 1.0;
+
+	// Unused cascades have an infinite split and are never counted.
+	vec4 split_test = step(u_shadow_splits, vec4_splat(view_depth));
+	float cascade = split_test.x + split_test.y + split_test.z + split_test.w;
+	if (cascade >= u_shadow_params.w)
+		return 1.0;
+
+	// Texels of further cascades are larger, so is the offset.
+	vec4 position = vec4(world_position + world_normal * (u_shadow_params.z * (cascade + 1.0)), 1.0);
+	mat4 shadow_matrix = u_shadow_matrix[0];
+	if (cascade > 2.5)
+		shadow_matrix = u_shadow_matrix[3];
+	else if (cascade > 1.5)
+		shadow_matrix = u_shadow_matrix[2];
+	else if (cascade > 0.5)
+		shadow_matrix = u_shadow_matrix[1];
+
+	return sample_shadow_map(mul(shadow_matrix, position));
+}
+
+float spot_shadow(vec3 world_position, vec3 world_normal)
+{
+	if (u_shadow_params.x < 0.5)
+		return 1.0;
+
+	vec4 position = vec4(world_position + world_normal * u_shadow_params.z, 1.0);
+	return sample_shadow_map(mul(u_shadow_matrix[0], position));
+}
+
+float point_shadow(vec3 world_position, vec3 world_normal, vec3 light_to_position)
+{
+	if (u_shadow_params.x < 0.5)
+		return 1.0;
+
+	// Same face order as shadow_maps::get_point_face, +x, -x, +y, -y, +z, -z.
+	vec3 a = abs(light_to_position);
+	mat4 shadow_matrix = u_shadow_matrix[5];
+	if (a.x >= a.y && a.x >= a.z)
+	{
+		if (light_to_position.x >= 0.0)
+			shadow_matrix = u_shadow_matrix[0];
+		else
+			shadow_matrix = u_shadow_matrix[1];
+	}
+	else if (a.y >= a.z)
+	{
+		if (light_to_position.y >= 0.0)
+			shadow_matrix = u_shadow_matrix[2];
+		else
+			shadow_matrix = u_shadow_matrix[3];
+	}
+	else if (light_to_position.z >= 0.0)
+	{
+		shadow_matrix = u_shadow_matrix[4];
+	}
+
+	vec4 position = vec4(world_position + world_normal * u_shadow_params.z, 1.0);
+	return sample_shadow_map(mul(shadow_matrix, position));
+}
+
+#endif // __SHADOWS_SH__
@@ -1,7 +1,6 @@
 vec3 a_position  : POSITION;
 vec4 a_normal    : NORMAL;
 vec4 a_tangent   : TANGENT;
-vec4 a_bitangent : BITANGENT;
 vec2 a_texcoord0 : TEXCOORD0;
 vec4 a_weight : BLENDWEIGHT;
 ivec4 a_indices : BLENDINDICES;
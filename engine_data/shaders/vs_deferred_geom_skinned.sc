@@ -1,8 +1,10 @@
-$input a_position, a_normal, a_tangent, a_bitangent, a_texcoord0, a_weight, a_indices
+$input a_position, a_normal, a_tangent, a_texcoord0, a_weight, a_indices
 $output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0
 
 #include "common.sh"
 
+uniform vec4 u_position_decode; // position = a_position * w + xyz
+
 void main()
 {
 	
@@ -12,19 +14,21 @@ void main()
 	a_weight.z * u_model[int(a_indices.z)] +
 	a_weight.w * u_model[int(a_indices.w)];
   			
-	vec3 wpos = mul(model, vec4(a_position, 1.0) ).xyz;
+	vec3 position = a_position * u_position_decode.w + u_position_decode.xyz;
+	vec3 wpos = mul(model, vec4(position, 1.0) ).xyz;
 	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
 
 	vec4 normal = a_normal * 2.0 - 1.0;
 	vec4 tangent = a_tangent * 2.0 - 1.0;
-	vec4 bitangent = a_bitangent * 2.0 - 1.0;
+	// the handedness of the tangent frame is kept in the tangent's w
+	vec3 bitangent = cross(normal.xyz, tangent.xyz) * sign(tangent.w);
 
 	mat3 modelIT = calculateInverseTranspose(model);
 	
 	
 	vec3 wnormal = normalize(mul(modelIT, normal.xyz ));
 	vec3 wtangent = normalize(mul(modelIT, tangent.xyz ));
-	vec3 wbitangent = normalize(mul(modelIT, bitangent.xyz ));
+	vec3 wbitangent = normalize(mul(modelIT, bitangent ));
 	
 	v_wpos = wpos;
 	v_pos = gl_Position.xyz/gl_Position.w;
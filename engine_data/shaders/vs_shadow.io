@@ -0,0 +1 @@
+vec3 a_position  : POSITION;
@@ -0,0 +1,11 @@
+$input a_position
+
+#include "common.sh"
+
+uniform vec4 u_position_decode; // position = a_position * w + xyz
+
+void main()
+{
+	vec3 position = a_position * u_position_decode.w + u_position_decode.xyz;
+	gl_Position = mul(u_modelViewProj, vec4(position, 1.0) );
+}
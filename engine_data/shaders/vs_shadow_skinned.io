@@ -0,0 +1,3 @@
+vec3 a_position  : POSITION;
+vec4 a_weight : BLENDWEIGHT;
+ivec4 a_indices : BLENDINDICES;
@@ -0,0 +1,18 @@
+$input a_position, a_weight, a_indices
+
+#include "common.sh"
+
+uniform vec4 u_position_decode; // position = a_position * w + xyz
+
+void main()
+{
+	//u_model should already be in the right space
+	mat4 model = a_weight.x * u_model[int(a_indices.x)] +
+	a_weight.y * u_model[int(a_indices.y)] +
+	a_weight.z * u_model[int(a_indices.z)] +
+	a_weight.w * u_model[int(a_indices.w)];
+
+	vec3 position = a_position * u_position_decode.w + u_position_decode.xyz;
+	vec3 wpos = mul(model, vec4(position, 1.0) ).xyz;
+	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
+}